@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+# Builds google-benchmark from the third_party/benchmark submodule for the mat-bench target.
+# Usage: ./build-benchmark.sh && cmake -DBUILD_BENCHMARKS=ON ...
+cd `dirname $0`
+
+BENCHMARK_PATH=third_party/benchmark
+if [ ! "$(ls -A $BENCHMARK_PATH 2>/dev/null)" ]; then
+  echo Clone benchmark from google/benchmark ...
+  git clone https://github.com/google/benchmark $BENCHMARK_PATH
+fi
+
+pushd $BENCHMARK_PATH
+set -evx
+rm -rf build
+mkdir -p build || true
+cd build
+cmake -DCMAKE_BUILD_TYPE=Release \
+      -DBENCHMARK_ENABLE_TESTING=OFF \
+      -DBENCHMARK_ENABLE_GTEST_TESTS=OFF \
+      -DBENCHMARK_ENABLE_INSTALL=OFF \
+      -DCMAKE_CXX_FLAGS="-fPIC $CXX_FLAGS" \
+      ..
+make
+popd
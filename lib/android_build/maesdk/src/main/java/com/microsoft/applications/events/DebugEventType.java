@@ -32,6 +32,8 @@ public enum DebugEventType {
   EVT_DROPPED(0x03000000L),
   /// <summary>Event(s) filtered.</summary>
   EVT_FILTERED(0x03000001L),
+  /// <summary>Event(s) dropped by client-side sampling.</summary>
+  EVT_SAMPLED(0x03000002L),
 
   /// <summary>Event(s) sent.</summary>
   EVT_SENT(0x04000000L),
@@ -82,9 +84,14 @@ public enum DebugEventType {
   EVT_STORAGE_FULL(0x0E000000L),
   /// <summary>Storage failed.</summary>
   EVT_STORAGE_FAILED(0x0E000001L),
+  /// <summary>Storage opened and ready: param1 is the time it took to open, in milliseconds.</summary>
+  EVT_STORAGE_READY(0x0E000002L),
 
   /// <summary>Ticket Expired</summary>
   EVT_TICKET_EXPIRED(0x0F000000L),
+
+  /// <summary>Pipeline stage latency sample: param1 is the PipelineStage, param2 the duration in microseconds.</summary>
+  EVT_PIPELINE_LATENCY(0x10000000L),
   /// <summary>Unknown error.</summary>
   EVT_UNKNOWN(0xDEADBEEFL);
 
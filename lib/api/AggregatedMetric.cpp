@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "AggregatedMetric.hpp"
+
+#include "pal/PAL.hpp"
+#include "pal/TaskDispatcher.hpp"
+#include "stats/MetricAggregator.hpp"
+
+#include <chrono>
+#include <memory>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Aggregates the values of an AggregatedMetric and logs the aggregate
+    /// via ILogger::LogAggregatedMetric once per interval, on the SDK timer.
+    /// </summary>
+    class AggregatedMetricImpl
+    {
+    public:
+        AggregatedMetricImpl(std::string const& name,
+            std::string const& units,
+            unsigned intervalInSec,
+            std::string const& instanceName,
+            std::string const& objectClass,
+            std::string const& objectId,
+            EventProperties const& eventProperties,
+            ILogger* pLogger) :
+            m_name(name),
+            m_units(units),
+            m_intervalMs(intervalInSec * 1000),
+            m_instanceName(instanceName),
+            m_objectClass(objectClass),
+            m_objectId(objectId),
+            m_eventProperties(eventProperties),
+            m_logger(pLogger),
+            m_intervalStart(std::chrono::steady_clock::now()),
+            m_isStopped(false)
+        {
+            if (m_logger == nullptr)
+            {
+                LOG_WARN("AggregatedMetric %s has no logger: aggregates will not be reported", m_name.c_str());
+                return;
+            }
+            if (m_intervalMs != 0)
+            {
+                // Keep the dispatcher alive for as long as the timer may be pending on it
+                m_taskDispatcher = PAL::getDefaultTaskDispatcher();
+                std::lock_guard<std::mutex> lock(m_timerLock);
+                m_scheduledFlush = PAL::scheduleTask(m_taskDispatcher.get(), m_intervalMs, this, &AggregatedMetricImpl::onTimer);
+            }
+        }
+
+        ~AggregatedMetricImpl()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_timerLock);
+                m_isStopped = true;
+            }
+            if (m_taskDispatcher)
+            {
+                // Waits for a flush that is already in progress
+                m_scheduledFlush.Cancel(m_intervalMs);
+            }
+            flush();
+        }
+
+        void PushMetric(double value)
+        {
+            m_aggregator.Add(value);
+        }
+
+    protected:
+        void onTimer()
+        {
+            std::lock_guard<std::mutex> lock(m_timerLock);
+            if (m_isStopped)
+            {
+                return;
+            }
+            flush();
+            m_scheduledFlush = PAL::scheduleTask(m_taskDispatcher.get(), m_intervalMs, this, &AggregatedMetricImpl::onTimer);
+        }
+
+        void flush()
+        {
+            MetricAccumulator total;
+            m_aggregator.Collect(total);
+
+            auto now = std::chrono::steady_clock::now();
+            long duration = static_cast<long>(std::chrono::duration_cast<std::chrono::microseconds>(now - m_intervalStart).count());
+            m_intervalStart = now;
+
+            if (total.Empty() || (m_logger == nullptr))
+            {
+                return;
+            }
+
+            AggregatedMetricData data(m_name, duration, 0);
+            data.units = m_units;
+            data.instanceName = m_instanceName;
+            data.objectClass = m_objectClass;
+            data.objectId = m_objectId;
+            total.Export(data);
+            LOG_TRACE("AggregatedMetric %s: count=%ld, duration=%ld us", m_name.c_str(), data.count, duration);
+            m_logger->LogAggregatedMetric(data, m_eventProperties);
+        }
+
+        std::string const                        m_name;
+        std::string const                        m_units;
+        unsigned const                           m_intervalMs;
+        std::string const                        m_instanceName;
+        std::string const                        m_objectClass;
+        std::string const                        m_objectId;
+        EventProperties const                    m_eventProperties;
+        ILogger*                                 m_logger;
+
+        MetricAggregator                         m_aggregator;
+        std::chrono::steady_clock::time_point    m_intervalStart;
+
+        std::mutex                               m_timerLock;
+        bool                                     m_isStopped;
+        std::shared_ptr<ITaskDispatcher>         m_taskDispatcher;
+        PAL::DeferredCallbackHandle              m_scheduledFlush;
+    };
+
+    namespace Models {
+
+        AggregatedMetric::AggregatedMetric(std::string const& name,
+            std::string const& units,
+            unsigned const intervalInSec,
+            EventProperties const& eventProperties,
+            ILogger* pLogger) :
+            m_pAggregatedMetricImpl(new AggregatedMetricImpl(name, units, intervalInSec, std::string(), std::string(), std::string(), eventProperties, pLogger))
+        {
+        }
+
+        AggregatedMetric::AggregatedMetric(std::string const& name,
+            std::string const& units,
+            unsigned const intervalInSec,
+            std::string const& instanceName,
+            std::string const& objectClass,
+            std::string const& objectId,
+            EventProperties const& eventProperties,
+            ILogger* pLogger) :
+            m_pAggregatedMetricImpl(new AggregatedMetricImpl(name, units, intervalInSec, instanceName, objectClass, objectId, eventProperties, pLogger))
+        {
+        }
+
+        AggregatedMetric::~AggregatedMetric()
+        {
+            delete static_cast<AggregatedMetricImpl*>(m_pAggregatedMetricImpl);
+        }
+
+        void AggregatedMetric::PushMetric(double value)
+        {
+            static_cast<AggregatedMetricImpl*>(m_pAggregatedMetricImpl)->PushMetric(value);
+        }
+
+    } // Models
+
+} MAT_NS_END
@@ -11,6 +11,31 @@
 namespace MAT_NS_BEGIN
 {
 
+    // Names of the common fields copied to Part A, as strings so that looking them up for every
+    // event does not allocate a key
+    static const std::string s_appExperimentIds(COMMONFIELDS_APP_EXPERIMENTIDS);
+    static const std::string s_sessionImpressionId(SESSION_IMPRESSION_ID);
+    static const std::string s_appExperimentEtag(COMMONFIELDS_APP_EXPERIMENTETAG);
+    static const std::string s_appId(COMMONFIELDS_APP_ID);
+    static const std::string s_appEnv(COMMONFIELDS_APP_ENV);
+    static const std::string s_appName(COMMONFIELDS_APP_NAME);
+    static const std::string s_appVersion(COMMONFIELDS_APP_VERSION);
+    static const std::string s_appLanguage(COMMONFIELDS_APP_LANGUAGE);
+    static const std::string s_deviceId(COMMONFIELDS_DEVICE_ID);
+    static const std::string s_deviceOrgId(COMMONFIELDS_DEVICE_ORGID);
+    static const std::string s_deviceMake(COMMONFIELDS_DEVICE_MAKE);
+    static const std::string s_deviceModel(COMMONFIELDS_DEVICE_MODEL);
+    static const std::string s_deviceClass(COMMONFIELDS_DEVICE_CLASS);
+    static const std::string s_commercialId(COMMONFIELDS_COMMERCIAL_ID);
+    static const std::string s_osName(COMMONFIELDS_OS_NAME);
+    static const std::string s_osBuild(COMMONFIELDS_OS_BUILD);
+    static const std::string s_userId(COMMONFIELDS_USER_ID);
+    static const std::string s_userLanguage(COMMONFIELDS_USER_LANGUAGE);
+    static const std::string s_userTimezone(COMMONFIELDS_USER_TIMEZONE);
+    static const std::string s_networkCost(COMMONFIELDS_NETWORK_COST);
+    static const std::string s_networkProvider(COMMONFIELDS_NETWORK_PROVIDER);
+    static const std::string s_networkType(COMMONFIELDS_NETWORK_TYPE);
+
     ContextFieldsProvider::ContextFieldsProvider()
         : ContextFieldsProvider(nullptr)
     {
@@ -54,62 +79,53 @@ namespace MAT_NS_BEGIN
 
         if (record.data.size() == 0)
         {
-            ::CsProtocol::Data data;
-            record.data.push_back(data);
+            record.data.emplace_back();
         }
         if (record.extApp.size() == 0)
         {
-            ::CsProtocol::App app;
-            record.extApp.push_back(app);
+            record.extApp.emplace_back();
         }
 
         if (record.extDevice.size() == 0)
         {
-            ::CsProtocol::Device device;
-            record.extDevice.push_back(device);
+            record.extDevice.emplace_back();
         }
 
         if (record.extOs.size() == 0)
         {
-            ::CsProtocol::Os os;
-            record.extOs.push_back(os);
+            record.extOs.emplace_back();
         }
 
         if (record.extUser.size() == 0)
         {
-            ::CsProtocol::User user;
-            record.extUser.push_back(user);
+            record.extUser.emplace_back();
         }
 
         if (record.extLoc.size() == 0)
         {
-            ::CsProtocol::Loc loc;
-            record.extLoc.push_back(loc);
+            record.extLoc.emplace_back();
         }
 
         if (record.extNet.size() == 0)
         {
-            ::CsProtocol::Net net;
-            record.extNet.push_back(net);
+            record.extNet.emplace_back();
         }
 
         if (record.extProtocol.size() == 0)
         {
-            ::CsProtocol::Protocol proto;
-            record.extProtocol.push_back(proto);
+            record.extProtocol.emplace_back();
         }
 
         if (record.extM365a.size() == 0)
         {
-            ::CsProtocol::M365a m365a;
-            record.extM365a.push_back(m365a);
+            record.extM365a.emplace_back();
         }
 
         std::map<std::string, ::CsProtocol::Value>& ext = record.data[0].properties;
         {
             LOCKGUARD(m_lock);
 
-            std::string value = m_commonContextFields[COMMONFIELDS_APP_EXPERIMENTIDS].as_string;
+            std::string value = m_commonContextFields[s_appExperimentIds].as_string;
             if (!value.empty())
             {// for ECS set event specific config ids
                 std::string eventName = record.name;
@@ -127,39 +143,39 @@ namespace MAT_NS_BEGIN
 
             if (!m_commonContextFields.empty())
             {
-                if (m_commonContextFields.find(SESSION_IMPRESSION_ID) != m_commonContextFields.end())
+                if (m_commonContextFields.find(s_sessionImpressionId) != m_commonContextFields.end())
                 {
                     CsProtocol::Value temp;
-                    EventProperty prop = m_commonContextFields[SESSION_IMPRESSION_ID];
+                    EventProperty prop = m_commonContextFields[s_sessionImpressionId];
                     temp.stringValue = prop.as_string;
 
-                    ext[SESSION_IMPRESSION_ID] = temp;
+                    ext[s_sessionImpressionId] = temp;
                 }
 
-                if (m_commonContextFields.find(COMMONFIELDS_APP_EXPERIMENTETAG) != m_commonContextFields.end())
+                if (m_commonContextFields.find(s_appExperimentEtag) != m_commonContextFields.end())
                 {
                     CsProtocol::Value temp;
-                    EventProperty prop = m_commonContextFields[COMMONFIELDS_APP_EXPERIMENTETAG];
+                    EventProperty prop = m_commonContextFields[s_appExperimentEtag];
                     temp.stringValue = prop.as_string;
 
-                    ext[COMMONFIELDS_APP_EXPERIMENTETAG] = temp;
+                    ext[s_appExperimentEtag] = temp;
                 }
 
-                auto iter = m_commonContextFields.find(COMMONFIELDS_APP_ID);
+                auto iter = m_commonContextFields.find(s_appId);
                 bool hasAppId = (iter != m_commonContextFields.end());
                 if (hasAppId)
                 {
                     record.extApp[0].id = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_APP_ENV);
+                iter = m_commonContextFields.find(s_appEnv);
                 bool hasAppEnv = (iter != m_commonContextFields.end());
                 if (hasAppEnv)
                 {
                     record.extApp[0].env = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_APP_NAME);
+                iter = m_commonContextFields.find(s_appName);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extApp[0].name = iter->second.as_string;
@@ -173,19 +189,19 @@ namespace MAT_NS_BEGIN
                     record.extApp[0].name = record.extApp[0].id;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_APP_VERSION);
+                iter = m_commonContextFields.find(s_appVersion);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extApp[0].ver = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_APP_LANGUAGE);
+                iter = m_commonContextFields.find(s_appLanguage);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extApp[0].locale = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_ID);
+                iter = m_commonContextFields.find(s_deviceId);
                 if (iter != m_commonContextFields.end())
                 {
                     // Use "c:" prefix
@@ -219,80 +235,80 @@ namespace MAT_NS_BEGIN
                     record.extDevice[0].localId = temp;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_ORGID);
+                iter = m_commonContextFields.find(s_deviceOrgId);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extDevice[0].orgId = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_MAKE);
+                iter = m_commonContextFields.find(s_deviceMake);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extProtocol[0].devMake = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_MODEL);
+                iter = m_commonContextFields.find(s_deviceModel);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extProtocol[0].devModel = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_CLASS);
+                iter = m_commonContextFields.find(s_deviceClass);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extDevice[0].deviceClass = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_COMMERCIAL_ID);
+                iter = m_commonContextFields.find(s_commercialId);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extM365a[0].enrolledTenantId = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_OS_NAME);
+                iter = m_commonContextFields.find(s_osName);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extOs[0].name = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_OS_BUILD);
+                iter = m_commonContextFields.find(s_osBuild);
                 if (iter != m_commonContextFields.end())
                 {
                     //EventProperty prop = (*m_commonContextFieldsP)[COMMONFIELDS_OS_VERSION];
                     record.extOs[0].ver = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_USER_ID);
+                iter = m_commonContextFields.find(s_userId);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extUser[0].localId = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_USER_LANGUAGE);
+                iter = m_commonContextFields.find(s_userLanguage);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extUser[0].locale = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_USER_TIMEZONE);
+                iter = m_commonContextFields.find(s_userTimezone);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extLoc[0].timezone = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_NETWORK_COST);
+                iter = m_commonContextFields.find(s_networkCost);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extNet[0].cost = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_NETWORK_PROVIDER);
+                iter = m_commonContextFields.find(s_networkProvider);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extNet[0].provider = iter->second.as_string;
                 }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_NETWORK_TYPE);
+                iter = m_commonContextFields.find(s_networkType);
                 if (iter != m_commonContextFields.end())
                 {
                     record.extNet[0].type = iter->second.as_string;
@@ -301,14 +317,15 @@ namespace MAT_NS_BEGIN
 
             if (m_ticketsMap.size() > 0)
             {
-                std::vector<std::string> tickets;
+                auto& ticketKeys = record.extProtocol[0].ticketKeys;
+                if (ticketKeys.size() == 0)
+                {
+                    ticketKeys.emplace_back();
+                }
                 for (auto const& field : m_ticketsMap)
                 {
-                    tickets.push_back(field.second);
+                    ticketKeys[0].push_back(field.second);
                 }
-                CsProtocol::Protocol temp;
-                temp.ticketKeys.push_back(tickets);
-                record.extProtocol.push_back(temp);
             }
 
             if (!commonOnly)
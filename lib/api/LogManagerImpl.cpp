@@ -15,6 +15,7 @@
 #include "system/TelemetrySystem.hpp"
 
 #include "EventProperty.hpp"
+#include "bwcontrol/TokenBucketBandwidthController.hpp"
 #include "TransmitProfiles.hpp"
 #include "http/HttpClientFactory.hpp"
 #include "pal/TaskDispatcher.hpp"
@@ -148,13 +149,17 @@ namespace MAT_NS_BEGIN
     LogManagerImpl::LogManagerImpl(ILogConfiguration& configuration, bool deferSystemStart) :
         m_logConfiguration(configuration),
         m_bandwidthController(nullptr),
-        m_offlineStorage(nullptr)
+        m_memoryBudget(std::static_pointer_cast<IMemoryResource>(configuration.GetModule(CFG_MODULE_MEMORY_RESOURCE))),
+        m_offlineStorage(nullptr),
+        m_pipelineLatency(*this)
     {
         m_httpClient = std::static_pointer_cast<IHttpClient>(configuration.GetModule(CFG_MODULE_HTTP_CLIENT));
         m_taskDispatcher = std::static_pointer_cast<ITaskDispatcher>(configuration.GetModule(CFG_MODULE_TASK_DISPATCHER));
         m_dataViewer = std::static_pointer_cast<IDataViewer>(configuration.GetModule(CFG_MODULE_DATA_VIEWER));
         m_customDecorator = std::static_pointer_cast<IDecoratorModule>(configuration.GetModule(CFG_MODULE_DECORATOR));
         m_config = std::unique_ptr<IRuntimeConfig>(new RuntimeConfig_Default(m_logConfiguration));
+        m_pipelineLatency.Configure(*m_config);
+        m_memoryBudget.Configure(*m_config);
         setLogLevel(configuration);
         LOG_TRACE("New LogManager instance");
 
@@ -220,9 +225,19 @@ namespace MAT_NS_BEGIN
             m_dataViewerCollection.RegisterViewer(m_dataViewer);
         }
 
+        if (m_logConfiguration.HasConfig(CFG_STR_SHARED_RUNTIME))
+        {
+            std::string sharedRuntime = m_logConfiguration[CFG_STR_SHARED_RUNTIME];
+            if (!sharedRuntime.empty())
+            {
+                LOG_INFO("Joining shared runtime %s", sharedRuntime.c_str());
+                m_sharedRuntime = SharedRuntime::Acquire(sharedRuntime);
+            }
+        }
+
         if (m_taskDispatcher == nullptr)
         {
-            m_taskDispatcher = PAL::getDefaultTaskDispatcher();
+            m_taskDispatcher = (m_sharedRuntime != nullptr) ? m_sharedRuntime->GetTaskDispatcher() : PAL::getDefaultTaskDispatcher();
         }
         else
         {
@@ -262,7 +277,7 @@ namespace MAT_NS_BEGIN
 #ifdef HAVE_MAT_DEFAULT_HTTP_CLIENT
         if (m_httpClient == nullptr)
         {
-            m_httpClient = HttpClientFactory::Create();
+            m_httpClient = (m_sharedRuntime != nullptr) ? m_sharedRuntime->GetHttpClient() : HttpClientFactory::Create();
 #ifdef HAVE_MAT_WININET_HTTP_CLIENT
             HttpClient_WinInet* client = static_cast<HttpClient_WinInet*>(m_httpClient.get());
             if (client != nullptr)
@@ -285,6 +300,13 @@ namespace MAT_NS_BEGIN
 
         if (m_bandwidthController == nullptr)
         {
+            uint32_t bandwidthBps = m_logConfiguration[CFG_MAP_TPM][CFG_INT_TPM_BANDWIDTH_BPS];
+            if (bandwidthBps > 0)
+            {
+                uint32_t burstBytes = m_logConfiguration[CFG_MAP_TPM][CFG_INT_TPM_BANDWIDTH_BURST_BYTES];
+                m_ownBandwidthController.reset(new TokenBucketBandwidthController(bandwidthBps, burstBytes));
+                LOG_TRACE("BandwidthController: Token bucket %u bytes/sec", bandwidthBps);
+            }
             m_bandwidthController = m_ownBandwidthController.get();
         }
         else
@@ -296,7 +318,12 @@ namespace MAT_NS_BEGIN
             LOG_TRACE("BandwidthController: None");
         }
 
-        m_offlineStorage.reset(new OfflineStorageHandler(*this, *m_config, *m_taskDispatcher));
+        std::shared_ptr<IOfflineStorage> sharedStorage;
+        if ((m_sharedRuntime != nullptr) && (m_logConfiguration.GetModule(CFG_MODULE_OFFLINE_STORAGE) == nullptr))
+        {
+            sharedStorage = m_sharedRuntime->GetStorage(*this, *m_config);
+        }
+        m_offlineStorage.reset(new OfflineStorageHandler(*this, *m_config, *m_taskDispatcher, sharedStorage, &m_memoryBudget));
 
 #if defined(STORE_SESSION_DB) && defined(HAVE_MAT_STORAGE)
         m_logSessionDataProvider.reset(new LogSessionDataProvider(m_offlineStorage.get()));
@@ -315,7 +342,7 @@ namespace MAT_NS_BEGIN
         {
             // Default mode is Common Schema - direct
             m_system.reset(new TelemetrySystem(*this, *m_config, *m_offlineStorage, *m_httpClient,
-                                               *m_taskDispatcher, m_bandwidthController, *m_logSessionDataProvider));
+                                               *m_taskDispatcher, m_bandwidthController, *m_logSessionDataProvider, m_pipelineLatency, m_transmitProfiles, m_memoryBudget));
         }
         LOG_TRACE("Telemetry system created, starting up...");
         if (m_system && !deferSystemStart)
@@ -340,6 +367,8 @@ namespace MAT_NS_BEGIN
     /// </summary>
     void LogManagerImpl::Configure()
     {
+        m_pipelineLatency.Configure(*m_config);
+        m_memoryBudget.Configure(*m_config);
         // TODO: [maxgolov] - add other config params.
 #ifdef HAVE_MAT_WININET_HTTP_CLIENT
         HttpClient_WinInet* client = static_cast<HttpClient_WinInet*>(m_httpClient.get());
@@ -380,6 +409,7 @@ namespace MAT_NS_BEGIN
                 // this waits until no active calls on this logger
                 kv.second->RecordShutdown();
             }
+            m_loggerRegistry.Clear();
             s_deadLoggers.AddMap(std::move(m_loggers));
 
             // Ensure that AddMap clears m_loggers (it does, it should continue to).
@@ -401,6 +431,7 @@ namespace MAT_NS_BEGIN
 
             m_httpClient = nullptr;
             m_taskDispatcher = nullptr;
+            m_sharedRuntime = nullptr;
             m_dataViewer = nullptr;
             m_dataInspector = nullptr;
 
@@ -458,7 +489,7 @@ namespace MAT_NS_BEGIN
     /// <param name="profile">Profile enum</param>
     status_t LogManagerImpl::SetTransmitProfile(TransmitProfile profile)
     {
-        bool result = TransmitProfiles::setDefaultProfile(profile);
+        bool result = m_transmitProfiles.setDefaultProfile(profile);
         return (result) ? STATUS_SUCCESS : STATUS_EFAIL;
     }
 
@@ -469,7 +500,7 @@ namespace MAT_NS_BEGIN
     status_t LogManagerImpl::SetTransmitProfile(const std::string& profile)
     {
         LOG_INFO("SetTransmitProfile: profile=%s", profile.c_str());
-        bool result = TransmitProfiles::setProfile(profile);
+        bool result = m_transmitProfiles.setProfile(profile);
         return (result) ? STATUS_SUCCESS : STATUS_EFAIL;
     }
 
@@ -481,14 +512,14 @@ namespace MAT_NS_BEGIN
     status_t LogManagerImpl::LoadTransmitProfiles(const std::string& profiles_json)
     {
         LOG_INFO("LoadTransmitProfiles");
-        bool result = TransmitProfiles::load(profiles_json);
+        bool result = m_transmitProfiles.load(profiles_json);
         return (result) ? STATUS_SUCCESS : STATUS_EFAIL;
     }
 
     status_t LogManagerImpl::LoadTransmitProfiles(const std::vector<TransmitProfileRules>& profiles) noexcept
     {
         LOG_INFO("LoadTransmitProfiles");
-        bool result = TransmitProfiles::load(profiles);
+        bool result = m_transmitProfiles.load(profiles);
         return (result) ? STATUS_SUCCESS : STATUS_EFAIL;
     }
 
@@ -498,13 +529,13 @@ namespace MAT_NS_BEGIN
     status_t LogManagerImpl::ResetTransmitProfiles()
     {
         LOG_INFO("ResetTransmitProfiles");
-        TransmitProfiles::reset();
+        m_transmitProfiles.reset();
         return STATUS_SUCCESS;
     }
 
     const std::string& LogManagerImpl::GetTransmitProfileName()
     {
-        return TransmitProfiles::getProfile();
+        return m_transmitProfiles.getProfile();
     };
 
     ISemanticContext& LogManagerImpl::GetSemanticContext()
@@ -621,38 +652,46 @@ namespace MAT_NS_BEGIN
 
     ILogger* LogManagerImpl::GetLogger(const std::string& tenantToken, const std::string& source, const std::string& scope)
     {
+        if (!m_alive)
+        {
+            return nullptr;
+        }
+
+        // Loggers created before are found without locking or allocating
+        Logger* logger = m_loggerRegistry.Find(tenantToken, source);
+        if (logger == nullptr)
         {
+            LOG_TRACE("GetLogger(tenantId=\"%s\", source=\"%s\")", tenantTokenToId(tenantToken).c_str(), source.c_str());
+
+            std::string normalizedTenantToken = toLower(tenantToken);
+            std::string normalizedSource = toLower(source);
+
             LOCKGUARD(m_lock);
             if (!m_alive)
             {
                 return nullptr;
             }
+            logger = m_loggerRegistry.Find(tenantToken, source);
+            if (logger == nullptr)
+            {
+                auto& entry = m_loggers[normalizedTenantToken + "/" + normalizedSource];
+                if (!entry)
+                {
+                    entry = std::make_unique<Logger>(
+                        normalizedTenantToken, normalizedSource, scope,
+                        *this, m_context, *m_config);
+                }
+                logger = entry.get();
+                m_loggerRegistry.Add(normalizedTenantToken, normalizedSource, logger);
+            }
         }
-        //
-        LOG_TRACE("GetLogger(tenantId=\"%s\", source=\"%s\")", tenantTokenToId(tenantToken).c_str(), source.c_str());
-
-        std::string normalizedTenantToken = toLower(tenantToken);
-        std::string normalizedSource = toLower(source);
-        std::string hash = normalizedTenantToken + "/" + normalizedSource;
 
-        LOCKGUARD(m_lock);
-        if (!m_alive)
-        {
-            return nullptr;
-        }
-        auto it = m_loggers.find(hash);
-        if (it == std::end(m_loggers))
-        {
-            m_loggers[hash] = std::make_unique<Logger>(
-                normalizedTenantToken, normalizedSource, scope,
-                *this, m_context, *m_config);
-        }
         uint8_t level = m_diagLevelFilter.GetDefaultLevel();
         if (level != DIAG_LEVEL_DEFAULT)
         {
-            m_loggers[hash]->SetLevel(level);
+            logger->SetLevel(level);
         }
-        return m_loggers[hash].get();
+        return logger;
     }
 
     /// <summary>
@@ -719,6 +758,34 @@ namespace MAT_NS_BEGIN
         }
     }
 
+    void LogManagerImpl::sendEvents(IncomingEventContextBatch const& events)
+    {
+        LOCKGUARD(m_lock);
+        if (GetSystem())
+        {
+            if (m_customDecorator)
+            {
+                for (auto const& event : events)
+                {
+                    m_customDecorator->decorate(*(event->source));
+                }
+            }
+
+            {
+                LOCKGUARD(m_dataInspectorGuard);
+
+                if (m_dataInspector)
+                {
+                    for (auto const& event : events)
+                    {
+                        m_dataInspector->InspectRecord(*(event->source));
+                    }
+                }
+            }
+            GetSystem()->sendEvents(events);
+        }
+    }
+
     ILogController* LogManagerImpl::GetLogController()
     {
         return this;
@@ -815,6 +882,18 @@ namespace MAT_NS_BEGIN
         return m_dataInspector;
     }
 
+    status_t LogManagerImpl::GetPipelineLatency(std::vector<PipelineStageLatency>& stages, bool reset)
+    {
+        m_pipelineLatency.GetLatencies(stages, reset);
+        return STATUS_SUCCESS;
+    }
+
+    status_t LogManagerImpl::GetMemoryUsage(MemoryUsage& usage)
+    {
+        m_memoryBudget.GetMemoryUsage(usage);
+        return STATUS_SUCCESS;
+    }
+
     status_t LogManagerImpl::DeleteData()
     {
 
@@ -28,9 +28,14 @@
 #include "filter/EventFilterCollection.hpp"
 
 #include "AllowedLevelsCollection.hpp"
+#include "LoggerRegistry.hpp"
 
 #include "IDataInspector.hpp"
 #include "offline/LogSessionDataProvider.hpp"
+#include "stats/PipelineLatencyRecorder.hpp"
+#include "system/MemoryBudget.hpp"
+#include "system/SharedRuntime.hpp"
+#include "TransmitProfiles.hpp"
 
 #include <mutex>
 #include <set>
@@ -122,8 +127,21 @@ namespace MAT_NS_BEGIN
         std::shared_ptr<IDecoratorModule> m_customDecorator;
 
         virtual void sendEvent(IncomingEventContextPtr const& event) = 0;
+
+        /// <summary>
+        /// Sends several events of the same logger call; by default one at a time.
+        /// </summary>
+        virtual void sendEvents(IncomingEventContextBatch const& events)
+        {
+            for (auto const& event : events)
+            {
+                sendEvent(event);
+            }
+        }
+
         virtual const ContextFieldsProvider& GetContext() = 0;
         virtual const DiagLevelFilter& GetLevelFilter() = 0;
+        virtual PipelineLatencyRecorder* GetPipelineLatencyRecorder() = 0;
     };
 
     class Logger;
@@ -272,6 +290,12 @@ namespace MAT_NS_BEGIN
         /// <param name="event">The event.</param>
         virtual void sendEvent(IncomingEventContextPtr const& event) override;
 
+        /// <summary>
+        /// Adds the incoming events, decorated and inspected under a single lock.
+        /// </summary>
+        /// <param name="events">The events.</param>
+        virtual void sendEvents(IncomingEventContextBatch const& events) override;
+
         void SetLevelFilter(uint8_t defaultLevel, uint8_t levelMin, uint8_t levelMax) override;
 
         void SetLevelFilter(uint8_t defaultLevel, const std::set<uint8_t>& allowedLevels) override;
@@ -300,6 +324,15 @@ namespace MAT_NS_BEGIN
 
         virtual std::shared_ptr<IDataInspector> GetDataInspector() noexcept override;
 
+        virtual status_t GetPipelineLatency(std::vector<PipelineStageLatency>& stages, bool reset = false) override;
+
+        virtual PipelineLatencyRecorder* GetPipelineLatencyRecorder() override
+        {
+            return &m_pipelineLatency;
+        }
+
+        virtual status_t GetMemoryUsage(MemoryUsage& usage) override;
+
        protected:
         std::unique_ptr<ITelemetrySystem>& GetSystem();
         void InitializeModules() noexcept;
@@ -310,8 +343,10 @@ namespace MAT_NS_BEGIN
         static DeadLoggers s_deadLoggers;
         std::recursive_mutex m_lock;
         LoggerMap m_loggers;
+        LoggerRegistry m_loggerRegistry;
         ContextFieldsProvider m_context;
 
+        std::shared_ptr<SharedRuntime> m_sharedRuntime;
         std::shared_ptr<IHttpClient> m_httpClient;
         std::shared_ptr<ITaskDispatcher> m_taskDispatcher;
         std::shared_ptr<IDataViewer> m_dataViewer;
@@ -324,12 +359,16 @@ namespace MAT_NS_BEGIN
 
         AuthTokensController m_authTokensController;
 
+        MemoryBudget m_memoryBudget;
+
         std::unique_ptr<IOfflineStorage> m_offlineStorage;
         std::unique_ptr<LogSessionDataProvider> m_logSessionDataProvider;
+        PipelineLatencyRecorder m_pipelineLatency;
+        TransmitProfiles m_transmitProfiles;
         bool m_isSystemStarted{};
         std::unique_ptr<ITelemetrySystem> m_system;
 
-        bool m_alive;
+        std::atomic<bool> m_alive { false };
 
         DebugEventSource m_debugEventSource;
         DiagLevelFilter m_diagLevelFilter;
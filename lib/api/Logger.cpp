@@ -7,6 +7,7 @@
 #include "CommonFields.h"
 #include "LogSessionData.hpp"
 #include "NullObjects.hpp"
+#include "system/ContextPools.hpp"
 #include "utils/Utils.hpp"
 
 #include <algorithm>
@@ -103,6 +104,10 @@ namespace MAT_NS_BEGIN
         m_iKey = "o:" + tenantId;
         m_allowDotsInType = m_config[CFG_MAP_COMPAT][CFG_BOOL_COMPAT_DOTS];
         m_resetSessionOnEnd = m_config[CFG_BOOL_SESSION_RESET_ENABLED];
+        m_sampler.Configure(m_config, tenantId, [this]() {
+            LogSessionData* sessionData = m_logManager.GetLogSessionData();
+            return (sessionData != nullptr) ? sessionData->getSessionSDKUid() : std::string();
+        });
 
         // Special scope "-" - means opt-out from parent context variables auto-capture.
         // It allows to detach the logger from its parent context.
@@ -239,14 +244,14 @@ namespace MAT_NS_BEGIN
         LOG_TRACE("%p: LogAppLifecycle(state=%u, properties.name=\"%s\", ...)",
                   this, state, properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
 
-        if (!CanEventPropertiesBeSent(properties))
+        if (!acceptEvent(properties))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
 
         const bool decorated =
             applyCommonDecorators(record, properties, latency) &&
@@ -295,30 +300,217 @@ namespace MAT_NS_BEGIN
         LOG_TRACE("%p: LogEvent(properties.name=\"%s\", ...)",
                   this, properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
 
-        if (!CanEventPropertiesBeSent(properties))
+        if (!acceptEvent(properties))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
+
         EventLatency latency = EventLatency_Normal;
+        if (!decorateCustomEvent(record, properties, latency))
+        {
+            return;
+        }
+
+        submit(record, properties);
+        DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_EVENT, size_t(latency), size_t(0), static_cast<void*>(&record), sizeof(record)));
+    }
+
+    /// <summary>
+    /// Applies the event filters and the sampler to an event.
+    /// </summary>
+    /// <returns>Whether the event is to be logged</returns>
+    bool Logger::acceptEvent(EventProperties const& properties)
+    {
+        if (!CanEventPropertiesBeSent(properties))
+        {
+            DispatchEvent(DebugEventType::EVT_FILTERED);
+            return false;
+        }
+        return sampleIn(properties.GetName());
+    }
+
+    /// <summary>
+    /// Applies the sampler to an event.
+    /// </summary>
+    /// <param name="eventName">Name of the event as given by the caller, the sampling key.</param>
+    /// <returns>Whether the event is kept on this device</returns>
+    bool Logger::sampleIn(std::string const& eventName)
+    {
+        if (!m_sampler.IsSampledIn(eventName))
+        {
+            DispatchEvent(DebugEventType::EVT_SAMPLED);
+            return false;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Scales the population sample of a sampled-in record by the rate it was sampled with.
+    /// </summary>
+    /// <param name="record">The decorated record.</param>
+    /// <param name="eventName">The key passed to sampleIn(), which is not always the record name.</param>
+    void Logger::applySampleRate(::CsProtocol::Record& record, std::string const& eventName)
+    {
+        if (m_sampler.IsEnabled())
+        {
+            // Each event kept at rate r% stands for 100/r events of the population
+            record.popSample = record.popSample * m_sampler.GetSampleRate(eventName) / EventSampler::FullSampleRate;
+        }
+    }
+
+    /// <summary>
+    /// Decorates the record of a custom event and computes its latency.
+    /// </summary>
+    bool Logger::decorateCustomEvent(::CsProtocol::Record& record, EventProperties const& properties, EventLatency& latency)
+    {
+        latency = EventLatency_Normal;
         if (properties.GetLatency() > EventLatency_Unspecified)
         {
             latency = properties.GetLatency();
         }
 
-        ::CsProtocol::Record record;
-
         if (!applyCommonDecorators(record, properties, latency))
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
                       "custom",
                       tenantTokenToId(m_tenantToken).c_str(),
                       properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Logs the events as one batch.
+    /// </summary>
+    /// <param name="events">The events.</param>
+    /// <param name="count">The number of events.</param>
+    void Logger::LogEvents(EventProperties const* events, size_t count)
+    {
+        ActiveLoggerCall active(*this);
+        if (active.LoggerIsDead() || events == nullptr || count == 0)
+        {
             return;
         }
 
-        submit(record, properties);
+        LOG_TRACE("%p: LogEvents(count=%u)", this, static_cast<unsigned>(count));
+
+        // Records and contexts come from the same pools as those of LogEvent
+        struct PreparedEvent
+        {
+            ObjectPool<::CsProtocol::Record>::Ptr  record;
+            ObjectPool<IncomingEventContext>::Ptr  context;
+            EventLatency                           latency;
+        };
+        std::vector<PreparedEvent> prepared;
+        prepared.reserve(count);
+        IncomingEventContextBatch batch;
+        batch.reserve(count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            EventProperties const& properties = events[i];
+            if (!acceptEvent(properties))
+            {
+                continue;
+            }
+
+            ObjectPool<::CsProtocol::Record>::Ptr record = ContextPools::Records().Acquire();
+            EventLatency latency = EventLatency_Normal;
+            if (!decorateCustomEvent(*record, properties, latency))
+            {
+                continue;
+            }
+
+            ObjectPool<IncomingEventContext>::Ptr context = prepareIncomingEvent(*record, properties.GetLatency(), properties.GetPersistence(),
+                properties.GetPolicyBitFlags(), getEventLevel(properties));
+            if (!context)
+            {
+                continue;
+            }
+
+            batch.push_back(context.get());
+            prepared.push_back(PreparedEvent { std::move(record), std::move(context), latency });
+        }
+
+        if (batch.empty())
+        {
+            return;
+        }
+
+        m_logManager.sendEvents(batch);
+
+        for (auto const& event : prepared)
+        {
+            DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_EVENT, size_t(event.latency), size_t(0), static_cast<void*>(event.record.get()), sizeof(*event.record)));
+        }
+    }
+
+    void ILogger::LogEvent(EventSchemaBase const& event)
+    {
+        LogEvent(event.ToEventProperties());
+    }
+
+    /// <summary>
+    /// Logs an event declared with EventSchema.
+    /// </summary>
+    /// <param name="event">The event.</param>
+    void Logger::LogEvent(EventSchemaBase const& event)
+    {
+        ActiveLoggerCall active(*this);
+        if (active.LoggerIsDead())
+        {
+            return;
+        }
+
+        LOG_TRACE("%p: LogEvent(schema.name=\"%s\", ...)", this, event.GetName().c_str());
+
+        // Filters only understand EventProperties: convert when any filter is registered
+        if (!m_filters.Empty() || !m_logManager.GetEventFilters().Empty())
+        {
+            if (!CanEventPropertiesBeSent(event.ToEventProperties()))
+            {
+                DispatchEvent(DebugEventType::EVT_FILTERED);
+                return;
+            }
+        }
+
+        if (!sampleIn(event.GetName()))
+        {
+            return;
+        }
+
+        EventLatency latency = EventLatency_Normal;
+        if (event.GetLatency() > EventLatency_Unspecified)
+        {
+            latency = event.GetLatency();
+        }
+
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
+        bool decorated = false;
+        {
+            PipelineLatencyTimer decorateTimer(m_logManager.GetPipelineLatencyRecorder(), PipelineStage_Decorate);
+            record.name = event.GetName();
+            record.baseType = EVENTRECORD_TYPE_CUSTOM_EVENT;
+            record.iKey = m_iKey;
+            decorated = m_baseDecorator.decorate(record) && m_semanticContextDecorator.decorate(record) && m_eventPropertiesDecorator.decorate(record, latency, event);
+        }
+
+        if (!decorated)
+        {
+            LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
+                      "schema",
+                      tenantTokenToId(m_tenantToken).c_str(),
+                      event.GetName().c_str());
+            return;
+        }
+        applySampleRate(record, event.GetName());
+
+        submitRecord(record, event.GetLatency(), event.GetPersistence(), event.GetPolicyBitFlags(), event.GetLevel());
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_EVENT, size_t(latency), size_t(0), static_cast<void*>(&record), sizeof(record)));
     }
 
@@ -347,14 +539,14 @@ namespace MAT_NS_BEGIN
         LOG_TRACE("%p: LogFailure(signature=\"%s\", properties.name=\"%s\", ...)",
                   this, signature.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
 
-        if (!CanEventPropertiesBeSent(properties))
+        if (!acceptEvent(properties))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
 
         const bool decorated =
             applyCommonDecorators(record, properties, latency) &&
@@ -398,14 +590,14 @@ namespace MAT_NS_BEGIN
         LOG_TRACE("%p: LogPageView(id=\"%s\", properties.name=\"%s\", ...)",
                   this, id.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
 
-        if (!CanEventPropertiesBeSent(properties))
+        if (!acceptEvent(properties))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
 
         const bool decorated =
             applyCommonDecorators(record, properties, latency) &&
@@ -452,14 +644,14 @@ namespace MAT_NS_BEGIN
         LOG_TRACE("%p: LogPageAction(pageActionData.actionType=%u, properties.name=\"%s\", ...)",
                   this, pageActionData.actionType, properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
 
-        if (!CanEventPropertiesBeSent(properties))
+        if (!acceptEvent(properties))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
 
         const bool decorated =
             applyCommonDecorators(record, properties, latency) &&
@@ -490,6 +682,7 @@ namespace MAT_NS_BEGIN
             return false;
         }
 
+        PipelineLatencyTimer decorateTimer(m_logManager.GetPipelineLatencyRecorder(), PipelineStage_Decorate);
         record.name = properties.GetName();
         record.baseType = EVENTRECORD_TYPE_CUSTOM_EVENT;
 
@@ -510,10 +703,44 @@ namespace MAT_NS_BEGIN
         }
         record.iKey = m_iKey;
 
-        return m_baseDecorator.decorate(record) && m_semanticContextDecorator.decorate(record) && m_eventPropertiesDecorator.decorate(record, latency, properties);
+        if (!(m_baseDecorator.decorate(record) && m_semanticContextDecorator.decorate(record) && m_eventPropertiesDecorator.decorate(record, latency, properties)))
+        {
+            return false;
+        }
+        applySampleRate(record, properties.GetName());
+        return true;
+    }
+
+    uint8_t Logger::getEventLevel(const EventProperties& props)
+    {
+        //
+        // Level policy:
+        // * get level from the COMMONFIELDS_EVENT_LEVEL property if set
+        // * if not set, then get level from the ILogger instance
+        // * if not set, then get level from the LogManager instance
+        // * if still not set (no default assigned at LogManager scope),
+        // then prefer to drop. This is user error: user set the range
+        // restrition, but didn't specify the defaults.
+        //
+        uint8_t level = m_level;
+        if (m_logManager.GetLevelFilter().IsLevelFilterEnabled())
+        {
+            const auto& m_props = props.GetProperties();
+            const auto it = m_props.find(COMMONFIELDS_EVENT_LEVEL);
+            if (it != m_props.cend())
+            {
+                level = static_cast<uint8_t>(it->second.as_int64);
+            }
+        }
+        return level;
     }
 
     void Logger::submit(::CsProtocol::Record& record, const EventProperties& props)
+    {
+        submitRecord(record, props.GetLatency(), props.GetPersistence(), props.GetPolicyBitFlags(), getEventLevel(props));
+    }
+
+    void Logger::submitRecord(::CsProtocol::Record& record, EventLatency latency, EventPersistence persistence, uint64_t policyBitFlags, uint8_t level)
     {
         ActiveLoggerCall active(*this);
         if (active.LoggerIsDead())
@@ -521,24 +748,37 @@ namespace MAT_NS_BEGIN
             return;
         }
 
-        const auto policyBitFlags = props.GetPolicyBitFlags();
-        const auto persistence = props.GetPersistence();
-        const auto latency = props.GetLatency();
+        ObjectPool<IncomingEventContext>::Ptr event = prepareIncomingEvent(record, latency, persistence, policyBitFlags, level);
+        if (event)
+        {
+            m_logManager.sendEvent(event.get());
+        }
+    }
+
+    ObjectPool<IncomingEventContext>::Ptr Logger::prepareIncomingEvent(::CsProtocol::Record& record, EventLatency latency, EventPersistence persistence, uint64_t policyBitFlags, uint8_t level)
+    {
+        if (!canRecordBeSubmitted(record, latency, level))
+        {
+            return ObjectPool<IncomingEventContext>::Ptr(nullptr, ObjectPool<IncomingEventContext>::Releaser(nullptr));
+        }
+
+        // Pooled, so that the id, token and blob buffers are reused
+        ObjectPool<IncomingEventContext>::Ptr event = ContextPools::IncomingEventContexts().Acquire();
+        // TODO: [MG] - check if optimization is possible in generateUuidString
+        event->record.id = PAL::generateUuidString();
+        event->record.tenantToken = m_tenantToken;
+        event->record.latency = latency;
+        event->record.persistence = persistence;
+        event->source = &record;
+        event->policyBitFlags = policyBitFlags;
+        return event;
+    }
+
+    bool Logger::canRecordBeSubmitted(::CsProtocol::Record& record, EventLatency latency, uint8_t level)
+    {
         auto levelFilter = m_logManager.GetLevelFilter();
         if (levelFilter.IsLevelFilterEnabled())
         {
-            const auto& m_props = props.GetProperties();
-            const auto it = m_props.find(COMMONFIELDS_EVENT_LEVEL);
-            //
-            // Level policy:
-            // * get level from the COMMONFIELDS_EVENT_LEVEL property if set
-            // * if not set, then get level from the ILogger instance
-            // * if not set, then get level from the LogManager instance
-            // * if still not set (no default assigned at LogManager scope),
-            // then prefer to drop. This is user error: user set the range
-            // restrition, but didn't specify the defaults.
-            //
-            uint8_t level = (it != m_props.cend()) ? static_cast<uint8_t>(it->second.as_int64) : m_level;
             if (level == DIAG_LEVEL_DEFAULT)
             {
                 level = levelFilter.GetDefaultLevel();
@@ -548,13 +788,13 @@ namespace MAT_NS_BEGIN
                     LOG_INFO("Event %s/%s dropped: no diagnostic level assigned!",
                              tenantTokenToId(m_tenantToken).c_str(), record.baseType.c_str());
                     DispatchEvent(DebugEventType::EVT_FILTERED);
-                    return;
+                    return false;
                 }
             }
             if (!levelFilter.IsLevelEnabled(level))
             {
                 DispatchEvent(DebugEventType::EVT_FILTERED);
-                return;
+                return false;
             }
         }
 
@@ -563,14 +803,9 @@ namespace MAT_NS_BEGIN
             DispatchEvent(DebugEventType::EVT_DROPPED);
             LOG_INFO("Event %s/%s dropped: calculated latency 0 (Off)",
                      tenantTokenToId(m_tenantToken).c_str(), record.baseType.c_str());
-            return;
+            return false;
         }
-
-        // TODO: [MG] - check if optimization is possible in generateUuidString
-        IncomingEventContext event(PAL::generateUuidString(), m_tenantToken, latency, persistence, &record);
-        event.policyBitFlags = policyBitFlags;
-
-        m_logManager.sendEvent(&event);
+        return true;
     }
 
     void Logger::onSubmitted()
@@ -602,14 +837,14 @@ namespace MAT_NS_BEGIN
         LOG_TRACE("%p: LogSampledMetric(name=\"%s\", properties.name=\"%s\", ...)",
                   this, name.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
 
-        if (!CanEventPropertiesBeSent(properties))
+        if (!acceptEvent(properties))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
 
         const bool decorated =
             applyCommonDecorators(record, properties, latency) &&
@@ -658,14 +893,14 @@ namespace MAT_NS_BEGIN
         LOG_TRACE("%p: LogAggregatedMetric(name=\"%s\", properties.name=\"%s\", ...)",
                   this, metricData.name.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
 
-        if (!CanEventPropertiesBeSent(properties))
+        if (!acceptEvent(properties))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
 
         const bool decorated =
             applyCommonDecorators(record, properties, latency) &&
@@ -696,14 +931,14 @@ namespace MAT_NS_BEGIN
         LOG_TRACE("%p: LogTrace(level=%u, properties.name=\"%s\", ...)",
                   this, level, properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
 
-        if (!CanEventPropertiesBeSent(properties))
+        if (!acceptEvent(properties))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
 
         bool decorated =
             applyCommonDecorators(record, properties, latency) &&
@@ -734,14 +969,14 @@ namespace MAT_NS_BEGIN
         LOG_TRACE("%p: LogUserState(state=%u, properties.name=\"%s\", ...)",
                   this, state, properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
 
-        if (!CanEventPropertiesBeSent(properties))
+        if (!acceptEvent(properties))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
 
         bool decorated =
             applyCommonDecorators(record, properties, latency) &&
@@ -772,9 +1007,8 @@ namespace MAT_NS_BEGIN
             return;
         }
 
-        if (!CanEventPropertiesBeSent(props))
+        if (!acceptEvent(props))
         {
-            DispatchEvent(DebugEventType::EVT_FILTERED);
             return;
         }
 
@@ -844,7 +1078,8 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_RealTime;
-        ::CsProtocol::Record record;
+        ObjectPool<::CsProtocol::Record>::Ptr pooledRecord = ContextPools::Records().Acquire();
+        ::CsProtocol::Record& record = *pooledRecord;
 
         bool decorated = applyCommonDecorators(record, props, latency) &&
                          m_semanticApiDecorators.decorateSessionMessage(record, state, m_sessionId, PAL::formatUtcTimestampMsAsISO8601(sessionFirstTime), sessionSDKUid, sessionDuration);
@@ -23,6 +23,9 @@
 #include "decorators/SemanticContextDecorator.hpp"
 
 #include "filter/EventFilterCollection.hpp"
+#include "filter/EventSampler.hpp"
+
+#include "utils/ObjectPool.hpp"
 
 namespace MAT_NS_BEGIN
 {
@@ -142,6 +145,12 @@ namespace MAT_NS_BEGIN
 
         virtual void LogEvent(EventProperties const& properties) override;
 
+        virtual void LogEvent(EventSchemaBase const& event) override;
+
+        using ILogger::LogEvents;
+
+        virtual void LogEvents(EventProperties const* events, size_t count) override;
+
         virtual void LogFailure(std::string const& signature,
                                 std::string const& detail,
                                 std::string const& category,
@@ -234,6 +243,38 @@ namespace MAT_NS_BEGIN
         virtual void
         submit(::CsProtocol::Record& record, const EventProperties& props);
 
+        void submitRecord(::CsProtocol::Record& record,
+                          EventLatency latency,
+                          EventPersistence persistence,
+                          uint64_t policyBitFlags,
+                          uint8_t level);
+
+        /// <summary>
+        /// Takes a pooled incoming event context for a decorated record,
+        /// or returns an empty pointer if the level filter or the latency drops the record.
+        /// </summary>
+        ObjectPool<IncomingEventContext>::Ptr prepareIncomingEvent(::CsProtocol::Record& record,
+                                                                   EventLatency latency,
+                                                                   EventPersistence persistence,
+                                                                   uint64_t policyBitFlags,
+                                                                   uint8_t level);
+
+        bool acceptEvent(EventProperties const& properties);
+
+        bool sampleIn(std::string const& eventName);
+
+        void applySampleRate(::CsProtocol::Record& record, std::string const& eventName);
+
+        bool decorateCustomEvent(::CsProtocol::Record& record,
+                                 EventProperties const& properties,
+                                 EventLatency& latency);
+
+        uint8_t getEventLevel(const EventProperties& props);
+
+        bool canRecordBeSubmitted(::CsProtocol::Record& record,
+                                  EventLatency latency,
+                                  uint8_t level);
+
         bool
         CanEventPropertiesBeSent(EventProperties const& properties) const noexcept;
 
@@ -248,7 +289,7 @@ namespace MAT_NS_BEGIN
         // "*"      - allows C API caller to attach their guest ILogger to parent's Host global context
         // "<id>"   - allows to rewire this ILogger to alternate semantic context
         std::string m_scope;
-        uint8_t m_level;
+        std::atomic<uint8_t> m_level;
 
         ILogManagerInternal& m_logManager;
         ContextFieldsProvider m_context;
@@ -265,6 +306,7 @@ namespace MAT_NS_BEGIN
         bool m_allowDotsInType;
         bool m_resetSessionOnEnd;
         EventFilterCollection m_filters;
+        EventSampler m_sampler;
 
         /// m_shutdown_mutex protects shut-down state
         mutable std::mutex m_shutdown_mutex;
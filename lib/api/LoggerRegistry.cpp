@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "LoggerRegistry.hpp"
+
+#include <ctype.h>
+#include <cstdint>
+
+namespace MAT_NS_BEGIN
+{
+    LoggerRegistry::Table::Table(size_t capacity) :
+        mask(capacity - 1),
+        count(0),
+        slots(new std::atomic<const Entry*>[capacity])
+    {
+        for (size_t i = 0; i < capacity; i++)
+        {
+            slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    LoggerRegistry::LoggerRegistry()
+    {
+        m_tables.emplace_back(new Table(InitialCapacity));
+        m_table.store(m_tables.back().get(), std::memory_order_release);
+    }
+
+    LoggerRegistry::~LoggerRegistry() noexcept
+    {
+    }
+
+    size_t LoggerRegistry::hashOf(const std::string& tenantToken, const std::string& source) noexcept
+    {
+        // FNV-1a of the lowercase "<tenantToken>/<source>"
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](unsigned char c)
+        {
+            hash ^= static_cast<unsigned char>(::tolower(c));
+            hash *= 1099511628211ULL;
+        };
+        for (char c : tenantToken)
+        {
+            mix(static_cast<unsigned char>(c));
+        }
+        mix('/');
+        for (char c : source)
+        {
+            mix(static_cast<unsigned char>(c));
+        }
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+
+    bool LoggerRegistry::equalsLowercase(const std::string& normalized, const std::string& value) noexcept
+    {
+        if (normalized.size() != value.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            if (normalized[i] != static_cast<char>(::tolower(static_cast<unsigned char>(value[i]))))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Logger* LoggerRegistry::Find(const std::string& tenantToken, const std::string& source) const noexcept
+    {
+        const Table* table = m_table.load(std::memory_order_acquire);
+        size_t hash = hashOf(tenantToken, source);
+        // Tables are never more than half full, so the probe always reaches an empty slot
+        for (size_t i = hash & table->mask;; i = (i + 1) & table->mask)
+        {
+            const Entry* entry = table->slots[i].load(std::memory_order_acquire);
+            if (entry == nullptr)
+            {
+                return nullptr;
+            }
+            if (entry->hash == hash && equalsLowercase(entry->tenantToken, tenantToken) && equalsLowercase(entry->source, source))
+            {
+                return entry->logger;
+            }
+        }
+    }
+
+    void LoggerRegistry::insert(Table& table, const Entry* entry) noexcept
+    {
+        size_t i = entry->hash & table.mask;
+        while (table.slots[i].load(std::memory_order_relaxed) != nullptr)
+        {
+            i = (i + 1) & table.mask;
+        }
+        table.slots[i].store(entry, std::memory_order_release);
+        table.count++;
+    }
+
+    void LoggerRegistry::Add(const std::string& normalizedTenantToken, const std::string& normalizedSource, Logger* logger)
+    {
+        m_entries.emplace_back(new Entry { hashOf(normalizedTenantToken, normalizedSource), normalizedTenantToken, normalizedSource, logger });
+        const Entry* entry = m_entries.back().get();
+
+        Table* table = m_table.load(std::memory_order_relaxed);
+        if ((table->count + 1) * 2 > table->mask + 1)
+        {
+            // Readers keep probing the current table until the larger one is published
+            std::unique_ptr<Table> grown(new Table((table->mask + 1) * 2));
+            for (size_t i = 0; i <= table->mask; i++)
+            {
+                const Entry* existing = table->slots[i].load(std::memory_order_relaxed);
+                if (existing != nullptr)
+                {
+                    insert(*grown, existing);
+                }
+            }
+            insert(*grown, entry);
+            m_tables.push_back(std::move(grown));
+            m_table.store(m_tables.back().get(), std::memory_order_release);
+            return;
+        }
+        insert(*table, entry);
+    }
+
+    void LoggerRegistry::Clear()
+    {
+        m_tables.emplace_back(new Table(InitialCapacity));
+        m_table.store(m_tables.back().get(), std::memory_order_release);
+    }
+
+} MAT_NS_END
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef LOGGERREGISTRY_HPP
+#define LOGGERREGISTRY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Version.hpp"
+#include "ctmacros.hpp"
+
+namespace MAT_NS_BEGIN
+{
+    class Logger;
+
+    /// <summary>
+    /// Read-optimized index of the loggers of a LogManager, by tenant token and source.
+    ///
+    /// Lookups take no locks and allocate nothing: keys are hashed and compared case-insensitively
+    /// in place, against an open-addressing table published through an atomic pointer. Writers must
+    /// be serialized by the caller. A full table is replaced by one twice as large; replaced tables
+    /// and entries are kept until the registry is destroyed, since readers may still be probing them.
+    /// </summary>
+    class LoggerRegistry
+    {
+    public:
+        LoggerRegistry();
+        ~LoggerRegistry() noexcept;
+
+        LoggerRegistry(const LoggerRegistry&) = delete;
+        LoggerRegistry& operator=(const LoggerRegistry&) = delete;
+
+        /// <summary>
+        /// Logger registered for the tenant token and source, ignoring case, or nullptr.
+        /// </summary>
+        Logger* Find(const std::string& tenantToken, const std::string& source) const noexcept;
+
+        /// <summary>
+        /// Registers a logger under lowercase tenant token and source. Not thread-safe.
+        /// </summary>
+        void Add(const std::string& normalizedTenantToken, const std::string& normalizedSource, Logger* logger);
+
+        /// <summary>
+        /// Removes all the loggers. Not thread-safe.
+        /// </summary>
+        void Clear();
+
+    protected:
+        struct Entry
+        {
+            size_t      hash;
+            std::string tenantToken;
+            std::string source;
+            Logger*     logger;
+        };
+
+        struct Table
+        {
+            explicit Table(size_t capacity);
+
+            size_t                                      mask;
+            size_t                                      count;
+            std::unique_ptr<std::atomic<const Entry*>[]> slots;
+        };
+
+        static const size_t InitialCapacity = 16;
+
+        static size_t hashOf(const std::string& tenantToken, const std::string& source) noexcept;
+        static bool equalsLowercase(const std::string& normalized, const std::string& value) noexcept;
+        static void insert(Table& table, const Entry* entry) noexcept;
+
+        std::atomic<Table*>                 m_table;
+        std::vector<std::unique_ptr<Table>> m_tables;
+        std::vector<std::unique_ptr<Entry>> m_entries;
+    };
+
+} MAT_NS_END
+
+#endif // LOGGERREGISTRY_HPP
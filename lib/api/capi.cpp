@@ -16,9 +16,11 @@
 
 #include "CommonFields.h"
 
+#include <algorithm>
 #include <mutex>
 #include <map>
 #include <cstdint>
+#include <vector>
 
 static const char * libSemver = TELEMETRY_EVENTS_VERSION;
 
@@ -161,6 +163,27 @@ evt_status_t mat_open_core(
         }
     }
 
+    // Privacy feature for OTEL C API client:
+    //
+    // C API customer that does not explicitly pass down JSON
+    //   config["config]["scope"] = COMMONFIELDS_SCOPE_ALL;
+    //
+    // should not be able to capture the host's context vars.
+    clients[code].scope = CONTEXT_SCOPE_NONE;
+    {
+        MAT::VariantMap &config_map = clients[code].config[CFG_MAP_FACTORY_CONFIG];
+        const auto & it = config_map.find(CFG_STR_CONTEXT_SCOPE);
+        if (it != config_map.cend())
+        {
+            clients[code].scope = static_cast<const char *>(it->second);
+            // Specifying "*" in JSON config allows Guest C API logger to capture Host context variables
+            if (clients[code].scope == CONTEXT_SCOPE_ALL)
+            {
+                clients[code].scope = CONTEXT_SCOPE_EMPTY;
+            }
+        }
+    }
+
     status_t status = static_cast<status_t>(EFAULT);
     clients[code].logmanager = LogManagerProvider::CreateLogManager(clients[code].config, status);
 
@@ -229,6 +252,81 @@ evt_status_t mat_open_with_params(evt_context_t *ctx)
     return mat_open_core(ctx, data->config, httpSendFn, httpCancelFn, taskDispatcherQueueFn, taskDispatcherCancelFn, taskDispatcherJoinFn);
 }
 
+/// <summary>
+/// Resolve the logger of a token and source, asking the LogManager only the first time.
+/// </summary>
+static ILogger* get_logger(capi_client* client, const std::string& token, const std::string& source)
+{
+    LOCKGUARD(client->loggersLock);
+    auto key = std::make_pair(token, source);
+    const auto it = client->loggers.find(key);
+    if (it != client->loggers.cend())
+    {
+        return it->second;
+    }
+    ILogger* logger = client->logmanager->GetLogger(token, source, client->scope);
+    if (logger != nullptr)
+    {
+        // Detach from the host context once, rather than on every event
+        logger->SetParentContext(nullptr);
+        client->loggers[key] = logger;
+    }
+    return logger;
+}
+
+/// <summary>
+/// Convert from logger handle returned by EVT_OP_GET_LOGGER to ILogger.
+/// </summary>
+static ILogger* get_logger(capi_client* client, evt_handle_t handle)
+{
+    LOCKGUARD(client->loggersLock);
+    if ((handle <= 0) || (static_cast<uint64_t>(handle) > client->loggerHandles.size()))
+    {
+        return nullptr;
+    }
+    return client->loggerHandles[static_cast<size_t>(handle - 1)];
+}
+
+/// <summary>
+/// Resolve the logger of unpacked event properties: the given logger, or the logger of its iKey if none.
+/// </summary>
+static ILogger* resolve_logger(capi_client* client, ILogger* logger, EventProperties& props)
+{
+    const auto& m = props.GetProperties();
+    if (logger == nullptr)
+    {
+        std::string token;
+        const auto & ikey = m.find(COMMONFIELDS_IKEY);
+        if ((ikey != m.cend()) && (ikey->second.type == EventProperty::TYPE_STRING))
+        {
+            token = ikey->second.as_string;
+        }
+        const auto & it = m.find(COMMONFIELDS_EVENT_SOURCE);
+        std::string source = ((it != m.cend()) && (it->second.type == EventProperty::TYPE_STRING)) ? it->second.as_string : "";
+        logger = get_logger(client, token, source);
+        if (logger == nullptr)
+        {
+            return nullptr;
+        }
+    }
+    props.erase(COMMONFIELDS_IKEY);
+    return logger;
+}
+
+/// <summary>
+/// Log unpacked event properties with the given logger, or with the logger of its iKey if none.
+/// </summary>
+static evt_status_t log_event(capi_client* client, ILogger* logger, EventProperties& props)
+{
+    logger = resolve_logger(client, logger, props);
+    if (logger == nullptr)
+    {
+        return EFAULT; /* invalid address */
+    }
+    logger->LogEvent(props);
+    return EOK;
+}
+
 /**
  * Marashal C struct to C++ API
  */
@@ -236,52 +334,105 @@ evt_status_t mat_log(evt_context_t *ctx)
 {
     VERIFY_CLIENT_HANDLE(client, ctx);
 
-    ILogConfiguration & config = client->config;
     evt_prop *evt = static_cast<evt_prop*>(ctx->data);
     EventProperties props;
     props.unpack(evt, ctx->size);
 
-    auto m = props.GetProperties();
-    EventProperty &prop = m[COMMONFIELDS_IKEY];
-    std::string token = prop.as_string;
-    props.erase(COMMONFIELDS_IKEY);
+    ctx->result = log_event(client, nullptr, props);
+    return ctx->result;
+}
 
-    // Privacy feature for OTEL C API client:
-    //
-    // C API customer that does not explicitly pass down JSON
-    //   config["config]["scope"] = COMMONFIELDS_SCOPE_ALL;
-    //
-    // should not be able to capture the host's context vars.
-    std::string scope = CONTEXT_SCOPE_NONE;
+evt_status_t mat_get_logger(evt_context_t *ctx)
+{
+    VERIFY_CLIENT_HANDLE(client, ctx);
+
+    evt_logger_data_t *data = static_cast<evt_logger_data_t*>(ctx->data);
+    if (data == nullptr)
     {
-        MAT::VariantMap &config_map = config[CFG_MAP_FACTORY_CONFIG];
-        const auto & it = config_map.find(CFG_STR_CONTEXT_SCOPE);
-        if (it != config_map.cend())
+        return EFAULT;
+    }
+
+    const char *token = data->token;
+    if (token == nullptr)
+    {
+        token = client->config[CFG_STR_PRIMARY_TOKEN];
+    }
+    std::string source = (data->source != nullptr) ? data->source : "";
+    ILogger *logger = (token != nullptr) ? get_logger(client, token, source) : nullptr;
+    if (logger == nullptr)
+    {
+        data->logger = 0;
+        ctx->result = EFAULT;
+        return ctx->result;
+    }
+
+    {
+        LOCKGUARD(client->loggersLock);
+        auto& handles = client->loggerHandles;
+        auto it = std::find(handles.begin(), handles.end(), logger);
+        if (it == handles.end())
         {
-            scope = static_cast<const char *>(it->second);
-            // Specifying "*" in JSON config allows Guest C API logger to capture Host context variables
-            if (scope == CONTEXT_SCOPE_ALL)
-            {
-                scope = CONTEXT_SCOPE_EMPTY;
-            }
+            it = handles.insert(handles.end(), logger);
         }
+        data->logger = static_cast<evt_handle_t>(it - handles.begin()) + 1;
     }
+    ctx->result = EOK;
+    return ctx->result;
+}
 
-    const auto & it = m.find(COMMONFIELDS_EVENT_SOURCE);
-    std::string source = ((it != m.cend()) && (it->second.type == EventProperty::TYPE_STRING)) ? it->second.as_string : "";
+evt_status_t mat_log_batch(evt_context_t *ctx)
+{
+    VERIFY_CLIENT_HANDLE(client, ctx);
 
-    ILogger *logger = client->logmanager->GetLogger(token, source, scope);
-    if (logger == nullptr)
+    const evt_log_batch_data_t *data = static_cast<evt_log_batch_data_t*>(ctx->data);
+    ctx->size = 0;
+    if ((data == nullptr) || ((data->events == nullptr) && (data->count != 0)))
     {
-        ctx->result = EFAULT; /* invalid address */
+        return EFAULT;
     }
-    else
+
+    ILogger *logger = nullptr;
+    if (data->logger != 0)
     {
-        logger->SetParentContext(nullptr);
-        logger->LogEvent(props);
-        ctx->result = EOK;
+        logger = get_logger(client, data->logger);
+        if (logger == nullptr)
+        {
+            return ENOENT;
+        }
     }
-    return ctx->result;
+
+    evt_status_t result = EOK;
+    std::vector<EventProperties> events(data->count);
+    std::vector<ILogger*> loggers(data->count);
+    for (uint32_t i = 0; i < data->count; i++)
+    {
+        const evt_batch_item_t& item = data->events[i];
+        events[i].unpack(item.props, item.size);
+        loggers[i] = resolve_logger(client, logger, events[i]);
+        if ((loggers[i] == nullptr) && (result == EOK))
+        {
+            result = EFAULT; /* invalid address */
+        }
+    }
+
+    // Each run of events that go to the same logger is logged as one batch
+    uint32_t start = 0;
+    while (start < data->count)
+    {
+        uint32_t end = start + 1;
+        while ((end < data->count) && (loggers[end] == loggers[start]))
+        {
+            end++;
+        }
+        if (loggers[start] != nullptr)
+        {
+            loggers[start]->LogEvents(events.data() + start, end - start);
+            ctx->size += end - start;
+        }
+        start = end;
+    }
+    ctx->result = result;
+    return result;
 }
 
 evt_status_t mat_close(evt_context_t *ctx)
@@ -377,6 +528,14 @@ extern "C" {
                 result = mat_log(ctx);
                 break;
 
+            case EVT_OP_GET_LOGGER:
+                result = mat_get_logger(ctx);
+                break;
+
+            case EVT_OP_LOG_BATCH:
+                result = mat_log_batch(ctx);
+                break;
+
             case EVT_OP_PAUSE:
                 result = mat_pause(ctx);
                 break;
@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "utils/annex_k.hpp"
+#include "generated/BondConstTypes.hpp"
 
 namespace bond_lite {
 
@@ -18,15 +19,34 @@ namespace bond_lite {
 // https://github.com/Microsoft/bond/blob/master/cpp/inc/bond/protocol/compact_binary.h
 // https://github.com/Microsoft/bond/blob/master/cs/src/core/protocols/CompactBinary.cs
 
+// The reader never copies its input: besides the usual Read*() methods filling owned values,
+// ReadStringView(), ReadBlobView() and Skip() give access to the data in place. Views point into
+// the input buffer and stay valid only as long as it does.
+// After a failed read, IsTruncated() tells input ending early from malformed input.
 class CompactBinaryProtocolReader {
   protected:
-    std::vector<uint8_t> const& m_input;
+    uint8_t const* m_input;
+    size_t m_size;
     size_t m_ofs;
+    bool m_truncated;
+
+    // Nesting allowed by Skip(), so that malformed input cannot exhaust the stack
+    static const unsigned MaxSkipDepth = 64;
 
   public:
     CompactBinaryProtocolReader(std::vector<uint8_t> const& input)
+      : m_input(input.data()),
+        m_size(input.size()),
+        m_ofs(0),
+        m_truncated(false)
+    {
+    }
+
+    CompactBinaryProtocolReader(uint8_t const* input, size_t size)
       : m_input(input),
-        m_ofs(0)
+        m_size(size),
+        m_ofs(0),
+        m_truncated(false)
     {
     }
 
@@ -35,7 +55,21 @@ class CompactBinaryProtocolReader {
         return m_ofs;
     }
 
+    bool IsTruncated() const
+    {
+        return m_truncated;
+    }
+
   protected:
+    bool hasBytes(size_t size)
+    {
+        if (size > m_size - m_ofs) {
+            m_truncated = true;
+            return false;
+        }
+        return true;
+    }
+
     template<typename T>
     bool readVarint(T& value)
     {
@@ -60,20 +94,20 @@ class CompactBinaryProtocolReader {
   public:
     bool ReadBlob(_Out_writes_bytes_ (size) void* data, size_t size)
     {
-        if (size > (m_input.size() - m_ofs)) {
+        if (!hasBytes(size)) {
             return false;
         }
         if ((data == nullptr) || (size == 0)) {
             return false;
         }
-        bool result = (memcpy_s(static_cast<uint8_t*>(data), size, &(m_input[m_ofs]), size) == 0);
+        bool result = (memcpy_s(static_cast<uint8_t*>(data), size, m_input + m_ofs, size) == 0);
         m_ofs += size;
         return result;
     }
 
     bool ReadBool(bool& value)
     {
-        if (1 > m_input.size() - m_ofs) {
+        if (!hasBytes(1)) {
             return false;
         }
         switch (m_input[m_ofs]) {
@@ -94,7 +128,7 @@ class CompactBinaryProtocolReader {
 
     bool ReadUInt8(uint8_t& value)
     {
-        if (1 > m_input.size() - m_ofs) {
+        if (!hasBytes(1)) {
             return false;
         }
         value = m_input[m_ofs];
@@ -177,14 +211,39 @@ class CompactBinaryProtocolReader {
         if (!ReadUInt32(length)) {
             return false;
         }
-        if (length > m_input.size() - m_ofs) {
+        if (!hasBytes(length)) {
+            return false;
+        }
+        value.assign(reinterpret_cast<char const*>(m_input + m_ofs), length);
+        m_ofs += length;
+        return true;
+    }
+
+    bool ReadStringView(char const*& data, size_t& size)
+    {
+        uint32_t length;
+        if (!ReadUInt32(length)) {
+            return false;
+        }
+        if (!hasBytes(length)) {
             return false;
         }
-        value.assign(reinterpret_cast<char const*>(&m_input[m_ofs]), length);
+        data = reinterpret_cast<char const*>(m_input + m_ofs);
+        size = length;
         m_ofs += length;
         return true;
     }
 
+    bool ReadBlobView(uint8_t const*& data, size_t size)
+    {
+        if (!hasBytes(size)) {
+            return false;
+        }
+        data = m_input + m_ofs;
+        m_ofs += size;
+        return true;
+    }
+
     bool ReadWString(std::string const& value)
     {
         UNREFERENCED_PARAMETER(value);
@@ -192,7 +251,8 @@ class CompactBinaryProtocolReader {
         if (!ReadUInt32(length)) {
             return false;
         }
-        if (length > (m_input.size() - m_ofs) / 2) {
+        if (length > (m_size - m_ofs) / 2) {
+            m_truncated = true;
             return false;
         }
         // TODO: Read with 16-bits per character (as UTF-16?)
@@ -268,6 +328,118 @@ class CompactBinaryProtocolReader {
 		UNREFERENCED_PARAMETER(isBase);
         return true;
     }
+
+    // Moves past a value of the given type without decoding it; a struct is skipped up to and
+    // including its BT_STOP, base classes included.
+    bool Skip(uint8_t type)
+    {
+        return skip(type, 0);
+    }
+
+  protected:
+    bool skipBytes(size_t size)
+    {
+        if (!hasBytes(size)) {
+            return false;
+        }
+        m_ofs += size;
+        return true;
+    }
+
+    bool skip(uint8_t type, unsigned depth)
+    {
+        if (depth > MaxSkipDepth) {
+            return false;
+        }
+
+        switch (type) {
+            case BT_BOOL:
+            case BT_UINT8:
+            case BT_INT8:
+                return skipBytes(1);
+
+            case BT_UINT16:
+            case BT_UINT32:
+            case BT_UINT64:
+            case BT_INT16:
+            case BT_INT32:
+            case BT_INT64: {
+                uint64_t value;
+                return readVarint(value);
+            }
+
+            case BT_FLOAT:
+                return skipBytes(4);
+
+            case BT_DOUBLE:
+                return skipBytes(8);
+
+            case BT_STRING: {
+                uint32_t length;
+                return ReadUInt32(length) && skipBytes(length);
+            }
+
+            case BT_WSTRING: {
+                uint32_t length;
+                if (!ReadUInt32(length)) {
+                    return false;
+                }
+                if (length > (m_size - m_ofs) / 2) {
+                    m_truncated = true;
+                    return false;
+                }
+                return skipBytes(size_t(length) * 2);
+            }
+
+            case BT_STRUCT: {
+                for (;;) {
+                    uint8_t fieldType;
+                    uint16_t id;
+                    if (!ReadFieldBegin(fieldType, id)) {
+                        return false;
+                    }
+                    if (fieldType == BT_STOP) {
+                        return true;
+                    }
+                    if (fieldType != BT_STOP_BASE && !skip(fieldType, depth + 1)) {
+                        return false;
+                    }
+                }
+            }
+
+            case BT_LIST:
+            case BT_SET: {
+                uint32_t size;
+                uint8_t elementType;
+                if (!ReadContainerBegin(size, elementType)) {
+                    return false;
+                }
+                for (uint32_t i = 0; i < size; i++) {
+                    if (!skip(elementType, depth + 1)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            case BT_MAP: {
+                uint32_t size;
+                uint8_t keyType, valueType;
+                if (!ReadMapContainerBegin(size, keyType, valueType)) {
+                    return false;
+                }
+                for (uint32_t i = 0; i < size; i++) {
+                    if (!skip(keyType, depth + 1) || !skip(valueType, depth + 1)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            default:
+                return false;
+        }
+    }
 };
 
 } // namespace bond_lite
@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "TokenBucketBandwidthController.hpp"
+
+#include <algorithm>
+
+namespace MAT_NS_BEGIN {
+
+TokenBucketBandwidthController::TokenBucketBandwidthController(unsigned rateBps, unsigned burstBytes) :
+    m_rateBps(rateBps),
+    m_burstBytes((std::max)(burstBytes, rateBps)),
+    m_tokens(1000 * static_cast<int64_t>(m_burstBytes)),
+    m_lastRefillMs(0)
+{
+}
+
+TokenBucketBandwidthController::~TokenBucketBandwidthController()
+{
+}
+
+uint64_t TokenBucketBandwidthController::getMonotonicTimeMs()
+{
+    return PAL::getMonotonicTimeMs();
+}
+
+void TokenBucketBandwidthController::refill()
+{
+    uint64_t now = getMonotonicTimeMs();
+    if (!m_started)
+    {
+        m_started = true;
+        m_lastRefillMs = now;
+        return;
+    }
+    if (now <= m_lastRefillMs)
+    {
+        return;
+    }
+    int64_t capacity = 1000 * static_cast<int64_t>(m_burstBytes);
+    uint64_t elapsedMs = now - m_lastRefillMs;
+    m_lastRefillMs = now;
+    if (m_rateBps == 0 || m_tokens >= capacity)
+    {
+        return;
+    }
+    // Compare durations rather than token counts, which could overflow after a long idle time
+    uint64_t fillMs = static_cast<uint64_t>(capacity - m_tokens) / m_rateBps;
+    m_tokens = (elapsedMs >= fillMs) ? capacity : m_tokens + static_cast<int64_t>(elapsedMs) * m_rateBps;
+}
+
+unsigned TokenBucketBandwidthController::GetProposedBandwidthBps()
+{
+    return m_rateBps;
+}
+
+unsigned TokenBucketBandwidthController::GetAvailableBytes()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    refill();
+    return (m_tokens > 0) ? static_cast<unsigned>(m_tokens / 1000) : 0;
+}
+
+void TokenBucketBandwidthController::OnBytesUploaded(unsigned bytes)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    refill();
+    m_tokens -= 1000 * static_cast<int64_t>(bytes);
+}
+
+} MAT_NS_END
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef TOKENBUCKETBANDWIDTHCONTROLLER_HPP
+#define TOKENBUCKETBANDWIDTHCONTROLLER_HPP
+
+#include "IBandwidthController.hpp"
+#include "pal/PAL.hpp"
+
+#include <cstdint>
+#include <mutex>
+
+namespace MAT_NS_BEGIN {
+
+/// <summary>
+/// Portable bandwidth controller enforcing a byte budget with a token bucket.
+///
+/// The bucket starts full and is refilled at the configured rate, up to the burst
+/// size. Uploaded requests are taken out of it; a request larger than the tokens
+/// left puts the bucket into debt, which postpones the next upload accordingly.
+/// </summary>
+class TokenBucketBandwidthController : public IBandwidthController
+{
+  public:
+    /// <summary>
+    /// Creates a token bucket.
+    /// </summary>
+    /// <param name="rateBps">Refill rate in bytes per second</param>
+    /// <param name="burstBytes">Bucket size in bytes, at least one second worth of rate</param>
+    TokenBucketBandwidthController(unsigned rateBps, unsigned burstBytes);
+    virtual ~TokenBucketBandwidthController();
+
+    virtual unsigned GetProposedBandwidthBps() override;
+    virtual unsigned GetAvailableBytes() override;
+    virtual void OnBytesUploaded(unsigned bytes) override;
+
+  protected:
+    virtual uint64_t getMonotonicTimeMs();
+    void refill();
+
+    std::mutex m_lock;
+    unsigned   m_rateBps;
+    unsigned   m_burstBytes;
+    // Tokens are counted in thousandths of a byte, so that each elapsed millisecond adds exactly m_rateBps
+    int64_t    m_tokens;
+    uint64_t   m_lastRefillMs;
+    bool       m_started { false };
+};
+
+} MAT_NS_END
+
+#endif
@@ -87,6 +87,7 @@ namespace MAT_NS_BEGIN {
 
         ctx->body.resize(stream.total_out);
         ctx->compressed = true;
+        ctx->packagingMemory.Set(MemoryBudget::GetHeapSize(ctx->body));
 #endif
         return true;
     }
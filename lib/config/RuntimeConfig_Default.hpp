@@ -14,9 +14,13 @@ namespace MAT_NS_BEGIN
         {CFG_INT_SDK_MODE, SdkModeTypes::SdkModeTypes_CS},
         {CFG_BOOL_ENABLE_ANALYTICS, false},
         {CFG_INT_CACHE_FILE_SIZE, 3145728},
+        {CFG_STR_OFFLINE_STORAGE_TYPE, "sqlite"},
+        {CFG_INT_STORAGE_SEGMENT_SIZE, 262144},
         {CFG_INT_RAM_QUEUE_SIZE, 524288},
+        {CFG_INT_MEMORY_BUDGET, 0},
         {CFG_BOOL_ENABLE_MULTITENANT, true},
         {CFG_BOOL_ENABLE_DB_DROP_IF_FULL, false},
+        {CFG_BOOL_ENABLE_CRC32, false},
         {CFG_INT_MAX_TEARDOWN_TIME, 1},
         {CFG_INT_MAX_PENDING_REQ, 4},
         {CFG_INT_RAM_QUEUE_BUFFERS, 3},
@@ -62,6 +66,13 @@ namespace MAT_NS_BEGIN
              {CFG_INT_TPM_MAX_RETRY, 5},
              {CFG_BOOL_TPM_CLOCK_SKEW_ENABLED, true},
              {CFG_STR_TPM_BACKOFF, "E,3000,300000,2,1"},
+             {CFG_INT_TPM_BANDWIDTH_BPS, 0},
+             {CFG_INT_TPM_BANDWIDTH_BURST_BYTES, 0},
+         }},
+        {CFG_MAP_PIPELINE_LATENCY,
+         {
+             {CFG_BOOL_PIPELINE_LATENCY_ENABLED, true},
+             {CFG_BOOL_PIPELINE_LATENCY_DEBUG_EVENTS, false},
          }},
         {CFG_MAP_COMPAT,
          {
@@ -6,7 +6,10 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cinttypes>
+#include <cstdio>
 #include <fstream>
+#include <functional>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -27,7 +30,6 @@
 #include "bond/All.hpp"
 #include "CsProtocol_types.hpp"
 #include "bond/generated/CsProtocol_readers.hpp"
-#include "utils/ZlibUtils.hpp"
 
 #include "zlib.h"
 #undef compress
@@ -41,71 +43,1119 @@ namespace clienttelemetry {
 
             void to_json(json& j, const Record& r);
 
-            std::vector<Record> decodeRequest(const std::vector<uint8_t>& request)
+            /// <summary>
+            /// What the consumer of a serialized record did with it.
+            /// </summary>
+            enum class RecordResult
             {
-                std::vector<Record> v;
-                size_t i = 0;
-                size_t length = 0;
-                while (i < request.size())
+                Decoded,    // Decoded, decoding goes on
+                Stopped,    // Decoded, decoding ends
+                Malformed   // Not decodable, skipped
+            };
+
+            /// <summary>
+            /// Incremental decoder of a request body: records are framed in place with
+            /// CompactBinaryProtocolReader::Skip as soon as their last byte is available and handed
+            /// to the consumer one at a time, still serialized, so that only the current partial
+            /// record is buffered. Input that cannot be framed fails the whole request.
+            /// </summary>
+            class RequestDecoder
+            {
+            public:
+                // Largest record the decoder waits for before declaring the input malformed
+                static const size_t MaxRecordSize = 64 * 1024 * 1024;
+
+                using RecordHandler = std::function<RecordResult(const uint8_t* data, size_t size)>;
+
+                RequestDecoder(bool compressed, RecordHandler const& onRecord) :
+                    m_compressed(compressed),
+                    m_onRecord(onRecord),
+                    m_streamEnd(!compressed),
+                    m_stopped(false),
+                    m_failed(false),
+                    m_recordCount(0),
+                    m_errorCount(0)
+                {
+                    memset(&m_zs, 0, sizeof(m_zs));
+                    if (m_compressed && (inflateInit2(&m_zs, -MAX_WBITS) != Z_OK))
+                    {
+                        TEST_LOG_ERROR("Failed to initialize inflate");
+                        m_compressed = false;
+                        m_failed = true;
+                    }
+                }
+
+                ~RequestDecoder()
+                {
+                    if (m_compressed)
+                    {
+                        inflateEnd(&m_zs);
+                    }
+                }
+
+                /// <summary>
+                /// Feeds the next chunk of the request body, returns false once decoding cannot go on.
+                /// </summary>
+                bool Write(const uint8_t* data, size_t size)
+                {
+                    if (m_failed || m_stopped)
+                    {
+                        return false;
+                    }
+                    if (m_compressed)
+                    {
+                        return inflateChunk(data, size);
+                    }
+                    if (m_pending.empty())
+                    {
+                        // Nothing buffered: decode straight from the caller's buffer
+                        size_t consumed = decodeRecords(data, size);
+                        if (!m_failed && !m_stopped && (consumed < size))
+                        {
+                            m_pending.assign(data + consumed, data + size);
+                        }
+                        return !m_failed && !m_stopped;
+                    }
+                    m_pending.insert(m_pending.end(), data, data + size);
+                    return decodePending();
+                }
+
+                /// <summary>
+                /// Returns true if the whole body was consumed and every record in it was decoded.
+                /// </summary>
+                bool Finish()
+                {
+                    if (m_failed || m_stopped)
+                    {
+                        return !m_failed;
+                    }
+                    if (!m_streamEnd)
+                    {
+                        TEST_LOG_ERROR("Compressed request is truncated");
+                        return false;
+                    }
+                    if (!m_pending.empty())
+                    {
+                        TEST_LOG_ERROR("Deserialization failed: %zu trailing bytes", m_pending.size());
+                        return false;
+                    }
+                    return (m_errorCount == 0);
+                }
+
+                size_t RecordCount() const
+                {
+                    return m_recordCount;
+                }
+
+                size_t ErrorCount() const
+                {
+                    return m_errorCount;
+                }
+
+            protected:
+                bool inflateChunk(const uint8_t* data, size_t size)
+                {
+                    uint8_t chunk[65536];
+                    m_zs.next_in = const_cast<Bytef*>(data);
+                    m_zs.avail_in = static_cast<uInt>(size);
+                    // Keep inflating while there is input left or the output chunk came back full
+                    do
+                    {
+                        if (m_streamEnd)
+                        {
+                            break;
+                        }
+                        m_zs.next_out = chunk;
+                        m_zs.avail_out = sizeof(chunk);
+                        int ret = inflate(&m_zs, Z_NO_FLUSH);
+                        if ((ret != Z_OK) && (ret != Z_STREAM_END) && (ret != Z_BUF_ERROR))
+                        {
+                            TEST_LOG_ERROR("Failed to inflate compressed data, error=%d", ret);
+                            m_failed = true;
+                            return false;
+                        }
+                        m_streamEnd = (ret == Z_STREAM_END);
+                        m_pending.insert(m_pending.end(), chunk, chunk + (sizeof(chunk) - m_zs.avail_out));
+                        if (!decodePending())
+                        {
+                            return false;
+                        }
+                    } while ((m_zs.avail_in != 0) || (m_zs.avail_out == 0));
+                    return true;
+                }
+
+                bool decodePending()
+                {
+                    size_t consumed = decodeRecords(m_pending.data(), m_pending.size());
+                    m_pending.erase(m_pending.begin(), m_pending.begin() + consumed);
+                    if (m_pending.size() > MaxRecordSize)
+                    {
+                        TEST_LOG_ERROR("Deserialization failed: record larger than %zu bytes", MaxRecordSize);
+                        m_failed = true;
+                    }
+                    return !m_failed && !m_stopped;
+                }
+
+                /// <summary>
+                /// Decodes all complete records of the buffer, returns the number of bytes consumed.
+                /// </summary>
+                size_t decodeRecords(const uint8_t* data, size_t size)
+                {
+                    size_t offset = 0;
+                    while (offset < size && !m_stopped)
+                    {
+                        bond_lite::CompactBinaryProtocolReader framer(data + offset, size - offset);
+                        if (!framer.Skip(bond_lite::BT_STRUCT))
+                        {
+                            if (!framer.IsTruncated())
+                            {
+                                // Nothing after a record that cannot be framed can be located
+                                TEST_LOG_ERROR("Deserialization failed: malformed record framing");
+                                m_failed = true;
+                            }
+                            // Otherwise the record is incomplete, wait for more data
+                            break;
+                        }
+                        size_t length = framer.getSize();
+
+                        // A malformed record is reported and skipped, its framing is still valid
+                        RecordResult result = m_onRecord(data + offset, length);
+                        if (result == RecordResult::Malformed)
+                        {
+                            TEST_LOG_ERROR("Deserialization failed!");
+                            m_errorCount++;
+                        }
+                        else
+                        {
+                            m_recordCount++;
+                            m_stopped = (result == RecordResult::Stopped);
+                        }
+                        offset += length;
+                    }
+                    return offset;
+                }
+
+                z_stream m_zs;
+                bool m_compressed;
+                RecordHandler m_onRecord;
+                std::vector<uint8_t> m_pending;
+                bool m_streamEnd;
+                bool m_stopped;
+                bool m_failed;
+                size_t m_recordCount;
+                size_t m_errorCount;
+            };
+
+            /// <summary>
+            /// Writes a serialized record as a single line of JSON, with the fields and the layout of
+            /// to_json, straight from the Bond input: strings and blobs are read as views, so that the
+            /// line is the only allocation. Fields are written in to_json's key order, so the nested ones
+            /// are kept as views of their serialized value until written.
+            /// </summary>
+            class RecordJsonWriter
+            {
+            public:
+                explicit RecordJsonWriter(std::string& out) :
+                    m_out(out)
+                {
+                }
+
+                /// <summary>
+                /// Appends the JSON line of a record, returns false and appends nothing if it is malformed.
+                /// </summary>
+                bool Write(const uint8_t* data, size_t size)
+                {
+                    size_t start = m_out.size();
+                    if (!writeRecord(data, size))
+                    {
+                        m_out.resize(start);
+                        return false;
+                    }
+                    return true;
+                }
+
+            protected:
+                typedef bond_lite::CompactBinaryProtocolReader Reader;
+
+                struct StringView
+                {
+                    const char* data;
+                    size_t size;
+                };
+
+                // Serialized value of a field
+                struct Span
+                {
+                    const uint8_t* data;
+                    size_t size;
+                };
+
+                enum FieldKind
+                {
+                    FieldString,
+                    FieldInt32,
+                    FieldUInt64,
+                    FieldStringLists,
+                    FieldIgnored
+                };
+
+                // Field of an extension struct, written under its name unless ignored
+                struct FieldSpec
+                {
+                    uint16_t id;
+                    FieldKind kind;
+                    const char* name;
+                };
+
+                struct FieldValue
+                {
+                    StringView string;
+                    int64_t number;
+                    uint64_t unsignedNumber;
+                    Span span;
+                };
+
+                static const size_t MaxExtensionFields = 12;
+
+                struct RecordFields
+                {
+                    StringView ver, name, iKey, cV, baseType;
+                    int64_t time, flags;
+                    double popSample;
+                    Span protocol, user, device, os, app, net, sdk, m365a, extData, tags, baseData, data;
+                };
+
+                struct ValueFields
+                {
+                    int32_t type;
+                    Span attributes;
+                    StringView stringValue;
+                    int64_t longValue;
+                    double doubleValue;
+                    Span guidValue, stringArray, longArray, doubleArray, guidArray;
+                };
+
+                /// <summary>
+                /// Reads the fields of a struct up to its end, handing each one to onField.
+                /// </summary>
+                template <typename TOnField>
+                static bool readStruct(Reader& reader, TOnField const& onField)
                 {
-                    Record result;
-                    length = request.size() - i;
-                    std::vector<uint8_t> test(request.data() + i, request.data() + i + length);
-                    size_t j = 3;
-                    bool found = false;
-                    while (j < length)
+                    for (;;)
                     {
-                        while (j < length && test[j] != '\x3')
+                        uint8_t type;
+                        uint16_t id;
+                        if (!reader.ReadFieldBegin(type, id))
+                        {
+                            return false;
+                        }
+                        if (type == bond_lite::BT_STOP)
                         {
-                            j++;
+                            return true;
                         }
-                        if (j < length)
+                        if ((type == bond_lite::BT_STOP_BASE) || !onField(type, id))
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                /// <summary>
+                /// Reads the header of a list of structs.
+                /// </summary>
+                static bool readStructList(Reader& reader, uint32_t& count)
+                {
+                    uint8_t elementType;
+                    return reader.ReadContainerBegin(count, elementType) && ((count == 0) || (elementType == bond_lite::BT_STRUCT));
+                }
+
+                static bool readString(Reader& reader, uint8_t type, StringView& value)
+                {
+                    return (type == bond_lite::BT_STRING) && reader.ReadStringView(value.data, value.size);
+                }
+
+                /// <summary>
+                /// Keeps the serialized value of a field of the given type, the reader reads from base.
+                /// </summary>
+                static bool readSpan(Reader& reader, const uint8_t* base, uint8_t type, uint8_t expectedType, Span& span)
+                {
+                    size_t start = reader.getSize();
+                    if ((type != expectedType) || !reader.Skip(type))
+                    {
+                        return false;
+                    }
+                    span.data = base + start;
+                    span.size = reader.getSize() - start;
+                    return true;
+                }
+
+                bool writeRecord(const uint8_t* data, size_t size)
+                {
+                    RecordFields r = RecordFields();
+                    r.popSample = 100;
+                    Reader reader(data, size);
+                    bool valid = readStruct(reader, [&](uint8_t type, uint16_t id) -> bool
+                    {
+                        switch (id)
                         {
-                            if (j + 2 < length)
+                        case 1:  return readString(reader, type, r.ver);
+                        case 2:  return readString(reader, type, r.name);
+                        case 3:  return (type == bond_lite::BT_INT64) && reader.ReadInt64(r.time);
+                        case 4:  return (type == bond_lite::BT_DOUBLE) && reader.ReadDouble(r.popSample);
+                        case 5:  return readString(reader, type, r.iKey);
+                        case 6:  return (type == bond_lite::BT_INT64) && reader.ReadInt64(r.flags);
+                        case 7:  return readString(reader, type, r.cV);
+                        case 21: return readSpan(reader, data, type, bond_lite::BT_LIST, r.protocol);
+                        case 22: return readSpan(reader, data, type, bond_lite::BT_LIST, r.user);
+                        case 23: return readSpan(reader, data, type, bond_lite::BT_LIST, r.device);
+                        case 24: return readSpan(reader, data, type, bond_lite::BT_LIST, r.os);
+                        case 25: return readSpan(reader, data, type, bond_lite::BT_LIST, r.app);
+                        case 31: return readSpan(reader, data, type, bond_lite::BT_LIST, r.net);
+                        case 32: return readSpan(reader, data, type, bond_lite::BT_LIST, r.sdk);
+                        case 37: return readSpan(reader, data, type, bond_lite::BT_LIST, r.m365a);
+                        case 41: return readSpan(reader, data, type, bond_lite::BT_LIST, r.extData);
+                        case 51: return readSpan(reader, data, type, bond_lite::BT_MAP, r.tags);
+                        case 60: return readString(reader, type, r.baseType);
+                        case 61: return readSpan(reader, data, type, bond_lite::BT_LIST, r.baseData);
+                        case 70: return readSpan(reader, data, type, bond_lite::BT_LIST, r.data);
+                        case 26:
+                        case 33:
+#ifdef HAVE_CS4_FULL
+                        case 20:
+                        case 27:
+                        case 28:
+                        case 29:
+                        case 34:
+                        case 35:
+                        case 36:
+                        case 42:
+                        case 43:
+                        case 44:
+                        case 45:
+#endif
+                            // Extensions that to_json leaves out
+                            return reader.Skip(type);
+                        default:
+                            return false;
+                        }
+                    });
+                    if (!valid)
+                    {
+                        return false;
+                    }
+
+                    bool first = true;
+                    m_out += '{';
+                    if (!writeData(first, "baseData", r.baseData))
+                    {
+                        return false;
+                    }
+                    writeKey(first, "baseType");
+                    writeString(r.baseType);
+                    writeKey(first, "cV");
+                    writeString(r.cV);
+                    if (!writeData(first, "data", r.data))
+                    {
+                        return false;
+                    }
+                    writeKey(first, "ext");
+                    if (!writeExtensions(r))
+                    {
+                        return false;
+                    }
+                    if (!writeData(first, "extData", r.extData))
+                    {
+                        return false;
+                    }
+                    writeKey(first, "flags");
+                    writeInteger(r.flags);
+                    writeKey(first, "iKey");
+                    writeString(r.iKey);
+                    writeKey(first, "name");
+                    writeString(r.name);
+                    writeKey(first, "popSample");
+                    writeDouble(r.popSample);
+                    writeKey(first, "tags");
+                    if (!writeTags(r.tags))
+                    {
+                        return false;
+                    }
+                    writeKey(first, "time");
+                    writeInteger(r.time);
+                    writeKey(first, "ver");
+                    writeString(r.ver);
+                    m_out += '}';
+                    return true;
+                }
+
+                bool writeExtensions(RecordFields const& r)
+                {
+                    static const FieldSpec app[] = {
+                        { 4, FieldInt32,  "asId" },
+                        { 3, FieldString, "env" },
+                        { 1, FieldString, "expId" },
+                        { 5, FieldString, "id" },
+                        { 7, FieldString, "locale" },
+                        { 8, FieldString, "name" },
+#ifdef HAVE_CS4
+                        { 9, FieldString, "sesId" },
+#endif
+                        { 2, FieldString, "userId" },
+                        { 6, FieldString, "ver" }
+                    };
+                    static const FieldSpec device[] = {
+                        { 3,  FieldString,  "authId" },
+#ifdef HAVE_CS4
+                        { 10, FieldString,  "authIdEnt" },
+#endif
+                        { 4,  FieldString,  "authSecId" },
+                        { 5,  FieldString,  "deviceClass" },
+                        { 1,  FieldString,  "id" },
+                        { 2,  FieldString,  "localId" },
+                        { 8,  FieldString,  "make" },
+                        { 9,  FieldString,  "model" },
+                        { 6,  FieldIgnored, nullptr },
+                        { 7,  FieldIgnored, nullptr }
+                    };
+                    static const FieldSpec net[] = {
+                        { 2, FieldString, "cost" },
+                        { 1, FieldString, "provider" },
+                        { 3, FieldString, "type" }
+                    };
+                    static const FieldSpec os[] = {
+                        { 3, FieldInt32,  "bootId" },
+                        { 2, FieldString, "expId" },
+                        { 1, FieldString, "locale" },
+                        { 4, FieldString, "name" },
+                        { 5, FieldString, "ver" }
+                    };
+                    static const FieldSpec protocol[] = {
+                        { 3, FieldString,      "devMake" },
+                        { 4, FieldString,      "devModel" },
+                        { 1, FieldInt32,       "metadataCrc" },
+#ifdef HAVE_CS4
+                        { 5, FieldUInt64,      "msp" },
+#endif
+                        { 2, FieldStringLists, "ticketKeys" }
+                    };
+                    static const FieldSpec sdk[] = {
+                        { 2, FieldString,  "epoch" },
+                        { 4, FieldString,  "installId" },
+#ifdef HAVE_CS4
+                        { 1, FieldString,  "ver" },
+                        { 5, FieldIgnored, nullptr },
+#else
+                        { 1, FieldString,  "libVer" },
+#endif
+                        { 3, FieldIgnored, nullptr }
+                    };
+                    static const FieldSpec user[] = {
+                        { 3, FieldString, "authId" },
+                        { 1, FieldString, "id" },
+                        { 2, FieldString, "localId" },
+                        { 4, FieldString, "locale" }
+                    };
+
+                    bool first = true;
+                    m_out += '{';
+                    bool valid =
+                        writeExtension(first, "app", r.app, app, sizeof(app) / sizeof(app[0])) &&
+                        writeExtension(first, "device", r.device, device, sizeof(device) / sizeof(device[0]));
+#ifdef HAVE_CS4
+                    static const FieldSpec m365a[] = {
+                        { 1, FieldString, "enrolledTenantId" },
+                        { 2, FieldUInt64, "msp" }
+                    };
+                    uint32_t m365aCount = 0;
+                    if (valid && (r.m365a.size != 0))
+                    {
+                        Reader reader(r.m365a.data, r.m365a.size);
+                        valid = readStructList(reader, m365aCount);
+                    }
+                    valid = valid && ((m365aCount == 0) || writeExtension(first, "m365", r.m365a, m365a, sizeof(m365a) / sizeof(m365a[0])));
+#endif
+                    valid = valid &&
+                        writeExtension(first, "net", r.net, net, sizeof(net) / sizeof(net[0])) &&
+                        writeExtension(first, "os", r.os, os, sizeof(os) / sizeof(os[0])) &&
+                        writeExtension(first, "protocol", r.protocol, protocol, sizeof(protocol) / sizeof(protocol[0])) &&
+                        writeExtension(first, "sdk", r.sdk, sdk, sizeof(sdk) / sizeof(sdk[0])) &&
+                        writeExtension(first, "user", r.user, user, sizeof(user) / sizeof(user[0]));
+                    m_out += '}';
+                    return valid;
+                }
+
+                /// <summary>
+                /// Writes the first struct of an extension list, with default values if there is none.
+                /// </summary>
+                bool writeExtension(bool& first, const char* name, Span span, const FieldSpec* specs, size_t count)
+                {
+                    FieldValue values[MaxExtensionFields] = {};
+                    if (span.size != 0)
+                    {
+                        Reader reader(span.data, span.size);
+                        uint32_t structs = 0;
+                        if (!readStructList(reader, structs))
+                        {
+                            return false;
+                        }
+                        if ((structs != 0) && !readStruct(reader, [&](uint8_t type, uint16_t id) -> bool
                             {
-                                if (test[j + 1] == ('0'+::CsProtocol::CS_VER_MAJOR) && test[j + 2] == '.')
+                                size_t i = 0;
+                                while ((i < count) && (specs[i].id != id))
+                                {
+                                    i++;
+                                }
+                                if (i == count)
                                 {
-                                    found = true;
-                                    break;
+                                    return false;
                                 }
+                                switch (specs[i].kind)
+                                {
+                                case FieldString:
+                                    return readString(reader, type, values[i].string);
+                                case FieldInt32:
+                                {
+                                    int32_t value = 0;
+                                    bool read = (type == bond_lite::BT_INT32) && reader.ReadInt32(value);
+                                    values[i].number = value;
+                                    return read;
+                                }
+                                case FieldUInt64:
+                                    return (type == bond_lite::BT_UINT64) && reader.ReadUInt64(values[i].unsignedNumber);
+                                case FieldStringLists:
+                                    return readSpan(reader, span.data, type, bond_lite::BT_LIST, values[i].span);
+                                default:
+                                    return reader.Skip(type);
+                                }
+                            }))
+                        {
+                            return false;
+                        }
+                    }
+
+                    writeKey(first, name);
+                    bool firstField = true;
+                    m_out += '{';
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        if (specs[i].kind == FieldIgnored)
+                        {
+                            continue;
+                        }
+                        writeKey(firstField, specs[i].name);
+                        switch (specs[i].kind)
+                        {
+                        case FieldString:
+                            writeString(values[i].string);
+                            break;
+                        case FieldInt32:
+                            writeInteger(values[i].number);
+                            break;
+                        case FieldUInt64:
+                            writeUnsigned(values[i].unsignedNumber);
+                            break;
+                        default:
+                            if (!writeLists(values[i].span, 2, bond_lite::BT_STRING))
+                            {
+                                return false;
+                            }
+                            break;
+                        }
+                    }
+                    m_out += '}';
+                    return true;
+                }
+
+                /// <summary>
+                /// Writes the properties of the first Data struct of a list, nothing if the list is empty.
+                /// </summary>
+                bool writeData(bool& first, const char* name, Span span)
+                {
+                    if (span.size == 0)
+                    {
+                        return true;
+                    }
+                    Reader reader(span.data, span.size);
+                    uint32_t structs = 0;
+                    if (!readStructList(reader, structs))
+                    {
+                        return false;
+                    }
+                    if (structs == 0)
+                    {
+                        return true;
+                    }
+
+                    writeKey(first, name);
+                    bool firstProperty = true;
+                    m_out += '{';
+                    bool valid = readStruct(reader, [&](uint8_t type, uint16_t id) -> bool
+                    {
+                        uint32_t count = 0;
+                        uint8_t keyType = 0;
+                        uint8_t valueType = 0;
+                        if ((id != 1) || (type != bond_lite::BT_MAP) || !reader.ReadMapContainerBegin(count, keyType, valueType))
+                        {
+                            return false;
+                        }
+                        if ((count != 0) && ((keyType != bond_lite::BT_STRING) || (valueType != bond_lite::BT_STRUCT)))
+                        {
+                            return false;
+                        }
+                        for (uint32_t i = 0; i < count; i++)
+                        {
+                            StringView key;
+                            if (!reader.ReadStringView(key.data, key.size) || !writeProperty(reader, span.data, firstProperty, key))
+                            {
+                                return false;
+                            }
+                        }
+                        return true;
+                    });
+                    m_out += '}';
+                    return valid;
+                }
+
+                bool writeTags(Span span)
+                {
+                    m_out += '{';
+                    if (span.size != 0)
+                    {
+                        Reader reader(span.data, span.size);
+                        uint32_t count = 0;
+                        uint8_t keyType = 0;
+                        uint8_t valueType = 0;
+                        if (!reader.ReadMapContainerBegin(count, keyType, valueType))
+                        {
+                            return false;
+                        }
+                        if ((count != 0) && ((keyType != bond_lite::BT_STRING) || (valueType != bond_lite::BT_STRING)))
+                        {
+                            return false;
+                        }
+                        bool first = true;
+                        for (uint32_t i = 0; i < count; i++)
+                        {
+                            StringView key;
+                            StringView value;
+                            if (!reader.ReadStringView(key.data, key.size) || !reader.ReadStringView(value.data, value.size))
+                            {
+                                return false;
                             }
-                            j++;
+                            writeKey(first, key);
+                            writeString(value);
                         }
                     }
-                    if (!found)
+                    m_out += '}';
+                    return true;
+                }
+
+                /// <summary>
+                /// Writes a property of a Data struct as to_json does, the reader reads from base.
+                /// </summary>
+                bool writeProperty(Reader& reader, const uint8_t* base, bool& first, StringView key)
+                {
+                    ValueFields v = ValueFields();
+                    v.type = ::CsProtocol::ValueKind::ValueString;
+                    bool valid = readStruct(reader, [&](uint8_t type, uint16_t id) -> bool
                     {
-                        j += 1;
+                        switch (id)
+                        {
+                        case 1:  return (type == bond_lite::BT_INT32) && reader.ReadInt32(v.type);
+                        case 2:  return readSpan(reader, base, type, bond_lite::BT_LIST, v.attributes);
+                        case 3:  return readString(reader, type, v.stringValue);
+                        case 4:  return (type == bond_lite::BT_INT64) && reader.ReadInt64(v.longValue);
+                        case 5:  return (type == bond_lite::BT_DOUBLE) && reader.ReadDouble(v.doubleValue);
+                        case 6:  return readSpan(reader, base, type, bond_lite::BT_LIST, v.guidValue);
+                        case 10: return readSpan(reader, base, type, bond_lite::BT_LIST, v.stringArray);
+                        case 11: return readSpan(reader, base, type, bond_lite::BT_LIST, v.longArray);
+                        case 12: return readSpan(reader, base, type, bond_lite::BT_LIST, v.doubleArray);
+                        case 13: return readSpan(reader, base, type, bond_lite::BT_LIST, v.guidArray);
+                        default: return false;
+                        }
+                    });
+                    if (!valid)
+                    {
+                        return false;
                     }
-                    std::vector<uint8_t> input(request.data() + i, request.data() + i + j - 1);
-                    bond_lite::CompactBinaryProtocolReader reader(input);
 
-                    if (!Deserialize(reader, result, false))
+                    if (v.attributes.size != 0)
                     {
-                        TEST_LOG_ERROR("Deserialization failed!");
-                        goto fail;
+                        Reader attributes(v.attributes.data, v.attributes.size);
+                        uint32_t structs = 0;
+                        int32_t kind = 0;
+                        if (!readStructList(attributes, structs) || ((structs != 0) && !readPiiKind(attributes, kind)))
+                        {
+                            return false;
+                        }
+                        if (structs != 0)
+                        {
+                            writeKey(first, key);
+                            m_out += "{\"pii\":";
+                            writeUnsigned(static_cast<unsigned>(kind));
+                            m_out += ",\"stringValue\":";
+                            writeString(v.stringValue);
+                            m_out += '}';
+                            return true;
+                        }
+                    }
+
+                    switch (v.type)
+                    {
+                    case ::CsProtocol::ValueKind::ValueInt64:
+                    case ::CsProtocol::ValueKind::ValueDateTime:
+                        writeKey(first, key);
+                        writeInteger(v.longValue);
+                        return true;
+                    case ::CsProtocol::ValueKind::ValueUInt64:
+                        writeKey(first, key);
+                        writeUnsigned(static_cast<uint64_t>(v.longValue));
+                        return true;
+                    case ::CsProtocol::ValueKind::ValueInt32:
+                        writeKey(first, key);
+                        writeInteger(static_cast<int32_t>(v.longValue));
+                        return true;
+                    case ::CsProtocol::ValueKind::ValueUInt32:
+                        writeKey(first, key);
+                        writeUnsigned(static_cast<uint32_t>(v.longValue));
+                        return true;
+                    case ::CsProtocol::ValueKind::ValueDouble:
+                        writeKey(first, key);
+                        writeDouble(v.doubleValue);
+                        return true;
+                    case ::CsProtocol::ValueKind::ValueString:
+                        writeKey(first, key);
+                        writeString(v.stringValue);
+                        return true;
+                    case ::CsProtocol::ValueKind::ValueBool:
+                        writeKey(first, key);
+                        m_out += (v.longValue > 0) ? "true" : "false";
+                        return true;
+                    case ::CsProtocol::ValueKind::ValueGuid:
+                        writeKey(first, key);
+                        return writeLists(v.guidValue, 2, bond_lite::BT_UINT8);
+                    case ::CsProtocol::ValueKind::ValueArrayInt64:
+                    case ::CsProtocol::ValueKind::ValueArrayUInt64:
+                    case ::CsProtocol::ValueKind::ValueArrayInt32:
+                    case ::CsProtocol::ValueKind::ValueArrayUInt32:
+                    case ::CsProtocol::ValueKind::ValueArrayBool:
+                    case ::CsProtocol::ValueKind::ValueArrayDateTime:
+                        writeKey(first, key);
+                        return writeLists(v.longArray, 2, bond_lite::BT_INT64);
+                    case ::CsProtocol::ValueKind::ValueArrayDouble:
+                        writeKey(first, key);
+                        return writeLists(v.doubleArray, 2, bond_lite::BT_DOUBLE);
+                    case ::CsProtocol::ValueKind::ValueArrayString:
+                        writeKey(first, key);
+                        return writeLists(v.stringArray, 2, bond_lite::BT_STRING);
+                    case ::CsProtocol::ValueKind::ValueArrayGuid:
+                        writeKey(first, key);
+                        return writeLists(v.guidArray, 3, bond_lite::BT_UINT8);
+                    default:
+                        return true;
                     }
-                    i += j - 1;
-                    v.push_back(result);
                 }
-            fail:
-                return v;
-            }
 
-            bool to_json(json& out, const std::vector<uint8_t>& request)
-            {
-                auto records = decodeRequest(request);
-                if (records.size() == 0)
+                /// <summary>
+                /// Reads the kind of the first PII of an Attributes struct, leaving it unchanged if there is none.
+                /// </summary>
+                static bool readPiiKind(Reader& reader, int32_t& kind)
                 {
-                    return false;
+                    return readStruct(reader, [&](uint8_t type, uint16_t id) -> bool
+                    {
+                        if (id == 2)
+                        {
+                            return reader.Skip(type);
+                        }
+                        uint32_t count = 0;
+                        if ((id != 1) || (type != bond_lite::BT_LIST) || !readStructList(reader, count))
+                        {
+                            return false;
+                        }
+                        for (uint32_t i = 0; i < count; i++)
+                        {
+                            bool read = (i == 0) ?
+                                readStruct(reader, [&](uint8_t piiType, uint16_t piiId) -> bool
+                                {
+                                    return (piiId == 1) && (piiType == bond_lite::BT_INT32) && reader.ReadInt32(kind);
+                                }) :
+                                reader.Skip(bond_lite::BT_STRUCT);
+                            if (!read)
+                            {
+                                return false;
+                            }
+                        }
+                        return true;
+                    });
                 }
-                for (const auto &r : records)
+
+                /// <summary>
+                /// Writes a serialized list nested depth times as JSON arrays, leaves being strings,
+                /// 64-bit integers, doubles or bytes. An absent field is an empty list.
+                /// </summary>
+                bool writeLists(Span span, unsigned depth, uint8_t leafType)
                 {
-                    json j;
-                    to_json(j, r);
-                    out.push_back(j);
+                    if (span.size == 0)
+                    {
+                        m_out += "[]";
+                        return true;
+                    }
+                    Reader reader(span.data, span.size);
+                    return writeList(reader, depth, leafType);
                 }
-                return true;
-            }
+
+                bool writeList(Reader& reader, unsigned depth, uint8_t leafType)
+                {
+                    uint32_t count;
+                    uint8_t elementType;
+                    if (!reader.ReadContainerBegin(count, elementType))
+                    {
+                        return false;
+                    }
+                    if ((count != 0) && (elementType != ((depth > 1) ? static_cast<uint8_t>(bond_lite::BT_LIST) : leafType)))
+                    {
+                        return false;
+                    }
+
+                    m_out += '[';
+                    if ((depth == 1) && (leafType == bond_lite::BT_UINT8))
+                    {
+                        // Bytes are serialized back to back
+                        const uint8_t* bytes = nullptr;
+                        if ((count != 0) && !reader.ReadBlobView(bytes, count))
+                        {
+                            return false;
+                        }
+                        for (uint32_t i = 0; i < count; i++)
+                        {
+                            if (i != 0)
+                            {
+                                m_out += ',';
+                            }
+                            writeUnsigned(bytes[i]);
+                        }
+                    }
+                    else
+                    {
+                        for (uint32_t i = 0; i < count; i++)
+                        {
+                            if (i != 0)
+                            {
+                                m_out += ',';
+                            }
+                            if (!writeElement(reader, depth, leafType))
+                            {
+                                return false;
+                            }
+                        }
+                    }
+                    m_out += ']';
+                    return true;
+                }
+
+                bool writeElement(Reader& reader, unsigned depth, uint8_t leafType)
+                {
+                    if (depth > 1)
+                    {
+                        return writeList(reader, depth - 1, leafType);
+                    }
+                    switch (leafType)
+                    {
+                    case bond_lite::BT_STRING:
+                    {
+                        StringView value;
+                        if (!reader.ReadStringView(value.data, value.size))
+                        {
+                            return false;
+                        }
+                        writeString(value);
+                        return true;
+                    }
+                    case bond_lite::BT_INT64:
+                    {
+                        int64_t value;
+                        if (!reader.ReadInt64(value))
+                        {
+                            return false;
+                        }
+                        writeInteger(value);
+                        return true;
+                    }
+                    default:
+                    {
+                        double value;
+                        if (!reader.ReadDouble(value))
+                        {
+                            return false;
+                        }
+                        writeDouble(value);
+                        return true;
+                    }
+                    }
+                }
+
+                void writeKey(bool& first, const char* name)
+                {
+                    if (!first)
+                    {
+                        m_out += ',';
+                    }
+                    first = false;
+                    m_out += '"';
+                    m_out += name;
+                    m_out += "\":";
+                }
+
+                void writeKey(bool& first, StringView name)
+                {
+                    if (!first)
+                    {
+                        m_out += ',';
+                    }
+                    first = false;
+                    writeString(name);
+                    m_out += ':';
+                }
+
+                void writeInteger(int64_t value)
+                {
+                    char buffer[24];
+                    int length = snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+                    m_out.append(buffer, static_cast<size_t>(length));
+                }
+
+                void writeUnsigned(uint64_t value)
+                {
+                    char buffer[24];
+                    int length = snprintf(buffer, sizeof(buffer), "%" PRIu64, value);
+                    m_out.append(buffer, static_cast<size_t>(length));
+                }
+
+                void writeDouble(double value)
+                {
+                    // Same number format as to_json
+                    m_out += json(value).dump();
+                }
+
+                /// <summary>
+                /// Writes a string escaped as nlohmann::json does, invalid UTF-8 being replaced with U+FFFD.
+                /// </summary>
+                void writeString(StringView value)
+                {
+                    static const char hex[] = "0123456789abcdef";
+                    const char* data = value.data;
+                    size_t size = value.size;
+                    m_out += '"';
+                    size_t i = 0;
+                    while (i < size)
+                    {
+                        // Characters that need no escaping are appended in runs
+                        size_t run = i;
+                        while ((run < size) && isPlainCharacter(static_cast<uint8_t>(data[run])))
+                        {
+                            run++;
+                        }
+                        m_out.append(data + i, run - i);
+                        i = run;
+                        if (i == size)
+                        {
+                            break;
+                        }
+
+                        uint8_t c = static_cast<uint8_t>(data[i]);
+                        if (c >= 0x80)
+                        {
+                            size_t length = utf8SequenceLength(data + i, size - i);
+                            if (length == 0)
+                            {
+                                m_out += "\xEF\xBF\xBD";
+                                i++;
+                            }
+                            else
+                            {
+                                m_out.append(data + i, length);
+                                i += length;
+                            }
+                            continue;
+                        }
+                        switch (c)
+                        {
+                        case '"':  m_out += "\\\""; break;
+                        case '\\': m_out += "\\\\"; break;
+                        case '\b': m_out += "\\b"; break;
+                        case '\f': m_out += "\\f"; break;
+                        case '\n': m_out += "\\n"; break;
+                        case '\r': m_out += "\\r"; break;
+                        case '\t': m_out += "\\t"; break;
+                        default:
+                            m_out += "\\u00";
+                            m_out += hex[c >> 4];
+                            m_out += hex[c & 15];
+                            break;
+                        }
+                        i++;
+                    }
+                    m_out += '"';
+                }
+
+                static bool isPlainCharacter(uint8_t c)
+                {
+                    return (c >= 0x20) && (c < 0x80) && (c != '"') && (c != '\\');
+                }
+
+                /// <summary>
+                /// Length of the valid UTF-8 sequence the input starts with, 0 if there is none.
+                /// </summary>
+                static size_t utf8SequenceLength(const char* data, size_t size)
+                {
+                    uint8_t c = static_cast<uint8_t>(data[0]);
+                    size_t length;
+                    uint32_t codePoint;
+                    uint32_t minimum;
+                    if ((c & 0xE0) == 0xC0)
+                    {
+                        length = 2;
+                        codePoint = c & 0x1F;
+                        minimum = 0x80;
+                    }
+                    else if ((c & 0xF0) == 0xE0)
+                    {
+                        length = 3;
+                        codePoint = c & 0x0F;
+                        minimum = 0x800;
+                    }
+                    else if ((c & 0xF8) == 0xF0)
+                    {
+                        length = 4;
+                        codePoint = c & 0x07;
+                        minimum = 0x10000;
+                    }
+                    else
+                    {
+                        return 0;
+                    }
+                    if (length > size)
+                    {
+                        return 0;
+                    }
+                    for (size_t i = 1; i < length; i++)
+                    {
+                        uint8_t next = static_cast<uint8_t>(data[i]);
+                        if ((next & 0xC0) != 0x80)
+                        {
+                            return 0;
+                        }
+                        codePoint = (codePoint << 6) | (next & 0x3F);
+                    }
+                    if ((codePoint < minimum) || (codePoint > 0x10FFFF) || ((codePoint >= 0xD800) && (codePoint <= 0xDFFF)))
+                    {
+                        return 0;
+                    }
+                    return length;
+                }
+
+                std::string& m_out;
+            };
 
             void to_json(json& j, const Data& d)
             {
@@ -511,24 +1561,24 @@ namespace MAT_NS_BEGIN {
         {
             out.clear();
 
-            std::vector<uint8_t> buffer;
-            if (compressed)
+            json j = json::array();
+            RequestDecoder decoder(compressed, [&j](const uint8_t* data, size_t size)
             {
-                if (!ZlibUtils::InflateVector(in, buffer, false /* isGzip */))
+                CsProtocol::Record r;
+                bond_lite::CompactBinaryProtocolReader reader(data, size);
+                if (!bond_lite::Deserialize(reader, r, false))
                 {
-                    TEST_LOG_ERROR("Failed to inflate compressed data");
-                    return false;
+                    return RecordResult::Malformed;
                 }
-            }
-            else
-            {
-                std::copy(in.begin(), in.end(), std::back_inserter(buffer));
-            }
-
-            bool result = true;
-            json j = json::array();
-            result = to_json(j, buffer);
+                json record;
+                to_json(record, r);
+                j.push_back(record);
+                return RecordResult::Decoded;
+            });
+            decoder.Write(in.data(), in.size());
+            decoder.Finish();
 
+            bool result = (decoder.RecordCount() != 0);
             if (result)
             {
                 out = j.dump(2);
@@ -537,6 +1587,65 @@ namespace MAT_NS_BEGIN {
             return result;
         }
 
+        /// <summary>
+        /// Decodes the request record by record, each record as a single line of JSON.
+        /// </summary>
+        /// <param name="in">Input request buffer containing HTTP request body</param>
+        /// <param name="onRecord">Consumer of the JSON records, returns false to stop decoding</param>
+        /// <param name="compressed">If set to <c>true</c> then the input buffer is [compressed] (optional)</param>
+        bool DecodeRequestRecords(const std::vector<uint8_t>& in, std::function<bool(const std::string&)> const& onRecord, bool compressed)
+        {
+            std::string line;
+            RecordJsonWriter writer(line);
+            RequestDecoder decoder(compressed, [&](const uint8_t* data, size_t size)
+            {
+                line.clear();
+                if (!writer.Write(data, size))
+                {
+                    return RecordResult::Malformed;
+                }
+                return onRecord(line) ? RecordResult::Decoded : RecordResult::Stopped;
+            });
+            decoder.Write(in.data(), in.size());
+            return decoder.Finish();
+        }
+
+        /// <summary>
+        /// Decodes the request read from a stream into newline-delimited JSON.
+        /// </summary>
+        /// <param name="in">Stream of the HTTP request body</param>
+        /// <param name="out">Stream receiving one line of JSON per record</param>
+        /// <param name="compressed">If set to <c>true</c> then the input stream is [compressed] (optional)</param>
+        bool DecodeRequestStream(std::istream& in, std::ostream& out, bool compressed)
+        {
+            // The line buffer is reused from one record to the next
+            std::string line;
+            RecordJsonWriter writer(line);
+            RequestDecoder decoder(compressed, [&](const uint8_t* data, size_t size)
+            {
+                line.clear();
+                if (!writer.Write(data, size))
+                {
+                    return RecordResult::Malformed;
+                }
+                line += '\n';
+                out.write(line.data(), static_cast<std::streamsize>(line.size()));
+                return out.good() ? RecordResult::Decoded : RecordResult::Stopped;
+            });
+
+            std::vector<char> chunk(65536);
+            while (in)
+            {
+                in.read(chunk.data(), chunk.size());
+                size_t size = static_cast<size_t>(in.gcount());
+                if ((size != 0) && !decoder.Write(reinterpret_cast<const uint8_t*>(chunk.data()), size))
+                {
+                    break;
+                }
+            }
+            return !in.bad() && decoder.Finish();
+        }
+
         /// <summary>
         /// Decodes the record contents from binary into human-readable format.
         /// </summary>
@@ -23,10 +23,10 @@ namespace MAT_NS_BEGIN {
     /// <returns>true if successful</returns>
     bool BaseDecorator::decorate(::CsProtocol::Record& record)
     {
+        // Pooled records keep their extensions, fill in the first one
         if (record.extSdk.size() == 0)
         {
-            ::CsProtocol::Sdk sdk;
-            record.extSdk.push_back(sdk);
+            record.extSdk.emplace_back();
         }
 
         record.time = PAL::getUtcSystemTimeinTicks();
@@ -60,13 +60,11 @@ namespace MAT_NS_BEGIN {
             auto tokensController = m_owner.GetAuthTokensController();
             if (record.extProtocol.size() == 0)
             {
-                ::CsProtocol::Protocol temp;
-                record.extProtocol.push_back(temp);
+                record.extProtocol.emplace_back();
             }
             if (record.extProtocol[0].ticketKeys.size() == 0)
             {
-                std::vector<std::string> temp;
-                record.extProtocol[0].ticketKeys.push_back(temp);
+                record.extProtocol[0].ticketKeys.emplace_back();
             }
             for (const auto& ticket : tokensController->GetTickets())
             {
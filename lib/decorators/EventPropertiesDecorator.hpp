@@ -7,7 +7,9 @@
 
 #include "IDecorator.hpp"
 #include "EventProperties.hpp"
+#include "EventSchema.hpp"
 #include "CorrelationVector.hpp"
+#include "system/EventPropertiesStorage.hpp"
 #include "utils/Utils.hpp"
 
 #include <algorithm>
@@ -87,37 +89,16 @@ namespace MAT_NS_BEGIN {
             record.cV = "";
         }
 
-        bool decorate(::CsProtocol::Record& record, EventLatency& latency, EventProperties const& eventProperties)
+        /// <summary>
+        /// Applies popSample and the on-wire record flags derived from event tags, persistence and latency.
+        /// </summary>
+        /// <returns>true if the caller asked to drop Pii from Part A of the event</returns>
+        bool applyEnvelope(::CsProtocol::Record& record, EventLatency latency, EventPersistence persistence, uint64_t policyBitFlags, double popSample)
         {
-            if (latency == EventLatency_Unspecified)
-                latency = EventLatency_Normal;
-
-            if (eventProperties.GetName().empty()) {
-                // OK, using some default set by earlier decorator.
-            }
-            else
-            {
-                EventRejectedReason isValidEventName = validateEventName(eventProperties.GetName());
-                if (isValidEventName != REJECTED_REASON_OK) {
-                    LOG_ERROR("Invalid event properties!");
-                    DebugEvent evt;
-                    evt.type = DebugEventType::EVT_REJECTED;
-                    evt.param1 = isValidEventName;
-                    m_owner.DispatchEvent(evt);
-                    return false;
-                }
-            }
-
-            if (record.data.size() == 0)
-            {
-                ::CsProtocol::Data data;
-                record.data.push_back(data);
-            }
-
-            record.popSample = eventProperties.GetPopSample();
+            record.popSample = popSample;
 
             // API surface tags('flags') are different from on-wire record.flags
-            int64_t tags = eventProperties.GetPolicyBitFlags();
+            int64_t tags = static_cast<int64_t>(policyBitFlags);
             int64_t flags = 0;
 
             // We must remap from one bitfield set to another, no way to bit-shift :(
@@ -125,10 +106,7 @@ namespace MAT_NS_BEGIN {
             flags |= (tags & MICROSOFT_EVENTTAG_MARK_PII) ? RECORD_FLAGS_EVENTTAG_MARK_PII : 0;
             flags |= (tags & MICROSOFT_EVENTTAG_DROP_PII) ? RECORD_FLAGS_EVENTTAG_DROP_PII : 0;
 
-            // Caller asked to drop Pii from Part A of that event
-            bool tagDropPii = bool(tags & MICROSOFT_EVENTTAG_DROP_PII);
-
-            if (EventPersistence_Critical == eventProperties.GetPersistence())
+            if (EventPersistence_Critical == persistence)
             {
                 flags = flags | 0x02;
             }
@@ -151,271 +129,364 @@ namespace MAT_NS_BEGIN {
             }
             record.flags = flags;
 
+            return bool(tags & MICROSOFT_EVENTTAG_DROP_PII);
+        }
+
+        void applyCorrelationVector(::CsProtocol::Record& record)
+        {
             std::map<std::string, ::CsProtocol::Value>& ext = record.data[0].properties;
-            std::map<std::string, ::CsProtocol::Value> extPartB;
+            auto it = ext.find(CorrelationVector::PropertyName);
+            if (it == ext.end())
+            {
+                return;
+            }
 
-            for (auto &kv : eventProperties.GetProperties()) {
+            const CsProtocol::Value& cvValue = it->second;
+            if (cvValue.type == ::CsProtocol::ValueKind::ValueString)
+            {
+                record.cV = cvValue.stringValue;
+            }
+            else
+            {
+                LOG_TRACE("CorrelationVector value type is invalid %u", cvValue.type);
+            }
+            ext.erase(it);
+        }
+
+        bool acceptPropertyName(const char* name, size_t length)
+        {
+            EventRejectedReason isValidPropertyName = validatePropertyName(name, length);
+            if (isValidPropertyName != REJECTED_REASON_OK)
+            {
+                DebugEvent evt;
+                evt.type = DebugEventType::EVT_REJECTED;
+                evt.param1 = isValidPropertyName;
+                m_owner.DispatchEvent(evt);
+                return false;
+            }
+            return true;
+        }
+
+        static std::string toString(const EventProperty& v, const char* stringValue, size_t stringLength)
+        {
+            return (stringValue != nullptr) ? std::string(stringValue, stringLength) : v.to_string();
+        }
+
+        /// <summary>
+        /// Converts one event property into the Part B or Part C map of the record.
+        /// String values of flat storage are passed in stringValue, all other values in v.
+        /// </summary>
+        void decorateProperty(std::map<std::string, ::CsProtocol::Value>& ext, std::map<std::string, ::CsProtocol::Value>& extPartB,
+            const std::string& k, const EventProperty& v, const char* stringValue, size_t stringLength)
+        {
+            if (v.piiKind != PiiKind_None)
+            {
+                if (v.piiKind == PiiKind::CustomerContentKind_GenericData)
+                {  //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
+                    CsProtocol::CustomerContent cc;
+                    cc.Kind = CsProtocol::CustomerContentKind::GenericContent;
+                    CsProtocol::Value temp;
+
+                    CsProtocol::Attributes attrib;
+                    attrib.customerContent.push_back(cc);
+
+                    temp.attributes.push_back(attrib);
+                    temp.stringValue = toString(v, stringValue, stringLength);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = std::move(temp);
+                    }
+                    else
+                    {
+                        ext[k] = std::move(temp);
+                    }
 
-                EventRejectedReason isValidPropertyName = validatePropertyName(kv.first);
-                if (isValidPropertyName != REJECTED_REASON_OK)
-                {
-                    DebugEvent evt;
-                    evt.type = DebugEventType::EVT_REJECTED;
-                    evt.param1 = isValidPropertyName;
-                    m_owner.DispatchEvent(evt);
-                    return false;
                 }
-                const auto &k = kv.first;
-                const auto &v = kv.second;
-                if (v.piiKind != PiiKind_None)
-                {
-                    if (v.piiKind == PiiKind::CustomerContentKind_GenericData)
-                    {  //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
-                        CsProtocol::CustomerContent cc;
-                        cc.Kind = CsProtocol::CustomerContentKind::GenericContent;
-                        CsProtocol::Value temp;
-
-                        CsProtocol::Attributes attrib;
-                        attrib.customerContent.push_back(cc);
-
-                        temp.attributes.push_back(attrib);
-                        temp.stringValue = v.to_string();
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
+                else
+                { //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
+                    CsProtocol::PII pii;
+                    pii.Kind = static_cast<CsProtocol::PIIKind>(v.piiKind);
+                    CsProtocol::Value temp;
+
+                    CsProtocol::Attributes attrib;
+                    attrib.pii.push_back(pii);
 
+
+                    temp.attributes.push_back(attrib);
+                    temp.stringValue = toString(v, stringValue, stringLength);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = std::move(temp);
                     }
                     else
-                    { //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
+                    {
+                        ext[k] = std::move(temp);
+                    }
+#if 0 /* v2 code */
+                    if (v.piiKind != PiiKind_None)
+                    {
+                        //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
                         CsProtocol::PII pii;
                         pii.Kind = static_cast<CsProtocol::PIIKind>(v.piiKind);
-                        CsProtocol::Value temp;
-
-                        CsProtocol::Attributes attrib;
-                        attrib.pii.push_back(pii);
-
-
-                        temp.attributes.push_back(attrib);
-                        temp.stringValue = v.to_string();
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-#if 0 /* v2 code */
-                        if (v.piiKind != PiiKind_None)
-                        {
-                            //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
-                            CsProtocol::PII pii;
-                            pii.Kind = static_cast<CsProtocol::PIIKind>(v.piiKind);
-                            pii.RawContent = v.to_string();
-                            // ScrubType = 1 is the O365 scrubber which is the default behavior.
-                            // pii.ScrubType = static_cast<PIIScrubber>(O365);
-                            pii.ScrubType = CsProtocol::O365;
-                            PIIExtensions[k] = pii;
-                            // 4. Send event's Pii context fields as record.PIIExtensions
-                        }
-                        else
-                        {
-                            //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
-                            CsProtocol::CustomerContent cc;
-                            cc.Kind = static_cast<CsProtocol::CustomerContentKind>(v.ccKind);
-                            cc.RawContent = v.to_string();
-                            ccExtensions[k] = cc;
-                            // 4. Send event's Pii context fields as record.PIIExtensions
-#endif
+                        pii.RawContent = v.to_string();
+                        // ScrubType = 1 is the O365 scrubber which is the default behavior.
+                        // pii.ScrubType = static_cast<PIIScrubber>(O365);
+                        pii.ScrubType = CsProtocol::O365;
+                        PIIExtensions[k] = pii;
+                        // 4. Send event's Pii context fields as record.PIIExtensions
                     }
+                    else
+                    {
+                        //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
+                        CsProtocol::CustomerContent cc;
+                        cc.Kind = static_cast<CsProtocol::CustomerContentKind>(v.ccKind);
+                        cc.RawContent = v.to_string();
+                        ccExtensions[k] = cc;
+                        // 4. Send event's Pii context fields as record.PIIExtensions
+#endif
                 }
-                else {
-                    std::vector<uint8_t> guid;
-                    uint8_t guid_bytes[16] = { 0 };
+            }
+            else {
+                std::vector<uint8_t> guid;
+                uint8_t guid_bytes[16] = { 0 };
 
-                    switch (v.type)
+                switch ((stringValue != nullptr) ? EventProperty::TYPE_STRING : v.type)
+                {
+                case EventProperty::TYPE_STRING:
+                {
+                    CsProtocol::Value temp;
+                    temp.stringValue = toString(v, stringValue, stringLength);
+                    if (v.dataCategory == DataCategory_PartB)
                     {
-                    case EventProperty::TYPE_STRING:
+                        extPartB[k] = std::move(temp);
+                    }
+                    else
                     {
-                        CsProtocol::Value temp;
-                        temp.stringValue = v.to_string();
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
+                        ext[k] = std::move(temp);
                     }
-                    case EventProperty::TYPE_INT64:
+                    break;
+                }
+                case EventProperty::TYPE_INT64:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueInt64;
+                    temp.longValue = v.as_int64;
+                    if (v.dataCategory == DataCategory_PartB)
                     {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueInt64;
-                        temp.longValue = v.as_int64;
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
+                        extPartB[k] = std::move(temp);
                     }
-                    case EventProperty::TYPE_DOUBLE:
+                    else
                     {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueDouble;
-                        temp.doubleValue = v.as_double;
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
+                        ext[k] = std::move(temp);
                     }
-                    case EventProperty::TYPE_TIME:
+                    break;
+                }
+                case EventProperty::TYPE_DOUBLE:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueDouble;
+                    temp.doubleValue = v.as_double;
+                    if (v.dataCategory == DataCategory_PartB)
                     {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueDateTime;
-                        temp.longValue = v.as_time_ticks.ticks;
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
+                        extPartB[k] = std::move(temp);
                     }
-                    case EventProperty::TYPE_BOOLEAN:
+                    else
                     {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueBool;
-                        temp.longValue = v.as_bool;
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
+                        ext[k] = std::move(temp);
                     }
-                    case EventProperty::TYPE_GUID:
+                    break;
+                }
+                case EventProperty::TYPE_TIME:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueDateTime;
+                    temp.longValue = v.as_time_ticks.ticks;
+                    if (v.dataCategory == DataCategory_PartB)
                     {
-                        GUID_t temp = v.as_guid;
-                        temp.to_bytes(guid_bytes);
-                        guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
+                        extPartB[k] = std::move(temp);
+                    }
+                    else
+                    {
+                        ext[k] = std::move(temp);
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_BOOLEAN:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueBool;
+                    temp.longValue = v.as_bool;
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = std::move(temp);
+                    }
+                    else
+                    {
+                        ext[k] = std::move(temp);
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_GUID:
+                {
+                    GUID_t temp = v.as_guid;
+                    temp.to_bytes(guid_bytes);
+                    guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
+
+                    CsProtocol::Value tempValue;
+                    tempValue.type = ::CsProtocol::ValueKind::ValueGuid;
+                    tempValue.guidValue.push_back(guid);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = std::move(tempValue);
+                    }
+                    else
+                    {
+                        ext[k] = std::move(tempValue);
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_INT64_ARRAY:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueArrayInt64;
+                    temp.longArray.push_back(*v.as_longArray);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = std::move(temp);
+                    }
+                    else
+                    {
+                        ext[k] = std::move(temp);
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_DOUBLE_ARRAY:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueArrayDouble;
+                    temp.doubleArray.push_back(*v.as_doubleArray);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = std::move(temp);
+                    }
+                    else
+                    {
+                        ext[k] = std::move(temp);
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_STRING_ARRAY:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueArrayString;
+                    temp.stringArray.push_back(*v.as_stringArray);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = std::move(temp);
+                    }
+                    else
+                    {
+                        ext[k] = std::move(temp);
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_GUID_ARRAY:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueArrayGuid;
 
-                        CsProtocol::Value tempValue;
-                        tempValue.type = ::CsProtocol::ValueKind::ValueGuid;
-                        tempValue.guidValue.push_back(guid);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = tempValue;
-                        }
-                        else
-                        {
-                            ext[k] = tempValue;
-                        }
-                        break;
+                    std::vector<std::vector<uint8_t>> values;
+                    for (const auto& tempValue : *v.as_guidArray)
+                    {
+                        tempValue.to_bytes(guid_bytes);
+                        guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
+                        values.push_back(guid);
                     }
-                    case EventProperty::TYPE_INT64_ARRAY:
+                    temp.guidArray.push_back(values);
+                    if (v.dataCategory == DataCategory_PartB)
                     {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueArrayInt64;
-                        temp.longArray.push_back(*v.as_longArray);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
+                        extPartB[k] = std::move(temp);
                     }
-                    case EventProperty::TYPE_DOUBLE_ARRAY:
+                    else
                     {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueArrayDouble;
-                        temp.doubleArray.push_back(*v.as_doubleArray);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
+                        ext[k] = std::move(temp);
                     }
-                    case EventProperty::TYPE_STRING_ARRAY:
+                    break;
+                }
+                default:
+                {
+                    // Convert all unknown types to string
+                    CsProtocol::Value temp;
+                    temp.stringValue = toString(v, stringValue, stringLength);
+                    if (v.dataCategory == DataCategory_PartB)
                     {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueArrayString;
-                        temp.stringArray.push_back(*v.as_stringArray);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
+                        extPartB[k] = std::move(temp);
                     }
-                    case EventProperty::TYPE_GUID_ARRAY:
+                    else
                     {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueArrayGuid;
-
-                        std::vector<std::vector<uint8_t>> values;
-                        for (const auto& tempValue : *v.as_guidArray)
-                        {
-                            tempValue.to_bytes(guid_bytes);
-                            guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
-                            values.push_back(guid);
-                        }
-                        temp.guidArray.push_back(values);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
+                        ext[k] = std::move(temp);
                     }
-                    default:
+                }
+                }
+            }
+        }
+
+        bool decorate(::CsProtocol::Record& record, EventLatency& latency, EventProperties const& eventProperties)
+        {
+            if (latency == EventLatency_Unspecified)
+                latency = EventLatency_Normal;
+
+            if (eventProperties.GetName().empty()) {
+                // OK, using some default set by earlier decorator.
+            }
+            else
+            {
+                EventRejectedReason isValidEventName = validateEventName(eventProperties.GetName());
+                if (isValidEventName != REJECTED_REASON_OK) {
+                    LOG_ERROR("Invalid event properties!");
+                    DebugEvent evt;
+                    evt.type = DebugEventType::EVT_REJECTED;
+                    evt.param1 = isValidEventName;
+                    m_owner.DispatchEvent(evt);
+                    return false;
+                }
+            }
+
+            if (record.data.size() == 0)
+            {
+                record.data.emplace_back();
+            }
+
+            // Caller asked to drop Pii from Part A of that event
+            bool tagDropPii = applyEnvelope(record, latency, eventProperties.GetPersistence(),
+                eventProperties.GetPolicyBitFlags(), eventProperties.GetPopSample());
+
+            std::map<std::string, ::CsProtocol::Value>& ext = record.data[0].properties;
+            std::map<std::string, ::CsProtocol::Value> extPartB;
+
+            const FlatProperties* flatProperties = eventProperties.GetFlatProperties();
+            if (flatProperties != nullptr)
+            {
+                // Walk the flat entries in place: GetProperties() would rebuild a std::map for every event
+                for (const auto& entry : *flatProperties)
+                {
+                    if (!acceptPropertyName(entry.name, entry.nameLength))
                     {
-                        // Convert all unknown types to string
-                        CsProtocol::Value temp;
-                        temp.stringValue = v.to_string();
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
+                        return false;
                     }
+                    decorateProperty(ext, extPartB, std::string(entry.name, entry.nameLength), entry.value,
+                        entry.isString ? entry.stringValue : nullptr, entry.stringLength);
+                }
+            }
+            else
+            {
+                for (const auto& kv : eventProperties.GetProperties())
+                {
+                    if (!acceptPropertyName(kv.first.data(), kv.first.length()))
+                    {
+                        return false;
                     }
+                    decorateProperty(ext, extPartB, kv.first, kv.second, nullptr, 0);
                 }
             }
 
@@ -427,22 +498,37 @@ namespace MAT_NS_BEGIN {
             }
 
             // special case of CorrelationVector value
-            if (ext.count(CorrelationVector::PropertyName) > 0)
+            applyCorrelationVector(record);
+
+            // scrub if MICROSOFT_EVENTTAG_DROP_PII is set
+            if (tagDropPii)
             {
-                CsProtocol::Value cvValue = ext[CorrelationVector::PropertyName];
+                dropPiiPartA(record);
+            }
 
-                if (cvValue.type == ::CsProtocol::ValueKind::ValueString)
-                {
-                    record.cV = cvValue.stringValue;
-                }
-                else
-                {
-                    LOG_TRACE("CorrelationVector value type is invalid %u", cvValue.type);
-                }
-                ext.erase(CorrelationVector::PropertyName);
+            return true;
+        }
+
+        /// <summary>
+        /// Decorates a record with the envelope and typed properties of an EventSchema event.
+        /// Event and property names were validated at compile time.
+        /// </summary>
+        bool decorate(::CsProtocol::Record& record, EventLatency& latency, EventSchemaBase const& event)
+        {
+            if (latency == EventLatency_Unspecified)
+                latency = EventLatency_Normal;
+
+            if (record.data.size() == 0)
+            {
+                record.data.emplace_back();
             }
 
-            // scrub if MICROSOFT_EVENTTAG_DROP_PII is set
+            bool tagDropPii = applyEnvelope(record, latency, event.GetPersistence(), event.GetPolicyBitFlags(), event.GetPopSample());
+
+            event.SerializeProperties(record.data[0].properties);
+
+            applyCorrelationVector(record);
+
             if (tagDropPii)
             {
                 dropPiiPartA(record);
@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "EventSampler.hpp"
+
+#include "ILogConfiguration.hpp"
+#include "pal/PAL.hpp"
+
+namespace MAT_NS_BEGIN
+{
+    constexpr double EventSampler::FullSampleRate;
+
+    /// <summary>
+    /// Reads a sample rate from a config value: accepts integer and floating point
+    /// percentages, clamped to [0..100]. Returns false if the value is not a number.
+    /// </summary>
+    static bool readSampleRate(Variant& value, double& rate)
+    {
+        if (value.type == Variant::TYPE_INT)
+        {
+            rate = static_cast<double>(static_cast<int64_t>(value));
+        }
+        else if (value.type == Variant::TYPE_DOUBLE)
+        {
+            rate = static_cast<double>(value);
+        }
+        else
+        {
+            return false;
+        }
+        rate = (rate < 0.0) ? 0.0 : ((rate > EventSampler::FullSampleRate) ? EventSampler::FullSampleRate : rate);
+        return true;
+    }
+
+    EventSampler::EventSampler() noexcept :
+        m_enabled(false),
+        m_defaultRate(FullSampleRate),
+        m_deviceBucket(0.0)
+    {
+    }
+
+    void EventSampler::Configure(IRuntimeConfig& config, const std::string& tenantId, std::function<std::string()> deviceIdProvider)
+    {
+        m_deviceIdProvider = std::move(deviceIdProvider);
+        if (!config.HasConfig(CFG_MAP_SAMPLING))
+        {
+            return;
+        }
+
+        VariantMap& sampling = config[CFG_MAP_SAMPLING];
+        double rate = FullSampleRate;
+
+        auto it = sampling.find(CFG_DBL_SAMPLING_RATE);
+        if ((it != sampling.end()) && readSampleRate(it->second, rate))
+        {
+            m_defaultRate = rate;
+        }
+
+        it = sampling.find(CFG_MAP_SAMPLING_TENANTS);
+        if (it != sampling.end() && (it->second.type == Variant::TYPE_OBJ))
+        {
+            VariantMap& tenants = it->second;
+            auto tenant = tenants.find(tenantId);
+            if ((tenant != tenants.end()) && readSampleRate(tenant->second, rate))
+            {
+                m_defaultRate = rate;
+            }
+        }
+
+        it = sampling.find(CFG_MAP_SAMPLING_EVENTS);
+        if (it != sampling.end() && (it->second.type == Variant::TYPE_OBJ))
+        {
+            VariantMap& events = it->second;
+            for (auto& kv : events)
+            {
+                if (readSampleRate(kv.second, rate))
+                {
+                    m_eventRates[kv.first] = rate;
+                }
+            }
+        }
+
+        m_enabled = (m_defaultRate < FullSampleRate) || !m_eventRates.empty();
+        LOG_TRACE("Sampling for tenant %s: enabled=%u, rate=%f, event rates=%u",
+                  tenantId.c_str(), m_enabled, m_defaultRate, static_cast<unsigned>(m_eventRates.size()));
+    }
+
+    double EventSampler::GetSampleRate(const std::string& eventName) const
+    {
+        if (!m_eventRates.empty())
+        {
+            auto it = m_eventRates.find(eventName);
+            if (it != m_eventRates.end())
+            {
+                return it->second;
+            }
+        }
+        return m_defaultRate;
+    }
+
+    bool EventSampler::IsSampledIn(const std::string& eventName)
+    {
+        if (!m_enabled)
+        {
+            return true;
+        }
+        double rate = GetSampleRate(eventName);
+        if (rate >= FullSampleRate)
+        {
+            return true;
+        }
+        return GetDeviceBucket() < rate;
+    }
+
+    double EventSampler::GetDeviceBucket()
+    {
+        std::call_once(m_deviceBucketOnce, [this]() {
+            std::string deviceId = m_deviceIdProvider ? m_deviceIdProvider() : std::string();
+            if (deviceId.empty())
+            {
+                // No stable identifier available: sample this process instance as a whole
+                deviceId = PAL::generateUuidString();
+            }
+            m_deviceBucket = GetBucket(deviceId);
+        });
+        return m_deviceBucket;
+    }
+
+    double EventSampler::GetBucket(const std::string& deviceId) noexcept
+    {
+        // FNV-1a: stable across platforms and SDK versions, unlike std::hash
+        uint64_t hash = 14695981039346656037ull;
+        for (char ch : deviceId)
+        {
+            hash ^= static_cast<uint8_t>(ch);
+            hash *= 1099511628211ull;
+        }
+        // 1/10000th of a percent resolution
+        return static_cast<double>(hash % 1000000ull) / 10000.0;
+    }
+
+} MAT_NS_END
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef EVENTSAMPLER_HPP
+#define EVENTSAMPLER_HPP
+
+#include "Version.hpp"
+#include "api/IRuntimeConfig.hpp"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Client-side sampling of events, driven by the CFG_MAP_SAMPLING configuration.
+    /// Sampling is deterministic per device: each device falls into a fixed bucket in
+    /// [0..100) derived from a hash of its identifier, and an event is kept when that
+    /// bucket is below the effective sample rate (in percent) of the event.
+    /// Rate precedence: per-event name, then per-tenant, then the default rate.
+    /// </summary>
+    class EventSampler
+    {
+    public:
+        static constexpr double FullSampleRate = 100.0;
+
+        EventSampler() noexcept;
+
+        /// <summary>
+        /// Reads the sampling configuration that applies to the given tenant.
+        /// </summary>
+        /// <param name="config">Runtime configuration.</param>
+        /// <param name="tenantId">Tenant id of the owning logger (tenant token prefix).</param>
+        /// <param name="deviceIdProvider">Returns a stable device identifier. Called once, on
+        /// the first sampling decision. A random identifier is used if it returns an empty string.</param>
+        void Configure(IRuntimeConfig& config, const std::string& tenantId, std::function<std::string()> deviceIdProvider);
+
+        /// <summary>
+        /// Returns true if sampling is configured for this tenant.
+        /// </summary>
+        bool IsEnabled() const noexcept
+        {
+            return m_enabled;
+        }
+
+        /// <summary>
+        /// Returns the sample rate (in percent) that applies to an event.
+        /// </summary>
+        double GetSampleRate(const std::string& eventName) const;
+
+        /// <summary>
+        /// Returns true if an event with the given name is kept on this device.
+        /// </summary>
+        bool IsSampledIn(const std::string& eventName);
+
+        /// <summary>
+        /// Returns the device bucket in [0..100) used for sampling decisions.
+        /// </summary>
+        double GetDeviceBucket();
+
+        /// <summary>
+        /// Maps a device identifier onto its sampling bucket in [0..100).
+        /// </summary>
+        static double GetBucket(const std::string& deviceId) noexcept;
+
+    protected:
+        bool                                    m_enabled;
+        double                                  m_defaultRate;
+        std::unordered_map<std::string, double> m_eventRates;
+        std::function<std::string()>            m_deviceIdProvider;
+        std::once_flag                          m_deviceBucketOnce;
+        double                                  m_deviceBucket;
+    };
+
+} MAT_NS_END
+
+#endif // EVENTSAMPLER_HPP
@@ -35,14 +35,21 @@ namespace MAT_NS_BEGIN {
         HttpCallback(HttpClientManager& hcm, EventsUploadContextPtr const& ctx)
             : m_hcm(hcm),
             m_ctx(ctx),
-            m_startTime(PAL::getMonotonicTimeMs())
+            m_requestId(ctx->httpRequest->GetId()),
+            m_startTime(PAL::getMonotonicTimeMs()),
+            m_memory(hcm.m_memoryBudget, MemorySubsystem_Http)
         {
+            m_memory.Add(ctx->httpRequest->GetSizeEstimate());
         }
 
         virtual void OnHttpResponse(IHttpResponse* response) override
         {
             m_ctx->durationMs = static_cast<int>(PAL::getMonotonicTimeMs() - m_startTime);
             m_ctx->httpResponse = response;
+            if (response != nullptr)
+            {
+                m_memory.Add(response->GetBody().size());
+            }
 #ifdef USE_SYNC_HTTPRESPONSE_HANDLER // handle HTTP callback synchronously in context of a callback thread
             // We need to decide on pros and cons of synchronous vs. asynchronous callback
             m_hcm.onHttpResponse(this);
@@ -72,16 +79,22 @@ namespace MAT_NS_BEGIN {
     public:
         HttpClientManager&      m_hcm;
         EventsUploadContextPtr  m_ctx;
+        std::string             m_requestId;
         int64_t                 m_startTime;
+        MemoryCharge            m_memory;
     };
 
     //---
 
-    HttpClientManager::HttpClientManager(ILogManager& logManager, IHttpClient& httpClient, ITaskDispatcher& taskDispatcher) :
+    HttpClientManager::HttpClientManager(ILogManager& logManager, IHttpClient& httpClient, ITaskDispatcher& taskDispatcher, MemoryBudget* memoryBudget) :
         m_logManager(logManager),
         m_httpClient(httpClient),
-        m_taskDispatcher(taskDispatcher)
+        m_taskDispatcher(taskDispatcher),
+        m_memoryBudget(memoryBudget)
     {
+        ILogConfiguration& configuration = logManager.GetLogConfiguration();
+        const char* sharedRuntime = configuration.HasConfig(CFG_STR_SHARED_RUNTIME) ? static_cast<const char*>(configuration[CFG_STR_SHARED_RUNTIME]) : nullptr;
+        m_isClientShared = (sharedRuntime != nullptr) && (sharedRuntime[0] != '\0');
     }
 
     HttpClientManager::~HttpClientManager() noexcept
@@ -142,7 +155,25 @@ namespace MAT_NS_BEGIN {
 
     bool HttpClientManager::cancelAllRequestsAsync()
     {
-        m_httpClient.CancelAllRequests();
+        if (!m_isClientShared)
+        {
+            m_httpClient.CancelAllRequests();
+            return true;
+        }
+
+        // The client also carries the requests of the other instances of the shared runtime
+        std::vector<std::string> requestIds;
+        {
+            LOCKGUARD(m_httpCallbacksMtx);
+            for (HttpCallback* callback : m_httpCallbacks)
+            {
+                requestIds.push_back(callback->m_requestId);
+            }
+        }
+        for (auto const& requestId : requestIds)
+        {
+            m_httpClient.CancelRequestAsync(requestId);
+        }
         return true;
     }
 
@@ -12,6 +12,8 @@
 
 #include <list>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace MAT_NS_BEGIN
 {
@@ -24,7 +26,8 @@ class HttpClientManager
         HttpClientManager(
                 ILogManager& logManager,
                 IHttpClient& httpClient,
-                ITaskDispatcher& taskDispatcher);
+                ITaskDispatcher& taskDispatcher,
+                MemoryBudget* memoryBudget = nullptr);
 
         virtual ~HttpClientManager() noexcept;
 
@@ -54,8 +57,10 @@ class HttpClientManager
         ILogManager&              m_logManager;
         IHttpClient&              m_httpClient;
         ITaskDispatcher&          m_taskDispatcher;
+        MemoryBudget*             m_memoryBudget;
         std::recursive_mutex      m_httpCallbacksMtx;
         std::list<HttpCallback*>  m_httpCallbacks;
+        bool                      m_isClientShared;
 };
 
 } MAT_NS_END
@@ -64,7 +64,7 @@ public:
 
 		void AddHeader(std::string &&key, std::string &&value)
 		{
-			m_headers.emplace(std::move(key), std::move(value));
+			m_headers.add(std::move(key), std::move(value));
 		}
 
 		void SetBody(size_t length, const uint8_t *body)
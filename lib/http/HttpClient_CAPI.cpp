@@ -115,7 +115,7 @@ namespace MAT_NS_BEGIN {
                 for (int32_t i = 0; i < capiResponse->headersCount; ++i)
                 {
                     const http_header_t* capiHeader = &capiResponse->headers[i];
-                    response->m_headers.emplace(capiHeader->name, capiHeader->value);
+                    response->m_headers.add(capiHeader->name, capiHeader->value);
                 }
             }
 
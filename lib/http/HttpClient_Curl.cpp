@@ -69,12 +69,7 @@ namespace MAT_NS_BEGIN {
         auto curlRequest = static_cast<CurlHttpRequest*>(request);
 
         std::string requestId = curlRequest->GetId();
-        std::map<std::string, std::string> requestHeaders;
-        for (const auto& header : curlRequest->m_headers) {
-            requestHeaders[header.first] = header.second;
-        }
-
-        auto curlOperation = std::make_shared<CurlHttpOperation>(curlRequest->m_method, curlRequest->m_url, callback, requestHeaders, curlRequest->m_body);
+        auto curlOperation = std::make_shared<CurlHttpOperation>(curlRequest->m_method, curlRequest->m_url, callback, curlRequest->m_headers, curlRequest->m_body);
         curlRequest->SetOperation(curlOperation);
         
         // The lifetime of curlOperation is guarnteed by the call to result.wait() in the d'tor.  
@@ -98,8 +93,7 @@ namespace MAT_NS_BEGIN {
                 }
             }
 
-            auto responseHeaders = operation.GetResponseHeaders();
-            response->m_headers.insert(responseHeaders.begin(), responseHeaders.end());
+            operation.GetResponseHeaders(response->m_headers);
             response->m_body = operation.GetResponseBody();
             
             // 'response' is no longer owned by IHttpClient and gets deleted in EventsUploadContext.clear()
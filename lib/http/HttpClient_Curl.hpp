@@ -28,11 +28,11 @@
 #include <unistd.h>
 
 #include "IHttpClient.hpp"
+#include "HttpHeaderParser.hpp"
 #include "pal/PAL.hpp"
 
 #define HTTP_CONN_TIMEOUT       5L
 #define HTTP_STATUS_REGEXP		"HTTP\\/\\d\\.\\d (\\d+)\\ .*"
-#define HTTP_HEADER_REGEXP      "(.*)\\: (.*)\\n*"
 
 #undef TRACE
 #define TRACE(...)	// printf
@@ -83,7 +83,7 @@ public:
             std::string url,
             IHttpResponseCallback* callback,
             // Default empty headers and empty request body
-            const std::map<std::string, std::string>& requestHeaders = std::map<std::string, std::string>(),
+            const HttpHeaders& requestHeaders                        = HttpHeaders(),
             const std::vector<uint8_t>& requestBody                  = std::vector<uint8_t>(),
             // Default connectivity and response size options
             bool rawResponse                                         = false,
@@ -322,28 +322,16 @@ cleanup:
     }
 
     /**
-     * Return a copy of resposne headers
+     * Append response headers to the given container
      *
-     * @return
+     * @param headers
      */
-    std::map<std::string, std::string> GetResponseHeaders()
+    void GetResponseHeaders(HttpHeaders& headers)
     {
-        std::map<std::string, std::string> result;
         if (respHeaders.size() == 0)
-            return result;
-
-        std::stringstream ss;
-        std::string headers((const char *)&respHeaders[0], respHeaders.size());
-        ss.str(headers);
+            return;
 
-        std::string header;
-        while (std::getline(ss, header, '\n')) {
-            std::smatch match;
-            std::regex http_headers_regex(HTTP_HEADER_REGEXP);
-            if (std::regex_search(header, match, http_headers_regex))
-                result[match[1]] = match[2];    // Key: value
-        }
-        return result;
+        HttpHeaderParser::Parse(reinterpret_cast<const char *>(respHeaders.data()), respHeaders.size(), headers);
     }
 
     /**
@@ -416,7 +404,7 @@ protected:
     // Request values
     std::string m_method;
     std::string m_url;
-    const std::map<std::string, std::string>& requestHeaders;
+    const HttpHeaders& requestHeaders;
     const std::vector<uint8_t>& requestBody;
     struct curl_slist *m_headersChunk = nullptr;
 
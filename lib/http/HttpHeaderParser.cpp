@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "HttpHeaderParser.hpp"
+
+#include <string.h>
+#include <vector>
+
+namespace MAT_NS_BEGIN {
+
+    static bool isWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    size_t HttpHeaderParser::Parse(char const* data, size_t size, HttpHeaders& headers)
+    {
+        // Headers appended from the response being parsed, in order
+        std::vector<HttpHeaders::iterator> added;
+        char const* const end = data + size;
+        char const* line = data;
+        while (line < end)
+        {
+            char const* lineEnd = static_cast<char const*>(memchr(line, '\n', static_cast<size_t>(end - line)));
+            char const* next = (lineEnd != nullptr) ? lineEnd + 1 : end;
+            if (lineEnd == nullptr)
+            {
+                lineEnd = end;
+            }
+            while (lineEnd > line && isWhitespace(lineEnd[-1]))
+            {
+                lineEnd--;
+            }
+
+            if (lineEnd - line >= 5 && memcmp(line, "HTTP/", 5) == 0)
+            {
+                // Status line of another response: whatever came before belonged to an interim one
+                for (auto const& it : added)
+                {
+                    headers.erase(it);
+                }
+                added.clear();
+            }
+            else if (line < lineEnd && isWhitespace(*line))
+            {
+                // Obsolete line folding, RFC 7230 section 3.2.4
+                if (!added.empty())
+                {
+                    while (isWhitespace(*line))
+                    {
+                        line++;
+                    }
+                    std::string& value = added.back()->second;
+                    value.push_back(' ');
+                    value.append(line, lineEnd);
+                }
+            }
+            else
+            {
+                char const* colon = static_cast<char const*>(memchr(line, ':', static_cast<size_t>(lineEnd - line)));
+                if (colon != nullptr)
+                {
+                    char const* nameEnd = colon;
+                    while (nameEnd > line && isWhitespace(nameEnd[-1]))
+                    {
+                        nameEnd--;
+                    }
+                    char const* value = colon + 1;
+                    while (value < lineEnd && isWhitespace(*value))
+                    {
+                        value++;
+                    }
+                    if (nameEnd > line)
+                    {
+                        added.push_back(headers.add(std::string(line, nameEnd), std::string(value, lineEnd)));
+                    }
+                }
+            }
+            line = next;
+        }
+        return added.size();
+    }
+
+} MAT_NS_END
@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef HTTPHEADERPARSER_HPP
+#define HTTPHEADERPARSER_HPP
+
+#include "pal/PAL.hpp"
+#include "IHttpClient.hpp"
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// Tokenizer of raw HTTP response header blocks, as handed over by the HTTP stacks that
+    /// do not split the headers themselves.
+    /// </summary>
+    class HttpHeaderParser
+    {
+    public:
+        /// <summary>
+        /// Appends the headers found in a raw header block to <paramref name="headers"/>.
+        /// Lines are separated by LF or CRLF, names and values are trimmed of surrounding whitespace,
+        /// and folded continuation lines are joined to the header they continue. When the block holds
+        /// several responses (e.g. "100 Continue" before the final one), only the headers of the last
+        /// response are kept.
+        /// </summary>
+        /// <param name="data">The raw header block, including the status lines.</param>
+        /// <param name="size">The size of the block in bytes.</param>
+        /// <param name="headers">The container the parsed headers are appended to.</param>
+        /// <returns>The number of headers appended.</returns>
+        static size_t Parse(char const* data, size_t size, HttpHeaders& headers);
+    };
+
+} MAT_NS_END
+
+#endif // HTTPHEADERPARSER_HPP
@@ -4,6 +4,7 @@
 //
 
 #include "HttpRequestEncoder.hpp"
+#include "utils/Crc32.hpp"
 #include "utils/StringUtils.hpp"
 #include "pal/PAL.hpp"
 
@@ -35,64 +36,82 @@ namespace MAT_NS_BEGIN {
         m_system.getLogManager().GetDataViewerCollection().DispatchDataViewerEvent(dataPacket);
     }
 
-    bool HttpRequestEncoder::handleEncode(EventsUploadContextPtr const& ctx)
+    /// <summary>
+    /// Rebuilds the headers shared by all requests when the auth tokens or the strict mode changed since the last time.
+    /// </summary>
+    void HttpRequestEncoder::refreshStaticHeaders()
     {
-        ctx->httpRequest = m_httpClient.CreateRequest();
-        ctx->httpRequestId = ctx->httpRequest->GetId();
-
-        ctx->httpRequest->SetMethod("POST");
-
-        ctx->httpRequest->SetUrl(m_config.GetCollectorUrl());
-
-        ctx->httpRequest->GetHeaders().set("Expect", "100-continue");
-        ctx->httpRequest->GetHeaders().set("SDK-Version", PAL::getSdkVersion());
-        ctx->httpRequest->GetHeaders().set("Client-Id", "NO_AUTH");
-        ctx->httpRequest->GetHeaders().set("Content-Type", "application/bond-compact-binary");
-        ctx->httpRequest->GetHeaders().set("Upload-Time", toString(PAL::getUtcSystemTimeMs()));
-
-
-        if (GetAuthTokensController() != nullptr && GetAuthTokensController()->GetDeviceTokens().size() > 0)
+        IAuthTokensController* controller = GetAuthTokensController();
+        if (controller != nullptr)
         {
-            std::map<TicketType, std::string>& map = GetAuthTokensController()->GetDeviceTokens();
-            if (map.end() != map.find(TicketType::TicketType_MSA_Device))
+            if (m_staticHeadersValid && controller->GetDeviceTokens() == m_deviceTokens &&
+                controller->GetUserTokens() == m_userTokens && controller->GetStrictMode() == m_strictMode)
             {
-                ctx->httpRequest->GetHeaders().set("AuthMsaDeviceTicket", map[TicketType::TicketType_MSA_Device]);
+                return;
             }
-
-            if (map.end() != map.find(TicketType::TicketType_XAuth_Device))
+            m_deviceTokens = controller->GetDeviceTokens();
+            m_userTokens = controller->GetUserTokens();
+            m_strictMode = controller->GetStrictMode();
+        }
+        else
+        {
+            if (m_staticHeadersValid && m_deviceTokens.empty() && m_userTokens.empty() && !m_strictMode)
             {
-                ctx->httpRequest->GetHeaders().set("AuthXToken", map[TicketType::TicketType_XAuth_Device]);
+                return;
             }
+            m_deviceTokens.clear();
+            m_userTokens.clear();
+            m_strictMode = false;
+        }
 
-            if (map.end() != map.find(TicketType::TicketType_AAD))
-            {
-                ctx->httpRequest->GetHeaders().set("Aad-Token", map[TicketType::TicketType_AAD]);
-            }
+        m_staticHeaders.clear();
+        m_staticHeaders.set("Expect", "100-continue");
+        m_staticHeaders.set("SDK-Version", PAL::getSdkVersion());
+        m_staticHeaders.set("Client-Id", "NO_AUTH");
+        m_staticHeaders.set("Content-Type", "application/bond-compact-binary");
 
-            if (map.end() != map.find(TicketType::TicketType_AAD_JWT))
-            {
-                ctx->httpRequest->GetHeaders().set("Aad-Jwt-Token", map[TicketType::TicketType_AAD_JWT]);
-            }
+        auto it = m_deviceTokens.find(TicketType::TicketType_MSA_Device);
+        if (it != m_deviceTokens.end())
+        {
+            m_staticHeaders.set("AuthMsaDeviceTicket", it->second);
         }
 
-        if (GetAuthTokensController() != nullptr && GetAuthTokensController()->GetUserTokens().size() > 0)
-        {  //create Ticket header
-            std::map<TicketType, std::string>& map = GetAuthTokensController()->GetUserTokens();
+        it = m_deviceTokens.find(TicketType::TicketType_XAuth_Device);
+        if (it != m_deviceTokens.end())
+        {
+            m_staticHeaders.set("AuthXToken", it->second);
+        }
+
+        it = m_deviceTokens.find(TicketType::TicketType_AAD);
+        if (it != m_deviceTokens.end())
+        {
+            m_staticHeaders.set("Aad-Token", it->second);
+        }
 
+        it = m_deviceTokens.find(TicketType::TicketType_AAD_JWT);
+        if (it != m_deviceTokens.end())
+        {
+            m_staticHeaders.set("Aad-Jwt-Token", it->second);
+        }
+
+        if (!m_userTokens.empty())
+        {  //create Ticket header
             std::string ticketHeader;
             // We know that each ticket is about 1kb in size, so pre-reserve space for the appends
-            ticketHeader.reserve(GetAuthTokensController()->GetUserTokens().size() * 1024);//
+            ticketHeader.reserve(m_userTokens.size() * 1024);
 
-            if (map.end() != map.find(TicketType::TicketType_MSA_User))
+            it = m_userTokens.find(TicketType::TicketType_MSA_User);
+            if (it != m_userTokens.end())
             {
                 ticketHeader.append("\"");
                 ticketHeader.append(TICKETS_PREPEND_STRING + std::to_string(TicketType::TicketType_MSA_User));
                 ticketHeader.append("\"=\"");
                 ticketHeader.append("p:");
-                ticketHeader.append(map[TicketType::TicketType_MSA_User]);
+                ticketHeader.append(it->second);
                 ticketHeader.append("\"");
             }
-            if (map.end() != map.find(TicketType::TicketType_XAuth_User))
+            it = m_userTokens.find(TicketType::TicketType_XAuth_User);
+            if (it != m_userTokens.end())
             {
                 if (!ticketHeader.empty())
                 {
@@ -102,10 +121,11 @@ namespace MAT_NS_BEGIN {
                 ticketHeader.append(TICKETS_PREPEND_STRING + std::to_string(TicketType::TicketType_XAuth_User));
                 ticketHeader.append("\"=\"");
                 ticketHeader.append("x:XBL3.0 x=");
-                ticketHeader.append(map[TicketType::TicketType_XAuth_User]);
+                ticketHeader.append(it->second);
                 ticketHeader.append("\"");
             }
-            if (map.end() != map.find(TicketType::TicketType_AAD_User))
+            it = m_userTokens.find(TicketType::TicketType_AAD_User);
+            if (it != m_userTokens.end())
             {
                 if (!ticketHeader.empty())
                 {
@@ -115,20 +135,49 @@ namespace MAT_NS_BEGIN {
                 ticketHeader.append(TICKETS_PREPEND_STRING + std::to_string(TicketType::TicketType_AAD_User));
                 ticketHeader.append("\"=\"");
                 ticketHeader.append("at:");
-                ticketHeader.append(map[TicketType::TicketType_AAD_User]);
+                ticketHeader.append(it->second);
                 ticketHeader.append("\"");
             }
 
             if (!ticketHeader.empty())
             {
-                ctx->httpRequest->GetHeaders().set("Tickets", ticketHeader);
+                m_staticHeaders.set("Tickets", ticketHeader);
             }
         }
         //strict mode
-        if (GetAuthTokensController() != nullptr && true == GetAuthTokensController()->GetStrictMode())
+        if (m_strictMode)
         {
-            ctx->httpRequest->GetHeaders().set("Strict", "true");
+            m_staticHeaders.set("Strict", "true");
         }
+        m_staticHeadersValid = true;
+    }
+
+    bool HttpRequestEncoder::handleEncode(EventsUploadContextPtr const& ctx)
+    {
+        ctx->httpRequest = m_httpClient.CreateRequest();
+        ctx->httpRequestId = ctx->httpRequest->GetId();
+
+        ctx->httpRequest->SetMethod("POST");
+
+        ctx->httpRequest->SetUrl(m_config.GetCollectorUrl());
+
+        HttpHeaders& headers = ctx->httpRequest->GetHeaders();
+        {
+            LOCKGUARD(m_staticHeadersLock);
+            refreshStaticHeaders();
+            if (headers.empty())
+            {
+                headers = m_staticHeaders;
+            }
+            else
+            {
+                for (auto const& header : m_staticHeaders)
+                {
+                    headers.set(header.first, header.second);
+                }
+            }
+        }
+        headers.set("Upload-Time", toString(PAL::getUtcSystemTimeMs()));
 
         std::string tenantTokens;
         tenantTokens.reserve(ctx->packageIds.size() * 75); // Tenants tokens are usually 74 chars long.
@@ -138,10 +187,17 @@ namespace MAT_NS_BEGIN {
             }
             tenantTokens.append(item.first);
         }
-        ctx->httpRequest->GetHeaders().set("APIKey", tenantTokens);
+        headers.set("APIKey", tenantTokens);
 
         if (ctx->compressed) {
-            ctx->httpRequest->GetHeaders().add("Content-Encoding", "deflate");
+            headers.add("Content-Encoding", "deflate");
+        }
+
+        if (m_config[CFG_BOOL_ENABLE_CRC32]) {
+            // Checksum of the body as sent on the wire, i.e. after compression
+            char checksum[9];
+            snprintf(checksum, sizeof(checksum), "%08x", Crc32::Crc32c(ctx->body.data(), ctx->body.size()));
+            headers.set("Payload-CRC32C", checksum);
         }
 
 
@@ -155,6 +211,8 @@ namespace MAT_NS_BEGIN {
         ctx->httpRequest->SetBody(ctx->body);
         // IHttpRequest::SetBody() is free to swap the real body out, but better clear it anyway.
         ctx->body.clear();
+        // From now on the body is accounted to the in-flight request by HttpClientManager
+        ctx->packagingMemory.Reset();
 
         ctx->httpRequest->SetLatency(ctx->latency);
 
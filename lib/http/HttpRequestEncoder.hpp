@@ -14,6 +14,9 @@
 
 #include "IAuthTokensController.hpp"
 
+#include <map>
+#include <mutex>
+
 namespace MAT_NS_BEGIN {
 
     class HttpRequestEncoder {
@@ -25,11 +28,20 @@ namespace MAT_NS_BEGIN {
 
     protected:
         bool handleEncode(EventsUploadContextPtr const& ctx);
+        void refreshStaticHeaders();
 
         ITelemetrySystem &      m_system;
         IHttpClient &           m_httpClient;
         IRuntimeConfig&         m_config;
 
+        // Headers that are the same for every request until the auth tokens change, built once
+        std::mutex              m_staticHeadersLock;
+        HttpHeaders             m_staticHeaders;
+        bool                    m_staticHeadersValid {};
+        std::map<TicketType, std::string> m_deviceTokens;
+        std::map<TicketType, std::string> m_userTokens;
+        bool                    m_strictMode {};
+
         IAuthTokensController* GetAuthTokensController()
         {
             return m_system.getLogManager().GetAuthTokensController();
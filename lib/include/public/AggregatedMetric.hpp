@@ -60,8 +60,14 @@ namespace MAT_NS_BEGIN
             /// </summary>
             ~AggregatedMetric();
 
+            AggregatedMetric(AggregatedMetric const&) = delete;
+            AggregatedMetric& operator=(AggregatedMetric const&) = delete;
+
             /// <summary>
             /// Pushes a single metric value for auto-aggregation.
+            /// Values are aggregated per interval and logged as one aggregated metric event
+            /// when the interval elapses, and once more when the AggregatedMetric is destroyed.
+            /// This method is thread-safe.
             /// </summary>
             /// <param name="value">The metric value to push.</param>
             void PushMetric(double value);
@@ -59,6 +59,16 @@ namespace MAT_NS_BEGIN
             return evt_log(handle, evt);
         }
 
+        evt_handle_t getLogger(const char* token = NULL, const char* source = NULL)
+        {
+            return evt_get_logger(handle, token, source);
+        }
+
+        evt_status_t logBatch(evt_handle_t logger, evt_batch_item_t* events, uint32_t count, uint32_t* logged = NULL)
+        {
+            return evt_log_batch(handle, logger, events, count, logged);
+        }
+
         evt_status_t pause()
         {
             return evt_pause(handle);
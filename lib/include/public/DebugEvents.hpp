@@ -75,6 +75,8 @@ namespace MAT_NS_BEGIN
         EVT_DROPPED             = 0x03000000,
         /// <summary>Event(s) filtered.</summary>
         EVT_FILTERED            = 0x03000001,
+        /// <summary>Event(s) dropped by client-side sampling.</summary>
+        EVT_SAMPLED             = 0x03000002,
 
         /// <summary>Event(s) sent.</summary>
         EVT_SENT                = 0x04000000,
@@ -125,9 +127,14 @@ namespace MAT_NS_BEGIN
         EVT_STORAGE_FULL        = 0x0E000000,
         /// <summary>Storage failed.</summary>
         EVT_STORAGE_FAILED      = 0x0E000001,
+        /// <summary>Storage opened and ready: param1 is the time it took to open, in milliseconds.</summary>
+        EVT_STORAGE_READY       = 0x0E000002,
 
         /// <summary>Ticket Expired</summary>
         EVT_TICKET_EXPIRED      = 0x0F000000,
+
+        /// <summary>Pipeline stage latency sample: param1 is the PipelineStage, param2 the duration in microseconds.</summary>
+        EVT_PIPELINE_LATENCY    = 0x10000000,
         /// <summary>Unknown error.</summary>
         EVT_UNKNOWN             = 0xDEADBEEF,
 
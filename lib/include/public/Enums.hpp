@@ -517,6 +517,19 @@ namespace MAT_NS_BEGIN
         TransmitProfile_BestEffort = 2
     };
 
+    /// <summary>
+    /// Storage layouts available for EventProperties.
+    /// </summary>
+    enum PropertyStorageMode
+    {
+        /// <summary>Properties are kept in a std::map keyed by property name (default).</summary>
+        PropertyStorageMode_Map = 0,
+        /// <summary>Properties are kept in a flat sorted array, with names and string values
+        /// copied into an arena owned by the EventProperties object. Reduces heap allocations
+        /// on the hot path of building an event.</summary>
+        PropertyStorageMode_Flat = 1
+    };
+
     /// <summary>Event rejected due to legit reasoning</summary>
     enum EventRejectedReason
     {
@@ -17,6 +17,7 @@
 #include <stdint.h>
 #include <string>
 #include <tuple>
+#include <type_traits>
 
 #ifdef MAT_C_API
 #include "mat.h"
@@ -25,6 +26,7 @@
 namespace MAT_NS_BEGIN
 {
     struct EventPropertiesStorage;
+    class FlatProperties;
 
     /// <summary>
     /// The EventProperties class encapsulates event properties.
@@ -83,6 +85,16 @@ namespace MAT_NS_BEGIN
         /// </summary>
         EventProperties(const std::string& name, std::initializer_list<std::pair<std::string const, EventProperty>> properties);
 
+        /// <summary>
+        /// Constructs an EventProperties object that uses the specified property storage layout.
+        /// <b>PropertyStorageMode_Flat</b> keeps properties in a flat array backed by an arena,
+        /// sized up-front for the expected number of properties.
+        /// </summary>
+        /// <param name="name">Event name.</param>
+        /// <param name="storageMode">Property storage layout.</param>
+        /// <param name="expectedPropertyCount">Number of properties to reserve space for.</param>
+        EventProperties(const std::string& name, PropertyStorageMode storageMode, size_t expectedPropertyCount = 0);
+
         /// <summary>
         /// An EventProperties assignment operator using C++11 initializer list.
         /// </summary>
@@ -199,7 +211,7 @@ namespace MAT_NS_BEGIN
         /// </summary>
         void SetLevel(uint8_t level)
         {
-            SetProperty(COMMONFIELDS_EVENT_LEVEL, level);
+            SetPropertyView(string_view_t::literal(COMMONFIELDS_EVENT_LEVEL), static_cast<int64_t>(level));
         }
 
         ///
@@ -343,12 +355,83 @@ namespace MAT_NS_BEGIN
         /// </summary>
         void SetProperty(const std::string& name, std::vector<int64_t>& value, PiiKind piiKind = PiiKind_None, DataCategory category = DataCategory_PartC);
 
+        /// <summary>
+        /// Specify a property for an event without constructing std::string temporaries.
+        /// Name and value are copied into the property storage, so they only need to
+        /// remain valid for the duration of the call.
+        /// It either creates a new property if none exists or overwrites the existing one.
+        /// </summary>
+        void SetPropertyView(string_view_t name, string_view_t value, PiiKind piiKind = PiiKind_None, DataCategory category = DataCategory_PartC);
+
+        /// <summary>
+        /// Specify a property for an event without constructing std::string temporaries.
+        /// It either creates a new property if none exists or overwrites the existing one.
+        /// </summary>
+        void SetPropertyView(string_view_t name, char const* value, PiiKind piiKind = PiiKind_None, DataCategory category = DataCategory_PartC)
+        {
+            SetPropertyView(name, string_view_t(value), piiKind, category);
+        }
+
+        /// <summary>
+        /// Specify a property for an event without constructing std::string temporaries.
+        /// It either creates a new property if none exists or overwrites the existing one.
+        /// </summary>
+        void SetPropertyView(string_view_t name, double value, PiiKind piiKind = PiiKind_None, DataCategory category = DataCategory_PartC);
+
+        /// <summary>
+        /// Specify a property for an event without constructing std::string temporaries.
+        /// It either creates a new property if none exists or overwrites the existing one.
+        /// </summary>
+        void SetPropertyView(string_view_t name, int64_t value, PiiKind piiKind = PiiKind_None, DataCategory category = DataCategory_PartC);
+
+        /// <summary>
+        /// Specify a property for an event without constructing std::string temporaries.
+        /// It either creates a new property if none exists or overwrites the existing one.
+        /// </summary>
+        void SetPropertyView(string_view_t name, bool value, PiiKind piiKind = PiiKind_None, DataCategory category = DataCategory_PartC);
+
+        /// <summary>
+        /// Specify a property for an event without constructing std::string temporaries.
+        /// It either creates a new property if none exists or overwrites the existing one.
+        /// </summary>
+        void SetPropertyView(string_view_t name, time_ticks_t value, PiiKind piiKind = PiiKind_None, DataCategory category = DataCategory_PartC);
+
+        /// <summary>
+        /// Specify a property for an event without constructing std::string temporaries.
+        /// It either creates a new property if none exists or overwrites the existing one.
+        /// </summary>
+        void SetPropertyView(string_view_t name, GUID_t value, PiiKind piiKind = PiiKind_None, DataCategory category = DataCategory_PartC);
+
+        /// <summary>
+        /// Specify a property for an event without constructing std::string temporaries.
+        /// Integral values of any other width are stored as int64_t.
+        /// </summary>
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type
+        SetPropertyView(string_view_t name, T value, PiiKind piiKind = PiiKind_None, DataCategory category = DataCategory_PartC)
+        {
+            SetPropertyView(name, static_cast<int64_t>(value), piiKind, category);
+        }
+
+        /// <summary>
+        /// Get the property storage layout used by this event.
+        /// </summary>
+        PropertyStorageMode GetStorageMode() const;
+
         /// <summary>
         /// Get the properties bag of an event.
+        /// For <b>PropertyStorageMode_Flat</b> the map is materialized on first access after a modification.
         /// </summary>
         /// <returns>Properties bag of the event</returns>
         const std::map<std::string, EventProperty>& GetProperties(DataCategory category = DataCategory_PartC) const;
 
+        /// <summary>
+        /// Get the flat Part C property storage of an event, so that the SDK can iterate it
+        /// without materializing GetProperties().
+        /// </summary>
+        /// <returns>Flat properties, or nullptr for <b>PropertyStorageMode_Map</b></returns>
+        const FlatProperties* GetFlatProperties() const;
+
         /// <summary>
         /// Get the Pii properties bag of an event.
         /// </summary>
@@ -369,6 +452,8 @@ namespace MAT_NS_BEGIN
 #endif
 
        private:
+        void setPropertyView(string_view_t name, EventProperty&& prop);
+
         EventPropertiesStorage* m_storage;
     };
 } MAT_NS_END
@@ -18,6 +18,7 @@
 #include <ctime>
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
 
 #ifdef _WIN32
 /* Required for GUID type helper function on Windows */
@@ -225,6 +226,64 @@ namespace MAT_NS_BEGIN
     };
     /// @endcond
 
+    /// <summary>
+    /// The string_view_t structure is a non-owning reference to a character sequence,
+    /// a C++11 stand-in for std::string_view. The referenced data must stay valid
+    /// for the duration of the call that receives the view.
+    /// </summary>
+    struct string_view_t
+    {
+        /// <summary>
+        /// Pointer to the first character of the sequence (not necessarily NUL-terminated).
+        /// </summary>
+        const char* data;
+
+        /// <summary>
+        /// Number of characters in the sequence.
+        /// </summary>
+        size_t size;
+
+        /// <summary>
+        /// True if the characters have static storage duration, see literal().
+        /// Flat EventProperties reference such names in place instead of copying them.
+        /// </summary>
+        bool is_static;
+
+        string_view_t() : data(""), size(0), is_static(true) {}
+
+        string_view_t(const char* str) : data(str), size((str != nullptr) ? strlen(str) : 0), is_static(false)
+        {
+            if (str == nullptr)
+            {
+                data = "";
+                is_static = true;
+            }
+        }
+
+        string_view_t(const char* str, size_t length) : data(str), size(length), is_static(false) {}
+
+        string_view_t(const std::string& str) : data(str.data()), size(str.size()), is_static(false) {}
+
+        /// <summary>
+        /// Returns a view of a string literal (or any other character array with static storage duration).
+        /// </summary>
+        template <size_t N>
+        static string_view_t literal(const char (&str)[N])
+        {
+            string_view_t result(str, N - 1);
+            result.is_static = true;
+            return result;
+        }
+
+        /// <summary>
+        /// Returns an owning copy of the referenced characters.
+        /// </summary>
+        std::string str() const
+        {
+            return std::string(data, size);
+        }
+    };
+
     /// <summary>
     /// The EventProperty structure represents a C++11 variant object that holds an event property type 
     /// and an event property value.
@@ -316,9 +375,10 @@ namespace MAT_NS_BEGIN
 
         /// <summary>
         /// The EventProperty move constructor.
+        /// Heap-allocated values (strings and arrays) are transferred without copying.
         /// </summary>
         /// <param name="source">The EventProperty object to move.</param>
-        EventProperty(EventProperty&& source);
+        EventProperty(EventProperty&& source) noexcept;
 
         /// <summary>
         /// The EventProperty equalto operator.
@@ -330,6 +390,12 @@ namespace MAT_NS_BEGIN
         /// </summary>
         EventProperty& operator=(const EventProperty& source);
 
+        /// <summary>
+        /// An EventProperty move assignment operator.
+        /// Heap-allocated values (strings and arrays) are transferred without copying.
+        /// </summary>
+        EventProperty& operator=(EventProperty&& source) noexcept;
+
         /// <summary>
         /// An EventProperty assignment operator that takes a string value.
         /// </summary>
@@ -519,6 +585,8 @@ namespace MAT_NS_BEGIN
     private:
         void copydata(EventProperty const* source);
 
+        void release() noexcept;
+
     };
 
 } MAT_NS_END
@@ -0,0 +1,383 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef EVENTSCHEMA_HPP
+#define EVENTSCHEMA_HPP
+
+#include "Version.hpp"
+
+#include "CommonFields.h"
+#include "CsProtocol_types.hpp"
+#include "Enums.hpp"
+#include "EventProperties.hpp"
+#include "EventProperty.hpp"
+#include "ctmacros.hpp"
+
+#include <map>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace MAT_NS_BEGIN
+{
+    namespace schema
+    {
+        /// <summary>
+        /// Compile-time counterpart of validatePropertyName: [0-9A-Za-z_.] characters only,
+        /// must not start or end with a dot.
+        /// </summary>
+        constexpr bool isPropertyNameChar(char ch)
+        {
+            return ((ch >= '0') && (ch <= '9')) || ((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z')) || (ch == '_') || (ch == '.');
+        }
+
+        constexpr bool hasOnlyPropertyNameChars(const char* name, size_t length)
+        {
+            return (length == 0) || (isPropertyNameChar(name[0]) && hasOnlyPropertyNameChars(name + 1, length - 1));
+        }
+
+        template <size_t N>
+        constexpr bool isValidPropertyName(const char (&name)[N])
+        {
+            return (N >= 2) && (N - 1 <= 100) && (name[0] != '.') && (name[N - 2] != '.') && hasOnlyPropertyNameChars(name, N - 1);
+        }
+
+        /// <summary>
+        /// Compile-time counterpart of validateEventName: 4 to 100 characters, [0-9A-Za-z_.] only.
+        /// </summary>
+        template <size_t N>
+        constexpr bool isValidEventName(const char (&name)[N])
+        {
+            return (N - 1 >= 4) && (N - 1 <= 100) && hasOnlyPropertyNameChars(name, N - 1);
+        }
+
+        /// <summary>
+        /// Maps a C++ field type onto its CsProtocol::Value and EventProperty representations.
+        /// Only the types below are supported: using any other type fails to compile.
+        /// </summary>
+        template <typename T, typename Enable = void>
+        struct FieldTraits;
+
+        template <typename T>
+        struct FieldTraits<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+        {
+            static void ToValue(T value, ::CsProtocol::Value& result)
+            {
+                result.type = ::CsProtocol::ValueKind::ValueInt64;
+                result.longValue = static_cast<int64_t>(value);
+            }
+
+            static EventProperty ToProperty(T value)
+            {
+                return EventProperty(static_cast<int64_t>(value));
+            }
+        };
+
+        template <typename T>
+        struct FieldTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+        {
+            static void ToValue(T value, ::CsProtocol::Value& result)
+            {
+                result.type = ::CsProtocol::ValueKind::ValueDouble;
+                result.doubleValue = static_cast<double>(value);
+            }
+
+            static EventProperty ToProperty(T value)
+            {
+                return EventProperty(static_cast<double>(value));
+            }
+        };
+
+        template <>
+        struct FieldTraits<bool>
+        {
+            static void ToValue(bool value, ::CsProtocol::Value& result)
+            {
+                result.type = ::CsProtocol::ValueKind::ValueBool;
+                result.longValue = value;
+            }
+
+            static EventProperty ToProperty(bool value)
+            {
+                return EventProperty(value);
+            }
+        };
+
+        template <>
+        struct FieldTraits<std::string>
+        {
+            static void ToValue(const std::string& value, ::CsProtocol::Value& result)
+            {
+                result.type = ::CsProtocol::ValueKind::ValueString;
+                result.stringValue = value;
+            }
+
+            static EventProperty ToProperty(const std::string& value)
+            {
+                return EventProperty(value);
+            }
+        };
+
+        template <>
+        struct FieldTraits<time_ticks_t>
+        {
+            static void ToValue(const time_ticks_t& value, ::CsProtocol::Value& result)
+            {
+                result.type = ::CsProtocol::ValueKind::ValueDateTime;
+                result.longValue = value.ticks;
+            }
+
+            static EventProperty ToProperty(const time_ticks_t& value)
+            {
+                return EventProperty(value);
+            }
+        };
+
+        template <>
+        struct FieldTraits<GUID_t>
+        {
+            static void ToValue(const GUID_t& value, ::CsProtocol::Value& result)
+            {
+                uint8_t bytes[16] = { 0 };
+                value.to_bytes(bytes);
+                result.type = ::CsProtocol::ValueKind::ValueGuid;
+                result.guidValue.clear();
+                result.guidValue.emplace_back(bytes, bytes + sizeof(bytes));
+            }
+
+            static EventProperty ToProperty(const GUID_t& value)
+            {
+                return EventProperty(value);
+            }
+        };
+
+        /// <summary>
+        /// Inserts or overwrites a record property, reusing the map position lookup for the insertion.
+        /// </summary>
+        inline void assignValue(std::map<std::string, ::CsProtocol::Value>& properties, const std::string& key, ::CsProtocol::Value&& value)
+        {
+            auto it = properties.lower_bound(key);
+            if ((it != properties.end()) && (it->first == key))
+            {
+                it->second = std::move(value);
+            }
+            else
+            {
+                properties.emplace_hint(it, key, std::move(value));
+            }
+        }
+
+        /// <summary>
+        /// Recursive storage of the field values of an EventSchema, one base class per field.
+        /// </summary>
+        template <typename... Fields>
+        struct FieldStorage
+        {
+            void SerializeFields(std::map<std::string, ::CsProtocol::Value>&) const {}
+
+            void CopyFields(EventProperties&) const {}
+        };
+
+        template <typename Field, typename... Rest>
+        struct FieldStorage<Field, Rest...> : FieldStorage<Rest...>
+        {
+            typename Field::value_type value {};
+
+            void SerializeFields(std::map<std::string, ::CsProtocol::Value>& properties) const
+            {
+                ::CsProtocol::Value result;
+                FieldTraits<typename Field::value_type>::ToValue(value, result);
+                assignValue(properties, Field::Key(), std::move(result));
+                FieldStorage<Rest...>::SerializeFields(properties);
+            }
+
+            void CopyFields(EventProperties& properties) const
+            {
+                properties.SetProperty(Field::Key(), FieldTraits<typename Field::value_type>::ToProperty(value));
+                FieldStorage<Rest...>::CopyFields(properties);
+            }
+        };
+
+        /// <summary>
+        /// Resolves the storage slot of a field. Template argument deduction picks the
+        /// FieldStorage base whose first parameter is the requested field.
+        /// </summary>
+        template <typename Field, typename... Rest>
+        typename Field::value_type& fieldValue(FieldStorage<Field, Rest...>& storage)
+        {
+            return storage.value;
+        }
+
+        template <typename Field, typename... Rest>
+        const typename Field::value_type& fieldValue(const FieldStorage<Field, Rest...>& storage)
+        {
+            return storage.value;
+        }
+
+    } // namespace schema
+
+    /// <summary>
+    /// Non-template part of an event with a compile-time schema, consumed by ILogger::LogEvent.
+    /// Holds the event envelope (latency, persistence, diagnostic level, ...) while the derived
+    /// EventSchema holds the typed field values.
+    /// </summary>
+    class EventSchemaBase
+    {
+    public:
+        virtual ~EventSchemaBase() noexcept = default;
+
+        /// <summary>
+        /// Gets the event name declared by the schema.
+        /// </summary>
+        virtual const std::string& GetName() const = 0;
+
+        /// <summary>
+        /// Writes all fields (and the diagnostic level) into the Part C properties of a record.
+        /// Names were validated at compile time, so no per-event validation is performed.
+        /// </summary>
+        virtual void SerializeProperties(std::map<std::string, ::CsProtocol::Value>& properties) const = 0;
+
+        /// <summary>
+        /// Builds an equivalent EventProperties object. Only used when event filters need
+        /// to inspect the event, since it gives up the benefits of the typed schema.
+        /// </summary>
+        virtual EventProperties ToEventProperties() const = 0;
+
+        void SetLatency(EventLatency latency) noexcept { m_latency = latency; }
+        EventLatency GetLatency() const noexcept { return m_latency; }
+
+        void SetPersistence(EventPersistence persistence) noexcept { m_persistence = persistence; }
+        EventPersistence GetPersistence() const noexcept { return m_persistence; }
+
+        void SetPopSample(double popSample) noexcept { m_popSample = popSample; }
+        double GetPopSample() const noexcept { return m_popSample; }
+
+        void SetPolicyBitFlags(uint64_t policyBitFlags) noexcept { m_policyBitFlags = policyBitFlags; }
+        uint64_t GetPolicyBitFlags() const noexcept { return m_policyBitFlags; }
+
+        void SetLevel(uint8_t level) noexcept { m_level = level; }
+        uint8_t GetLevel() const noexcept { return m_level; }
+
+    protected:
+        /// <summary>
+        /// Copies the envelope and level onto an EventProperties object.
+        /// </summary>
+        void CopyEnvelope(EventProperties& properties) const
+        {
+            properties.SetLatency(m_latency);
+            properties.SetPersistence(m_persistence);
+            properties.SetPopsample(m_popSample);
+            properties.SetPolicyBitFlags(m_policyBitFlags);
+            properties.SetLevel(m_level);
+        }
+
+        void SerializeLevel(std::map<std::string, ::CsProtocol::Value>& properties) const
+        {
+            static const std::string levelKey(COMMONFIELDS_EVENT_LEVEL);
+            ::CsProtocol::Value level;
+            schema::FieldTraits<int64_t>::ToValue(m_level, level);
+            schema::assignValue(properties, levelKey, std::move(level));
+        }
+
+        EventLatency     m_latency = EventLatency_Normal;
+        EventPersistence m_persistence = EventPersistence_Normal;
+        double           m_popSample = 100.0;
+        uint64_t         m_policyBitFlags = 0;
+        uint8_t          m_level = DIAG_LEVEL_OPTIONAL;
+    };
+
+    /// <summary>
+    /// Event with a schema known at build time. EventName is declared with MAT_SCHEMA_EVENT_NAME,
+    /// each field with MAT_SCHEMA_FIELD; both are validated at compile time. Example:
+    /// <code>
+    /// MAT_SCHEMA_EVENT_NAME(FileOpenedName, "App.FileOpened");
+    /// MAT_SCHEMA_FIELD(FileSize, "File.Size", int64_t);
+    /// MAT_SCHEMA_FIELD(FileType, "File.Type", std::string);
+    /// typedef EventSchema&lt;FileOpenedName, FileSize, FileType&gt; FileOpened;
+    ///
+    /// FileOpened event;
+    /// event.Set&lt;FileSize&gt;(1024);
+    /// event.Set&lt;FileType&gt;("docx");
+    /// logger->LogEvent(event);
+    /// </code>
+    /// </summary>
+    template <typename EventName, typename... Fields>
+    class EventSchema : public EventSchemaBase, private schema::FieldStorage<Fields...>
+    {
+        typedef schema::FieldStorage<Fields...> Storage;
+
+    public:
+        /// <summary>
+        /// Sets the value of a field.
+        /// </summary>
+        template <typename Field>
+        void Set(typename Field::value_type value)
+        {
+            schema::fieldValue<Field>(static_cast<Storage&>(*this)) = std::move(value);
+        }
+
+        /// <summary>
+        /// Gets the value of a field.
+        /// </summary>
+        template <typename Field>
+        const typename Field::value_type& Get() const
+        {
+            return schema::fieldValue<Field>(static_cast<const Storage&>(*this));
+        }
+
+        virtual const std::string& GetName() const override
+        {
+            return EventName::Name();
+        }
+
+        virtual void SerializeProperties(std::map<std::string, ::CsProtocol::Value>& properties) const override
+        {
+            SerializeLevel(properties);
+            Storage::SerializeFields(properties);
+        }
+
+        virtual EventProperties ToEventProperties() const override
+        {
+            EventProperties properties(GetName());
+            CopyEnvelope(properties);
+            Storage::CopyFields(properties);
+            return properties;
+        }
+    };
+
+} MAT_NS_END
+
+/// <summary>
+/// Declares a schema event name type. The name is validated at compile time.
+/// </summary>
+#define MAT_SCHEMA_EVENT_NAME(Identifier, EventName)                                                 \
+    struct Identifier                                                                                \
+    {                                                                                                \
+        static_assert(MAT::schema::isValidEventName(EventName), "Invalid event name: " EventName); \
+        static const std::string& Name()                                                             \
+        {                                                                                            \
+            static const std::string name(EventName);                                                \
+            return name;                                                                             \
+        }                                                                                            \
+    }
+
+/// <summary>
+/// Declares a schema field type. The property name is validated at compile time,
+/// the std::string key is built once and shared by all events using the field.
+/// </summary>
+#define MAT_SCHEMA_FIELD(Identifier, PropertyName, Type)                                                       \
+    struct Identifier                                                                                          \
+    {                                                                                                          \
+        static_assert(MAT::schema::isValidPropertyName(PropertyName), "Invalid property name: " PropertyName); \
+        typedef Type value_type;                                                                               \
+        static const std::string& Key()                                                                        \
+        {                                                                                                      \
+            static const std::string key(PropertyName);                                                        \
+            return key;                                                                                        \
+        }                                                                                                      \
+    }
+
+#endif
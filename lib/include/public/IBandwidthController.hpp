@@ -7,6 +7,8 @@
 
 #include "Version.hpp"
 
+#include <limits>
+
 namespace MAT_NS_BEGIN
 {
     class IBandwidthController {
@@ -25,6 +27,28 @@ namespace MAT_NS_BEGIN
         /// </summary>
         /// <returns>Proposed bandwidth in bytes per second</returns>
         virtual unsigned GetProposedBandwidthBps() = 0;
+
+        /// <summary>
+        /// Query the number of bytes that may be uploaded right now.
+        ///
+        /// Controllers enforcing a byte budget return what is left of it: the
+        /// SDK sizes the next HTTP request accordingly, and postpones the upload
+        /// until enough budget is available. Default: no byte budget.
+        /// </summary>
+        /// <returns>Available upload budget in bytes</returns>
+        virtual unsigned GetAvailableBytes()
+        {
+            return (std::numeric_limits<unsigned>::max)();
+        }
+
+        /// <summary>
+        /// Notifies the controller of an HTTP request about to be uploaded.
+        /// </summary>
+        /// <param name="bytes">Size of the request in bytes</param>
+        virtual void OnBytesUploaded(unsigned bytes)
+        {
+            (void)bytes;
+        }
     };
 } MAT_NS_END
 
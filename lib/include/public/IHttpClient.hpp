@@ -14,6 +14,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <utility>
 
 ///@cond INTERNAL_DOCS
 namespace MAT_NS_BEGIN
@@ -65,11 +66,21 @@ namespace MAT_NS_BEGIN
         }
 
         /// <summary>
-        /// Inserts a name/value pair into the multimap.
+        /// Inserts a name/value pair into the multimap, after the elements with the same name.
         /// </summary>
-        void add(std::string const& name, std::string const& value)
+        /// <returns>An iterator to the inserted element.</returns>
+        iterator add(std::string const& name, std::string const& value)
         {
-            insert(std::make_pair(name, value));
+            return emplace(name, value);
+        }
+
+        /// <summary>
+        /// Inserts a name/value pair into the multimap, after the elements with the same name.
+        /// </summary>
+        /// <returns>An iterator to the inserted element.</returns>
+        iterator add(std::string&& name, std::string&& value)
+        {
+            return emplace(std::move(name), std::move(value));
         }
 
         /// <summary>
@@ -83,6 +94,21 @@ namespace MAT_NS_BEGIN
             return (it != end()) ? it->second : m_empty;
         }
 
+        /// <summary>
+        /// Gets the values of every element of the specified name, in the order they were inserted.
+        /// </summary>
+        /// <param name="name">A string that contains the name to look for.</param>
+        std::vector<std::string> getAll(std::string const& name) const
+        {
+            std::vector<std::string> values;
+            auto range = equal_range(name);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                values.push_back(it->second);
+            }
+            return values;
+        }
+
         /// <summary>
         /// Tests whether the multimap contains the specified name.
         /// </summary>
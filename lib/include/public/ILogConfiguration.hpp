@@ -76,7 +76,8 @@ namespace MAT_NS_BEGIN
     static constexpr const char* const CFG_BOOL_ENABLE_MULTITENANT = "multiTenantEnabled";
 
     /// <summary>
-    /// Enable CRC-32 check.
+    /// Enable CRC-32C checksums of stored records and of upload request bodies.
+    /// Records failing verification on retrieval are dropped.
     /// </summary>
     static constexpr const char* const CFG_BOOL_ENABLE_CRC32 = "enableCRC32";
 
@@ -100,6 +101,19 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_BOOL_ENABLE_WAL_JOURNAL = "enableWALJournal";
 
+    /// <summary>
+    /// Share the cache file with other processes: events of every process are stored directly in
+    /// the database, and only the process elected as uploader sends and trims them.
+    /// </summary>
+    static constexpr const char* const CFG_BOOL_ENABLE_MULTIPROCESS_STORAGE = "enableMultiProcessStorage";
+
+    /// <summary>
+    /// Open the cache file on the worker thread instead of during LogManager initialization.
+    /// Events are kept in the RAM queue until the storage is ready, which is reported with
+    /// EVT_STORAGE_READY. Has no effect when the RAM queue is disabled.
+    /// </summary>
+    static constexpr const char* const CFG_BOOL_DEFER_STORAGE_OPEN = "deferStorageOpen";
+
     /// <summary>
     /// Enable network detector.
     /// </summary>
@@ -130,16 +144,39 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_STR_CACHE_FILE_PATH = "cacheFilePath";
 
+    /// <summary>
+    /// Name of a shared runtime to join. LogManager instances joining the same runtime share one
+    /// HTTP client and, per collector URI, one offline storage, so that their uploads are coalesced.
+    /// </summary>
+    static constexpr const char* const CFG_STR_SHARED_RUNTIME = "sharedRuntime";
+
     /// <summary>
     /// the cache file size limit in bytes.
     /// </summary>
     static constexpr const char* const CFG_INT_CACHE_FILE_SIZE = "cacheFileSizeLimitInBytes";
 
+    /// <summary>
+    /// The offline storage backend: "sqlite" (default) or "segments" for the memory-mapped segment log.
+    /// </summary>
+    static constexpr const char* const CFG_STR_OFFLINE_STORAGE_TYPE = "offlineStorageType";
+
+    /// <summary>
+    /// The size of a segment file of the "segments" offline storage, in bytes.
+    /// </summary>
+    static constexpr const char* const CFG_INT_STORAGE_SEGMENT_SIZE = "segmentSizeInBytes";
+
     /// <summary>
     /// The RAM queue size limit in bytes.
     /// </summary>
     static constexpr const char* const CFG_INT_RAM_QUEUE_SIZE = "cacheMemorySizeLimitInBytes";
 
+    /// <summary>
+    /// Cap on the memory used by the RAM queue, request packaging and in-flight HTTP requests, in bytes.
+    /// Once it is reached, new events go straight to the offline storage if possible; otherwise the
+    /// RAM queue sheds its lowest priority events first. 0 (default) means no cap.
+    /// </summary>
+    static constexpr const char* const CFG_INT_MEMORY_BUDGET = "memoryBudgetInBytes";
+
     /// <summary>
     /// The size of the RAM queue buffers, in bytes.
     /// </summary>
@@ -262,6 +299,11 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_MODULE_OFFLINE_STORAGE = "offlineStorage";
 
+    /// <summary>
+    /// IMemoryResource override module
+    /// </summary>
+    static constexpr const char* const CFG_MODULE_MEMORY_RESOURCE = "memoryResource";
+
     /// <summary>
     /// Pointer to the Android app's JavaVM
     /// </summary>
@@ -362,11 +404,86 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_BOOL_TPM_CLOCK_SKEW_ENABLED = "clockSkewEnabled";
 
+    /// <summary>
+    /// TPM configuration: upload bandwidth budget in bytes per second, 0 for unlimited.
+    /// Ignored when a bandwidth controller module is provided.
+    /// </summary>
+    static constexpr const char* const CFG_INT_TPM_BANDWIDTH_BPS = "bandwidthBps";
+
+    /// <summary>
+    /// TPM configuration: upload bandwidth burst in bytes, at least one second worth of bandwidth
+    /// </summary>
+    static constexpr const char* const CFG_INT_TPM_BANDWIDTH_BURST_BYTES = "bandwidthBurstBytes";
+
     /// <summary>
     /// When enabled, the session timer is reset after session is completed, allowing for several session events in the duration of the SDK lifecycle
     /// </summary>
     static constexpr const char* const CFG_BOOL_SESSION_RESET_ENABLED = "sessionResetEnabled";
 
+    /// <summary>
+    /// Client-side sampling configuration map
+    /// </summary>
+    static constexpr const char* const CFG_MAP_SAMPLING = "sampling";
+
+    /// <summary>
+    /// Sampling configuration: default sample rate in percent [0..100]
+    /// </summary>
+    static constexpr const char* const CFG_DBL_SAMPLING_RATE = "rate";
+
+    /// <summary>
+    /// Sampling configuration: map of tenant id to sample rate in percent
+    /// </summary>
+    static constexpr const char* const CFG_MAP_SAMPLING_TENANTS = "tenants";
+
+    /// <summary>
+    /// Sampling configuration: map of event name to sample rate in percent
+    /// </summary>
+    static constexpr const char* const CFG_MAP_SAMPLING_EVENTS = "events";
+
+    /// <summary>
+    /// Per-tenant fairness of the offline storage configuration map
+    /// </summary>
+    static constexpr const char* const CFG_MAP_TENANT_FAIRNESS = "tenantFairness";
+
+    /// <summary>
+    /// Tenant fairness: deficit round robin quantum in bytes used to interleave the records
+    /// of different tenants of the same latency when retrieving them for upload, 0 to disable
+    /// </summary>
+    static constexpr const char* const CFG_INT_TENANT_FAIRNESS_QUANTUM = "quantumBytes";
+
+    /// <summary>
+    /// Tenant fairness: default storage quota of a tenant in bytes, 0 for unlimited.
+    /// The oldest records of a tenant over its quota are dropped first.
+    /// </summary>
+    static constexpr const char* const CFG_INT_TENANT_FAIRNESS_QUOTA = "quotaBytes";
+
+    /// <summary>
+    /// Tenant fairness: map of tenant id to storage quota in bytes
+    /// </summary>
+    static constexpr const char* const CFG_MAP_TENANT_FAIRNESS_TENANTS = "tenants";
+
+    /// <summary>
+    /// Pipeline latency histograms configuration map
+    /// </summary>
+    static constexpr const char* const CFG_MAP_PIPELINE_LATENCY = "pipelineLatency";
+
+    /// <summary>
+    /// Pipeline latency: record per-stage latencies of the event pipeline
+    /// </summary>
+    static constexpr const char* const CFG_BOOL_PIPELINE_LATENCY_ENABLED = "enabled";
+
+    /// <summary>
+    /// Pipeline latency: dispatch an EVT_PIPELINE_LATENCY DebugEvent for every sample
+    /// </summary>
+    static constexpr const char* const CFG_BOOL_PIPELINE_LATENCY_DEBUG_EVENTS = "debugEvents";
+
+    /// <summary>
+    /// Precomputed system information map on POSIX platforms: field name to string value.
+    /// Provided fields are not collected from the system. Fields: devId, devMake, devModel,
+    /// osName, osVer, osRel, osBuild, appId, tz. Read once, by the first LogManager.
+    /// </summary>
+    static constexpr const char* const CFG_MAP_SYSTEM_INFO = "systemInfo";
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 4251)
@@ -11,6 +11,7 @@
 #include <cstdint>
 #include <string>
 #include <functional>
+#include <vector>
 
 #include "Enums.hpp"
 #include "IAuthTokensController.hpp"
@@ -18,9 +19,11 @@
 #include "IDataViewerCollection.hpp"
 #include "IEventFilterCollection.hpp"
 #include "ILogger.hpp"
+#include "IMemoryResource.hpp"
 #include "ISemanticContext.hpp"
 #include "LogConfiguration.hpp"
 #include "LogSessionData.hpp"
+#include "PipelineLatency.hpp"
 
 #include "DebugEvents.hpp"
 #include "TransmitProfiles.hpp"
@@ -384,6 +387,27 @@ namespace MAT_NS_BEGIN
         /// </summary>
         /// <returns>Current instance of IDataInspector if set, nullptr otherwise.</returns>
         virtual std::shared_ptr<IDataInspector> GetDataInspector() noexcept = 0;
+
+        /// <summary>
+        /// Get the latency statistics of every stage of the event pipeline, from decoration to the collector response.
+        /// </summary>
+        /// <param name="stages">Receives one entry per PipelineStage, in stage order.</param>
+        /// <param name="reset">Clear the histograms after reading them.</param>
+        /// <returns>STATUS_SUCCESS, or STATUS_ENOSYS if latency tracking is not available.</returns>
+        virtual status_t GetPipelineLatency(std::vector<PipelineStageLatency>& /*stages*/, bool /*reset*/ = false)
+        {
+            return STATUS_ENOSYS;
+        }
+
+        /// <summary>
+        /// Get the memory used by the RAM queue, request packaging and in-flight HTTP requests, and the events shed to stay within CFG_INT_MEMORY_BUDGET.
+        /// </summary>
+        /// <param name="usage">Receives the current and peak bytes of every MemorySubsystem.</param>
+        /// <returns>STATUS_SUCCESS, or STATUS_ENOSYS if memory accounting is not available.</returns>
+        virtual status_t GetMemoryUsage(MemoryUsage& /*usage*/)
+        {
+            return STATUS_ENOSYS;
+        }
     };
 
 }
@@ -20,6 +20,7 @@
 
 namespace MAT_NS_BEGIN
 {
+    class EventSchemaBase;
 
 /* Data Type Flags */
 #define MICROSOFT_KEYWORD_CRITICAL_DATA         0x0000800000000000 // Bit 47
@@ -436,6 +437,39 @@ Refer to https://osgwiki.com/wiki/Common_Schema_Event_Overrides for details on t
         /// <param name="properties">Properties of this custom event, specified using an EventProperties object.</param>
         virtual void LogEvent(EventProperties const& properties) = 0;
 
+        /// <summary>
+        /// Logs a custom event whose name and properties are declared at compile time with EventSchema.
+        /// Typed field values are written directly into the event record, skipping the per-event
+        /// property name validation and EventProperties conversion.
+        /// The default implementation logs the equivalent EventProperties.
+        /// </summary>
+        /// <param name="event">Event declared with EventSchema (see EventSchema.hpp).</param>
+        virtual void LogEvent(EventSchemaBase const& event);
+
+        /// <summary>
+        /// Logs a batch of custom events, e.g. the events buffered for the duration of a request.
+        /// Each event is filtered, sampled and decorated as with LogEvent, but the batch is
+        /// serialized, stored and scheduled for upload as a whole.
+        /// </summary>
+        /// <param name="events">Pointer to the first of the contiguous events.</param>
+        /// <param name="count">Number of events.</param>
+        virtual void LogEvents(EventProperties const* events, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                LogEvent(events[i]);
+            }
+        }
+
+        /// <summary>
+        /// Logs a batch of custom events.
+        /// </summary>
+        /// <param name="events">The events.</param>
+        void LogEvents(std::vector<EventProperties> const& events)
+        {
+            LogEvents(events.data(), events.size());
+        }
+
         /// <summary>
         /// Logs a failure event - such as an application exception.
         /// </summary>
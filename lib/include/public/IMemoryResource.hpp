@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef IMEMORYRESOURCE_HPP
+#define IMEMORYRESOURCE_HPP
+
+#include "IModule.hpp"
+#include "Version.hpp"
+#include "ctmacros.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Memory resource override module, modeled after std::pmr::memory_resource.
+    /// Register it with ILogConfiguration::AddModule(CFG_MODULE_MEMORY_RESOURCE, ...)
+    /// to make the SDK allocate the buffers of its RAM queue from a host allocator,
+    /// for example a dedicated jemalloc arena.
+    /// </summary>
+    /// <remarks>
+    /// Both methods may be called from any SDK thread and must be thread-safe.
+    /// The resource must outlive every ILogManager configured with it.
+    /// </remarks>
+    class MATSDK_LIBABI IMemoryResource : public IModule
+    {
+    public:
+        /// <summary>
+        /// Allocates at least the given number of bytes with the given alignment.
+        /// Throws std::bad_alloc or returns nullptr if the memory cannot be allocated.
+        /// </summary>
+        virtual void* Allocate(size_t bytes, size_t alignment) = 0;
+
+        /// <summary>
+        /// Releases memory returned by Allocate with the same size and alignment.
+        /// </summary>
+        virtual void Deallocate(void* ptr, size_t bytes, size_t alignment) noexcept = 0;
+    };
+
+    /// <summary>
+    /// Subsystems whose memory is accounted against the budget of an ILogManager.
+    /// </summary>
+    enum MemorySubsystem
+    {
+        /// <summary>Records in the RAM queue, including the records reserved for an upload.</summary>
+        MemorySubsystem_Storage = 0,
+        /// <summary>Request bodies being spliced and compressed.</summary>
+        MemorySubsystem_Packaging,
+        /// <summary>In-flight HTTP requests and their responses.</summary>
+        MemorySubsystem_Http,
+        /// <summary>Number of subsystems.</summary>
+        MemorySubsystem_Count
+    };
+
+    /// <summary>
+    /// Memory used by an ILogManager, in bytes, as returned by ILogManager::GetMemoryUsage.
+    /// </summary>
+    struct MemoryUsage
+    {
+        /// <summary>Bytes currently used by every subsystem.</summary>
+        size_t   bytes[MemorySubsystem_Count];
+        /// <summary>Highest usage of every subsystem since the ILogManager was created.</summary>
+        size_t   peakBytes[MemorySubsystem_Count];
+        /// <summary>Sum of the current usage of all subsystems.</summary>
+        size_t   totalBytes;
+        /// <summary>The configured CFG_INT_MEMORY_BUDGET, 0 if unlimited.</summary>
+        size_t   limitBytes;
+        /// <summary>Number of events dropped to stay within the limit.</summary>
+        uint64_t shedEvents;
+    };
+
+} MAT_NS_END
+
+#endif // IMEMORYRESOURCE_HPP
@@ -180,6 +180,9 @@ namespace MAT_NS_BEGIN {
         /// <remarks>
         /// The offline storage might need to trim the oldest events before
         /// inserting the new one in order to maintain its configured size limit.
+        /// Records that could not be stored are moved behind the stored ones,
+        /// so that the first N records of the vector are the N stored records.
+        /// Records are otherwise left unmodified.
         /// Called from the internal worker thread.
         /// </remarks>
         /// <param name="record">Record data to store</param>
@@ -87,7 +87,19 @@ namespace MAT_NS_BEGIN
         virtual void operator()() {}
 
         /// <summary>
-        /// The typename of the underlying functor executed by this work item
+        /// Returns the typename of the underlying functor executed by this work item.
+        /// Task implementations may compute it lazily, so that the cost of obtaining
+        /// a human-readable type name is only paid by callers that need it (tracing).
+        /// </summary>
+        virtual const std::string& GetTypeName()
+        {
+            return TypeName;
+        }
+
+        /// <summary>
+        /// The typename of the underlying functor executed by this work item.
+        /// Tasks created by the SDK fill this field in on the first GetTypeName()
+        /// call only, so read the type name through GetTypeName() instead.
         /// </summary>
         std::string TypeName;
     };
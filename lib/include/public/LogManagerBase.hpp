@@ -575,6 +575,35 @@ namespace MAT_NS_BEGIN
         static ILogger* GetLogger(const std::string& tenantToken, const std::string& source)
             LM_SAFE_CALL_PTR(GetLogger, tenantToken, source);
 
+        /// <summary>
+        /// Logs a batch of custom events with the primary token logger, see ILogger::LogEvents.
+        /// </summary>
+        /// <param name="events">Pointer to the first of the contiguous events</param>
+        /// <param name="count">Number of events</param>
+        static status_t LogEvents(EventProperties const* events, size_t count)
+        {
+            LM_LOCKGUARD(stateLock());
+            if (nullptr != instance)
+            {
+                ILogger* logger = instance->GetLogger(GetPrimaryToken());
+                if (nullptr != logger)
+                {
+                    logger->LogEvents(events, count);
+                    return STATUS_SUCCESS;
+                }
+            }
+            return STATUS_EFAIL;
+        }
+
+        /// <summary>
+        /// Logs a batch of custom events with the primary token logger, see ILogger::LogEvents.
+        /// </summary>
+        /// <param name="events">The events</param>
+        static status_t LogEvents(std::vector<EventProperties> const& events)
+        {
+            return LogEvents(events.data(), events.size());
+        }
+
         /// <summary>
         /// Get Auth token controller
         /// </summary>
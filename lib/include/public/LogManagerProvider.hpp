@@ -11,6 +11,12 @@
 #include "ITaskDispatcher.hpp"
 #include "NullObjects.hpp"
 
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace MAT_NS_BEGIN
 {
 
@@ -163,6 +169,9 @@ namespace MAT_NS_BEGIN
     /// ctx_data       - original JSON configuration or token passed to mat_open
     /// http           - optional IHttpClient override instance
     /// taskDispatcher - optional ITaskDispatcher override instance
+    /// scope          - context scope of the loggers, resolved from config once
+    /// loggers        - loggers already resolved, by token and source
+    /// loggerHandles  - loggers handed out by EVT_OP_GET_LOGGER, handle N is at index N-1
     /// </summary>
     typedef struct capi_client_struct
     {
@@ -171,6 +180,10 @@ namespace MAT_NS_BEGIN
         std::string                      ctx_data;
         std::shared_ptr<IHttpClient>     http;
         std::shared_ptr<ITaskDispatcher> taskDispatcher;
+        std::string                      scope;
+        std::mutex                       loggersLock;
+        std::map<std::pair<std::string, std::string>, ILogger*> loggers;
+        std::vector<ILogger*>            loggerHandles;
     } capi_client;
 
     /// <summary>
@@ -88,6 +88,10 @@ namespace MAT_NS_BEGIN
 
         virtual void LogEvent(EventProperties const & /*properties*/) override {};
 
+        virtual void LogEvent(EventSchemaBase const & /*event*/) override {};
+
+        virtual void LogEvents(EventProperties const * /*events*/, size_t /*count*/) override {};
+
         virtual void LogFailure(std::string const & /*signature*/, std::string const & /*detail*/, EventProperties const & /*properties*/) override {};
 
         virtual void LogFailure(std::string const & /*signature*/, std::string const & /*detail*/, std::string const & /*category*/, std::string const & /*id*/, EventProperties const & /*properties*/) override {};
@@ -380,6 +384,16 @@ namespace MAT_NS_BEGIN
             return STATUS_ENOSYS;
         }
 
+        virtual status_t GetPipelineLatency(std::vector<PipelineStageLatency>& /*stages*/, bool /*reset*/) noexcept override
+        {
+            return STATUS_ENOSYS;
+        }
+
+        virtual status_t GetMemoryUsage(MemoryUsage& /*usage*/) noexcept override
+        {
+            return STATUS_ENOSYS;
+        }
+
         private:
             NullDataViewerCollection nullDataViewerCollection;
             NullEventFilterCollection m_filters;
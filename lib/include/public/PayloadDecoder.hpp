@@ -15,7 +15,9 @@
 
 #include <vector>
 #include <cinttypes>
+#include <functional>
 #include <iostream>
+#include <string>
 
 namespace CsProtocol
 {
@@ -47,6 +49,29 @@ namespace MAT_NS_BEGIN {
         /// </returns>
         bool DecodeRequest(const std::vector<uint8_t>& in, std::string& out, bool compressed = true);
 
+        /// <summary>
+        /// Decode SDK request structure record by record, without holding all the decoded records in memory.
+        /// <param name="in">Payload data, e.g. HTTPS POST request body</param>
+        /// <param name="onRecord">Called with each record as a single line of JSON, returns false to stop decoding</param>
+        /// <param name="compressed">Parameter that specifies that the payload data is compressed (optional, default true)</param>
+        /// </summary>
+        /// <returns>
+        /// Returns true if every record of the payload was decoded.
+        /// </returns>
+        bool DecodeRequestRecords(const std::vector<uint8_t>& in, std::function<bool(const std::string&)> const& onRecord, bool compressed = true);
+
+        /// <summary>
+        /// Decode SDK request structure read from a stream into newline-delimited JSON (one record per line).
+        /// Only the record being decoded is buffered, so payloads of any size can be processed.
+        /// <param name="in">Stream of payload data, e.g. a captured HTTPS POST request body</param>
+        /// <param name="out">Stream receiving the records</param>
+        /// <param name="compressed">Parameter that specifies that the payload data is compressed (optional, default true)</param>
+        /// </summary>
+        /// <returns>
+        /// Returns true if the whole payload was read and every record of it was decoded.
+        /// </returns>
+        bool DecodeRequestStream(std::istream& in, std::ostream& out, bool compressed = true);
+
     };
 
 } MAT_NS_END
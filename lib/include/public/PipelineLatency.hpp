@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef PIPELINELATENCY_HPP
+#define PIPELINELATENCY_HPP
+
+#include "Version.hpp"
+
+#include <cstdint>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Stages of the event pipeline, from ILogger::LogEvent to the collector response.
+    /// </summary>
+    enum PipelineStage
+    {
+        /// <summary>Logger decorators, custom decorator and data inspector.</summary>
+        PipelineStage_Decorate = 0,
+        /// <summary>Bond serialization of the record.</summary>
+        PipelineStage_Serialize,
+        /// <summary>Storing the serialized record, including the hand-off to the worker thread.</summary>
+        PipelineStage_Store,
+        /// <summary>Reading and reserving records for an upload.</summary>
+        PipelineStage_Retrieve,
+        /// <summary>Splicing the retrieved records into a request body.</summary>
+        PipelineStage_Package,
+        /// <summary>Compressing the request body.</summary>
+        PipelineStage_Compress,
+        /// <summary>Building the HTTP request.</summary>
+        PipelineStage_Encode,
+        /// <summary>HTTP round trip, from submitting the request to receiving the response.</summary>
+        PipelineStage_Send,
+        /// <summary>Decoding the response and deleting or releasing the uploaded records.</summary>
+        PipelineStage_Response,
+        /// <summary>Number of stages.</summary>
+        PipelineStage_Count
+    };
+
+    /// <summary>
+    /// Latency statistics of one pipeline stage, in microseconds.
+    /// Percentiles are approximated by log-linear histogram buckets (about 6% relative error).
+    /// </summary>
+    struct PipelineStageLatency
+    {
+        PipelineStage stage;
+        const char*   name;
+        uint64_t      count;
+        uint64_t      minUs;
+        uint64_t      maxUs;
+        double        meanUs;
+        uint64_t      p50Us;
+        uint64_t      p90Us;
+        uint64_t      p99Us;
+        uint64_t      p999Us;
+    };
+
+} MAT_NS_END
+
+#endif // PIPELINELATENCY_HPP
@@ -14,6 +14,7 @@
 #include <atomic>
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -126,7 +127,11 @@ namespace MAT_NS_BEGIN
     } TransmitProfileRules;
 
     /// <summary>
-    /// The TransmitProfiles class manages transmit profiles.
+    /// The TransmitProfiles class manages the transmit profiles of a LogManager instance.
+    ///
+    /// Profile changes are serialized by a lock. The timers of the active rule are published
+    /// as a single immutable value, so that the per-event check of the transmission policy
+    /// is one atomic load.
     /// </summary>
     class TransmitProfiles {
 
@@ -134,42 +139,51 @@ namespace MAT_NS_BEGIN
         /// <summary>
         /// A map that contains all transmit profiles.
         /// </summary>
-        static std::map<std::string, TransmitProfileRules> profiles;
+        std::map<std::string, TransmitProfileRules> profiles;
 
         /// <summary>
         /// A string that contains the name of the currently active transmit profile.
         /// </summary>
-        static std::string      currProfileName;
+        std::string      currProfileName;
 
         /// <summary>
         /// The size of the currently active transmit profile rule.
         /// </summary>
-        static size_t           currRule;
+        size_t           currRule;
 
         /// <summary>
         /// The last reported network cost, as one of the MAT::NetworkCost enumeration values.
         /// </summary>
-        static NetworkCost      currNetCost;
+        NetworkCost      currNetCost;
 
         /// <summary>
         /// The last reported power state, as one of the MAT::PowerSource enumeration values.
         /// </summary>
-        static PowerSource      currPowState;
+        PowerSource      currPowState;
 
         /// <summary>
         /// A boolean value that indicates whether the timer was updated.
         /// </summary>
-        static bool isTimerUpdated;
+        std::atomic<bool> isTimerUpdated;
 
-        static void UpdateProfiles(const std::vector<TransmitProfileRules>& newProfiles) noexcept;
+        /// <summary>
+        /// The timers of the active rule, in milliseconds, packed into one word (see getTimers).
+        /// </summary>
+        std::atomic<uint64_t> activeTimers;
+
+        /// <summary>
+        /// Serializes profile and device state changes.
+        /// </summary>
+        std::recursive_mutex profilesLock;
 
-        static void EnsureDefaultProfiles() noexcept;
+        void UpdateProfiles(const std::vector<TransmitProfileRules>& newProfiles) noexcept;
 
-    public:
+        void EnsureDefaultProfiles() noexcept;
 
+    public:
 
         /// <summary>
-        /// The TransmitProfiles default constructor.
+        /// The TransmitProfiles default constructor, with the default profiles loaded.
         /// </summary>
         TransmitProfiles();
 
@@ -178,87 +192,93 @@ namespace MAT_NS_BEGIN
         /// </summary>
         virtual ~TransmitProfiles() noexcept = default;
 
+        TransmitProfiles(const TransmitProfiles&) = delete;
+        TransmitProfiles& operator=(const TransmitProfiles&) = delete;
+
         /// <summary>
         /// Prints transmit profiles to the debug log.
         /// </summary>
-        static void dump();
+        void dump();
 
         /// <summary>
         /// Removes custom profiles.
         /// This method is called from parse only, and does not require the lock.
         /// <b>Note:</b> This function is not thread safe.
         /// </summary>
-        static void removeCustomProfiles();
+        void removeCustomProfiles();
 
         /// <summary>
         /// Parses transmit profiles from JSON.
         /// </summary>
         /// <param name="profiles_json">A string that contains the the transmit profiles in JSON.</param>
         /// <returns>The size (in bytes) of the resulting TransmitProfiles object.</returns>
-        static size_t parse(const std::string& profiles_json);
+        size_t parse(const std::string& profiles_json);
 
         /// <summary>
         /// Loads customer-supplied transmit profiles.
         /// </summary>
         /// <param name="profiles_json">A string that contains the the transmit profiles in JSON.</param>
         /// <returns>A boolean value that indicates success (true) or failure (false) if at least one transmit profile parses correctly.</returns>
-        static bool load(const std::string& profiles_json);
+        bool load(const std::string& profiles_json);
 
         /// <summary>
         /// Loads caller-supplied transmit profiles.
         /// </summary>
         /// <param name="profiles">A map of the caller-supplied profiles.</param>
         /// <returns>A boolean value that indicates success (true) if all transmit profiles are valid, false otherwise.</returns>
-        static bool load(const std::vector<TransmitProfileRules>& profiles) noexcept;
+        bool load(const std::vector<TransmitProfileRules>& profiles) noexcept;
 
         /// <summary>
         /// Resets transmit profiles to default values.
         /// </summary>
-        static void reset();
+        void reset();
 
         /// <summary>
         /// Sets the default transmit profile.
         /// </summary>
         /// <param name="profileName">The transmit profile to set as the default.</param>
         /// <returns>A boolean value that indicates success (true) or failure (false).</returns>
-        static bool setDefaultProfile(const TransmitProfile profileName);
+        bool setDefaultProfile(const TransmitProfile profileName);
 
         /// <summary>
         /// Sets the active transmit profile.
         /// </summary>
         /// <param name="profileName">A string that contains the name of the transmit profile to set.</param>
         /// <returns></returns>
-        static bool setProfile(const std::string& profileName);
+        bool setProfile(const std::string& profileName);
 
         /// <summary>
-        /// Gets the current priority timers.
+        /// Gets the current priority timers. Lock-free.
         /// </summary>
         /// <param name="out">A reference to a vector of integers that will contain the current timers.</param>
-        static void getTimers(TimerArray& out);
+        void getTimers(TimerArray& out);
 
         /// <summary>
         /// Gets the name of the current transmit profile.
         /// </summary>
         /// <returns>A string that contains the name of the current transmit profile.</returns>
-        static std::string& getProfile();
+        std::string& getProfile();
 
         /// <summary>
         /// Gets the current device's network cost and power state.
         /// </summary>
         /// <param name="netCost">A reference to an instance of a MAT::NetworkCost enumeration.</param>
         /// <param name="powState">A reference to an instance of a MAT::PowerSource enumeration.</param>
-        static void getDeviceState(NetworkCost &netCost, PowerSource &powState);
+        void getDeviceState(NetworkCost &netCost, PowerSource &powState);
 
         /// <summary>
-        /// A timer update event handler.
+        /// A timer update event handler: publishes the timers of the active rule.
         /// </summary>
-        static void onTimersUpdated();
+        void onTimersUpdated();
 
         /// <summary>
-        /// Determines whether a timer should be updated.
+        /// Determines whether a timer should be updated. Lock-free.
         /// </summary>
         /// <returns>A boolean value that indicates yes (true) or no (false).</returns>
-        static bool isTimerUpdateRequired();
+        bool isTimerUpdateRequired() const noexcept
+        {
+            return isTimerUpdated.load(std::memory_order_acquire);
+        }
 
         /// <summary>
         /// Selects a transmit profile rule based on the current device state.
@@ -268,7 +288,7 @@ namespace MAT_NS_BEGIN
         /// <param name="powState">The power state, as one of the 
         /// MAT::PowerSource enumeration values.</param>
         /// <returns>A boolean value that indicates success (true) or failure (false).</returns>
-        static bool updateStates(NetworkCost netCost, PowerSource powState);
+        bool updateStates(NetworkCost netCost, PowerSource powState);
 
     };
 
@@ -9,7 +9,7 @@
  * For version handshake check there is no mandatory requirement to update the $PATCH level.
  * Ref. https://semver.org/ for Semantic Versioning documentation.
  */
-#define TELEMETRY_EVENTS_VERSION	"3.1.0"
+#define TELEMETRY_EVENTS_VERSION	"3.2.0"
 
 #include "ctmacros.hpp"
 
@@ -59,7 +59,9 @@ extern "C" {
         EVT_OP_FLUSH = 0x0000000A,
         EVT_OP_VERSION = 0x0000000B,
         EVT_OP_OPEN_WITH_PARAMS = 0x0000000C,
-        EVT_OP_MAX = EVT_OP_OPEN_WITH_PARAMS + 1
+        EVT_OP_GET_LOGGER = 0x0000000D,
+        EVT_OP_LOG_BATCH = 0x0000000E,
+        EVT_OP_MAX = EVT_OP_LOG_BATCH + 1
     } evt_call_t;
 
     typedef enum
@@ -164,6 +166,18 @@ extern "C" {
         int32_t                 paramsCount;
     } evt_open_with_params_data_t;
 
+    /**
+     * <summary>
+     * Input and output of 'evt_get_logger'
+     * </summary>
+     */
+    typedef struct
+    {
+        const char*             token;      /* In: tenant token, primary token if NULL */
+        const char*             source;     /* In: event source, may be NULL */
+        evt_handle_t            logger;     /* Out: logger handle */
+    } evt_logger_data_t;
+
     typedef union
     {
         /* Basic types */
@@ -190,6 +204,29 @@ extern "C" {
         evt_prop_v              value;
         uint32_t                piiKind;
     } evt_prop;
+
+    /**
+     * <summary>
+     * Single event of a batch passed to 'evt_log_batch'
+     * </summary>
+     */
+    typedef struct
+    {
+        evt_prop*               props;      /* Event properties array */
+        uint32_t                size;       /* Number of properties, 0 if terminated with { .name = NULL, .type = TYPE_NULL } */
+    } evt_batch_item_t;
+
+    /**
+     * <summary>
+     * Wraps all input parameters to 'evt_log_batch'
+     * </summary>
+     */
+    typedef struct
+    {
+        evt_handle_t            logger;     /* Logger handle from 'evt_get_logger', or 0 to route each event by its iKey */
+        evt_batch_item_t*       events;
+        uint32_t                count;
+    } evt_log_batch_data_t;
     
     /**
      * <summary>
@@ -610,6 +647,65 @@ extern "C" {
         return (const char *)(ctx.data);
     }
 
+    /**
+     * <summary>
+     * Obtains a logger handle that stays valid until the SDK instance is closed.
+     * Logging with a logger handle avoids resolving the logger for every event.
+     * </summary>
+     * <param name="handle">SDK handle.</param>
+     * <param name="token">Tenant token, primary token of the SDK instance if NULL.</param>
+     * <param name="source">Event source, may be NULL.</param>
+     * <returns>Logger handle, 0 on failure.</returns>
+     */
+    static inline evt_handle_t evt_get_logger(evt_handle_t handle, const char* token, const char* source)
+    {
+        evt_logger_data_t data;
+        evt_context_t ctx;
+
+        data.token = token;
+        data.source = source;
+        data.logger = 0;
+
+        ctx.call = EVT_OP_GET_LOGGER;
+        ctx.handle = handle;
+        ctx.data = (void *)(&data);
+        evt_api_call(&ctx);
+        return data.logger;
+    }
+
+    /**
+     * <summary>
+     * Logs an array of telemetry events in one call.
+     * </summary>
+     * <param name="handle">SDK handle.</param>
+     * <param name="logger">Logger handle from evt_get_logger, or 0 to route each event by its iKey.</param>
+     * <param name="events">Events array.</param>
+     * <param name="count">Number of events in array.</param>
+     * <param name="logged">Optional number of events actually logged.</param>
+     * <returns>Status code, of the first failure if any.</returns>
+     */
+    static inline evt_status_t evt_log_batch(evt_handle_t handle, evt_handle_t logger, evt_batch_item_t* events, uint32_t count, uint32_t* logged)
+    {
+        evt_log_batch_data_t data;
+        evt_context_t ctx;
+        evt_status_t result;
+
+        data.logger = logger;
+        data.events = events;
+        data.count = count;
+
+        ctx.call = EVT_OP_LOG_BATCH;
+        ctx.handle = handle;
+        ctx.data = (void *)(&data);
+        ctx.size = 0;
+        result = evt_api_call(&ctx);
+        if (logged != NULL)
+        {
+            *logged = ctx.size;
+        }
+        return result;
+    }
+
     /* New API calls to be added using evt_api_call(&ctx) for backwards-forward / ABI compat */
 
 #ifdef __cplusplus
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "FileLock.hpp"
+
+#ifdef _WIN32
+#include "utils/StringConversion.hpp"
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace MAT_NS_BEGIN
+{
+    FileLock::FileLock() noexcept :
+#ifdef _WIN32
+        m_file(INVALID_HANDLE_VALUE)
+#else
+        m_fd(-1)
+#endif
+    {
+    }
+
+    FileLock::~FileLock() noexcept
+    {
+        Unlock();
+    }
+
+#ifdef _WIN32
+
+    bool FileLock::TryLock(std::string const& path)
+    {
+        if (IsLocked())
+        {
+            return true;
+        }
+        std::wstring path_w = to_utf16_string(path);
+#ifdef _WINRT
+        HANDLE file = ::CreateFile2(path_w.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, OPEN_ALWAYS, NULL);
+#else
+        HANDLE file = ::CreateFileW(path_w.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+#endif
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        OVERLAPPED overlapped = {};
+        if (!::LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &overlapped))
+        {
+            ::CloseHandle(file);
+            return false;
+        }
+        m_file = file;
+        return true;
+    }
+
+    void FileLock::Unlock() noexcept
+    {
+        if (m_file != INVALID_HANDLE_VALUE)
+        {
+            OVERLAPPED overlapped = {};
+            ::UnlockFileEx(m_file, 0, 1, 0, &overlapped);
+            ::CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+    }
+
+#else
+
+    bool FileLock::TryLock(std::string const& path)
+    {
+        if (IsLocked())
+        {
+            return true;
+        }
+        // Not inherited by child processes, which would otherwise share the lock
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        if (::flock(fd, LOCK_EX | LOCK_NB) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        m_fd = fd;
+        return true;
+    }
+
+    void FileLock::Unlock() noexcept
+    {
+        if (m_fd >= 0)
+        {
+            ::flock(m_fd, LOCK_UN);
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+#endif
+
+} MAT_NS_END
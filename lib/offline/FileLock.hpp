@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef FILELOCK_HPP
+#define FILELOCK_HPP
+
+#include "pal/PAL.hpp"
+
+#include <string>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Advisory exclusive lock on a file, held by at most one process at a time (flock on POSIX,
+    /// LockFileEx on Windows). The operating system releases the lock when the owning process
+    /// exits, including when it crashes, so another process can take over.
+    /// </summary>
+    class FileLock
+    {
+    public:
+        FileLock() noexcept;
+        ~FileLock() noexcept;
+
+        FileLock(FileLock const&) = delete;
+        FileLock& operator=(FileLock const&) = delete;
+
+        /// <summary>
+        /// Opens or creates the file and tries to lock it without waiting. Returns true if the
+        /// lock is held by this object, including when it was already held.
+        /// </summary>
+        bool TryLock(std::string const& path);
+
+        /// <summary>
+        /// Releases the lock and closes the file.
+        /// </summary>
+        void Unlock() noexcept;
+
+        bool IsLocked() const
+        {
+#ifdef _WIN32
+            return m_file != INVALID_HANDLE_VALUE;
+#else
+            return m_fd >= 0;
+#endif
+        }
+
+    protected:
+#ifdef _WIN32
+        HANDLE   m_file;
+#else
+        int      m_fd;
+#endif
+    };
+
+} MAT_NS_END
+
+#endif // FILELOCK_HPP
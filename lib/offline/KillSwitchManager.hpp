@@ -48,23 +48,18 @@ namespace MAT_NS_BEGIN {
                 }
             }
 
-            std::pair<std::multimap<std::string, std::string>::const_iterator, std::multimap<std::string, std::string>::const_iterator> ret;
-            ret = headers.equal_range("kill-tokens");
+            std::vector<std::string> killtokensVector = headers.getAll("kill-tokens");
 
-            if (ret.first != ret.second)
+            if (!killtokensVector.empty())
             {
-                std::vector<std::string> killtokensVector;
-
-                for (std::multimap<std::string, std::string>::const_iterator it = ret.first; it != ret.second; ++it)
+                for (std::string& token : killtokensVector)
                 {
-                    std::string token = std::move(it->second);
                     size_t pos = token.find(':');
                     if (pos != std::string::npos)
                     {
                         // Strip suffix and assume ':all' events of that tenant are killed
                         token.erase(pos, token.length() - pos);
                     }
-                    killtokensVector.push_back(token);
                 }
 
                 int64_t timeinSecs = 0;
@@ -0,0 +1,190 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include "utils/StringConversion.hpp"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MAT_NS_BEGIN
+{
+    MappedFile::MappedFile() noexcept :
+        m_data(nullptr),
+        m_size(0),
+#ifdef _WIN32
+        m_file(INVALID_HANDLE_VALUE),
+        m_mapping(NULL)
+#else
+        m_fd(-1)
+#endif
+    {
+    }
+
+    MappedFile::~MappedFile() noexcept
+    {
+        Close();
+    }
+
+#ifdef _WIN32
+
+    bool MappedFile::Open(std::string const& path, size_t size)
+    {
+        Close();
+        std::wstring path_w = to_utf16_string(path);
+#ifdef _WINRT
+        m_file = ::CreateFile2(path_w.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, OPEN_ALWAYS, NULL);
+#else
+        m_file = ::CreateFileW(path_w.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+#endif
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (size != 0)
+        {
+            fileSize.QuadPart = static_cast<LONGLONG>(size);
+            if (!::SetFilePointerEx(m_file, fileSize, NULL, FILE_BEGIN) || !::SetEndOfFile(m_file))
+            {
+                Close();
+                return false;
+            }
+        }
+        else if (!::GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            Close();
+            return false;
+        }
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+
+#ifdef _WINRT
+        m_mapping = ::CreateFileMappingFromApp(m_file, NULL, PAGE_READWRITE, 0, NULL);
+        if (m_mapping != NULL)
+        {
+            m_data = static_cast<uint8_t*>(::MapViewOfFileFromApp(m_mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, m_size));
+        }
+#else
+        m_mapping = ::CreateFileMappingW(m_file, NULL, PAGE_READWRITE, 0, 0, NULL);
+        if (m_mapping != NULL)
+        {
+            m_data = static_cast<uint8_t*>(::MapViewOfFile(m_mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, m_size));
+        }
+#endif
+        if (m_data == nullptr)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::Close() noexcept
+    {
+        if (m_data != nullptr)
+        {
+            ::UnmapViewOfFile(m_data);
+            m_data = nullptr;
+        }
+        if (m_mapping != NULL)
+        {
+            ::CloseHandle(m_mapping);
+            m_mapping = NULL;
+        }
+        if (m_file != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+        m_size = 0;
+    }
+
+    bool MappedFile::Sync(bool wait)
+    {
+        if (m_data == nullptr)
+        {
+            return false;
+        }
+        bool result = ::FlushViewOfFile(m_data, 0) != 0;
+        if (wait)
+        {
+            result = result && (::FlushFileBuffers(m_file) != 0);
+        }
+        return result;
+    }
+
+#else
+
+    bool MappedFile::Open(std::string const& path, size_t size)
+    {
+        Close();
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+        if (m_fd < 0)
+        {
+            return false;
+        }
+
+        if (size != 0)
+        {
+            if (::ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+            {
+                Close();
+                return false;
+            }
+        }
+        else
+        {
+            struct stat info;
+            if (::fstat(m_fd, &info) != 0 || info.st_size <= 0)
+            {
+                Close();
+                return false;
+            }
+            size = static_cast<size_t>(info.st_size);
+        }
+
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (data == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+        m_data = static_cast<uint8_t*>(data);
+        m_size = size;
+        return true;
+    }
+
+    void MappedFile::Close() noexcept
+    {
+        if (m_data != nullptr)
+        {
+            ::munmap(m_data, m_size);
+            m_data = nullptr;
+        }
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        m_size = 0;
+    }
+
+    bool MappedFile::Sync(bool wait)
+    {
+        if (m_data == nullptr)
+        {
+            return false;
+        }
+        return ::msync(m_data, m_size, wait ? MS_SYNC : MS_ASYNC) == 0;
+    }
+
+#endif
+
+} MAT_NS_END
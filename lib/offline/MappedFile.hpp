@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include "pal/PAL.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Read-write shared memory mapping of a whole file.
+    /// </summary>
+    class MappedFile
+    {
+    public:
+        MappedFile() noexcept;
+        ~MappedFile() noexcept;
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        /// <summary>
+        /// Opens or creates a file and maps it. With a non-zero <paramref name="size"/> the file
+        /// is first resized to exactly that many bytes (new space reads as zeros); with zero the
+        /// existing file is mapped as it is.
+        /// </summary>
+        bool Open(std::string const& path, size_t size);
+
+        /// <summary>
+        /// Unmaps and closes the file.
+        /// </summary>
+        void Close() noexcept;
+
+        /// <summary>
+        /// Schedules dirty pages to be written to disk; with <paramref name="wait"/> blocks until done.
+        /// </summary>
+        bool Sync(bool wait);
+
+        bool IsOpen() const
+        {
+            return m_data != nullptr;
+        }
+
+        uint8_t* Data() const
+        {
+            return m_data;
+        }
+
+        size_t Size() const
+        {
+            return m_size;
+        }
+
+    protected:
+        uint8_t* m_data;
+        size_t   m_size;
+#ifdef _WIN32
+        HANDLE   m_file;
+        HANDLE   m_mapping;
+#else
+        int      m_fd;
+#endif
+    };
+
+} MAT_NS_END
+
+#endif // MAPPEDFILE_HPP
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 #include "MemoryStorage.hpp"
+#include "StorageRecordBatch.hpp"
 
 #include "utils/StringUtils.hpp"
 #include <climits>
@@ -11,13 +12,48 @@ namespace MAT_NS_BEGIN {
 
     MATSDK_LOG_INST_COMPONENT_CLASS(MemoryStorage, "EventsSDK.MemoryStorage", "Events telemetry client - MemoryStorage class");
 
-    MemoryStorage::MemoryStorage(ILogManager & logManager, IRuntimeConfig & runtimeConfig) :
+    MemoryRecord::MemoryRecord(StorageRecord const& record, MemoryBudget* memoryBudget) :
+        id(record.id),
+        tenantToken(record.tenantToken),
+        latency(record.latency),
+        persistence(record.persistence),
+        timestamp(record.timestamp),
+        blob(record.blob.begin(), record.blob.end(), Blob::allocator_type(memoryBudget)),
+        retryCount(record.retryCount),
+        reservedUntil(record.reservedUntil)
+    {
+    }
+
+    StorageRecord MemoryRecord::ToStorageRecord() const
+    {
+        StorageRecord record(id, tenantToken, latency, persistence);
+        record.timestamp = timestamp;
+        record.blob.assign(blob.begin(), blob.end());
+        record.retryCount = retryCount;
+        record.reservedUntil = reservedUntil;
+        return record;
+    }
+
+    size_t MemoryRecord::GetSize() const
+    {
+        return sizeof(*this) + MemoryBudget::GetHeapSize(id) + MemoryBudget::GetHeapSize(tenantToken) + MemoryBudget::GetHeapSize(blob);
+    }
+
+    MemoryStorage::MemoryStorage(ILogManager & logManager, IRuntimeConfig & runtimeConfig, MemoryBudget* memoryBudget) :
         m_observer(nullptr),
         m_config(runtimeConfig),
         m_logManager(logManager),
-        m_size(0),
+        m_memoryBudget(memoryBudget),
+        m_reserved_records(std::less<StorageRecordId>(), MemoryRecordMap::allocator_type(memoryBudget)),
+        m_queuedMemory(memoryBudget, MemorySubsystem_Storage),
+        m_reservedMemory(memoryBudget, MemorySubsystem_Storage),
         m_lastReadCount(0)
     {
+        for (auto& records : m_records)
+        {
+            records = MemoryRecordVector(MemoryRecordVector::allocator_type(memoryBudget));
+        }
+        m_fairness.Configure(runtimeConfig);
     }
     
     /// <summary>
@@ -86,8 +122,8 @@ namespace MAT_NS_BEGIN {
     /// Whether the record was successfully stored
     /// </returns>
     /// <remarks>
-    /// The offline storage might need to trim the oldest events before
-    /// inserting the new one in order to maintain its configured size limit.
+    /// Over the memory budget, queued events of lower or equal latency are shed
+    /// to make room for the new one, which is dropped if that is not enough.
     /// Called from the internal worker thread.
     /// </remarks>
     bool MemoryStorage::StoreRecord(StorageRecord const & record)
@@ -96,27 +132,105 @@ namespace MAT_NS_BEGIN {
         if (record.latency == EventLatency_Off)
             return false;
 
-        LOCKGUARD(m_records_lock);
-        m_size += record.blob.size() + sizeof(record); // approximate contents size
-
+        MemoryRecord stored(record, m_memoryBudget);
+        size_t recordSize = stored.GetSize();
+        DroppedMap shed;
+        bool dropped = false;
+        {
+            LOCKGUARD(m_records_lock);
+            if ((m_memoryBudget != nullptr) && m_memoryBudget->WouldExceed(recordSize) &&
+                !shedRecords(record.latency, recordSize, shed))
+            {
+                shed[record.tenantToken]++;
+                dropped = true;
+            }
+            else
+            {
 #ifdef DEBUG_DUPLICATE_ROUTES
-        if (contains(m_records[record.latency], record))
-            LOG_WARN("Vector already contains this element!");
+                if (contains(m_records[record.latency], stored))
+                    LOG_WARN("Vector already contains this element!");
 #endif
+                pushRecord(std::move(stored));
+            }
+        }
+
+        if (shed.empty())
+        {
+            return true;
+        }
+
+        size_t numRecords = 0;
+        for (auto const& tenant : shed)
+        {
+            numRecords += tenant.second;
+        }
+        LOG_WARN("Memory budget of %u bytes exceeded, shed %u records", static_cast<unsigned>(m_memoryBudget->GetLimit()), static_cast<unsigned>(numRecords));
+        m_memoryBudget->AddShedEvents(numRecords);
+        if (m_observer != nullptr)
+        {
+            m_observer->OnStorageTrimmed(shed);
+        }
+        return !dropped;
+    }
 
+    void MemoryStorage::pushRecord(MemoryRecord&& record)
+    {
+        m_queuedMemory.Add(record.GetSize());
         m_records[record.latency].push_back(std::move(record));
-        return true;
     }
 
-    size_t MemoryStorage::StoreRecords(std::vector<StorageRecord> & records)
+    bool MemoryStorage::shedRecords(EventLatency maxLatency, size_t bytes, DroppedMap& shed)
     {
-        size_t stored = 0;
-        for (auto  & i : records) {
-            if (StoreRecord(i)) {
-                ++stored;
+        size_t usage = m_memoryBudget->GetTotalUsage() + bytes;
+        size_t limit = m_memoryBudget->GetLimit();
+        size_t excess = (usage > limit) ? usage - limit : 0;
+
+        size_t available = 0;
+        for (int latency = EventLatency_Off; latency <= static_cast<int>(maxLatency); latency++)
+        {
+            for (auto const& record : m_records[latency])
+            {
+                available += record.GetSize();
             }
         }
-        return stored;
+        if (available < excess)
+        {
+            return false;
+        }
+
+        // Non-critical records go first, then critical ones, each from the lowest latency and oldest
+        for (int pass = 0; (pass < 2) && (excess > 0); pass++)
+        {
+            for (int latency = EventLatency_Off; (latency <= static_cast<int>(maxLatency)) && (excess > 0); latency++)
+            {
+                auto& records = m_records[latency];
+                size_t kept = 0;
+                for (size_t i = 0; i < records.size(); i++)
+                {
+                    bool critical = (records[i].persistence == EventPersistence_Critical);
+                    if ((excess == 0) || (critical != (pass == 1)))
+                    {
+                        if (kept != i)
+                        {
+                            records[kept] = std::move(records[i]);
+                        }
+                        kept++;
+                        continue;
+                    }
+                    size_t recordSize = records[i].GetSize();
+                    excess -= std::min(excess, recordSize);
+                    m_queuedMemory.Subtract(recordSize);
+                    shed[records[i].tenantToken]++;
+                }
+                records.erase(records.begin() + kept, records.end());
+            }
+        }
+        return true;
+    }
+
+    size_t MemoryStorage::StoreRecords(std::vector<StorageRecord> & records)
+    {
+        return storeRecordsInPlace(records, [this](StorageRecord const& record) { return StoreRecord(record); });
     }
 
     /// <summary>
@@ -146,15 +260,20 @@ namespace MAT_NS_BEGIN {
         LOCKGUARD(m_reserved_lock);
         LOCKGUARD(m_records_lock);
         m_lastReadCount = 0;
+        if (m_fairness.IsFairQueueingEnabled())
+        {
+            getAndReserveRecordsFairly(consumer, leaseTimeMs, minLatency, maxCount);
+            return true;
+        }
         // Start processing events of critical latency first
         for (int latency = static_cast<int>(EventLatency_Max); (latency >= static_cast<int>(minLatency)) && (maxCount); latency--)
         {
             while (maxCount && (m_records[latency]).size())
             {
-                StorageRecord & record = m_records[latency].back();
+                MemoryRecord & record = m_records[latency].back();
 
-                size_t recordSize = record.blob.size() + sizeof(record);
-                StorageRecord forConsumer(record);
+                size_t recordSize = record.GetSize();
+                StorageRecord forConsumer = record.ToStorageRecord();
                 if (leaseTimeMs)
                 {
                     forConsumer.reservedUntil = PAL::getUtcSystemTimeMs() + leaseTimeMs;
@@ -167,16 +286,108 @@ namespace MAT_NS_BEGIN {
 
                 if (leaseTimeMs) {
                     m_reserved_records[record.id] = std::move(record); // move to reserved
+                    m_reservedMemory.Add(recordSize);
                 }
                 m_records[latency].pop_back();
-                m_size -= std::min(m_size, recordSize);
+                m_queuedMemory.Subtract(recordSize);
                 maxCount--;
                 m_lastReadCount++;
             }
         }
         return true;
     }
-    
+
+    void MemoryStorage::getAndReserveRecordsFairly(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency, unsigned maxCount)
+    {
+        typedef std::pair<int, size_t> Position;
+
+        // Positions of the records of each tenant, in the same order as when not interleaving tenants
+        std::map<std::string, std::vector<Position>> positions;
+        for (int latency = static_cast<int>(EventLatency_Max); latency >= static_cast<int>(minLatency); latency--)
+        {
+            for (size_t i = m_records[latency].size(); i-- > 0;)
+            {
+                positions[m_records[latency][i].tenantToken].push_back(Position(latency, i));
+            }
+        }
+
+        std::map<StorageRecordId, Position> handedOut;
+        std::vector<TenantFairness::RecordSource> sources;
+        for (auto& tenant : positions)
+        {
+            std::vector<Position>* tenantPositions = &tenant.second;
+            size_t next = 0;
+            sources.push_back([this, tenantPositions, next, leaseTimeMs, &handedOut](StorageRecord& record) mutable
+            {
+                if (next == tenantPositions->size())
+                {
+                    return false;
+                }
+                Position position = (*tenantPositions)[next++];
+                record = m_records[position.first][position.second].ToStorageRecord();
+                if (leaseTimeMs)
+                {
+                    record.reservedUntil = PAL::getUtcSystemTimeMs() + leaseTimeMs;
+                }
+                handedOut[record.id] = position;
+                return true;
+            });
+        }
+
+        std::vector<bool> taken[EventLatency_Max + 1];
+        TenantFairness::Schedule(sources, m_fairness.GetQuantum(), [&](StorageRecord&& record)
+        {
+            if (maxCount == 0)
+            {
+                return false;
+            }
+            Position position = handedOut[record.id];
+            if (!consumer(std::move(record)))
+            {
+                return false;
+            }
+            if (taken[position.first].empty())
+            {
+                taken[position.first].resize(m_records[position.first].size());
+            }
+            taken[position.first][position.second] = true;
+            maxCount--;
+            m_lastReadCount++;
+            return true;
+        });
+
+        // Remove what was handed out, keeping the order of the remaining records
+        for (int latency = static_cast<int>(EventLatency_Max); latency >= static_cast<int>(minLatency); latency--)
+        {
+            if (taken[latency].empty())
+            {
+                continue;
+            }
+            auto& records = m_records[latency];
+            size_t kept = 0;
+            for (size_t i = 0; i < records.size(); i++)
+            {
+                if (!taken[latency][i])
+                {
+                    if (kept != i)
+                    {
+                        records[kept] = std::move(records[i]);
+                    }
+                    kept++;
+                    continue;
+                }
+                size_t recordSize = records[i].GetSize();
+                if (leaseTimeMs)
+                {
+                    m_reserved_records[records[i].id] = std::move(records[i]); // move to reserved
+                    m_reservedMemory.Add(recordSize);
+                }
+                m_queuedMemory.Subtract(recordSize);
+            }
+            records.erase(records.begin() + kept, records.end());
+        }
+    }
+
     /// <summary>
     /// Determines whether the records were last read from memory. Always returns true.
     /// </summary>
@@ -206,6 +417,7 @@ namespace MAT_NS_BEGIN {
             {
                 m_reserved_records.clear();
             }
+            m_reservedMemory.Reset();
         }
         {
             LOCKGUARD(m_records_lock);
@@ -216,7 +428,7 @@ namespace MAT_NS_BEGIN {
                     records.clear();
                 }
             }
-            m_size = 0;
+            m_queuedMemory.Reset();
             m_lastReadCount = 0;
         }
 
@@ -224,7 +436,7 @@ namespace MAT_NS_BEGIN {
 
     void MemoryStorage::DeleteRecords(const std::map<std::string, std::string> & whereFilter)
     {
-        auto matcher = [&](const StorageRecord &r, const std::map<std::string, std::string> & whereFilter)
+        auto matcher = [&](const MemoryRecord &r, const std::map<std::string, std::string> & whereFilter)
         {
             bool matched = true;
             for (const auto &kv : whereFilter)
@@ -271,8 +483,7 @@ namespace MAT_NS_BEGIN {
                     auto &v = *it;
                     if (matcher(v, whereFilter))
                     {
-                        size_t recordSize = v.blob.size() + sizeof(v);
-                        m_size -= std::min(m_size, recordSize);
+                        m_queuedMemory.Subtract(v.GetSize());
                         it = records.erase(it);
                         continue;
                     }
@@ -305,6 +516,7 @@ namespace MAT_NS_BEGIN {
                     if (idSet.count(kv.first))
                     {
                         idSet.erase(kv.first);
+                        m_reservedMemory.Subtract(kv.second.GetSize());
                         it = m_reserved_records.erase(it);
                         continue;
                     }
@@ -336,8 +548,7 @@ namespace MAT_NS_BEGIN {
                         {
                             // record id appears once only, so remove from set
                             idSet.erase(v.id);
-                            size_t recordSize = v.blob.size() + sizeof(v);
-                            m_size -= std::min(m_size, recordSize);
+                            m_queuedMemory.Subtract(v.GetSize());
                             it = records.erase(it);
                             continue;
                         }
@@ -374,7 +585,11 @@ namespace MAT_NS_BEGIN {
                 {
                     if (incrementRetryCount)
                         kv.second.retryCount++;
-                    StoreRecord(kv.second);
+                    m_reservedMemory.Subtract(kv.second.GetSize());
+                    {
+                        LOCKGUARD(m_records_lock);
+                        pushRecord(std::move(kv.second));
+                    }
                     idSet.erase(kv.first);
                     it = m_reserved_records.erase(it);
                     continue;
@@ -395,7 +610,11 @@ namespace MAT_NS_BEGIN {
             while (it != m_reserved_records.end())
             {
                 auto &kv = *it;
-                StoreRecord(kv.second);
+                m_reservedMemory.Subtract(kv.second.GetSize());
+                {
+                    LOCKGUARD(m_records_lock);
+                    pushRecord(std::move(kv.second));
+                }
                 it = m_reserved_records.erase(it);
             }
         }
@@ -446,7 +665,7 @@ namespace MAT_NS_BEGIN {
     /// Get size of the ram DB excluding reserved (in-flight) records.
     /// </summary>
     /// <returns>
-    /// Approximate ram queue size
+    /// Bytes held by the queued records, including their buffers
     /// </returns>
     /// <remarks>
     /// Called from the internal worker thread.
@@ -454,7 +673,7 @@ namespace MAT_NS_BEGIN {
     size_t MemoryStorage::GetSize()
     {
         LOCKGUARD(m_records_lock);
-        return m_size;
+        return m_queuedMemory.GetBytes();
     }
 
     /// <summary>
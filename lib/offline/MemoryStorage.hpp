@@ -10,8 +10,10 @@
 #include "pal/PAL.hpp"
 
 #include "IOfflineStorage.hpp"
+#include "TenantFairness.hpp"
 
 #include "api/IRuntimeConfig.hpp"
+#include "system/MemoryBudget.hpp"
 
 #include "ILogManager.hpp"
 
@@ -24,11 +26,44 @@
 
 namespace MAT_NS_BEGIN {
 
+    /// <summary>
+    /// Record of the RAM queue. Its blob is allocated from the memory budget of the log manager.
+    /// </summary>
+    struct MemoryRecord
+    {
+        typedef std::vector<uint8_t, MemoryBudget::Allocator<uint8_t>> Blob;
+
+        StorageRecordId  id;
+        std::string      tenantToken;
+        EventLatency     latency = EventLatency_Unspecified;
+        EventPersistence persistence = EventPersistence_Normal;
+        int64_t          timestamp = 0;
+        Blob             blob;
+        int              retryCount = 0;
+        int64_t          reservedUntil = 0;
+
+        MemoryRecord()
+        {}
+
+        MemoryRecord(StorageRecord const& record, MemoryBudget* memoryBudget);
+
+        StorageRecord ToStorageRecord() const;
+
+        /// <summary>
+        /// Bytes held by the record, including its buffers.
+        /// </summary>
+        size_t GetSize() const;
+
+        bool operator==(const MemoryRecord& rhs) const {
+            return (id == rhs.id);
+        }
+    };
+
     class MemoryStorage : public IOfflineStorage
     {
 
     public:
-        MemoryStorage(ILogManager& logManager, IRuntimeConfig& runtimeConfig);
+        MemoryStorage(ILogManager& logManager, IRuntimeConfig& runtimeConfig, MemoryBudget* memoryBudget = nullptr);
 
         virtual void Initialize(IOfflineStorageObserver& observer) override;
 
@@ -76,22 +111,51 @@ namespace MAT_NS_BEGIN {
         virtual ~MemoryStorage() override;
 
     protected:
-        
+        typedef std::vector<MemoryRecord, MemoryBudget::Allocator<MemoryRecord>> MemoryRecordVector;
+        typedef std::map<StorageRecordId, MemoryRecord, std::less<StorageRecordId>,
+            MemoryBudget::Allocator<std::pair<const StorageRecordId, MemoryRecord>>> MemoryRecordMap;
+
+        /// <summary>
+        /// Hands the records out in deficit round robin order across tenants. Requires both locks.
+        /// </summary>
+        void getAndReserveRecordsFairly(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs,
+            EventLatency minLatency, unsigned maxCount);
+
+        /// <summary>
+        /// Appends a record to the queue of its latency. Requires m_records_lock.
+        /// </summary>
+        void pushRecord(MemoryRecord&& record);
+
+        /// <summary>
+        /// Drops queued records of at most the given latency, non-critical and oldest first, until
+        /// the given number of bytes fits in the memory budget. Drops nothing and returns false if
+        /// they cannot be made to fit. Requires m_records_lock.
+        /// </summary>
+        bool shedRecords(EventLatency maxLatency, size_t bytes, DroppedMap& shed);
+
         IOfflineStorageObserver*    m_observer;
         IRuntimeConfig&             m_config;
         ILogManager&                m_logManager;
+        MemoryBudget*               m_memoryBudget;
 
         mutable std::mutex          m_records_lock;
-        std::vector<StorageRecord>  m_records[EventLatency_Max+1];
-        
+        MemoryRecordVector          m_records[EventLatency_Max+1];
+
         /// <summary>
         /// Contains reserved (aka in-flight) records.
         /// Current storage interface API requires deletion and release by StorageRecordId.
         /// </summary>
         std::mutex                  m_reserved_lock;
-        std::map<StorageRecordId, StorageRecord> m_reserved_records;
+        MemoryRecordMap             m_reserved_records;
+
+        /// <summary>
+        /// Bytes of the queued and of the reserved records, charged to the memory budget.
+        /// Guarded by m_records_lock and m_reserved_lock respectively.
+        /// </summary>
+        MemoryCharge                m_queuedMemory;
+        MemoryCharge                m_reservedMemory;
 
-        size_t                      m_size;
+        TenantFairness              m_fairness;
 
         MATSDK_LOG_DECL_COMPONENT_CLASS();
 
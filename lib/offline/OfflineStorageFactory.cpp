@@ -14,6 +14,7 @@
 #else
 #include "offline/OfflineStorage_SQLite.hpp"
 #endif
+#include "offline/OfflineStorage_Segments.hpp"
 
 #include <memory>
 
@@ -27,6 +28,14 @@ namespace MAT_NS_BEGIN
             LOG_TRACE("Creating OfflineStorage from module");
             return std::static_pointer_cast<IOfflineStorage>(std::static_pointer_cast<IOfflineStorageModule>(module));
         }
+        const char* storageType = runtimeConfig[CFG_STR_OFFLINE_STORAGE_TYPE];
+        const char* cacheFilePath = runtimeConfig[CFG_STR_CACHE_FILE_PATH];
+        if ((storageType != nullptr) && (std::string(storageType) == "segments") &&
+            (cacheFilePath != nullptr) && (cacheFilePath[0] != '\0') && (std::string(cacheFilePath) != ":memory:"))
+        {
+            LOG_TRACE("Creating OfflineStorage_Segments");
+            return std::make_shared<OfflineStorage_Segments>(logManager, runtimeConfig);
+        }
 #ifdef USE_ROOM
         LOG_TRACE("Creating OfflineStorage_Room");
         return std::make_shared<OfflineStorage_Room>(logManager, runtimeConfig);
@@ -7,9 +7,11 @@
 #include "OfflineStorageFactory.hpp"
 
 #include "offline/MemoryStorage.hpp"
+#include "offline/StorageRecordBatch.hpp"
 
 #include "ILogManager.hpp"
 #include <algorithm>
+#include <iterator>
 #include <numeric>
 #include <set>
 
@@ -18,16 +20,26 @@ namespace MAT_NS_BEGIN {
 
     MATSDK_LOG_INST_COMPONENT_CLASS(OfflineStorageHandler, "EventsSDK.StorageHandler", "Events telemetry client - OfflineStorageHandler class");
 
-    OfflineStorageHandler::OfflineStorageHandler(ILogManager& logManager, IRuntimeConfig& runtimeConfig, ITaskDispatcher& taskDispatcher) :
+    // Quiet period after the last upload deletion before the disk storage gets its maintenance pass
+    constexpr static unsigned kMaintenanceDelayMs = 5000;
+
+    // Longest wait at shutdown for a deferred disk storage open that is already running
+    constexpr static unsigned kDiskOpenWaitMs = 30000;
+
+    OfflineStorageHandler::OfflineStorageHandler(ILogManager& logManager, IRuntimeConfig& runtimeConfig, ITaskDispatcher& taskDispatcher, std::shared_ptr<IOfflineStorage> sharedStorage,
+        MemoryBudget* memoryBudget) :
         m_observer(nullptr),
         m_logManager(logManager),
         m_config(runtimeConfig),
         m_taskDispatcher(taskDispatcher),
+        m_memoryBudget(memoryBudget),
         m_killSwitchManager(),
         m_clockSkewManager(),
         m_flushPending(false),
+        m_diskReady(false),
         m_offlineStorageMemory(nullptr),
         m_offlineStorageDisk(nullptr),
+        m_sharedStorageDisk(sharedStorage),
         m_readFromMemory(false),
         m_lastReadCount(0),
         m_shutdownStarted(false),
@@ -69,6 +81,7 @@ namespace MAT_NS_BEGIN {
 
     OfflineStorageHandler::~OfflineStorageHandler()
     {
+        m_diskOpenHandle.Cancel(kDiskOpenWaitMs);
         WaitForFlush();
         if (nullptr != m_offlineStorageMemory)
         {
@@ -84,27 +97,90 @@ namespace MAT_NS_BEGIN {
     {
         m_observer = &observer;
         uint32_t cacheMemorySizeLimitInBytes = m_config[CFG_INT_RAM_QUEUE_SIZE];
-
-        m_offlineStorageDisk = OfflineStorageFactory::Create(m_logManager, m_config);
-        m_offlineStorageDisk->Initialize(*this);
+        if (cacheMemorySizeLimitInBytes > 0 && m_config[CFG_BOOL_ENABLE_MULTIPROCESS_STORAGE])
+        {
+            // Events go straight to the shared database, where the uploader process finds them
+            LOG_TRACE("Multi-process storage: in-memory queue disabled");
+            cacheMemorySizeLimitInBytes = 0;
+        }
 
         // TODO: [MG] - consider passing m_offlineStorageDisk to m_offlineStorageMemory,
         // so that the Flush() op on memory storage leads to saving unflushed events to
         // disk.
         if (cacheMemorySizeLimitInBytes > 0)
         {
-            m_offlineStorageMemory.reset(new MemoryStorage(m_logManager, m_config));
+            m_offlineStorageMemory.reset(new MemoryStorage(m_logManager, m_config, m_memoryBudget));
             m_offlineStorageMemory->Initialize(*this);
         }
 
+        m_diskReady = false;
         m_shutdownStarted = false;
+        if (m_config[CFG_BOOL_DEFER_STORAGE_OPEN] && (m_offlineStorageMemory != nullptr))
+        {
+            // Events are buffered in the RAM queue until the worker has the disk storage ready
+            LOG_TRACE("Deferring disk storage open to the worker thread");
+            m_diskOpenHandle = PAL::scheduleTask(&m_taskDispatcher, 0, this, &OfflineStorageHandler::OpenDiskStorage);
+        }
+        else
+        {
+            OpenDiskStorage();
+        }
         LOG_TRACE("Initializing offline storage handler");
     }
 
+    /// <summary>
+    /// Create and open the disk storage, then report that it is ready with EVT_STORAGE_READY
+    /// </summary>
+    /// <remarks>
+    /// Runs on the worker thread when the open is deferred, otherwise from Initialize.
+    /// No-op once the storage is open, so that Shutdown and the settings API can run it early.
+    /// </remarks>
+    void OfflineStorageHandler::OpenDiskStorage()
+    {
+        LOCKGUARD(m_diskOpenLock);
+        if (m_diskReady)
+        {
+            return;
+        }
+
+        auto start = PAL::getMonotonicTimeMs();
+        auto storage = (m_sharedStorageDisk != nullptr) ? m_sharedStorageDisk : OfflineStorageFactory::Create(m_logManager, m_config);
+        storage->Initialize(*this);
+        m_offlineStorageDisk = storage;
+        m_diskReady = true;
+
+        auto elapsed = PAL::getMonotonicTimeMs() - start;
+        LOG_INFO("Disk storage ready in %u ms", static_cast<unsigned>(elapsed));
+        DebugEvent evt;
+        evt.type = DebugEventType::EVT_STORAGE_READY;
+        evt.param1 = static_cast<size_t>(elapsed);
+        m_logManager.DispatchEvent(evt);
+    }
+
+    /// <summary>
+    /// Open the disk storage now if a deferred open has not run yet
+    /// </summary>
+    /// <returns>true if the disk storage is available</returns>
+    bool OfflineStorageHandler::WaitForDiskStorage()
+    {
+        if (!m_diskReady && !m_shutdownStarted && (m_observer != nullptr))
+        {
+            OpenDiskStorage();
+        }
+        return m_diskReady;
+    }
+
     void OfflineStorageHandler::Shutdown()
     {
         LOG_TRACE("Shutting down offline storage handler");
+        // The RAM queue gets flushed to disk below, so a deferred open that is still pending runs now
+        m_diskOpenHandle.Cancel(kDiskOpenWaitMs);
+        OpenDiskStorage();
         m_shutdownStarted = true;
+        {
+            LOCKGUARD(m_maintenanceLock);
+            m_maintenanceHandle.Cancel(kMaintenanceDelayMs);
+        }
         WaitForFlush();
         if (nullptr != m_offlineStorageMemory)
         {
@@ -112,7 +188,7 @@ namespace MAT_NS_BEGIN {
             Flush();
             m_offlineStorageMemory->Shutdown();
         }
-        if (nullptr != m_offlineStorageDisk)
+        if (m_diskReady)
         {
             m_offlineStorageDisk->Shutdown();
         }
@@ -132,7 +208,7 @@ namespace MAT_NS_BEGIN {
         size_t size = 0;
         if (m_offlineStorageMemory != nullptr)
             size += m_offlineStorageMemory->GetSize();
-        if (m_offlineStorageDisk != nullptr)
+        if (m_diskReady)
             size += m_offlineStorageDisk->GetSize();
         return size;
     }
@@ -142,7 +218,7 @@ namespace MAT_NS_BEGIN {
         size_t count = 0;
         if (m_offlineStorageMemory != nullptr)
             count += m_offlineStorageMemory->GetRecordCount(latency);
-        if (m_offlineStorageDisk != nullptr)
+        if (m_diskReady)
             count += m_offlineStorageDisk->GetRecordCount(latency);
         return count;
     }
@@ -158,24 +234,17 @@ namespace MAT_NS_BEGIN {
         // than the handle gets replaced by nullptr in this DeferredCallbackHandle obj.
         m_flushHandle.Cancel();
 
-        size_t dbSizeBeforeFlush = m_offlineStorageMemory->GetSize();
-        if ((m_offlineStorageMemory) && (dbSizeBeforeFlush > 0) && (m_offlineStorageDisk))
+        size_t dbSizeBeforeFlush = (m_offlineStorageMemory) ? m_offlineStorageMemory->GetSize() : 0;
+        if ((dbSizeBeforeFlush > 0) && (m_diskReady))
         {
             // This will block on and then take a lock for the duration of this move, and
             // StoreRecord() will then block until the move completes.
             auto records = m_offlineStorageMemory->GetRecords(false, EventLatency_Unspecified);
             std::vector<StorageRecordId> ids;
 
-            // TODO: [MG] - consider running the batch in transaction
-            //            if (sqlite)
-            //                sqlite->Execute("BEGIN");
-
+            // The disk storage writes the whole batch in one transaction
             size_t totalSaved = m_offlineStorageDisk->StoreRecords(records);
 
-            // TODO: [MG] - consider running the batch in transaction
-            //            if (sqlite)
-            //                sqlite->Execute("END");
-
             // Delete records from reserved on flush
             HttpHeaders dummy;
             bool fromMemory = true;
@@ -216,6 +285,16 @@ namespace MAT_NS_BEGIN {
         if (nullptr != m_offlineStorageMemory && !m_shutdownStarted)
         {
             auto memDbSize = m_offlineStorageMemory->GetSize();
+
+            // Over the memory budget, records that may be persisted skip the RAM queue
+            // instead of making it shed other records, and the RAM queue is flushed.
+            bool spill = m_diskReady && (record.persistence != EventPersistence::EventPersistence_DoNotStoreOnDisk) &&
+                (m_memoryBudget != nullptr) && m_memoryBudget->WouldExceed(record.blob.size());
+            if (spill)
+            {
+                m_offlineStorageDisk->StoreRecord(record);
+            }
+            else
             {
                 // During flush, this will block on a mutex while records
                 // are selected and removed from the cache (but will
@@ -225,7 +304,7 @@ namespace MAT_NS_BEGIN {
             }
 
             // Perform periodic flush to disk
-            if (memDbSize > cacheMemorySizeLimitInBytes)
+            if ((memDbSize > cacheMemorySizeLimitInBytes) || (spill && (memDbSize > 0)))
             {
                 if (m_flushLock.try_lock())
                 {
@@ -242,7 +321,7 @@ namespace MAT_NS_BEGIN {
         }
         else
         {
-            if (m_offlineStorageDisk != nullptr)
+            if (m_diskReady)
             {
                 if (record.persistence != EventPersistence::EventPersistence_DoNotStoreOnDisk)
                 {
@@ -256,15 +335,51 @@ namespace MAT_NS_BEGIN {
 
     size_t OfflineStorageHandler::StoreRecords(std::vector<StorageRecord>& records)
     {
-        size_t stored = 0;
-        for (auto& i : records)
+        if ((nullptr != m_offlineStorageMemory) && !m_shutdownStarted)
         {
-            if (StoreRecord(i))
+            // The RAM queue takes the records one by one, deciding for each whether it spills to disk
+            return storeRecordsInPlace(records, [this](StorageRecord const& record) { return StoreRecord(record); });
+        }
+
+        // Discard records associated with killed tenants, as StoreRecord does
+        size_t accepted = storeRecordsInPlace(records, [this](StorageRecord const& record) {
+            return m_shutdownStarted || !isKilled(record);
+        });
+        if (!m_diskReady)
+        {
+            return accepted;
+        }
+
+        // Records that must not be persisted are accepted and dropped. The others are
+        // handed to the disk storage as one batch, so that it can write them in one transaction.
+        size_t persisted = 0;
+        for (size_t i = 0; i < accepted; i++)
+        {
+            if (records[i].persistence != EventPersistence::EventPersistence_DoNotStoreOnDisk)
             {
-                ++stored;
+                if (i != persisted)
+                {
+                    std::swap(records[persisted], records[i]);
+                }
+                persisted++;
             }
         }
-        return stored;
+
+        size_t stored = 0;
+        if (persisted == records.size())
+        {
+            stored = m_offlineStorageDisk->StoreRecords(records);
+        }
+        else if (persisted > 0)
+        {
+            StorageRecordVector batch(std::make_move_iterator(records.begin()), std::make_move_iterator(records.begin() + persisted));
+            stored = m_offlineStorageDisk->StoreRecords(batch);
+            std::move(batch.begin(), batch.end(), records.begin());
+        }
+
+        // Keep the records the disk storage failed to store behind the stored and dropped ones
+        std::rotate(records.begin() + stored, records.begin() + persisted, records.begin() + accepted);
+        return stored + (accepted - persisted);
     }
 
     bool OfflineStorageHandler::ResizeDb()
@@ -274,7 +389,7 @@ namespace MAT_NS_BEGIN {
             m_offlineStorageMemory->ResizeDb();
         }
 
-        if (nullptr != m_offlineStorageDisk)
+        if (m_diskReady)
         {
             m_offlineStorageDisk->ResizeDb();
         }
@@ -313,7 +428,7 @@ namespace MAT_NS_BEGIN {
                 return returnValue;
         }
 
-        if (m_offlineStorageDisk)
+        if (m_diskReady)
         {
             returnValue |= m_offlineStorageDisk->GetAndReserveRecords(consumer, leaseTimeMs, minLatency, maxCount);
             auto lastOfflineReadCount = m_offlineStorageDisk->LastReadRecordCount();
@@ -366,7 +481,7 @@ namespace MAT_NS_BEGIN {
 
     void OfflineStorageHandler::DeleteAllRecords() 
     {
-        for (const auto storagePtr : { m_offlineStorageMemory.get() , m_offlineStorageDisk.get() })
+        for (const auto storagePtr : { m_offlineStorageMemory.get() , m_diskReady ? m_offlineStorageDisk.get() : nullptr })
         {
             if (storagePtr != nullptr)
             {
@@ -389,7 +504,7 @@ namespace MAT_NS_BEGIN {
     /// </remarks>
     void OfflineStorageHandler::DeleteRecords(const std::map<std::string, std::string>& whereFilter)
     {
-        for (const auto storagePtr : {m_offlineStorageMemory.get(), m_offlineStorageDisk.get()})
+        for (const auto storagePtr : {m_offlineStorageMemory.get(), m_diskReady ? m_offlineStorageDisk.get() : nullptr})
         {
             if (storagePtr != nullptr)
             {
@@ -432,13 +547,40 @@ namespace MAT_NS_BEGIN {
         }
         else
         {
-            if (nullptr != m_offlineStorageDisk)
+            if (m_diskReady)
             {
                 m_offlineStorageDisk->DeleteRecords(ids, headers, fromMemory);
+                ScheduleMaintenance();
             }
         }
     }
 
+    /// <summary>
+    /// Defer trimming and reclaiming of free space in the disk storage until uploads quiesce
+    /// </summary>
+    /// <remarks>
+    /// Every new batch of deletions pushes the pass back, so it runs while the worker is idle.
+    /// </remarks>
+    void OfflineStorageHandler::ScheduleMaintenance()
+    {
+        LOCKGUARD(m_maintenanceLock);
+        if (m_shutdownStarted)
+        {
+            return;
+        }
+        m_maintenanceHandle.Cancel();
+        m_maintenanceHandle = PAL::scheduleTask(&m_taskDispatcher, kMaintenanceDelayMs, this, &OfflineStorageHandler::PerformMaintenance);
+    }
+
+    void OfflineStorageHandler::PerformMaintenance()
+    {
+        if (!m_shutdownStarted && m_diskReady)
+        {
+            // Time-bounded in the storage implementations that support it
+            m_offlineStorageDisk->ResizeDb();
+        }
+    }
+
     void OfflineStorageHandler::ReleaseRecords(std::vector<StorageRecordId> const& ids, bool incrementRetryCount, HttpHeaders headers, bool& fromMemory)
     {
         if (m_clockSkewManager.isWaitingForClockSkew())
@@ -460,7 +602,7 @@ namespace MAT_NS_BEGIN {
         }
         else
         {
-            if (nullptr != m_offlineStorageDisk)
+            if (m_diskReady)
             {
                 m_offlineStorageDisk->ReleaseRecords(ids, incrementRetryCount, headers, fromMemory);
             }
@@ -469,7 +611,7 @@ namespace MAT_NS_BEGIN {
 
     bool OfflineStorageHandler::StoreSetting(std::string const& name, std::string const& value)
     {
-        if (nullptr != m_offlineStorageDisk)
+        if (WaitForDiskStorage())
         {
             m_offlineStorageDisk->StoreSetting(name, value);
             return true;
@@ -479,7 +621,7 @@ namespace MAT_NS_BEGIN {
 
     std::string OfflineStorageHandler::GetSetting(std::string const& name)
     {
-        if (nullptr != m_offlineStorageDisk)
+        if (WaitForDiskStorage())
         {
             return m_offlineStorageDisk->GetSetting(name);
         }
@@ -488,7 +630,7 @@ namespace MAT_NS_BEGIN {
 
     bool OfflineStorageHandler::DeleteSetting(std::string const& name)
     {
-        if (nullptr != m_offlineStorageDisk)
+        if (WaitForDiskStorage())
         {
             return m_offlineStorageDisk->DeleteSetting(name);
         }
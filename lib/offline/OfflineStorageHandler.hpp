@@ -12,6 +12,7 @@
 #include "api/IRuntimeConfig.hpp"
 #include "ILogManager.hpp"
 #include "pal/TaskDispatcher.hpp"
+#include "system/MemoryBudget.hpp"
 
 #include <memory>
 #include <atomic>
@@ -26,7 +27,13 @@ namespace MAT_NS_BEGIN {
     class OfflineStorageHandler : public IOfflineStorage, public IOfflineStorageObserver
     {
     public:
-        OfflineStorageHandler(ILogManager& logManager, IRuntimeConfig& runtimeConfig, ITaskDispatcher& taskDispatcher);
+        /// <summary>
+        /// Creates the storage handler.
+        /// </summary>
+        /// <param name="sharedStorage">Disk storage to use instead of creating one, e.g. a partition of a shared runtime.</param>
+        /// <param name="memoryBudget">Memory budget that the RAM queue allocates from and is accounted to.</param>
+        OfflineStorageHandler(ILogManager& logManager, IRuntimeConfig& runtimeConfig, ITaskDispatcher& taskDispatcher, std::shared_ptr<IOfflineStorage> sharedStorage = nullptr,
+            MemoryBudget* memoryBudget = nullptr);
         virtual ~OfflineStorageHandler() override;
         virtual void Initialize(IOfflineStorageObserver& observer) override;
         virtual void Shutdown() override;
@@ -69,6 +76,7 @@ namespace MAT_NS_BEGIN {
         std::string                 m_databasePath;
         IRuntimeConfig&             m_config;
         ITaskDispatcher&            m_taskDispatcher;
+        MemoryBudget*               m_memoryBudget;
         
         KillSwitchManager           m_killSwitchManager;
         ClockSkewManager            m_clockSkewManager;
@@ -80,8 +88,16 @@ namespace MAT_NS_BEGIN {
         PAL::DeferredCallbackHandle            m_flushHandle;
         PAL::Event                             m_flushComplete;
 
+        std::mutex                             m_maintenanceLock;
+        PAL::DeferredCallbackHandle            m_maintenanceHandle;
+
+        std::mutex                             m_diskOpenLock;
+        std::atomic<bool>                      m_diskReady;
+        PAL::DeferredCallbackHandle            m_diskOpenHandle;
+
         std::unique_ptr<IOfflineStorage>       m_offlineStorageMemory;
         std::shared_ptr<IOfflineStorage>       m_offlineStorageDisk;
+        std::shared_ptr<IOfflineStorage>       m_sharedStorageDisk;
 
         bool                                   m_readFromMemory;
         unsigned                               m_lastReadCount;
@@ -97,6 +113,10 @@ namespace MAT_NS_BEGIN {
 
     private:
         void WaitForFlush();
+        void ScheduleMaintenance();
+        void PerformMaintenance();
+        void OpenDiskStorage();
+        bool WaitForDiskStorage();
 
     };
 
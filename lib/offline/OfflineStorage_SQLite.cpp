@@ -8,8 +8,12 @@
 #include "OfflineStorage_SQLite.hpp"
 #include "ILogManager.hpp"
 #include "SQLiteWrapper.hpp"
+#include "StorageRecordBatch.hpp"
+#include "utils/Crc32.hpp"
 #include "utils/StringUtils.hpp"
 #include <algorithm>
+#include <deque>
+#include <limits>
 #include <numeric>
 #include <set>
 
@@ -17,6 +21,17 @@ namespace MAT_NS_BEGIN {
 
     constexpr static size_t kBlockSize = 8192;
 
+    // Trimming deletes the least important records this many at a time
+    constexpr static unsigned kTrimChunkSize = 256;
+    // Records read per tenant at a time when retrieving records in fair order
+    constexpr static unsigned kFairReadChunkSize = 32;
+    // Pages returned to the file system per incremental vacuum statement
+#define VACUUM_PAGES_PER_STEP "64"
+    // Time a single ResizeDb() call may spend trimming and vacuuming before yielding the worker
+    constexpr static uint64_t kMaintenanceBudgetMs = 50;
+    // Time a statement waits for the write lock held by another process sharing the database
+    constexpr static unsigned kMultiProcessBusyTimeoutMs = 2000;
+
     class DbTransaction {
         SqliteDB* m_db;
     public:
@@ -41,7 +56,11 @@ namespace MAT_NS_BEGIN {
 
     MATSDK_LOG_INST_COMPONENT_CLASS(OfflineStorage_SQLite, "EventsSDK.Storage", "Events telemetry client - OfflineStorage_SQLite class");
 
-    static int const CURRENT_SCHEMA_VERSION = 1;
+    // Version 2 adds the payload checksum column
+    static int const CURRENT_SCHEMA_VERSION = 2;
+
+    // Value of the checksum column for records stored without one
+    static int64_t const NO_CHECKSUM = -1;
 #define TABLE_NAME_EVENTS   "events"
 #define TABLE_NAME_SETTINGS "settings"
 #define TABLE_NAME_PACKAGES "packages"
@@ -76,6 +95,10 @@ namespace MAT_NS_BEGIN {
         uint32_t ramSizeLimit = m_config[CFG_INT_RAM_QUEUE_SIZE];
         m_DbSizeHeapLimit = ramSizeLimit;
 
+        m_checksumsEnabled = m_config[CFG_BOOL_ENABLE_CRC32];
+        m_fairness.Configure(m_config);
+        m_isMultiProcess = !inMemory && (m_offlineStorageFileName != ":memory:") && static_cast<bool>(m_config[CFG_BOOL_ENABLE_MULTIPROCESS_STORAGE]);
+
         const char* skipSqliteInit = m_config["skipSqliteInitAndShutdown"];
         if (skipSqliteInit != nullptr)
         {
@@ -128,6 +151,32 @@ namespace MAT_NS_BEGIN {
             }
             m_isOpened = false;
         }
+        if (m_uploaderLock.IsLocked())
+        {
+            LOG_INFO("Resigning as uploader of %s", m_offlineStorageFileName.c_str());
+            m_uploaderLock.Unlock();
+        }
+        m_reservedRecords.clear();
+        resetCounts();
+    }
+
+    /// <summary>
+    /// Returns true if this process may reserve and trim records: always, unless the database is shared
+    /// with other processes, in which case this process must hold or win the uploader lock. The lock is
+    /// released by the operating system when its holder exits, so a surviving process takes over.
+    /// </summary>
+    bool OfflineStorage_SQLite::isUploader()
+    {
+        if (!m_isMultiProcess || m_uploaderLock.IsLocked())
+        {
+            return true;
+        }
+        if (!m_uploaderLock.TryLock(m_offlineStorageFileName + ".lock"))
+        {
+            return false;
+        }
+        LOG_INFO("Elected as uploader of %s", m_offlineStorageFileName.c_str());
+        return true;
     }
 
     void OfflineStorage_SQLite::Execute(std::string command)
@@ -141,10 +190,7 @@ namespace MAT_NS_BEGIN {
         // TODO: [MG] - this works, but may not play nicely with several LogManager instances
         // static SqliteStatement sql_insert(*m_db, m_stmtInsertEvent_id_tenant_prio_ts_data);
 
-        if (record.id.empty() || record.tenantToken.empty() || static_cast<int>(record.latency) < 0 || record.timestamp <= 0) {
-            LOG_ERROR("Failed to store event %s:%s: Invalid parameters",
-                tenantTokenToId(record.tenantToken).c_str(), record.id.c_str());
-            m_observer->OnStorageFailed("Invalid parameters");
+        if (!isValidRecord(record)) {
             return false;
         }
 
@@ -155,6 +201,7 @@ namespace MAT_NS_BEGIN {
             return false;
         }
 
+        bool inserted = false;
         {
 #ifdef ENABLE_LOCKING
             LOCKGUARD(m_lock);
@@ -166,10 +213,74 @@ namespace MAT_NS_BEGIN {
                 return false;
             }
 #endif
-            SqliteStatement(*m_db, m_stmtInsertEvent_id_tenant_prio_ts_data).execute(record.id, record.tenantToken, static_cast<int>(record.latency), static_cast<int>(record.persistence), record.timestamp, record.blob);
-            m_DbSizeEstimate += record.id.size() + record.tenantToken.size() + record.blob.size();
+            inserted = insertRecord(record);
+        }
+
+        checkDbSize();
+        return inserted;
+    }
+
+    size_t OfflineStorage_SQLite::StoreRecords(std::vector<StorageRecord> & records)
+    {
+        if (records.empty()) {
+            return 0;
+        }
+
+        if (!m_db) {
+            LOG_ERROR("Failed to store %u events: Database is not open", static_cast<unsigned>(records.size()));
+            m_observer->OnStorageOpenFailed("Database is not open");
+            return 0;
+        }
+
+        size_t stored = 0;
+        {
+#ifdef ENABLE_LOCKING
+            // One transaction for the whole batch
+            LOCKGUARD(m_lock);
+            DbTransaction transaction(m_db.get());
+            if (!transaction.locked)
+            {
+                LOG_ERROR("Failed to store %u events: Database error", static_cast<unsigned>(records.size()));
+                m_observer->OnStorageFailed("Database error");
+                return 0;
+            }
+#endif
+            stored = storeRecordsInPlace(records, [this](StorageRecord const& record) {
+                return isValidRecord(record) && insertRecord(record);
+            });
         }
 
+        checkDbSize();
+        return stored;
+    }
+
+    bool OfflineStorage_SQLite::isValidRecord(StorageRecord const& record)
+    {
+        if (record.id.empty() || record.tenantToken.empty() || static_cast<int>(record.latency) < 0 || record.timestamp <= 0) {
+            LOG_ERROR("Failed to store event %s:%s: Invalid parameters",
+                tenantTokenToId(record.tenantToken).c_str(), record.id.c_str());
+            m_observer->OnStorageFailed("Invalid parameters");
+            return false;
+        }
+        return true;
+    }
+
+    bool OfflineStorage_SQLite::insertRecord(StorageRecord const& record)
+    {
+        int64_t checksum = m_checksumsEnabled ? static_cast<int64_t>(Crc32::Crc32c(record.blob.data(), record.blob.size())) : NO_CHECKSUM;
+        bool inserted = SqliteStatement(*m_db, m_stmtInsertEvent_id_tenant_prio_ts_data).execute(record.id, record.tenantToken, static_cast<int>(record.latency), static_cast<int>(record.persistence), record.timestamp, record.blob, checksum);
+        if (inserted) {
+            countRecord(static_cast<int>(record.latency), record.blob.size());
+        }
+        m_DbSizeEstimate += record.id.size() + record.tenantToken.size() + record.blob.size();
+        return inserted;
+    }
+
+    /// <summary>
+    /// Notifies about a nearly full database and trims it once it exceeds the size limit.
+    /// </summary>
+    void OfflineStorage_SQLite::checkDbSize()
+    {
         if ((m_DbSizeNotificationLimit != 0) && (m_DbSizeEstimate>m_DbSizeNotificationLimit))
         {
             auto now = PAL::getMonotonicTimeMs();
@@ -199,20 +310,6 @@ namespace MAT_NS_BEGIN {
                 m_resizing = false;
             }
         }
-
-        return true;
-
-    }
-
-    size_t OfflineStorage_SQLite::StoreRecords(std::vector<StorageRecord> & records)
-    {
-        size_t stored = 0;
-        for (auto & i : records) {
-            if (StoreRecord(i)) {
-                ++stored;
-            }
-        }
-        return stored;
     }
 
     // Debug routine to print record count in the DB
@@ -250,6 +347,16 @@ namespace MAT_NS_BEGIN {
 
         /* ============================================================================================================= */
         LOCKGUARD(m_lock);
+        if (m_isMultiProcess)
+        {
+            if (!isUploader())
+            {
+                LOG_TRACE("Not retrieving events: another process is the uploader");
+                return false;
+            }
+            // Records stored by the other processes are not counted as they come
+            reconcileCounts();
+        }
         {
 #ifdef ENABLE_LOCKING
             DbTransaction transaction(m_db.get());
@@ -261,28 +368,26 @@ namespace MAT_NS_BEGIN {
 #endif
             SqliteStatement releaseStmt(*m_db, m_stmtReleaseExpiredEvents);
 
-            if (!releaseStmt.execute(PAL::getUtcSystemTimeMs()))
+            int64_t now = PAL::getUtcSystemTimeMs();
+            if (!releaseStmt.execute(now))
                 LOG_ERROR("Failed to release expired reserved events: Database error occurred");
             else {
                 if (releaseStmt.changes() > 0) {
                     LOG_TRACE("Released %u expired reserved events", static_cast<unsigned>(releaseStmt.changes()));
+                    for (auto it = m_reservedRecords.begin(); it != m_reservedRecords.end();)
+                    {
+                        it = (it->second.reservedUntil <= now) ? m_reservedRecords.erase(it) : std::next(it);
+                    }
                 }
             }
 
-            SqliteStatement selectStmt(*m_db, m_stmtSelectEvents);
-            if (!selectStmt.select(static_cast<int>(minLatency), maxCount > 0 ? maxCount : -1)) {
-                LOG_ERROR("Failed to retrieve events to send: Database error occurred, recreating database");
-                recreate(204);
-                return false;
-            }
-
             std::vector<StorageRecordId> consumedIds;
+            std::vector<ReservedRecord> consumedRecords;
+            std::vector<StorageRecordId> corruptIds;
             std::map<std::string, size_t> deletedData;
 
-            StorageRecord record;
-            int latency;
-
-            while (selectStmt.getRow(record.id, record.tenantToken, latency, record.timestamp, record.retryCount, record.reservedUntil, record.blob))
+            // Hands a record over to the consumer, remembering it for reservation if accepted
+            auto consume = [&](StorageRecord&& record, int latency)
             {
                 if (latency < EventLatency_Off || latency > EventLatency_Max) {
                     record.latency = EventLatency_Normal;
@@ -291,21 +396,144 @@ namespace MAT_NS_BEGIN {
                     record.latency = static_cast<EventLatency>(latency);
                 }
                 consumedIds.push_back(record.id);
+                consumedRecords.push_back(ReservedRecord { latency, record.blob.size(), 0 });
                 if (!consumer(std::move(record)))
                 {
                     consumedIds.pop_back();
-                    break;
+                    consumedRecords.pop_back();
+                    return false;
+                }
+                return true;
+            };
+
+            if (!m_fairness.IsFairQueueingEnabled())
+            {
+                SqliteStatement selectStmt(*m_db, m_stmtSelectEvents);
+                if (!selectStmt.select(static_cast<int>(minLatency), maxCount > 0 ? maxCount : -1)) {
+                    LOG_ERROR("Failed to retrieve events to send: Database error occurred, recreating database");
+                    recreate(204);
+                    return false;
+                }
+
+                StorageRecord record;
+                int latency;
+                int64_t checksum;
+
+                while (selectStmt.getRow(record.id, record.tenantToken, latency, record.timestamp, record.retryCount, record.reservedUntil, record.blob, checksum))
+                {
+                    if (!verifyChecksum(record, checksum)) {
+                        corruptIds.push_back(record.id);
+                        deletedData[record.tenantToken]++;
+                        continue;
+                    }
+                    if (!consume(std::move(record), latency))
+                    {
+                        break;
+                    }
+                }
+
+                selectStmt.reset();
+
+                if (selectStmt.error()) {
+                    LOG_ERROR("Failed to search for events to send: Database error has occurred, recreating database");
+                    recreate(205);
+                    return false;
                 }
             }
+            else
+            {
+                std::vector<std::string> tenantTokens;
+                SqliteStatement tenantsStmt(*m_db, m_stmtSelectEventTenants);
+                if (!tenantsStmt.select(static_cast<int>(minLatency))) {
+                    LOG_ERROR("Failed to retrieve events to send: Database error occurred, recreating database");
+                    recreate(204);
+                    return false;
+                }
+                std::string tenantToken;
+                while (tenantsStmt.getRow(tenantToken))
+                {
+                    tenantTokens.push_back(tenantToken);
+                }
+                tenantsStmt.reset();
 
-            selectStmt.reset();
+                // Tenants are read a chunk at a time, so that a single statement is active at any time.
+                // Each chunk resumes after the sort key of the last row read, so reading a tenant stays linear.
+                bool failed = tenantsStmt.error();
+                std::vector<TenantFairness::RecordSource> sources;
+                for (auto const& token : tenantTokens)
+                {
+                    std::deque<StorageRecord> chunk;
+                    int lastLatency = (std::numeric_limits<int>::max)();
+                    int lastPersistence = 0;
+                    int64_t lastTimestamp = 0;
+                    std::string lastId;
+                    bool exhausted = false;
+                    sources.push_back([this, token, minLatency, chunk, lastLatency, lastPersistence, lastTimestamp, lastId, exhausted, &failed, &corruptIds, &deletedData](StorageRecord& record) mutable
+                    {
+                        while (chunk.empty())
+                        {
+                            if (exhausted || failed)
+                            {
+                                return false;
+                            }
+                            SqliteStatement selectStmt(*m_db, m_stmtSelectTenantEvents);
+                            if (!selectStmt.select(static_cast<int>(minLatency), token, lastLatency, lastPersistence, lastTimestamp, lastId, static_cast<int>(kFairReadChunkSize)))
+                            {
+                                failed = true;
+                                return false;
+                            }
+                            StorageRecord row;
+                            int latency;
+                            int persistence;
+                            int64_t checksum;
+                            unsigned rows = 0;
+                            while (selectStmt.getRow(row.id, row.tenantToken, latency, persistence, row.timestamp, row.retryCount, row.reservedUntil, row.blob, checksum))
+                            {
+                                rows++;
+                                lastLatency = latency;
+                                lastPersistence = persistence;
+                                lastTimestamp = row.timestamp;
+                                lastId = row.id;
+                                if (!verifyChecksum(row, checksum)) {
+                                    corruptIds.push_back(row.id);
+                                    deletedData[row.tenantToken]++;
+                                    continue;
+                                }
+                                // The raw latency orders the rounds and is restored by the consumer
+                                row.latency = static_cast<EventLatency>(latency);
+                                chunk.push_back(std::move(row));
+                            }
+                            selectStmt.reset();
+                            failed = selectStmt.error();
+                            exhausted = (rows < kFairReadChunkSize);
+                        }
+                        record = std::move(chunk.front());
+                        chunk.pop_front();
+                        return true;
+                    });
+                }
 
-            if (selectStmt.error()) {
-                LOG_ERROR("Failed to search for events to send: Database error has occurred, recreating database");
-                recreate(205);
-                return false;
+                if (!failed)
+                {
+                    TenantFairness::Schedule(sources, m_fairness.GetQuantum(), [&](StorageRecord&& record)
+                    {
+                        if ((maxCount > 0) && (consumedIds.size() >= maxCount))
+                        {
+                            return false;
+                        }
+                        return consume(std::move(record), static_cast<int>(record.latency));
+                    });
+                }
+
+                if (failed) {
+                    LOG_ERROR("Failed to search for events to send: Database error has occurred, recreating database");
+                    recreate(205);
+                    return false;
+                }
             }
 
+            deleteCorruptRecords(corruptIds, deletedData);
+
             if (consumedIds.empty()) {
                 return false;
             }
@@ -313,17 +541,23 @@ namespace MAT_NS_BEGIN {
             LOG_TRACE("Reserving %u event(s) {%s%s} for %u milliseconds",
                 static_cast<unsigned>(consumedIds.size()), consumedIds.front().c_str(), (consumedIds.size() > 1) ? ", ..." : "", leaseTimeMs);
 
+            int64_t reservedUntil = PAL::getUtcSystemTimeMs() + leaseTimeMs;
             for (size_t i = 0; i < consumedIds.size(); i += kBlockSize)
             {
                 auto count = std::min(kBlockSize, consumedIds.size() - i);
                 std::vector<uint8_t> idList = packageIdList(consumedIds.begin() + i, consumedIds.begin() + i + count);
-                if (!SqliteStatement(*m_db, m_stmtReserveEvents).execute(idList, PAL::getUtcSystemTimeMs() + leaseTimeMs))
+                if (!SqliteStatement(*m_db, m_stmtReserveEvents).execute(idList, reservedUntil))
                 {
                     LOG_ERROR("Failed to reserve events to send: Database error occurred, recreating database");
                     recreate(207);
                     return false;
                 }
             }
+            for (size_t i = 0; i < consumedIds.size(); i++)
+            {
+                consumedRecords[i].reservedUntil = reservedUntil;
+                m_reservedRecords[consumedIds[i]] = consumedRecords[i];
+            }
             m_lastReadCount = static_cast<unsigned>(consumedIds.size());
         }
         return true;
@@ -343,20 +577,30 @@ namespace MAT_NS_BEGIN {
     {
         std::vector<StorageRecord> records;
         StorageRecord record;
+        std::vector<StorageRecordId> corruptIds;
+        std::map<std::string, size_t> deletedData;
 
         if (!isOpen()) {
             return records;
         }
 
+        LOCKGUARD(m_lock);
+
         if (shutdown)
         {
             SqliteStatement selectStmt(*m_db, m_stmtSelectEventAtShutdown);
             if (selectStmt.select(static_cast<int>(minLatency), maxCount > 0 ? maxCount : -1))
             {
                 int latency;
-                while (selectStmt.getRow(record.id, record.tenantToken, latency, record.timestamp, record.retryCount, record.reservedUntil, record.blob))
+                int64_t checksum;
+                while (selectStmt.getRow(record.id, record.tenantToken, latency, record.timestamp, record.retryCount, record.reservedUntil, record.blob, checksum))
                 {
                     record.latency = static_cast<EventLatency>(latency);
+                    if (!verifyChecksum(record, checksum)) {
+                        corruptIds.push_back(record.id);
+                        deletedData[record.tenantToken]++;
+                        continue;
+                    }
                     records.push_back(record);
                 }
                 selectStmt.reset();
@@ -368,22 +612,63 @@ namespace MAT_NS_BEGIN {
             if (selectStmt.select(static_cast<int>(minLatency), maxCount > 0 ? maxCount : -1))
             {
                 int latency;
-                while (selectStmt.getRow(record.id, record.tenantToken, latency, record.timestamp, record.retryCount, record.reservedUntil, record.blob))
+                int64_t checksum;
+                while (selectStmt.getRow(record.id, record.tenantToken, latency, record.timestamp, record.retryCount, record.reservedUntil, record.blob, checksum))
                 {
                     record.latency = static_cast<EventLatency>(latency);
+                    if (!verifyChecksum(record, checksum)) {
+                        corruptIds.push_back(record.id);
+                        deletedData[record.tenantToken]++;
+                        continue;
+                    }
                     records.push_back(record);
                 }
                 selectStmt.reset();
             }
         }
+        deleteCorruptRecords(corruptIds, deletedData);
         return records;
     }
 
+    bool OfflineStorage_SQLite::verifyChecksum(StorageRecord const& record, int64_t checksum) const
+    {
+        if (checksum == NO_CHECKSUM || static_cast<int64_t>(Crc32::Crc32c(record.blob.data(), record.blob.size())) == checksum)
+        {
+            return true;
+        }
+        LOG_ERROR("Event %s:%s failed checksum verification", tenantTokenToId(record.tenantToken).c_str(), record.id.c_str());
+        return false;
+    }
+
+    void OfflineStorage_SQLite::deleteCorruptRecords(std::vector<StorageRecordId> const& ids, std::map<std::string, size_t> const& deletedData)
+    {
+        if (ids.empty()) {
+            return;
+        }
+
+        // Only the damaged records go; the rest of the database is still good
+        for (size_t i = 0; i < ids.size(); i += kBlockSize)
+        {
+            auto count = std::min(kBlockSize, ids.size() - i);
+            std::vector<uint8_t> idList = packageIdList(ids.begin() + i, ids.begin() + i + count);
+            if (!SqliteStatement(*m_db, m_stmtDeleteEvents_ids).execute(idList))
+            {
+                LOG_ERROR("Failed to delete %u corrupt event(s)", static_cast<unsigned>(ids.size()));
+                return;
+            }
+        }
+        LOG_ERROR("Dropped %u event(s) with corrupt payload", static_cast<unsigned>(ids.size()));
+        reconcileCounts();
+        m_observer->OnStorageRecordsDropped(deletedData);
+    }
+
     void OfflineStorage_SQLite::DeleteAllRecords()
     {
         std::string sql = "DELETE FROM "  TABLE_NAME_EVENTS ;
+        LOCKGUARD(m_lock);
         Execute(sql);
-
+        m_reservedRecords.clear();
+        resetCounts();
     }
 
     void OfflineStorage_SQLite::DeleteRecords(const std::map<std::string, std::string> & whereFilter)
@@ -437,6 +722,7 @@ namespace MAT_NS_BEGIN {
             };
             std::string sql = "DELETE FROM " TABLE_NAME_EVENTS " WHERE ";
             Execute(sql + formatter(whereFilter));
+            reconcileCounts();
         }
     }
 
@@ -468,11 +754,13 @@ namespace MAT_NS_BEGIN {
 #endif
             LOG_TRACE("Deleting %u sent event(s) {%s%s}...", static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "");
 
+            size_t deleted = 0;
             for (size_t i = 0; i < ids.size(); i += kBlockSize) {
                 size_t count = std::min(kBlockSize, ids.size() - i);
                 std::vector<uint8_t> idList = packageIdList(ids.begin() + i,
                                                             ids.begin() + i + count);
-                if (!SqliteStatement(*m_db, m_stmtDeleteEvents_ids).execute(idList)) {
+                SqliteStatement deleteStmt(*m_db, m_stmtDeleteEvents_ids);
+                if (!deleteStmt.execute(idList)) {
                     LOG_ERROR(
                             "Failed to delete %u sent event(s) {%s%s}: Database error occurred, recreating database",
                             static_cast<unsigned>(ids.size()), ids.front().c_str(),
@@ -480,6 +768,25 @@ namespace MAT_NS_BEGIN {
                     recreate(302);
                     return;
                 }
+                deleted += deleteStmt.changes();
+            }
+
+            // Records handed out by GetAndReserveRecords() are known; anything else means
+            // the counters can no longer be derived from what was deleted
+            size_t known = 0;
+            for (auto const& id : ids)
+            {
+                auto it = m_reservedRecords.find(id);
+                if (it != m_reservedRecords.end())
+                {
+                    uncountRecord(it->second.latency, it->second.bytes);
+                    m_reservedRecords.erase(it);
+                    known++;
+                }
+            }
+            if (known != deleted)
+            {
+                reconcileCounts();
             }
         }
     }
@@ -527,6 +834,10 @@ namespace MAT_NS_BEGIN {
             }
             LOG_TRACE("Successfully released %u requested event(s), %u were not found anymore",
                 releaseStmt.changes(), static_cast<unsigned>(ids.size()) - releaseStmt.changes());
+            for (auto const& id : ids)
+            {
+                m_reservedRecords.erase(id);
+            }
 
             if (incrementRetryCount)
             {
@@ -560,6 +871,7 @@ namespace MAT_NS_BEGIN {
                 {
                     LOG_ERROR("Deleted %u events over maximum retry count %u",
                         droppedCount, maxRetryCount);
+                    reconcileCounts();
                     m_observer->OnStorageRecordsDropped(deletedData);
                 }
             }
@@ -681,11 +993,46 @@ namespace MAT_NS_BEGIN {
         return false;
     }
 
+    bool OfflineStorage_SQLite::createEventsTable(int openedDbVersion)
+    {
+        if (!SqliteStatement(*m_db,
+            "CREATE TABLE IF NOT EXISTS " TABLE_NAME_EVENTS " ("
+            "record_id"      " TEXT,"
+            "tenant_token"   " TEXT NOT NULL,"
+            "latency"        " INTEGER,"
+            "persistence"    " INTEGER,"
+            "timestamp"      " INTEGER,"
+            "retry_count"    " INTEGER DEFAULT 0,"
+            "reserved_until" " INTEGER DEFAULT 0,"
+            "payload"        " BLOB,"
+            "checksum"       " INTEGER DEFAULT -1"
+            ")"
+        ).execute()) {
+            return false;
+        }
+
+        if (openedDbVersion == 1) {
+            // Existing records read back as having no checksum
+            if (!SqliteStatement(*m_db,
+                "ALTER TABLE " TABLE_NAME_EVENTS " ADD COLUMN checksum INTEGER DEFAULT -1"
+            ).execute()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     bool OfflineStorage_SQLite::initializeDatabase()
     {
-        SqliteStatement(*m_db, "PRAGMA auto_vacuum=FULL").select();
+        // Free pages are handed back by ResizeDb() in bounded steps instead of on every DELETE.
+        // Switching an existing FULL database to INCREMENTAL does not need a VACUUM.
+        SqliteStatement(*m_db, "PRAGMA auto_vacuum=INCREMENTAL").select();
         SqliteStatement(*m_db, "PRAGMA journal_mode=WAL").select();
         SqliteStatement(*m_db, "PRAGMA synchronous=NORMAL").select();
+        if (m_isMultiProcess)
+        {
+            SqliteStatement(*m_db, ("PRAGMA busy_timeout=" + toString(kMultiProcessBusyTimeoutMs)).c_str()).select();
+        }
         {
             std::ostringstream tempPragma;
             tempPragma << "PRAGMA temp_store_directory = '" << GetTempDirectory() << "'";
@@ -712,25 +1059,20 @@ namespace MAT_NS_BEGIN {
                     openedDbVersion, CURRENT_SCHEMA_VERSION);
                 return false;
             }
-            if (!SqliteStatement(*m_db,
-                ("PRAGMA user_version=" + toString(CURRENT_SCHEMA_VERSION)).c_str()
-            ).execute()) {
+
+            // The tables and the version they are at change in one transaction, so that
+            // an interrupted upgrade leaves the previous version to upgrade from again
+            if (!SqliteStatement(*m_db, "BEGIN IMMEDIATE").execute()) {
+                return false;
+            }
+            if (!createEventsTable(openedDbVersion) ||
+                !SqliteStatement(*m_db, ("PRAGMA user_version=" + toString(CURRENT_SCHEMA_VERSION)).c_str()).execute() ||
+                !SqliteStatement(*m_db, "COMMIT").execute()) {
+                SqliteStatement(*m_db, "ROLLBACK").execute();
                 return false;
             }
         }
-
-        if (!SqliteStatement(*m_db,
-            "CREATE TABLE IF NOT EXISTS " TABLE_NAME_EVENTS " ("
-            "record_id"      " TEXT,"
-            "tenant_token"   " TEXT NOT NULL,"
-            "latency"        " INTEGER,"
-            "persistence"    " INTEGER,"
-            "timestamp"      " INTEGER,"
-            "retry_count"    " INTEGER DEFAULT 0,"
-            "reserved_until" " INTEGER DEFAULT 0,"
-            "payload"        " BLOB"
-            ")"
-        ).execute()) {
+        else if (!createEventsTable(openedDbVersion)) {
             return false;
         }
 
@@ -771,22 +1113,26 @@ namespace MAT_NS_BEGIN {
 
         PREPARE_SQL(m_stmtGetPageCount,
             "PRAGMA page_count");
+        PREPARE_SQL(m_stmtGetFreelistCount,
+            "PRAGMA freelist_count");
+        PREPARE_SQL(m_stmtIncrementalVacuum,
+            "PRAGMA incremental_vacuum(" VACUUM_PAGES_PER_STEP ")");
 
-        PREPARE_SQL(m_stmtGetRecordCount,
-            "SELECT count(*) FROM " TABLE_NAME_EVENTS);
-        PREPARE_SQL(m_stmtGetRecordCountBylatency,
-            "SELECT count(*) FROM " TABLE_NAME_EVENTS " WHERE latency=?");
+        PREPARE_SQL(m_stmtGetRecordTotals,
+            "SELECT latency, count(*), sum(length(payload)) FROM " TABLE_NAME_EVENTS " GROUP BY latency");
 
         PREPARE_SQL(m_stmtPerTenantTrimCount,
             "SELECT tenant_token FROM " TABLE_NAME_EVENTS " ORDER BY persistence ASC, timestamp ASC LIMIT MAX(1,"
             "(SELECT COUNT(record_id) FROM " TABLE_NAME_EVENTS ")"
             "* ? / 100)");
-        PREPARE_SQL(m_stmtTrimEvents_percent,
-                    "DELETE FROM " TABLE_NAME_EVENTS " WHERE record_id IN ("
-                                                     "SELECT record_id FROM " TABLE_NAME_EVENTS " ORDER BY persistence ASC, timestamp ASC LIMIT MAX(1,"
-                                                                                                "(SELECT COUNT(record_id) FROM " TABLE_NAME_EVENTS ")"
-                                                                                                                                                   "* ? / 100)"
-                                                                                                                                                   ")");
+        PREPARE_SQL(m_stmtTrimEvents_count,
+            "DELETE FROM " TABLE_NAME_EVENTS " WHERE record_id IN ("
+            "SELECT record_id FROM " TABLE_NAME_EVENTS " ORDER BY persistence ASC, timestamp ASC LIMIT ?)");
+        PREPARE_SQL(m_stmtGetTenantTotals,
+            "SELECT tenant_token, count(*), sum(length(payload)) FROM " TABLE_NAME_EVENTS " GROUP BY tenant_token");
+        PREPARE_SQL(m_stmtTrimTenantEvents_tenant_count,
+            "DELETE FROM " TABLE_NAME_EVENTS " WHERE record_id IN ("
+            "SELECT record_id FROM " TABLE_NAME_EVENTS " WHERE tenant_token=? ORDER BY persistence ASC, timestamp ASC LIMIT ?)");
 
         PREPARE_SQL(m_stmtDeleteEvents_tenants,
                 SQL_SUPPLY_PACKAGED_IDS
@@ -799,20 +1145,29 @@ namespace MAT_NS_BEGIN {
             " SET reserved_until=0, retry_count=retry_count+1"
             " WHERE reserved_until<>0 AND reserved_until<=?");
         PREPARE_SQL(m_stmtSelectEvents,
-            "SELECT record_id,tenant_token,latency,timestamp,retry_count,reserved_until,payload"
+            "SELECT record_id,tenant_token,latency,timestamp,retry_count,reserved_until,payload,checksum"
             " FROM " TABLE_NAME_EVENTS
             " WHERE latency>=? AND reserved_until=0"
             " ORDER BY latency DESC,persistence DESC, timestamp ASC LIMIT ?");
         PREPARE_SQL(m_stmtSelectEventAtShutdown,
-            "SELECT record_id,tenant_token,latency,timestamp,retry_count,reserved_until,payload"
+            "SELECT record_id,tenant_token,latency,timestamp,retry_count,reserved_until,payload,checksum"
             " FROM " TABLE_NAME_EVENTS
             " WHERE latency>=?"
             " ORDER BY latency DESC,persistence DESC, timestamp ASC LIMIT ?");
         PREPARE_SQL(m_stmtSelectEventsMinlatency,
-            "SELECT record_id,tenant_token,latency,timestamp,retry_count,reserved_until,payload"
+            "SELECT record_id,tenant_token,latency,timestamp,retry_count,reserved_until,payload,checksum"
             " FROM " TABLE_NAME_EVENTS
             " WHERE latency=(SELECT MIN(latency) FROM " TABLE_NAME_EVENTS " WHERE reserved_until=0 AND latency>=?) AND reserved_until=0"
             " ORDER BY timestamp ASC LIMIT ?");
+        PREPARE_SQL(m_stmtSelectEventTenants,
+            "SELECT DISTINCT tenant_token FROM " TABLE_NAME_EVENTS
+            " WHERE latency>=? AND reserved_until=0");
+        PREPARE_SQL(m_stmtSelectTenantEvents,
+            "SELECT record_id,tenant_token,latency,persistence,timestamp,retry_count,reserved_until,payload,checksum"
+            " FROM " TABLE_NAME_EVENTS
+            " WHERE latency>=?1 AND reserved_until=0 AND tenant_token=?2"
+            " AND (latency<?3 OR (latency=?3 AND (persistence<?4 OR (persistence=?4 AND (timestamp>?5 OR (timestamp=?5 AND record_id>?6))))))"
+            " ORDER BY latency DESC,persistence DESC, timestamp ASC, record_id ASC LIMIT ?7");
 
         PREPARE_SQL(m_stmtReserveEvents,
             SQL_SUPPLY_PACKAGED_IDS
@@ -830,8 +1185,9 @@ namespace MAT_NS_BEGIN {
         PREPARE_SQL(m_stmtDeleteEventsRetried_maxRetryCount,
             "DELETE FROM " TABLE_NAME_EVENTS
             " WHERE retry_count>?");
+        // record_id is not a key, so every store adds a row and countRecord() can count it
         PREPARE_SQL(m_stmtInsertEvent_id_tenant_prio_ts_data,
-            "REPLACE INTO " TABLE_NAME_EVENTS " (record_id,tenant_token,latency,persistence,timestamp,payload) VALUES (?,?,?,?,?,?)");
+            "INSERT INTO " TABLE_NAME_EVENTS " (record_id,tenant_token,latency,persistence,timestamp,payload,checksum) VALUES (?,?,?,?,?,?,?)");
         PREPARE_SQL(m_stmtInsertSetting_name_value,
             "REPLACE INTO " TABLE_NAME_SETTINGS " (name,value) VALUES (?,?)");
         PREPARE_SQL(m_stmtDeleteSetting_name,
@@ -845,6 +1201,7 @@ namespace MAT_NS_BEGIN {
 #undef PREPARE_SQL
 #pragma warning(pop)
 
+        reconcileCounts();
         ResizeDb();
         return true;
 }
@@ -857,7 +1214,14 @@ namespace MAT_NS_BEGIN {
         }
 
         LOCKGUARD(m_lock);
+        return getUsedSize();
+    }
+
+    size_t OfflineStorage_SQLite::getUsedSize()
+    {
+        // Pages on the free list still take space in the file until vacuumed, but hold no data
         unsigned pageCount = 0;
+        unsigned freelistCount = 0;
         SqliteStatement pageCountStmt(*m_db, m_stmtGetPageCount);
         if (!pageCountStmt.select())
         {
@@ -866,27 +1230,75 @@ namespace MAT_NS_BEGIN {
         }
         pageCountStmt.getRow(pageCount);
         pageCountStmt.reset();
-        return size_t(pageCount) * size_t(m_pageSize);
+
+        SqliteStatement freelistCountStmt(*m_db, m_stmtGetFreelistCount);
+        if (freelistCountStmt.select())
+        {
+            freelistCountStmt.getRow(freelistCount);
+            freelistCountStmt.reset();
+        }
+        return size_t(pageCount - std::min(freelistCount, pageCount)) * size_t(m_pageSize);
     }
 
-    size_t OfflineStorage_SQLite::GetRecordCountUnsafe(EventLatency latency) const
+    void OfflineStorage_SQLite::countRecord(int latency, size_t bytes)
     {
-        int count = 0;
-        if (latency == EventLatency_Unspecified)
+        if (latency >= EventLatency_Off && latency <= EventLatency_Max)
         {
-            SqliteStatement recordCount(*m_db, m_stmtGetRecordCount);
-            recordCount.select();
-            recordCount.getOneValue(count);
-            recordCount.reset();
+            m_recordCounts[latency]++;
+            m_recordBytes[latency] += bytes;
         }
-        else
+        m_totalRecordCount++;
+        m_totalRecordBytes += bytes;
+    }
+
+    void OfflineStorage_SQLite::uncountRecord(int latency, size_t bytes)
+    {
+        if (latency >= EventLatency_Off && latency <= EventLatency_Max)
         {
-            SqliteStatement recordCount(*m_db, m_stmtGetRecordCountBylatency);
-            recordCount.select(latency);
-            recordCount.getOneValue(count);
-            recordCount.reset();
+            m_recordCounts[latency]--;
+            m_recordBytes[latency] -= bytes;
+        }
+        m_totalRecordCount--;
+        m_totalRecordBytes -= bytes;
+    }
+
+    void OfflineStorage_SQLite::resetCounts()
+    {
+        for (size_t i = 0; i < LatencyCount; i++)
+        {
+            m_recordCounts[i] = 0;
+            m_recordBytes[i] = 0;
+        }
+        m_totalRecordCount = 0;
+        m_totalRecordBytes = 0;
+    }
+
+    /// <summary>
+    /// Recounts the stored records from the database, after changes that could not be tracked one by one.
+    /// </summary>
+    void OfflineStorage_SQLite::reconcileCounts()
+    {
+        resetCounts();
+        SqliteStatement totalsStmt(*m_db, m_stmtGetRecordTotals);
+        if (!totalsStmt.select())
+        {
+            LOG_ERROR("Failed to count stored events: Database error occurred");
+            return;
+        }
+        int latency;
+        int64_t count;
+        int64_t bytes;
+        while (totalsStmt.getRow(latency, count, bytes))
+        {
+            if (latency >= EventLatency_Off && latency <= EventLatency_Max)
+            {
+                m_recordCounts[latency] = static_cast<size_t>(count);
+                m_recordBytes[latency] = static_cast<size_t>(bytes);
+            }
+            m_totalRecordCount += static_cast<size_t>(count);
+            m_totalRecordBytes += static_cast<size_t>(bytes);
         }
-        return count;
+        totalsStmt.reset();
     }
 
     size_t OfflineStorage_SQLite::GetRecordCount(EventLatency latency = EventLatency_Unspecified) const
@@ -896,8 +1308,35 @@ namespace MAT_NS_BEGIN {
             return 0;
         }
 
-        LOCKGUARD(m_lock);
-        return OfflineStorage_SQLite::GetRecordCountUnsafe(latency);
+        // Records stored by a process sharing the database are the uploader's to send
+        if (m_isMultiProcess && !m_uploaderLock.IsLocked())
+        {
+            return 0;
+        }
+
+        // Kept up to date by every change, so this neither queries nor waits for the database lock
+        if (latency == EventLatency_Unspecified)
+        {
+            return m_totalRecordCount;
+        }
+        if (latency < EventLatency_Off || latency > EventLatency_Max)
+        {
+            return 0;
+        }
+        return m_recordCounts[latency];
+    }
+
+    size_t OfflineStorage_SQLite::GetRecordBytes(EventLatency latency) const
+    {
+        if (latency == EventLatency_Unspecified)
+        {
+            return m_totalRecordBytes;
+        }
+        if (latency < EventLatency_Off || latency > EventLatency_Max)
+        {
+            return 0;
+        }
+        return m_recordBytes[latency];
     }
 
     bool OfflineStorage_SQLite::ResizeDb()
@@ -907,13 +1346,17 @@ namespace MAT_NS_BEGIN {
             return false;
         }
 
-        size_t eventsDropped = 0;
-        m_DbSizeEstimate = GetSize();
-        if (m_DbSizeEstimate <= m_DbSizeLimit)
-            return false;
-
         LOCKGUARD(m_lock);
+        if (!isUploader())
+        {
+            // The uploader trims the shared database against the size budget for all processes
+            return false;
+        }
+        uint64_t deadline = PAL::getMonotonicTimeMs() + kMaintenanceBudgetMs;
+        bool trimmed = false;
+        if (m_fairness.HasQuotas())
         {
+            // Tenants over their quota lose their own records before everyone's are trimmed
 #ifdef ENABLE_LOCKING
             DbTransaction transaction(m_db.get());
             if (!transaction.locked)
@@ -922,36 +1365,186 @@ namespace MAT_NS_BEGIN {
                 return false;
             }
 #endif
-            auto count = GetRecordCountUnsafe(EventLatency::EventLatency_Unspecified);
-            if (m_DbSizeEstimate > 2 * m_DbSizeLimit)
+            trimmed = trimTenants(deadline);
+        }
+        m_DbSizeEstimate = getUsedSize();
+        if ((m_DbSizeLimit != 0) && (m_DbSizeEstimate > m_DbSizeLimit))
+        {
+#ifdef ENABLE_LOCKING
+            DbTransaction transaction(m_db.get());
+            if (!transaction.locked)
             {
-                LOG_TRACE("DB is too big, deleting...");
-                Execute("DELETE FROM " TABLE_NAME_EVENTS);
-                Execute("VACUUM");
-                return true;
+                LOG_WARN("Failed to trim database");
+                return false;
             }
+#endif
+            trimmed = trimRecords(deadline) || trimmed;
+        }
+        vacuumStep(deadline);
+        return trimmed;
+    }
 
-            SqliteStatement trimStmt(*m_db, m_stmtTrimEvents_percent);
-            if (!trimStmt.execute(25))
+    bool OfflineStorage_SQLite::trimRecords(uint64_t deadline)
+    {
+        // Go a quarter below the limit, so that the next few stores do not trim again
+        size_t target = m_DbSizeLimit - m_DbSizeLimit / 4;
+        size_t count = m_totalRecordCount;
+        if (count == 0)
+        {
+            return false;
+        }
+        // Size each chunk from the average record size, so small databases are not emptied in one go
+        size_t recordSize = std::max(size_t(1), m_DbSizeEstimate / count);
+        size_t eventsDropped = 0;
+        bool failed = false;
+        while (m_DbSizeEstimate > target)
+        {
+            auto chunk = static_cast<unsigned>(std::min(size_t(kTrimChunkSize), (m_DbSizeEstimate - target) / recordSize + 1));
+            SqliteStatement trimStmt(*m_db, m_stmtTrimEvents_count);
+            if (!trimStmt.execute(chunk))
             {
-                // If something went wrong with trimming 25%, try more radical measure
-                LOG_TRACE("Evict all non-critical");
-                Execute("DELETE FROM " TABLE_NAME_EVENTS " WHERE persistence=1");
+                failed = true;
+                break;
+            }
+            if (trimStmt.changes() == 0)
+            {
+                break;
+            }
+            eventsDropped += trimStmt.changes();
+            m_DbSizeEstimate = getUsedSize();
+            if (PAL::getMonotonicTimeMs() >= deadline)
+            {
+                LOG_TRACE("Trimming budget exhausted, continuing on the next resize");
+                break;
             }
-            eventsDropped = count - GetRecordCountUnsafe(EventLatency::EventLatency_Unspecified);
-            LOG_TRACE("Db resized, events dropeed: %d", eventsDropped);
-            trimStmt.reset();
         }
 
-        m_DbSizeEstimate = GetSize();
+        if (failed && (m_DbSizeEstimate > m_DbSizeLimit))
+        {
+            // If something went wrong with trimming in order, try more radical measure
+            LOG_TRACE("Evict all non-critical");
+            Execute("DELETE FROM " TABLE_NAME_EVENTS " WHERE persistence=1");
+            reconcileCounts();
+            eventsDropped = count - m_totalRecordCount;
+            m_DbSizeEstimate = getUsedSize();
+        }
+        else if (eventsDropped != 0)
+        {
+            // Trimming picks records by age, not by what is tracked; recount what is left
+            reconcileCounts();
+        }
+        LOG_TRACE("Db resized, events dropped: %u", static_cast<unsigned>(eventsDropped));
+
+        if (eventsDropped == 0)
+        {
+            return false;
+        }
         DebugEvent evt(DebugEventType::EVT_DROPPED);
         evt.param1 = eventsDropped;
         evt.size = eventsDropped;
         m_logManager.DispatchEvent(evt);
+        return true;
+    }
+
+    bool OfflineStorage_SQLite::trimTenants(uint64_t deadline)
+    {
+        struct TenantUsage
+        {
+            std::string tenantToken;
+            size_t      count;
+            size_t      bytes;
+            size_t      quota;
+        };
 
+        std::vector<TenantUsage> overQuota;
+        {
+            SqliteStatement totalsStmt(*m_db, m_stmtGetTenantTotals);
+            if (!totalsStmt.select())
+            {
+                LOG_ERROR("Failed to count stored events per tenant: Database error occurred");
+                return false;
+            }
+            std::string tenantToken;
+            int64_t count;
+            int64_t bytes;
+            while (totalsStmt.getRow(tenantToken, count, bytes))
+            {
+                size_t quota = m_fairness.GetQuota(tenantToken);
+                if ((quota != 0) && (count > 0) && (static_cast<size_t>(bytes) > quota))
+                {
+                    overQuota.push_back(TenantUsage { tenantToken, static_cast<size_t>(count), static_cast<size_t>(bytes), quota });
+                }
+            }
+            totalsStmt.reset();
+        }
+
+        std::map<std::string, size_t> deletedData;
+        for (auto& usage : overQuota)
+        {
+            // Oldest, least persistent records first, sized from the tenant's average record
+            size_t recordSize = std::max(size_t(1), usage.bytes / usage.count);
+            while (usage.bytes > usage.quota && usage.count > 0)
+            {
+                auto chunk = static_cast<unsigned>(std::min(size_t(kTrimChunkSize), (usage.bytes - usage.quota + recordSize - 1) / recordSize));
+                SqliteStatement trimStmt(*m_db, m_stmtTrimTenantEvents_tenant_count);
+                if (!trimStmt.execute(usage.tenantToken, chunk) || (trimStmt.changes() == 0))
+                {
+                    break;
+                }
+                size_t changes = trimStmt.changes();
+                deletedData[usage.tenantToken] += changes;
+                usage.count -= std::min(usage.count, changes);
+                usage.bytes -= std::min(usage.bytes, changes * recordSize);
+                if (PAL::getMonotonicTimeMs() >= deadline)
+                {
+                    break;
+                }
+            }
+            LOG_TRACE("Tenant %s over its quota of %u bytes, events dropped: %u", tenantTokenToId(usage.tenantToken).c_str(),
+                static_cast<unsigned>(usage.quota), static_cast<unsigned>(deletedData[usage.tenantToken]));
+            if (PAL::getMonotonicTimeMs() >= deadline)
+            {
+                LOG_TRACE("Trimming budget exhausted, continuing on the next resize");
+                break;
+            }
+        }
+
+        if (deletedData.empty())
+        {
+            return false;
+        }
+        reconcileCounts();
+        m_observer->OnStorageRecordsDropped(deletedData);
         return true;
     }
 
+    void OfflineStorage_SQLite::vacuumStep(uint64_t deadline)
+    {
+        // Trimming may already have spent the budget, in which case the pages wait for the next call
+        while (PAL::getMonotonicTimeMs() < deadline)
+        {
+            SqliteStatement vacuumStmt(*m_db, m_stmtIncrementalVacuum);
+            if (!vacuumStmt.select())
+            {
+                return;
+            }
+            // Every step of the statement releases one page
+            while (vacuumStmt.getRow()) {}
+
+            unsigned freelistCount = 0;
+            SqliteStatement freelistCountStmt(*m_db, m_stmtGetFreelistCount);
+            if (!freelistCountStmt.select() || !freelistCountStmt.getRow(freelistCount))
+            {
+                return;
+            }
+            freelistCountStmt.reset();
+            if (freelistCount == 0)
+            {
+                return;
+            }
+        }
+    }
+
     std::vector<uint8_t> OfflineStorage_SQLite::packageIdList(
         std::vector<std::string>::const_iterator const & begin,
         std::vector<std::string>::const_iterator const & end) const
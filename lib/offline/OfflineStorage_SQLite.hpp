@@ -8,6 +8,8 @@
 #pragma once
 #include "pal/PAL.hpp"
 #include "IOfflineStorage.hpp"
+#include "FileLock.hpp"
+#include "TenantFairness.hpp"
 
 #include "api/IRuntimeConfig.hpp"
 
@@ -16,6 +18,7 @@
 #include <memory>
 #include <atomic>
 #include <mutex>
+#include <unordered_map>
 
 #define ENABLE_LOCKING      // Enable DB locking for flush
 
@@ -49,12 +52,33 @@ namespace MAT_NS_BEGIN {
         virtual bool DeleteSetting(std::string const& name) override;
         virtual size_t GetSize() override;
         virtual size_t GetRecordCount(EventLatency latency) const override;
+
+        /// <summary>
+        /// Total payload size of the stored records of the given latency, or of all records when unspecified.
+        /// </summary>
+        size_t GetRecordBytes(EventLatency latency = EventLatency_Unspecified) const;
         virtual std::vector<StorageRecord> GetRecords(bool shutdown, EventLatency minLatency = EventLatency_Normal, unsigned maxCount = 0) override;
         virtual bool ResizeDb() override;
 
     protected:
         bool initializeDatabase();
+        // Creates the events table, or upgrades it from the schema version it was opened at
+        bool createEventsTable(int openedDbVersion);
+        bool isUploader();
+        bool isValidRecord(StorageRecord const& record);
+        bool insertRecord(StorageRecord const& record);
+        void checkDbSize();
         bool recreate(unsigned failureCode);
+        size_t getUsedSize();
+        bool trimRecords(uint64_t deadline);
+        bool trimTenants(uint64_t deadline);
+        void vacuumStep(uint64_t deadline);
+        bool verifyChecksum(StorageRecord const& record, int64_t checksum) const;
+        void deleteCorruptRecords(std::vector<StorageRecordId> const& ids, std::map<std::string, size_t> const& deletedData);
+        void countRecord(int latency, size_t bytes);
+        void uncountRecord(int latency, size_t bytes);
+        void resetCounts();
+        void reconcileCounts();
 
         std::vector<uint8_t> packageIdList(
             std::vector<std::string>::const_iterator const & begin,
@@ -76,24 +100,57 @@ namespace MAT_NS_BEGIN {
 
         bool                        m_skipInitAndShutdown {};
         bool                        m_isOpened {};
+        bool                        m_checksumsEnabled {};
+        TenantFairness              m_fairness;
+
+        /// <summary>
+        /// With CFG_BOOL_ENABLE_MULTIPROCESS_STORAGE, the processes sharing the database elect the
+        /// uploader by locking a file next to it: only the holder reserves, uploads and trims records.
+        /// </summary>
+        bool                        m_isMultiProcess {};
+        FileLock                    m_uploaderLock;
 
         std::mutex                  m_resizeLock{};
         std::atomic<bool>           m_resizing{false};
 
+        static constexpr size_t     LatencyCount = static_cast<size_t>(EventLatency_Max) + 1;
+
+        /// <summary>
+        /// Size and latency of a record handed out for upload, so that deleting it
+        /// after a successful upload can update the counters without querying it back.
+        /// </summary>
+        struct ReservedRecord
+        {
+            int                     latency;
+            size_t                  bytes;
+            int64_t                 reservedUntil;
+        };
+
+        std::unordered_map<std::string, ReservedRecord> m_reservedRecords;
+        std::atomic<size_t>         m_recordCounts[LatencyCount] {};
+        std::atomic<size_t>         m_recordBytes[LatencyCount] {};
+        std::atomic<size_t>         m_totalRecordCount {};
+        std::atomic<size_t>         m_totalRecordBytes {};
+
         size_t                      m_stmtBeginTransaction {};
         size_t                      m_stmtCommitTransaction {};
         size_t                      m_stmtRollbackTransaction {};
         size_t                      m_stmtGetPageCount {};
-        size_t                      m_stmtGetRecordCount {};
-        size_t                      m_stmtGetRecordCountBylatency {};
+        size_t                      m_stmtGetFreelistCount {};
+        size_t                      m_stmtIncrementalVacuum {};
+        size_t                      m_stmtGetRecordTotals {};
         size_t                      m_stmtPerTenantTrimCount {};
-        size_t                      m_stmtTrimEvents_percent {};
+        size_t                      m_stmtTrimEvents_count {};
+        size_t                      m_stmtGetTenantTotals {};
+        size_t                      m_stmtTrimTenantEvents_tenant_count {};
         size_t                      m_stmtDeleteEvents_ids {};
         size_t                      m_stmtReleaseExpiredEvents {};
         size_t                      m_stmtDeleteEvents_tenants {};
         size_t                      m_stmtSelectEvents {};
         size_t                      m_stmtSelectEventAtShutdown {};
         size_t                      m_stmtSelectEventsMinlatency {};
+        size_t                      m_stmtSelectEventTenants {};
+        size_t                      m_stmtSelectTenantEvents {};
         size_t                      m_stmtReserveEvents {};
         size_t                      m_stmtReleaseEvents_ids_retryCountDelta {};
         size_t                      m_stmtDeleteEventsRetried_maxRetryCount {};
@@ -113,9 +170,6 @@ namespace MAT_NS_BEGIN {
 
     protected:
         MATSDK_LOG_DECL_COMPONENT_CLASS();
-
-    private:
-        size_t GetRecordCountUnsafe(EventLatency latency) const;
     };
 
 
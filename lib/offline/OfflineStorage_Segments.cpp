@@ -0,0 +1,1265 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#ifdef HAVE_MAT_STORAGE
+
+#include "OfflineStorage_Segments.hpp"
+#include "ILogManager.hpp"
+#include "StorageRecordBatch.hpp"
+#include "utils/Crc32.hpp"
+#include "utils/FileUtils.hpp"
+#include "utils/StringUtils.hpp"
+#include "utils/Utils.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace MAT_NS_BEGIN {
+
+    MATSDK_LOG_INST_COMPONENT_CLASS(OfflineStorage_Segments, "EventsSDK.Storage", "Events telemetry client - OfflineStorage_Segments class");
+
+    constexpr size_t OfflineStorage_Segments::LatencyCount;
+
+    // On-disk layout, all integers in native byte order:
+    //
+    //   segment := SegmentHeader record* (zero bytes)*
+    //   record  := RecordHeader body (padding to 8 bytes)
+    //   body    := RecordBodyHeader id tenantToken blob
+    //
+    // A record becomes visible when its non-zero size is written, which happens last. The CRC covers
+    // the body only, so the state and retry count bytes of the header can be updated in place.
+
+    static const char     SegmentMagic[8] = { 'M', 'A', 'T', 'S', 'E', 'G', 0, 1 };
+    static const uint32_t SegmentVersion = 1;
+    static const size_t   RecordAlignment = 8;
+    static const size_t   MinSegmentSize = 4096;
+    static const size_t   MaxStringSize = UINT16_MAX;
+
+    static const char* const SettingsFileName = "settings";
+    static const char* const SettingsTempFileName = "settings.tmp";
+
+    struct SegmentHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t latency;
+        uint64_t sequence;
+        uint64_t reserved;
+    };
+
+    enum RecordState : uint8_t
+    {
+        RecordState_Live = 1,
+        RecordState_Deleted = 2
+    };
+
+    struct RecordHeader
+    {
+        uint32_t size;
+        uint32_t crc;
+        uint32_t bodySize;
+        uint8_t  state;
+        uint8_t  retryCount;
+        uint16_t reserved;
+    };
+
+    struct RecordBodyHeader
+    {
+        int64_t  timestamp;
+        uint8_t  latency;
+        uint8_t  persistence;
+        uint16_t idSize;
+        uint16_t tokenSize;
+        uint16_t reserved;
+    };
+
+    static_assert(sizeof(SegmentHeader) == 32, "Unexpected segment header size");
+    static_assert(sizeof(RecordHeader) == 16, "Unexpected record header size");
+    static_assert(sizeof(RecordBodyHeader) == 16, "Unexpected record body header size");
+
+    static size_t alignUp(size_t size, size_t alignment)
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    static std::string formatSegmentName(EventLatency latency, uint64_t sequence)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%u-%016llx.seg", static_cast<unsigned>(latency), static_cast<unsigned long long>(sequence));
+        return name;
+    }
+
+    static bool parseSegmentName(std::string const& name, EventLatency& latency, uint64_t& sequence)
+    {
+        // <latency digit>-<16 hex digits>.seg
+        if (name.size() != 22 || name[1] != '-' || name.compare(18, 4, ".seg") != 0)
+        {
+            return false;
+        }
+        if (name[0] < '0' || name[0] > '0' + EventLatency_Max)
+        {
+            return false;
+        }
+        latency = static_cast<EventLatency>(name[0] - '0');
+        sequence = 0;
+        for (size_t i = 2; i < 18; i++)
+        {
+            char c = name[i];
+            uint64_t digit;
+            if (c >= '0' && c <= '9')
+                digit = static_cast<uint64_t>(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                digit = static_cast<uint64_t>(c - 'a' + 10);
+            else
+                return false;
+            sequence = (sequence << 4) | digit;
+        }
+        return true;
+    }
+
+    OfflineStorage_Segments::OfflineStorage_Segments(ILogManager& logManager, IRuntimeConfig& runtimeConfig)
+        : m_config(runtimeConfig)
+        , m_logManager(logManager)
+    {
+        const char* cacheFilePath = m_config[CFG_STR_CACHE_FILE_PATH];
+        m_directory = GetSegmentDirectory((cacheFilePath != nullptr) ? cacheFilePath : "");
+        m_DbSizeLimit = m_config.GetOfflineStorageMaximumSizeBytes();
+        // Records always carry a checksum; this only adds verification when they are read back
+        m_checksumsEnabled = m_config[CFG_BOOL_ENABLE_CRC32];
+
+        uint32_t percentage = m_config[CFG_INT_STORAGE_FULL_PCT];
+        if ((percentage == 0) || (percentage > 100))
+        {
+            percentage = DB_FULL_NOTIFICATION_DEFAULT_PERCENTAGE;
+        }
+        m_DbSizeNotificationLimit = (percentage * (uint32_t)m_DbSizeLimit) / 100;
+        m_DbSizeNotificationInterval = m_config[CFG_INT_STORAGE_FULL_CHECK_TIME];
+
+        // Space is reclaimed a whole segment at a time, so keep at least four of them within the limit
+        uint32_t segmentSize = m_config[CFG_INT_STORAGE_SEGMENT_SIZE];
+        m_segmentSize = segmentSize;
+        if ((m_DbSizeLimit != 0) && (m_segmentSize > m_DbSizeLimit / 4))
+        {
+            m_segmentSize = m_DbSizeLimit / 4;
+        }
+        m_segmentSize = alignUp(std::max(m_segmentSize, MinSegmentSize), MinSegmentSize);
+    }
+
+    OfflineStorage_Segments::~OfflineStorage_Segments()
+    {
+        Shutdown();
+    }
+
+    std::string OfflineStorage_Segments::GetSegmentDirectory(std::string const& cacheFilePath)
+    {
+        return cacheFilePath + ".segments";
+    }
+
+    void OfflineStorage_Segments::Initialize(IOfflineStorageObserver& observer)
+    {
+        m_observer = &observer;
+
+        LOG_TRACE("Initializing offline storage: %s", m_directory.c_str());
+        auto startTime = GetUptimeMs();
+        {
+            LOCKGUARD(m_lock);
+            if (!openSegments())
+            {
+                LOG_ERROR("Failed to open segment directory %s", m_directory.c_str());
+                m_observer->OnStorageOpenFailed("Failed to open segment directory");
+                return;
+            }
+            loadSettings();
+            m_isOpened = true;
+        }
+        m_observer->OnStorageOpened("Segments/Default");
+        startTime = GetUptimeMs() - startTime;
+        LOG_INFO("Storage opened in %lld ms, %u record(s) recovered", startTime, static_cast<unsigned>(m_index.size()));
+
+        ResizeDb();
+    }
+
+    void OfflineStorage_Segments::Shutdown()
+    {
+        LOG_TRACE("Shutting down offline storage %s", m_directory.c_str());
+        LOCKGUARD(m_lock);
+        for (auto& segments : m_segments)
+        {
+            segments.clear();
+        }
+        m_index.clear();
+        m_reserved.clear();
+        for (size_t i = 0; i < LatencyCount; i++)
+        {
+            m_recordCounts[i] = 0;
+            m_recordBytes[i] = 0;
+        }
+        m_totalRecordCount = 0;
+        m_totalRecordBytes = 0;
+        m_totalSize = 0;
+        m_isOpened = false;
+    }
+
+    void OfflineStorage_Segments::Flush()
+    {
+        LOCKGUARD(m_lock);
+        for (auto& segments : m_segments)
+        {
+            for (auto& segment : segments)
+            {
+                segment->file.Sync(false);
+            }
+        }
+    }
+
+    bool OfflineStorage_Segments::openSegments()
+    {
+        if (!DirectoryCreate(m_directory.c_str()))
+        {
+            return false;
+        }
+
+        std::vector<std::pair<uint64_t, std::string>> files;
+        for (auto const& name : DirectoryGetFiles(m_directory.c_str()))
+        {
+            EventLatency latency;
+            uint64_t sequence;
+            if (parseSegmentName(name, latency, sequence))
+            {
+                files.emplace_back(sequence, name);
+            }
+        }
+        // Replay in write order, so that a record stored again under the same id supersedes the older copy
+        std::sort(files.begin(), files.end());
+
+        m_nextSequence = 0;
+        for (auto const& file : files)
+        {
+            recoverSegment(file.second);
+            m_nextSequence = std::max(m_nextSequence, file.first + 1);
+        }
+
+        for (auto& segments : m_segments)
+        {
+            // The newest segment of each latency is reopened for appending, empty older ones go away
+            while (segments.size() > 1 && segments.front()->liveCount == 0)
+            {
+                dropSegment(segments.front().get(), nullptr);
+            }
+            for (size_t i = 1; i + 1 < segments.size();)
+            {
+                if (segments[i]->liveCount == 0)
+                {
+                    dropSegment(segments[i].get(), nullptr);
+                    continue;
+                }
+                i++;
+            }
+        }
+        return true;
+    }
+
+    bool OfflineStorage_Segments::recoverSegment(std::string const& fileName)
+    {
+        EventLatency latency;
+        uint64_t sequence;
+        if (!parseSegmentName(fileName, latency, sequence))
+        {
+            return false;
+        }
+
+        std::unique_ptr<Segment> segment(new Segment());
+        segment->path = m_directory + PATH_SEPARATOR_CHAR + fileName;
+        segment->sequence = sequence;
+        segment->latency = latency;
+        segment->liveCount = 0;
+        segment->firstLive = 0;
+
+        SegmentHeader header;
+        if (!segment->file.Open(segment->path, 0) || segment->file.Size() < sizeof(header))
+        {
+            LOG_WARN("Removing unreadable segment %s", fileName.c_str());
+            segment->file.Close();
+            FileDelete(segment->path.c_str());
+            return false;
+        }
+        memcpy(&header, segment->file.Data(), sizeof(header));
+        if (memcmp(header.magic, SegmentMagic, sizeof(SegmentMagic)) != 0 || header.version != SegmentVersion ||
+            header.latency != static_cast<uint32_t>(latency) || header.sequence != sequence)
+        {
+            LOG_WARN("Removing segment %s with invalid header", fileName.c_str());
+            segment->file.Close();
+            FileDelete(segment->path.c_str());
+            return false;
+        }
+
+        uint8_t* data = segment->file.Data();
+        size_t fileSize = segment->file.Size();
+        size_t offset = sizeof(SegmentHeader);
+        bool torn = false;
+        unsigned corrupt = 0;
+        while (offset + sizeof(RecordHeader) <= fileSize)
+        {
+            RecordHeader recordHeader;
+            memcpy(&recordHeader, data + offset, sizeof(recordHeader));
+            if (recordHeader.size == 0)
+            {
+                break;
+            }
+
+            RecordBodyHeader body;
+            torn = (recordHeader.size % RecordAlignment != 0) ||
+                   (recordHeader.size > fileSize - offset) ||
+                   (recordHeader.bodySize < sizeof(RecordBodyHeader)) ||
+                   (recordHeader.bodySize > recordHeader.size - sizeof(RecordHeader)) ||
+                   (recordHeader.state != RecordState_Live && recordHeader.state != RecordState_Deleted);
+            if (torn)
+            {
+                break;
+            }
+
+            if (recordHeader.state == RecordState_Live &&
+                Crc32::Crc32c(data + offset + sizeof(RecordHeader), recordHeader.bodySize) != recordHeader.crc)
+            {
+                // The framing is intact, so only this record is lost; the ones after it are still reachable
+                data[offset + offsetof(RecordHeader, state)] = RecordState_Deleted;
+                corrupt++;
+                offset += recordHeader.size;
+                continue;
+            }
+
+            memcpy(&body, data + offset + sizeof(RecordHeader), sizeof(body));
+            torn = (body.latency != static_cast<uint8_t>(latency)) ||
+                   (sizeof(RecordBodyHeader) + body.idSize + body.tokenSize > recordHeader.bodySize);
+            if (torn)
+            {
+                break;
+            }
+
+            if (recordHeader.state == RecordState_Live)
+            {
+                char const* strings = reinterpret_cast<char const*>(data + offset + sizeof(RecordHeader) + sizeof(RecordBodyHeader));
+                Slot slot;
+                slot.id.assign(strings, body.idSize);
+                slot.tenantToken.assign(strings + body.idSize, body.tokenSize);
+                slot.timestamp = body.timestamp;
+                slot.reservedUntil = 0;
+                slot.offset = static_cast<uint32_t>(offset);
+                slot.bytes = static_cast<uint32_t>(recordHeader.bodySize - sizeof(RecordBodyHeader) - body.idSize - body.tokenSize);
+                slot.persistence = body.persistence;
+                slot.retryCount = recordHeader.retryCount;
+                slot.deleted = false;
+
+                SlotRef previous;
+                if (findSlot(slot.id, previous))
+                {
+                    deleteSlot(previous);
+                }
+                countRecord(latency, slot.bytes);
+                segment->slots.push_back(std::move(slot));
+                segment->liveCount++;
+                m_index[segment->slots.back().id] = SlotRef(segment.get(), segment->slots.size() - 1);
+            }
+            offset += recordHeader.size;
+        }
+
+        if (corrupt != 0)
+        {
+            LOG_WARN("Segment %s: dropped %u record(s) failing checksum verification", fileName.c_str(), corrupt);
+        }
+        if (torn)
+        {
+            // Whatever follows a torn write is unreachable; clear it so that appends start from a clean tail
+            LOG_WARN("Segment %s has a torn or corrupt record at offset %u, discarding %u byte(s)",
+                fileName.c_str(), static_cast<unsigned>(offset), static_cast<unsigned>(fileSize - offset));
+            memset(data + offset, 0, fileSize - offset);
+        }
+        segment->writeOffset = offset;
+        m_totalSize += offset;
+        m_segments[latency].push_back(std::move(segment));
+        return true;
+    }
+
+    OfflineStorage_Segments::Segment* OfflineStorage_Segments::createSegment(EventLatency latency, size_t minSize)
+    {
+        std::unique_ptr<Segment> segment(new Segment());
+        segment->sequence = m_nextSequence++;
+        segment->latency = latency;
+        segment->path = m_directory + PATH_SEPARATOR_CHAR + formatSegmentName(latency, segment->sequence);
+        segment->liveCount = 0;
+        segment->firstLive = 0;
+
+        size_t size = std::max(m_segmentSize, alignUp(minSize, MinSegmentSize));
+        if (!segment->file.Open(segment->path, size))
+        {
+            LOG_ERROR("Failed to create segment %s", segment->path.c_str());
+            FileDelete(segment->path.c_str());
+            return nullptr;
+        }
+
+        SegmentHeader header {};
+        memcpy(header.magic, SegmentMagic, sizeof(SegmentMagic));
+        header.version = SegmentVersion;
+        header.latency = static_cast<uint32_t>(latency);
+        header.sequence = segment->sequence;
+        memcpy(segment->file.Data(), &header, sizeof(header));
+        segment->writeOffset = sizeof(header);
+
+        m_totalSize += segment->writeOffset;
+        m_segments[latency].push_back(std::move(segment));
+        return m_segments[latency].back().get();
+    }
+
+    void OfflineStorage_Segments::dropSegment(Segment* segment, std::map<std::string, size_t>* dropped)
+    {
+        for (auto& slot : segment->slots)
+        {
+            if (slot.deleted)
+            {
+                continue;
+            }
+            if (dropped != nullptr)
+            {
+                (*dropped)[slot.tenantToken]++;
+            }
+            m_index.erase(slot.id);
+            m_reserved.erase(slot.id);
+            uncountRecord(segment->latency, slot.bytes);
+        }
+
+        m_totalSize -= segment->writeOffset;
+        segment->file.Close();
+        if (FileDelete(segment->path.c_str()) != 0)
+        {
+            LOG_WARN("Failed to remove segment %s", segment->path.c_str());
+        }
+
+        auto& segments = m_segments[segment->latency];
+        for (auto it = segments.begin(); it != segments.end(); ++it)
+        {
+            if (it->get() == segment)
+            {
+                segments.erase(it);
+                break;
+            }
+        }
+    }
+
+    bool OfflineStorage_Segments::hasCriticalRecords(Segment const& segment)
+    {
+        for (size_t i = segment.firstLive; i < segment.slots.size(); i++)
+        {
+            if (!segment.slots[i].deleted && segment.slots[i].persistence == EventPersistence_Critical)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void OfflineStorage_Segments::dropAllSegments()
+    {
+        for (auto& segments : m_segments)
+        {
+            while (!segments.empty())
+            {
+                dropSegment(segments.front().get(), nullptr);
+            }
+        }
+    }
+
+    void OfflineStorage_Segments::sealSegment(Segment* segment)
+    {
+        // The remainder of the segment stays zeroed and marks its end
+        segment->file.Sync(false);
+        if (segment->liveCount == 0)
+        {
+            dropSegment(segment, nullptr);
+        }
+    }
+
+    bool OfflineStorage_Segments::appendRecord(StorageRecord const& record)
+    {
+        EventLatency latency = record.latency;
+        size_t bodySize = sizeof(RecordBodyHeader) + record.id.size() + record.tenantToken.size() + record.blob.size();
+        size_t recordSize = alignUp(sizeof(RecordHeader) + bodySize, RecordAlignment);
+
+        auto& segments = m_segments[latency];
+        Segment* segment = segments.empty() ? nullptr : segments.back().get();
+        if (segment == nullptr || segment->writeOffset + recordSize > segment->file.Size())
+        {
+            Segment* full = segment;
+            segment = createSegment(latency, sizeof(SegmentHeader) + recordSize);
+            if (segment == nullptr)
+            {
+                return false;
+            }
+            if (full != nullptr)
+            {
+                sealSegment(full);
+            }
+        }
+
+        // A record stored again under the same id replaces the previous copy
+        SlotRef previous;
+        if (findSlot(record.id, previous))
+        {
+            deleteSlot(previous);
+        }
+
+        uint8_t* target = segment->file.Data() + segment->writeOffset;
+        uint8_t* body = target + sizeof(RecordHeader);
+
+        RecordBodyHeader bodyHeader {};
+        bodyHeader.timestamp = record.timestamp;
+        bodyHeader.latency = static_cast<uint8_t>(latency);
+        bodyHeader.persistence = static_cast<uint8_t>(record.persistence);
+        bodyHeader.idSize = static_cast<uint16_t>(record.id.size());
+        bodyHeader.tokenSize = static_cast<uint16_t>(record.tenantToken.size());
+        memcpy(body, &bodyHeader, sizeof(bodyHeader));
+        uint8_t* cursor = body + sizeof(bodyHeader);
+        memcpy(cursor, record.id.data(), record.id.size());
+        cursor += record.id.size();
+        memcpy(cursor, record.tenantToken.data(), record.tenantToken.size());
+        cursor += record.tenantToken.size();
+        if (!record.blob.empty())
+        {
+            memcpy(cursor, record.blob.data(), record.blob.size());
+        }
+
+        RecordHeader header {};
+        header.crc = Crc32::Crc32c(body, bodySize);
+        header.bodySize = static_cast<uint32_t>(bodySize);
+        header.state = RecordState_Live;
+        header.retryCount = static_cast<uint8_t>(std::min(record.retryCount, 255));
+        memcpy(target + sizeof(header.size), reinterpret_cast<uint8_t*>(&header) + sizeof(header.size), sizeof(header) - sizeof(header.size));
+        // The size goes in last: until then a scan after a crash sees the end of the segment here
+        header.size = static_cast<uint32_t>(recordSize);
+        memcpy(target, &header.size, sizeof(header.size));
+
+        Slot slot;
+        slot.id = record.id;
+        slot.tenantToken = record.tenantToken;
+        slot.timestamp = record.timestamp;
+        slot.reservedUntil = 0;
+        slot.offset = static_cast<uint32_t>(segment->writeOffset);
+        slot.bytes = static_cast<uint32_t>(record.blob.size());
+        slot.persistence = bodyHeader.persistence;
+        slot.retryCount = header.retryCount;
+        slot.deleted = false;
+        segment->slots.push_back(std::move(slot));
+        segment->liveCount++;
+        segment->writeOffset += recordSize;
+        m_totalSize += recordSize;
+        countRecord(latency, record.blob.size());
+        m_index[record.id] = SlotRef(segment, segment->slots.size() - 1);
+        return true;
+    }
+
+    bool OfflineStorage_Segments::readRecord(Segment const& segment, Slot const& slot, StorageRecord& record) const
+    {
+        uint8_t const* target = segment.file.Data() + slot.offset;
+        RecordHeader header;
+        memcpy(&header, target, sizeof(header));
+        if (m_checksumsEnabled && Crc32::Crc32c(target + sizeof(RecordHeader), header.bodySize) != header.crc)
+        {
+            LOG_ERROR("Event %s:%s failed checksum verification", tenantTokenToId(slot.tenantToken).c_str(), slot.id.c_str());
+            return false;
+        }
+        size_t blobOffset = sizeof(RecordHeader) + sizeof(RecordBodyHeader) + slot.id.size() + slot.tenantToken.size();
+
+        record.id = slot.id;
+        record.tenantToken = slot.tenantToken;
+        record.latency = segment.latency;
+        record.persistence = static_cast<EventPersistence>(slot.persistence);
+        record.timestamp = slot.timestamp;
+        record.retryCount = slot.retryCount;
+        record.reservedUntil = slot.reservedUntil;
+        record.blob.assign(target + blobOffset, target + sizeof(RecordHeader) + header.bodySize);
+        return true;
+    }
+
+    void OfflineStorage_Segments::deleteCorruptRecords(std::vector<StorageRecordId> const& ids, std::map<std::string, size_t> const& deletedData)
+    {
+        if (ids.empty())
+        {
+            return;
+        }
+
+        for (auto const& id : ids)
+        {
+            SlotRef ref;
+            if (findSlot(id, ref))
+            {
+                deleteSlot(ref);
+            }
+        }
+        LOG_ERROR("Dropped %u event(s) with corrupt payload", static_cast<unsigned>(ids.size()));
+        m_observer->OnStorageRecordsDropped(deletedData);
+    }
+
+    void OfflineStorage_Segments::deleteSlot(SlotRef const& ref)
+    {
+        Segment* segment = ref.first;
+        Slot& slot = segment->slots[ref.second];
+        if (slot.deleted)
+        {
+            return;
+        }
+
+        segment->file.Data()[slot.offset + offsetof(RecordHeader, state)] = RecordState_Deleted;
+        slot.deleted = true;
+        m_index.erase(slot.id);
+        m_reserved.erase(slot.id);
+        // Only the slot position is needed from now on
+        std::string().swap(slot.id);
+        std::string().swap(slot.tenantToken);
+        segment->liveCount--;
+        uncountRecord(segment->latency, slot.bytes);
+        while (segment->firstLive < segment->slots.size() && segment->slots[segment->firstLive].deleted)
+        {
+            segment->firstLive++;
+        }
+
+        if (segment->liveCount == 0 && m_segments[segment->latency].back().get() != segment)
+        {
+            dropSegment(segment, nullptr);
+        }
+    }
+
+    void OfflineStorage_Segments::setRetryCount(SlotRef const& ref, uint8_t retryCount)
+    {
+        Slot& slot = ref.first->slots[ref.second];
+        slot.retryCount = retryCount;
+        ref.first->file.Data()[slot.offset + offsetof(RecordHeader, retryCount)] = retryCount;
+    }
+
+    bool OfflineStorage_Segments::findSlot(std::string const& id, SlotRef& ref) const
+    {
+        auto it = m_index.find(id);
+        if (it == m_index.end())
+        {
+            return false;
+        }
+        ref = it->second;
+        return true;
+    }
+
+    bool OfflineStorage_Segments::StoreRecord(StorageRecord const& record)
+    {
+        if (record.id.empty() || record.tenantToken.empty() || static_cast<int>(record.latency) < 0 || record.timestamp <= 0 ||
+            record.latency > EventLatency_Max || record.id.size() > MaxStringSize || record.tenantToken.size() > MaxStringSize) {
+            LOG_ERROR("Failed to store event %s:%s: Invalid parameters",
+                tenantTokenToId(record.tenantToken).c_str(), record.id.c_str());
+            m_observer->OnStorageFailed("Invalid parameters");
+            return false;
+        }
+
+        size_t totalSize;
+        {
+            LOCKGUARD(m_lock);
+            if (!m_isOpened) {
+                LOG_ERROR("Failed to store event %s:%s: Storage is not open",
+                    tenantTokenToId(record.tenantToken).c_str(), record.id.c_str());
+                m_observer->OnStorageOpenFailed("Storage is not open");
+                return false;
+            }
+
+            if (!appendRecord(record)) {
+                LOG_ERROR("Failed to store event %s:%s: Segment error",
+                    tenantTokenToId(record.tenantToken).c_str(), record.id.c_str());
+                m_observer->OnStorageFailed("Segment error");
+                return false;
+            }
+            totalSize = m_totalSize;
+        }
+
+        if ((m_DbSizeNotificationLimit != 0) && (totalSize > m_DbSizeNotificationLimit))
+        {
+            auto now = PAL::getMonotonicTimeMs();
+            if (static_cast<uint64_t>(now - m_isStorageFullNotificationSendTime) > m_DbSizeNotificationInterval)
+            {
+                // Notify the client that the storage is getting full, but only once in DB_FULL_CHECK_TIME_MS
+                m_isStorageFullNotificationSendTime = now;
+                DebugEvent evt;
+                evt.type = DebugEventType::EVT_STORAGE_FULL;
+                evt.param1 = (100 * totalSize) / m_DbSizeLimit;
+                m_logManager.DispatchEvent(evt);
+            }
+        }
+
+        if ((m_DbSizeLimit != 0) && (totalSize > m_DbSizeLimit) && m_config[CFG_BOOL_ENABLE_DB_DROP_IF_FULL])
+        {
+            ResizeDb();
+        }
+        return true;
+    }
+
+    size_t OfflineStorage_Segments::StoreRecords(std::vector<StorageRecord> & records)
+    {
+        return storeRecordsInPlace(records, [this](StorageRecord const& record) { return StoreRecord(record); });
+    }
+
+    void OfflineStorage_Segments::releaseExpiredReservations()
+    {
+        auto now = PAL::getUtcSystemTimeMs();
+        unsigned released = 0;
+        for (auto it = m_reserved.begin(); it != m_reserved.end();)
+        {
+            SlotRef ref;
+            if (!findSlot(*it, ref))
+            {
+                it = m_reserved.erase(it);
+                continue;
+            }
+            Slot& slot = ref.first->slots[ref.second];
+            if (slot.reservedUntil > now)
+            {
+                ++it;
+                continue;
+            }
+            slot.reservedUntil = 0;
+            setRetryCount(ref, static_cast<uint8_t>(std::min(slot.retryCount + 1, 255)));
+            it = m_reserved.erase(it);
+            released++;
+        }
+        if (released > 0) {
+            LOG_TRACE("Released %u expired reserved events", released);
+        }
+    }
+
+    bool OfflineStorage_Segments::GetAndReserveRecords(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency, unsigned maxCount)
+    {
+        LOCKGUARD(m_lock);
+        m_lastReadCount = 0;
+
+        if (!m_isOpened) {
+            LOG_ERROR("Failed to retrieve events to send: Storage is not open");
+            return false;
+        }
+
+        LOG_TRACE("Retrieving max. %u%s events of latency at least %d (%s)",
+            maxCount, (maxCount > 0) ? "" : " (unlimited)", minLatency, latencyToStr(static_cast<EventLatency>(minLatency)));
+
+        releaseExpiredReservations();
+
+        int64_t reservedUntil = PAL::getUtcSystemTimeMs() + leaseTimeMs;
+        std::vector<StorageRecordId> corruptIds;
+        std::map<std::string, size_t> deletedData;
+        unsigned consumed = 0;
+        bool done = false;
+        int lowest = std::max(static_cast<int>(minLatency), static_cast<int>(EventLatency_Off));
+        // Same order as the SQLite storage: latency DESC, persistence DESC, then write order
+        for (int latency = EventLatency_Max; latency >= lowest && !done; latency--)
+        {
+            for (int pass = 0; pass < 2 && !done; pass++)
+            {
+                bool critical = (pass == 0);
+                for (auto& segment : m_segments[latency])
+                {
+                    for (size_t i = segment->firstLive; i < segment->slots.size() && !done; i++)
+                    {
+                        Slot& slot = segment->slots[i];
+                        if (slot.deleted || slot.reservedUntil != 0 || ((slot.persistence >= EventPersistence_Critical) != critical))
+                        {
+                            continue;
+                        }
+                        StorageRecord record;
+                        if (!readRecord(*segment, slot, record))
+                        {
+                            corruptIds.push_back(slot.id);
+                            deletedData[slot.tenantToken]++;
+                            continue;
+                        }
+                        if (!consumer(std::move(record)))
+                        {
+                            done = true;
+                            break;
+                        }
+                        slot.reservedUntil = reservedUntil;
+                        m_reserved.insert(slot.id);
+                        consumed++;
+                        done = (maxCount > 0) && (consumed >= maxCount);
+                    }
+                    if (done)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Slots can only be deleted once the segments are no longer being walked
+        deleteCorruptRecords(corruptIds, deletedData);
+
+        if (consumed == 0) {
+            return false;
+        }
+        LOG_TRACE("Reserved %u event(s) for %u milliseconds", consumed, leaseTimeMs);
+        m_lastReadCount = consumed;
+        return true;
+    }
+
+    bool OfflineStorage_Segments::IsLastReadFromMemory()
+    {
+        return false;
+    }
+
+    unsigned OfflineStorage_Segments::LastReadRecordCount()
+    {
+        return m_lastReadCount;
+    }
+
+    std::vector<StorageRecord> OfflineStorage_Segments::GetRecords(bool shutdown, EventLatency minLatency, unsigned maxCount)
+    {
+        std::vector<StorageRecord> records;
+        std::vector<StorageRecordId> corruptIds;
+        std::map<std::string, size_t> deletedData;
+        LOCKGUARD(m_lock);
+        if (!m_isOpened) {
+            LOG_ERROR("Failed to get records: Storage is not open");
+            return records;
+        }
+
+        int lowest = std::max(static_cast<int>(minLatency), static_cast<int>(EventLatency_Off));
+        auto full = [&]() { return (maxCount > 0) && (records.size() >= maxCount); };
+
+        if (shutdown)
+        {
+            // Everything at or above the latency, reserved or not
+            for (int latency = EventLatency_Max; latency >= lowest && !full(); latency--)
+            {
+                for (int pass = 0; pass < 2 && !full(); pass++)
+                {
+                    bool critical = (pass == 0);
+                    for (auto& segment : m_segments[latency])
+                    {
+                        for (size_t i = segment->firstLive; i < segment->slots.size() && !full(); i++)
+                        {
+                            Slot const& slot = segment->slots[i];
+                            if (slot.deleted || ((slot.persistence >= EventPersistence_Critical) != critical))
+                            {
+                                continue;
+                            }
+                            records.emplace_back();
+                            if (!readRecord(*segment, slot, records.back()))
+                            {
+                                records.pop_back();
+                                corruptIds.push_back(slot.id);
+                                deletedData[slot.tenantToken]++;
+                            }
+                        }
+                    }
+                }
+            }
+            deleteCorruptRecords(corruptIds, deletedData);
+            return records;
+        }
+
+        // Unreserved records of the lowest latency that has any
+        for (int latency = lowest; latency <= EventLatency_Max && records.empty(); latency++)
+        {
+            for (auto& segment : m_segments[latency])
+            {
+                for (size_t i = segment->firstLive; i < segment->slots.size() && !full(); i++)
+                {
+                    Slot const& slot = segment->slots[i];
+                    if (slot.deleted || slot.reservedUntil != 0)
+                    {
+                        continue;
+                    }
+                    records.emplace_back();
+                    if (!readRecord(*segment, slot, records.back()))
+                    {
+                        records.pop_back();
+                        corruptIds.push_back(slot.id);
+                        deletedData[slot.tenantToken]++;
+                    }
+                }
+            }
+        }
+        deleteCorruptRecords(corruptIds, deletedData);
+        return records;
+    }
+
+    void OfflineStorage_Segments::DeleteAllRecords()
+    {
+        LOCKGUARD(m_lock);
+        dropAllSegments();
+    }
+
+    void OfflineStorage_Segments::DeleteRecords(const std::map<std::string, std::string> & whereFilter)
+    {
+        LOCKGUARD(m_lock);
+        if (!m_isOpened) {
+            LOG_ERROR("Failed to delete records: Storage is not open");
+            return;
+        }
+
+        for (const auto &kv : whereFilter)
+        {
+            if (kv.first != "record_id" && kv.first != "tenant_token" && kv.first != "latency" &&
+                kv.first != "persistence" && kv.first != "retry_count")
+            {
+                LOG_ERROR("Failed to delete records: unsupported filter column %s", kv.first.c_str());
+                return;
+            }
+        }
+
+        auto matches = [&](Segment const& segment, Slot const& slot)
+        {
+            for (const auto &kv : whereFilter)
+            {
+                if (kv.first == "record_id") {
+                    if (slot.id != kv.second) return false;
+                }
+                else if (kv.first == "tenant_token") {
+                    if (slot.tenantToken != kv.second) return false;
+                }
+                else {
+                    long value = strtol(kv.second.c_str(), nullptr, 10);
+                    long actual = (kv.first == "latency") ? static_cast<long>(segment.latency) :
+                                  (kv.first == "persistence") ? static_cast<long>(slot.persistence) :
+                                  static_cast<long>(slot.retryCount);
+                    if (actual != value) return false;
+                }
+            }
+            return true;
+        };
+
+        // Collect first: deleting may drop segments out from under the iteration
+        std::vector<std::string> ids;
+        for (auto& segments : m_segments)
+        {
+            for (auto& segment : segments)
+            {
+                for (size_t i = segment->firstLive; i < segment->slots.size(); i++)
+                {
+                    Slot const& slot = segment->slots[i];
+                    if (!slot.deleted && matches(*segment, slot))
+                    {
+                        ids.push_back(slot.id);
+                    }
+                }
+            }
+        }
+        for (auto const& id : ids)
+        {
+            SlotRef ref;
+            if (findSlot(id, ref))
+            {
+                deleteSlot(ref);
+            }
+        }
+    }
+
+    void OfflineStorage_Segments::DeleteRecords(std::vector<StorageRecordId> const& ids, HttpHeaders headers, bool& fromMemory)
+    {
+        UNREFERENCED_PARAMETER(fromMemory);
+        UNREFERENCED_PARAMETER(headers);
+
+        if (ids.empty()) {
+            return;
+        }
+
+        LOCKGUARD(m_lock);
+        if (!m_isOpened) {
+            LOG_ERROR("Failed to delete %u sent event(s) {%s%s}: Storage is not open",
+                static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "");
+            return;
+        }
+
+        LOG_TRACE("Deleting %u sent event(s) {%s%s}...", static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "");
+        for (auto const& id : ids)
+        {
+            SlotRef ref;
+            if (findSlot(id, ref))
+            {
+                deleteSlot(ref);
+            }
+        }
+    }
+
+    void OfflineStorage_Segments::ReleaseRecords(std::vector<StorageRecordId> const& ids, bool incrementRetryCount, HttpHeaders headers, bool& fromMemory)
+    {
+        UNREFERENCED_PARAMETER(fromMemory);
+        UNREFERENCED_PARAMETER(headers);
+
+        if (ids.empty()) {
+            return;
+        }
+
+        LOCKGUARD(m_lock);
+        if (!m_isOpened) {
+            LOG_ERROR("Failed to release %u event(s) {%s%s}, retry count %s: Storage is not open",
+                static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "", incrementRetryCount ? "+1" : "not changed");
+            return;
+        }
+
+        LOG_TRACE("Releasing %u event(s) {%s%s}, retry count %s...",
+            static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "", incrementRetryCount ? "+1" : "not changed");
+
+        unsigned maxRetryCount = m_config.GetMaximumRetryCount();
+        std::map<std::string, size_t> deletedData;
+        unsigned released = 0;
+        for (auto const& id : ids)
+        {
+            SlotRef ref;
+            if (!findSlot(id, ref))
+            {
+                continue;
+            }
+            Slot& slot = ref.first->slots[ref.second];
+            if (slot.reservedUntil == 0)
+            {
+                continue;
+            }
+            slot.reservedUntil = 0;
+            m_reserved.erase(slot.id);
+            released++;
+            if (incrementRetryCount)
+            {
+                setRetryCount(ref, static_cast<uint8_t>(std::min(slot.retryCount + 1, 255)));
+                if (slot.retryCount > maxRetryCount)
+                {
+                    deletedData[slot.tenantToken]++;
+                    deleteSlot(ref);
+                }
+            }
+        }
+        LOG_TRACE("Successfully released %u requested event(s), %u were not found anymore",
+            released, static_cast<unsigned>(ids.size()) - released);
+
+        if (!deletedData.empty())
+        {
+            LOG_ERROR("Deleted events over maximum retry count %u", maxRetryCount);
+            m_observer->OnStorageRecordsDropped(deletedData);
+        }
+    }
+
+    bool OfflineStorage_Segments::loadSettings()
+    {
+        m_settings.clear();
+        std::string path = m_directory + PATH_SEPARATOR_CHAR + SettingsFileName;
+        std::FILE* file = FileOpen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        std::string contents;
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            contents.append(buffer, read);
+        }
+        FileClose(file);
+
+        // Pairs of NUL-terminated name and value
+        size_t position = 0;
+        while (position < contents.size())
+        {
+            size_t nameEnd = contents.find('\0', position);
+            size_t valueEnd = (nameEnd == std::string::npos) ? std::string::npos : contents.find('\0', nameEnd + 1);
+            if (valueEnd == std::string::npos)
+            {
+                LOG_WARN("Ignoring truncated settings file");
+                break;
+            }
+            m_settings[contents.substr(position, nameEnd - position)] = contents.substr(nameEnd + 1, valueEnd - nameEnd - 1);
+            position = valueEnd + 1;
+        }
+        return true;
+    }
+
+    bool OfflineStorage_Segments::saveSettings()
+    {
+        std::string contents;
+        for (auto const& setting : m_settings)
+        {
+            contents.append(setting.first).push_back('\0');
+            contents.append(setting.second).push_back('\0');
+        }
+
+        // Written aside and renamed over the old file, so a crash leaves either version intact
+        std::string tempPath = m_directory + PATH_SEPARATOR_CHAR + SettingsTempFileName;
+        std::FILE* file = FileOpen(tempPath.c_str(), "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        bool written = (fwrite(contents.data(), 1, contents.size(), file) == contents.size());
+        written = (FileClose(file) == 0) && written;
+        std::string path = m_directory + PATH_SEPARATOR_CHAR + SettingsFileName;
+        return written && FileRename(tempPath.c_str(), path.c_str());
+    }
+
+    bool OfflineStorage_Segments::StoreSetting(std::string const& name, std::string const& value)
+    {
+        if (name.empty()) {
+            LOG_ERROR("Failed to set setting \"%s\": Name cannot be empty", name.c_str());
+            return false;
+        }
+
+        LOCKGUARD(m_lock);
+        if (!m_isOpened) {
+            LOG_ERROR("Failed to set setting \"%s\": Storage is not open", name.c_str());
+            return false;
+        }
+
+        if (!value.empty()) {
+            m_settings[name] = value;
+        }
+        else {
+            m_settings.erase(name);
+        }
+        if (!saveSettings()) {
+            LOG_ERROR("Failed to set setting \"%s\": Failed to write settings file", name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::string OfflineStorage_Segments::GetSetting(std::string const& name)
+    {
+        if (name.empty()) {
+            LOG_ERROR("Failed to get setting \"%s\": Name cannot be empty", name.c_str());
+            return std::string();
+        }
+
+        LOCKGUARD(m_lock);
+        auto it = m_settings.find(name);
+        return (it != m_settings.end()) ? it->second : std::string();
+    }
+
+    bool OfflineStorage_Segments::DeleteSetting(std::string const& name)
+    {
+        if (name.empty()) {
+            LOG_ERROR("Failed to delete setting \"%s\": Name cannot be empty", name.c_str());
+            return false;
+        }
+
+        LOCKGUARD(m_lock);
+        if (!m_isOpened) {
+            LOG_ERROR("Failed to delete setting \"%s\": Storage is not open", name.c_str());
+            return false;
+        }
+        if (m_settings.erase(name) == 0) {
+            return true;
+        }
+        if (!saveSettings()) {
+            LOG_ERROR("Failed to delete setting \"%s\": Failed to write settings file", name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    size_t OfflineStorage_Segments::GetSize()
+    {
+        LOCKGUARD(m_lock);
+        return m_totalSize;
+    }
+
+    void OfflineStorage_Segments::countRecord(EventLatency latency, size_t bytes)
+    {
+        m_recordCounts[latency]++;
+        m_recordBytes[latency] += bytes;
+        m_totalRecordCount++;
+        m_totalRecordBytes += bytes;
+    }
+
+    void OfflineStorage_Segments::uncountRecord(EventLatency latency, size_t bytes)
+    {
+        m_recordCounts[latency]--;
+        m_recordBytes[latency] -= bytes;
+        m_totalRecordCount--;
+        m_totalRecordBytes -= bytes;
+    }
+
+    size_t OfflineStorage_Segments::GetRecordCount(EventLatency latency) const
+    {
+        // The counters follow every change of the index, so readers do not need the storage lock
+        if (latency == EventLatency_Unspecified)
+        {
+            return m_totalRecordCount;
+        }
+        if (latency < EventLatency_Off || latency > EventLatency_Max)
+        {
+            return 0;
+        }
+        return m_recordCounts[latency];
+    }
+
+    size_t OfflineStorage_Segments::GetRecordBytes(EventLatency latency) const
+    {
+        if (latency == EventLatency_Unspecified)
+        {
+            return m_totalRecordBytes;
+        }
+        if (latency < EventLatency_Off || latency > EventLatency_Max)
+        {
+            return 0;
+        }
+        return m_recordBytes[latency];
+    }
+
+    bool OfflineStorage_Segments::ResizeDb()
+    {
+        std::map<std::string, size_t> dropped;
+        size_t eventsDropped = 0;
+        {
+            LOCKGUARD(m_lock);
+            if (!m_isOpened) {
+                LOG_ERROR("Failed to resize storage: Storage is not open");
+                return false;
+            }
+            if ((m_DbSizeLimit == 0) || (m_totalSize <= m_DbSizeLimit)) {
+                return false;
+            }
+
+            // Drop whole segments, oldest first, until a quarter of the limit is free again. Segments
+            // holding critical records go only once those without any are gone, like SQLite trims.
+            size_t target = m_DbSizeLimit / 4 * 3;
+            for (bool dropCritical : { false, true })
+            {
+                while (m_totalSize > target)
+                {
+                    Segment* oldest = nullptr;
+                    for (auto& segments : m_segments)
+                    {
+                        for (auto& segment : segments)
+                        {
+                            if (dropCritical || !hasCriticalRecords(*segment))
+                            {
+                                if (oldest == nullptr || segment->sequence < oldest->sequence)
+                                {
+                                    oldest = segment.get();
+                                }
+                                break;
+                            }
+                        }
+                    }
+                    if (oldest == nullptr)
+                    {
+                        break;
+                    }
+                    eventsDropped += oldest->liveCount;
+                    dropSegment(oldest, &dropped);
+                }
+            }
+            LOG_TRACE("Storage resized, events dropped: %u", static_cast<unsigned>(eventsDropped));
+        }
+
+        if (!dropped.empty())
+        {
+            m_observer->OnStorageTrimmed(dropped);
+        }
+        return true;
+    }
+
+} MAT_NS_END
+#endif
@@ -0,0 +1,169 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#ifdef HAVE_MAT_STORAGE
+
+#ifndef OFFLINESTORAGE_SEGMENTS_HPP
+#define OFFLINESTORAGE_SEGMENTS_HPP
+
+#include "pal/PAL.hpp"
+#include "IOfflineStorage.hpp"
+
+#include "api/IRuntimeConfig.hpp"
+
+#include "ILogManager.hpp"
+#include "MappedFile.hpp"
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// Append-only offline storage made of fixed-size memory-mapped segment files.
+    ///
+    /// Every latency has its own chain of segments in the "&lt;cacheFilePath&gt;.segments" directory.
+    /// Records are appended to the newest segment of their latency as length-prefixed, CRC32C-checked
+    /// entries; deleting a record only flips its state byte in place. Reservations, retry counts and
+    /// the id lookup live in an in-memory index that is rebuilt at startup by scanning every segment
+    /// up to its first empty or torn entry; entries failing their checksum are dropped individually. Space is reclaimed by removing whole segments,
+    /// either once all their records are gone or, when trimming, oldest first.
+    /// </summary>
+    class OfflineStorage_Segments : public IOfflineStorage
+    {
+    public:
+        OfflineStorage_Segments(ILogManager& logManager, IRuntimeConfig& runtimeConfig);
+
+        virtual ~OfflineStorage_Segments() override;
+        virtual void Initialize(IOfflineStorageObserver& observer) override;
+        virtual void Shutdown() override;
+        virtual void Flush() override;
+        virtual bool StoreRecord(StorageRecord const& record) override;
+        virtual size_t StoreRecords(std::vector<StorageRecord> & records) override;
+        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency = EventLatency_Normal, unsigned maxCount = 0) override;
+        virtual bool IsLastReadFromMemory() override;
+        virtual unsigned LastReadRecordCount() override;
+
+        virtual void DeleteRecords(const std::map<std::string, std::string> & whereFilter) override;
+        virtual void DeleteAllRecords() override;
+        virtual void DeleteRecords(std::vector<StorageRecordId> const& ids, HttpHeaders headers, bool& fromMemory) override;
+        virtual void ReleaseRecords(std::vector<StorageRecordId> const& ids, bool incrementRetryCount, HttpHeaders headers, bool& fromMemory) override;
+
+        virtual bool StoreSetting(std::string const& name, std::string const& value) override;
+        virtual std::string GetSetting(std::string const& name) override;
+        virtual bool DeleteSetting(std::string const& name) override;
+        virtual size_t GetSize() override;
+        virtual size_t GetRecordCount(EventLatency latency) const override;
+
+        /// <summary>
+        /// Total payload size of the stored records of the given latency, or of all records when unspecified.
+        /// </summary>
+        size_t GetRecordBytes(EventLatency latency = EventLatency_Unspecified) const;
+        virtual std::vector<StorageRecord> GetRecords(bool shutdown, EventLatency minLatency = EventLatency_Normal, unsigned maxCount = 0) override;
+        virtual bool ResizeDb() override;
+
+        /// <summary>
+        /// Directory holding the segment files of a given cache file path.
+        /// </summary>
+        static std::string GetSegmentDirectory(std::string const& cacheFilePath);
+
+    protected:
+        static constexpr size_t LatencyCount = static_cast<size_t>(EventLatency_Max) + 1;
+
+        /// <summary>
+        /// Index entry of a record stored in a segment.
+        /// </summary>
+        struct Slot
+        {
+            std::string      id;
+            std::string      tenantToken;
+            int64_t          timestamp;
+            int64_t          reservedUntil;
+            uint32_t         offset;
+            uint32_t         bytes;
+            uint8_t          persistence;
+            uint8_t          retryCount;
+            bool             deleted;
+        };
+
+        struct Segment
+        {
+            std::string       path;
+            uint64_t          sequence;
+            EventLatency      latency;
+            MappedFile        file;
+            size_t            writeOffset;
+            std::vector<Slot> slots;
+            size_t            liveCount;
+            size_t            firstLive;
+        };
+
+        typedef std::pair<Segment*, size_t> SlotRef;
+
+        bool openSegments();
+        bool recoverSegment(std::string const& fileName);
+        Segment* createSegment(EventLatency latency, size_t minSize);
+        void dropSegment(Segment* segment, std::map<std::string, size_t>* dropped);
+        void dropAllSegments();
+        static bool hasCriticalRecords(Segment const& segment);
+        void sealSegment(Segment* segment);
+
+        bool appendRecord(StorageRecord const& record);
+        bool readRecord(Segment const& segment, Slot const& slot, StorageRecord& record) const;
+        void deleteCorruptRecords(std::vector<StorageRecordId> const& ids, std::map<std::string, size_t> const& deletedData);
+        void deleteSlot(SlotRef const& ref);
+        void countRecord(EventLatency latency, size_t bytes);
+        void uncountRecord(EventLatency latency, size_t bytes);
+        void setRetryCount(SlotRef const& ref, uint8_t retryCount);
+        bool findSlot(std::string const& id, SlotRef& ref) const;
+        void releaseExpiredReservations();
+
+        bool loadSettings();
+        bool saveSettings();
+
+    protected:
+        mutable std::recursive_mutex        m_lock {};
+        IOfflineStorageObserver*            m_observer {};
+        IRuntimeConfig&                     m_config;
+        ILogManager&                        m_logManager;
+
+        std::string                         m_directory;
+        size_t                              m_segmentSize {};
+        bool                                m_isOpened {};
+        bool                                m_checksumsEnabled {};
+
+        std::deque<std::unique_ptr<Segment>> m_segments[LatencyCount];
+        std::unordered_map<std::string, SlotRef> m_index;
+        std::unordered_set<std::string>     m_reserved;
+        std::atomic<size_t>                 m_recordCounts[LatencyCount] {};
+        std::atomic<size_t>                 m_recordBytes[LatencyCount] {};
+        std::atomic<size_t>                 m_totalRecordCount {};
+        std::atomic<size_t>                 m_totalRecordBytes {};
+        uint64_t                            m_nextSequence {};
+        // Bytes written to the segments, without the preallocated space after their last record
+        size_t                              m_totalSize {};
+
+        std::map<std::string, std::string>  m_settings;
+
+        unsigned                            m_lastReadCount {};
+        unsigned                            m_DbSizeNotificationLimit {};
+        uint64_t                            m_DbSizeNotificationInterval {};
+        size_t                              m_DbSizeLimit {};
+        uint64_t                            m_isStorageFullNotificationSendTime {};
+
+    protected:
+        MATSDK_LOG_DECL_COMPONENT_CLASS();
+    };
+
+} MAT_NS_END
+
+#endif // OFFLINESTORAGE_SEGMENTS_HPP
+#endif // HAVE_MAT_STORAGE
@@ -5,6 +5,8 @@
 
 #include "StorageObserver.hpp"
 
+#include <unordered_map>
+
 namespace MAT_NS_BEGIN {
 
     StorageObserver::StorageObserver(ITelemetrySystem& system, IOfflineStorage& offlineStorage)
@@ -41,6 +43,71 @@ namespace MAT_NS_BEGIN {
         return true;
     }
 
+    void StorageObserver::handleStoreRecords(IncomingEventContextBatch const& events)
+    {
+        // Records are moved into the batch and back, so that the storage makes the only copy
+        int64_t timestamp = PAL::getUtcSystemTimeMs();
+        StorageRecordVector records;
+        records.reserve(events.size());
+        std::vector<const uint8_t*> payloads;
+        payloads.reserve(events.size());
+        for (auto const& ctx : events)
+        {
+            ctx->record.timestamp = timestamp;
+            records.push_back(std::move(ctx->record));
+            payloads.push_back(records.back().blob.data());
+        }
+
+        size_t stored = m_offlineStorage.StoreRecords(records);
+
+        // The storage moves the records it failed to store behind the stored ones. Payload
+        // buffers move along with the records (serialized records are never empty), so they
+        // tell which event each record belongs to.
+        bool inOrder = true;
+        for (size_t i = 0; inOrder && (i < records.size()); i++)
+        {
+            inOrder = (records[i].blob.data() == payloads[i]);
+        }
+        if (inOrder && (stored == events.size()))
+        {
+            for (size_t i = 0; i < events.size(); i++)
+            {
+                events[i]->record = std::move(records[i]);
+            }
+            recordsStored(events);
+            return;
+        }
+
+        std::unordered_map<const uint8_t*, size_t> positions;
+        if (!inOrder)
+        {
+            positions.reserve(records.size());
+            for (size_t i = 0; i < records.size(); i++)
+            {
+                positions[records[i].blob.data()] = i;
+            }
+        }
+
+        IncomingEventContextBatch storedEvents;
+        IncomingEventContextBatch failedEvents;
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            size_t position = inOrder ? i : positions[payloads[i]];
+            events[i]->record = std::move(records[position]);
+            ((position < stored) ? storedEvents : failedEvents).push_back(events[i]);
+        }
+
+        if (!failedEvents.empty())
+        {
+            // stats implementation must trigger a failure notification
+            storeRecordsFailed(failedEvents);
+        }
+        if (!storedEvents.empty())
+        {
+            recordsStored(storedEvents);
+        }
+    }
+
     void StorageObserver::handleRetrieveEvents(EventsUploadContextPtr const& ctx)
     {
         auto consumer = [&ctx, this](StorageRecord&& record) -> bool {
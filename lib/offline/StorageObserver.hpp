@@ -31,6 +31,7 @@ namespace MAT_NS_BEGIN {
         bool handleStop();
 
         bool handleStoreRecord(IncomingEventContextPtr const& ctx);
+        void handleStoreRecords(IncomingEventContextBatch const& events);
         void handleRetrieveEvents(EventsUploadContextPtr const& ctx);
 
         bool handleDeleteRecords(EventsUploadContextPtr const& ctx);
@@ -68,6 +69,10 @@ namespace MAT_NS_BEGIN {
         RouteSource<IncomingEventContextPtr const&>                              storeRecordFailed;
         RoutePassThrough<StorageObserver, IncomingEventContextPtr const&>        storeRecord{ this, &StorageObserver::handleStoreRecord };
 
+        RouteSource<IncomingEventContextBatch const&>                            recordsStored;
+        RouteSource<IncomingEventContextBatch const&>                            storeRecordsFailed;
+        RouteSink<StorageObserver, IncomingEventContextBatch const&>             storeRecords{ this, &StorageObserver::handleStoreRecords };
+
         RouteSink<StorageObserver, EventsUploadContextPtr const&>                retrieveEvents{ this, &StorageObserver::handleRetrieveEvents };
         RouteSource<EventsUploadContextPtr const&, StorageRecord const&, bool&>  retrievedEvent;
         RouteSource<EventsUploadContextPtr const&>                               retrievalFinished;
@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef STORAGERECORDBATCH_HPP
+#define STORAGERECORDBATCH_HPP
+
+#include "IOfflineStorage.hpp"
+
+#include <stddef.h>
+#include <utility>
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// Stores a batch record by record, moving the records that were not stored behind
+    /// the stored ones as IOfflineStorage::StoreRecords requires.
+    /// </summary>
+    /// <param name="records">Records to store.</param>
+    /// <param name="store">Stores one record, returns whether it was stored.</param>
+    /// <returns>Number of records stored</returns>
+    template <typename TStore>
+    size_t storeRecordsInPlace(StorageRecordVector& records, TStore store)
+    {
+        size_t stored = 0;
+        for (size_t i = 0; i < records.size(); i++)
+        {
+            if (store(records[i]))
+            {
+                if (i != stored)
+                {
+                    std::swap(records[stored], records[i]);
+                }
+                stored++;
+            }
+        }
+        return stored;
+    }
+
+} MAT_NS_END
+
+#endif // STORAGERECORDBATCH_HPP
@@ -0,0 +1,144 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "TenantFairness.hpp"
+
+#include "ILogConfiguration.hpp"
+#include "utils/Utils.hpp"
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Reads a size in bytes from a config value. Returns false if the value is not an integer.
+    /// </summary>
+    static bool readBytes(Variant& value, size_t& bytes)
+    {
+        if (value.type != Variant::TYPE_INT)
+        {
+            return false;
+        }
+        int64_t number = static_cast<int64_t>(value);
+        bytes = (number > 0) ? static_cast<size_t>(number) : 0;
+        return true;
+    }
+
+    TenantFairness::TenantFairness() noexcept :
+        m_quantum(0),
+        m_defaultQuota(0)
+    {
+    }
+
+    void TenantFairness::Configure(IRuntimeConfig& config)
+    {
+        if (!config.HasConfig(CFG_MAP_TENANT_FAIRNESS))
+        {
+            return;
+        }
+
+        VariantMap& fairness = config[CFG_MAP_TENANT_FAIRNESS];
+        auto it = fairness.find(CFG_INT_TENANT_FAIRNESS_QUANTUM);
+        if (it != fairness.end())
+        {
+            readBytes(it->second, m_quantum);
+        }
+
+        it = fairness.find(CFG_INT_TENANT_FAIRNESS_QUOTA);
+        if (it != fairness.end())
+        {
+            readBytes(it->second, m_defaultQuota);
+        }
+
+        it = fairness.find(CFG_MAP_TENANT_FAIRNESS_TENANTS);
+        if (it != fairness.end() && (it->second.type == Variant::TYPE_OBJ))
+        {
+            VariantMap& tenants = it->second;
+            for (auto& kv : tenants)
+            {
+                size_t quota;
+                if (readBytes(kv.second, quota))
+                {
+                    m_tenantQuotas[kv.first] = quota;
+                }
+            }
+        }
+    }
+
+    size_t TenantFairness::GetQuota(const std::string& tenantToken) const
+    {
+        if (!m_tenantQuotas.empty())
+        {
+            auto it = m_tenantQuotas.find(tenantTokenToId(tenantToken));
+            if (it != m_tenantQuotas.end())
+            {
+                return it->second;
+            }
+        }
+        return m_defaultQuota;
+    }
+
+    size_t TenantFairness::Schedule(std::vector<RecordSource>& sources, size_t quantum, std::function<bool(StorageRecord&&)> const& consumer)
+    {
+        struct TenantQueue
+        {
+            RecordSource*   source;
+            StorageRecord   head;
+            bool            hasHead;
+            size_t          deficit;
+        };
+
+        std::vector<TenantQueue> queues(sources.size());
+        for (size_t i = 0; i < sources.size(); i++)
+        {
+            queues[i].source = &sources[i];
+            queues[i].hasHead = sources[i](queues[i].head);
+            queues[i].deficit = 0;
+        }
+
+        size_t consumed = 0;
+        for (;;)
+        {
+            // Serve the most urgent latency class with pending records
+            bool pending = false;
+            EventLatency latency = EventLatency_Off;
+            for (auto const& queue : queues)
+            {
+                if (queue.hasHead && (!pending || queue.head.latency > latency))
+                {
+                    latency = queue.head.latency;
+                    pending = true;
+                }
+            }
+            if (!pending)
+            {
+                return consumed;
+            }
+
+            for (auto& queue : queues)
+            {
+                if (!queue.hasHead || queue.head.latency != latency)
+                {
+                    continue;
+                }
+                queue.deficit += quantum;
+                while (queue.hasHead && (queue.head.latency == latency) && (queue.head.blob.size() <= queue.deficit))
+                {
+                    queue.deficit -= queue.head.blob.size();
+                    if (!consumer(std::move(queue.head)))
+                    {
+                        return consumed;
+                    }
+                    consumed++;
+                    queue.head = StorageRecord();
+                    queue.hasHead = (*queue.source)(queue.head);
+                }
+                // Credit is not carried over once the tenant has nothing left in this class
+                if (!queue.hasHead || queue.head.latency != latency)
+                {
+                    queue.deficit = 0;
+                }
+            }
+        }
+    }
+
+} MAT_NS_END
@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef TENANTFAIRNESS_HPP
+#define TENANTFAIRNESS_HPP
+
+#include "IOfflineStorage.hpp"
+#include "api/IRuntimeConfig.hpp"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Per-tenant fairness of the offline storage, driven by the CFG_MAP_TENANT_FAIRNESS configuration.
+    ///
+    /// When a quantum is configured, records are retrieved for upload in deficit round robin order
+    /// across tenants: within each latency class, every tenant with pending records is credited the
+    /// quantum in turn and hands out records while its credit covers them, so that a tenant logging
+    /// large or many events cannot monopolize the uploads of the others. When quotas are configured,
+    /// a tenant storing more than its quota loses its own oldest records instead of everyone's.
+    /// </summary>
+    class TenantFairness
+    {
+    public:
+        /// <summary>
+        /// Returns the next record of a tenant in retrieval order (non-increasing latency),
+        /// or false when the tenant has no more records.
+        /// </summary>
+        using RecordSource = std::function<bool(StorageRecord&)>;
+
+        TenantFairness() noexcept;
+
+        /// <summary>
+        /// Reads the tenant fairness configuration.
+        /// </summary>
+        void Configure(IRuntimeConfig& config);
+
+        /// <summary>
+        /// Returns true if records are retrieved in deficit round robin order across tenants.
+        /// </summary>
+        bool IsFairQueueingEnabled() const noexcept
+        {
+            return m_quantum != 0;
+        }
+
+        size_t GetQuantum() const noexcept
+        {
+            return m_quantum;
+        }
+
+        /// <summary>
+        /// Returns true if the storage of at least one tenant is limited.
+        /// </summary>
+        bool HasQuotas() const noexcept
+        {
+            return (m_defaultQuota != 0) || !m_tenantQuotas.empty();
+        }
+
+        /// <summary>
+        /// Returns the storage quota in bytes of a tenant token, 0 if unlimited.
+        /// </summary>
+        size_t GetQuota(const std::string& tenantToken) const;
+
+        /// <summary>
+        /// Hands the records of the sources to the consumer in deficit round robin order, the
+        /// highest latency first, until the sources are exhausted or the consumer returns false.
+        /// </summary>
+        /// <param name="sources">Record sources, one per tenant.</param>
+        /// <param name="quantum">Credit in bytes granted to a tenant each round.</param>
+        /// <param name="consumer">Receives the records, returns false to stop.</param>
+        /// <returns>The number of records accepted by the consumer.</returns>
+        static size_t Schedule(std::vector<RecordSource>& sources, size_t quantum, std::function<bool(StorageRecord&&)> const& consumer);
+
+    protected:
+        size_t                                  m_quantum;
+        size_t                                  m_defaultQuota;
+        std::unordered_map<std::string, size_t> m_tenantQuotas;
+    };
+
+} MAT_NS_END
+
+#endif // TENANTFAIRNESS_HPP
@@ -10,8 +10,9 @@
 
 namespace MAT_NS_BEGIN {
 
-    Packager::Packager(IRuntimeConfig& runtimeConfig)
-        : m_config(runtimeConfig)
+    Packager::Packager(IRuntimeConfig& runtimeConfig, MemoryBudget* memoryBudget)
+        : m_config(runtimeConfig),
+        m_memoryBudget(memoryBudget)
     {
         const char *forcedTenantToken = runtimeConfig["forcedTenantToken"];
         if (forcedTenantToken != nullptr)
@@ -56,6 +57,7 @@ namespace MAT_NS_BEGIN {
             }
 
             ctx->splicer->addRecord(it->second, record.blob);
+            ctx->packagingMemory.Assign(m_memoryBudget, MemorySubsystem_Packaging, ctx->splicer->getSizeEstimate());
 
             ctx->recordIdsAndTenantIds[record.id] = record.tenantToken;
             ctx->recordTimestamps.push_back(record.timestamp);
@@ -76,6 +78,7 @@ namespace MAT_NS_BEGIN {
 
         ctx->body = ctx->splicer->splice();
         ctx->splicer->clear();
+        ctx->packagingMemory.Assign(m_memoryBudget, MemorySubsystem_Packaging, MemoryBudget::GetHeapSize(ctx->body));
 
         packagedEvents(ctx);
     }
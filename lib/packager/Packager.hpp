@@ -13,7 +13,7 @@ namespace MAT_NS_BEGIN {
 
     class Packager {
     public:
-        Packager(IRuntimeConfig& runtimeConfig);
+        Packager(IRuntimeConfig& runtimeConfig, MemoryBudget* memoryBudget = nullptr);
 
     protected:
         void handleAddEventToPackage(EventsUploadContextPtr const& ctx, StorageRecord const& record, bool& wantMore);
@@ -21,6 +21,7 @@ namespace MAT_NS_BEGIN {
 
     protected:
         IRuntimeConfig & m_config;
+        MemoryBudget*    m_memoryBudget;
         std::string      m_forcedTenantToken;
 
     public:
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "pal/PAL.hpp"
+#include "pal/TaskDispatcher.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+namespace PAL_NS_BEGIN {
+
+    namespace detail {
+
+        /// <summary>
+        /// Thread-safe free list of fixed-size blocks. Tasks are typically
+        /// allocated by the caller thread and released by the worker thread,
+        /// so a thread-local cache would not help here: blocks are shared
+        /// via a short critical section instead.
+        /// </summary>
+        class TaskBlockPool
+        {
+            struct Block
+            {
+                Block* next;
+            };
+
+        public:
+            TaskBlockPool(size_t blockSize, size_t maxBlocks) :
+                m_blockSize(blockSize),
+                m_maxBlocks(maxBlocks),
+                m_freeList(nullptr),
+                m_freeCount(0)
+            {
+            }
+
+            void* Allocate()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    if (m_freeList != nullptr)
+                    {
+                        Block* block = m_freeList;
+                        m_freeList = block->next;
+                        m_freeCount--;
+                        return block;
+                    }
+                }
+                return ::operator new(m_blockSize);
+            }
+
+            void Release(void* ptr) noexcept
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    if (m_freeCount < m_maxBlocks)
+                    {
+                        Block* block = static_cast<Block*>(ptr);
+                        block->next = m_freeList;
+                        m_freeList = block;
+                        m_freeCount++;
+                        return;
+                    }
+                }
+                ::operator delete(ptr);
+            }
+
+            size_t BlockSize() const
+            {
+                return m_blockSize;
+            }
+
+        private:
+            const size_t m_blockSize;
+            const size_t m_maxBlocks;
+            std::mutex   m_lock;
+            Block*       m_freeList;
+            size_t       m_freeCount;
+        };
+
+        /* Retain up to 256 recycled blocks per size class: ~240KB worst case */
+        static const size_t MAX_POOLED_TASKS_PER_CLASS = 256;
+
+        /// <summary>
+        /// Returns the pool for the smallest size class that fits the requested size,
+        /// or nullptr if the task is too large to be pooled.
+        /// </summary>
+        static TaskBlockPool* getTaskPool(size_t size) noexcept
+        {
+            // Pools are intentionally leaked: tasks may still be released by
+            // worker threads that outlive static destruction at process exit.
+            static TaskBlockPool* pools[] =
+            {
+                new TaskBlockPool(64,  MAX_POOLED_TASKS_PER_CLASS),
+                new TaskBlockPool(128, MAX_POOLED_TASKS_PER_CLASS),
+                new TaskBlockPool(256, MAX_POOLED_TASKS_PER_CLASS),
+                new TaskBlockPool(512, MAX_POOLED_TASKS_PER_CLASS)
+            };
+            for (TaskBlockPool* pool : pools)
+            {
+                if (size <= pool->BlockSize())
+                {
+                    return pool;
+                }
+            }
+            return nullptr;
+        }
+
+        void* allocateTask(size_t size)
+        {
+            TaskBlockPool* pool = getTaskPool(size);
+            return (pool != nullptr) ? pool->Allocate() : ::operator new(size);
+        }
+
+        void releaseTask(void* ptr, size_t size) noexcept
+        {
+            if (ptr == nullptr)
+            {
+                return;
+            }
+            TaskBlockPool* pool = getTaskPool(size);
+            if (pool != nullptr)
+            {
+                pool->Release(ptr);
+            }
+            else
+            {
+                ::operator delete(ptr);
+            }
+        }
+
+    } // namespace detail
+
+} PAL_NS_END
+
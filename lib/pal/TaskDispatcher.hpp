@@ -25,25 +25,36 @@ namespace PAL_NS_BEGIN {
 
     namespace detail {
 
+        /// <summary>
+        /// Allocates a block for a task object from the shared task pool.
+        /// Small tasks are served from fixed-size recycled blocks, so that
+        /// steady-state dispatching does not hit the global heap.
+        /// Larger tasks fall back to the global operator new.
+        /// </summary>
+        void* allocateTask(size_t size);
+
+        /// <summary>
+        /// Returns a block obtained via allocateTask back to the shared task pool.
+        /// </summary>
+        void releaseTask(void* ptr, size_t size) noexcept;
+
         template<typename TCall>
         class TaskCall : public Task
         {
         public:
 
-            TaskCall(TCall& call) :
+            TaskCall(TCall&& call) :
                 Task(),
-                m_call(call)
+                m_call(std::move(call))
             {
-                this->TypeName = TYPENAME(call);
                 this->Type = Task::Call;
                 this->TargetTime = 0;
             }
 
-            TaskCall(TCall& call, int64_t targetTime) :
+            TaskCall(TCall&& call, int64_t targetTime) :
                 Task(),
-                m_call(call)
+                m_call(std::move(call))
             {
-                this->TypeName = TYPENAME(call);
                 this->Type = Task::TimedCall;
                 this->TargetTime = targetTime;
             }
@@ -53,6 +64,27 @@ namespace PAL_NS_BEGIN {
                 m_call();
             }
 
+            // Demangling the functor type name is expensive (heap allocation plus a full
+            // demangle on GCC/Clang), so it is only done when somebody asks for it.
+            virtual const std::string& GetTypeName() override
+            {
+                if (this->TypeName.empty())
+                {
+                    this->TypeName = TYPENAME(m_call);
+                }
+                return this->TypeName;
+            }
+
+            static void* operator new(size_t size)
+            {
+                return allocateTask(size);
+            }
+
+            static void operator delete(void* ptr, size_t size) noexcept
+            {
+                releaseTask(ptr, size);
+            }
+
             virtual ~TaskCall() noexcept = default;
 
             const TCall m_call;
@@ -107,7 +139,7 @@ namespace PAL_NS_BEGIN {
     {
         assert(obj != nullptr);
         auto bound = std::bind(std::mem_fn(func), obj, std::forward<TPassedArgs>(args)...);
-        MAT::Task* task = new detail::TaskCall<decltype(bound)>(bound);
+        MAT::Task* task = new detail::TaskCall<decltype(bound)>(std::move(bound));
         taskDispatcher->Queue(task);
     }
 
@@ -121,7 +153,7 @@ namespace PAL_NS_BEGIN {
     DeferredCallbackHandle scheduleTask(MAT::ITaskDispatcher* taskDispatcher, unsigned delayMs, TObject* obj, void (TObject::*func)(TFuncArgs...), TPassedArgs&&... args)
     {
         auto bound = std::bind(std::mem_fn(func), obj, std::forward<TPassedArgs>(args)...);
-        auto task = new detail::TaskCall<decltype(bound)>(bound, getMonotonicTimeMs() + (int64_t)delayMs);
+        auto task = new detail::TaskCall<decltype(bound)>(std::move(bound), getMonotonicTimeMs() + (int64_t)delayMs);
         taskDispatcher->Queue(task);
         return DeferredCallbackHandle(task, taskDispatcher);
     }
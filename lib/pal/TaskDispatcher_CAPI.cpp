@@ -114,7 +114,7 @@ namespace PAL_NS_BEGIN {
         evt_task_t capiTask;
         std::string taskId = GetNextTaskId();
         capiTask.id = taskId.c_str();
-        capiTask.typeName = ownedItem->TypeName.c_str();
+        capiTask.typeName = ownedItem->GetTypeName().c_str();
         capiTask.delayMs = 0;
         if (ownedItem->Type == Task::TimedCall) {
             capiTask.delayMs = ownedItem->TargetTime - getMonotonicTimeMs();
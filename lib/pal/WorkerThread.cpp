@@ -31,7 +31,7 @@ namespace PAL_NS_BEGIN {
         std::recursive_mutex  m_lock;
         std::timed_mutex      m_execution_mutex;
 
-        std::list<MAT::Task*> m_queue;
+        std::deque<MAT::Task*> m_queue;
         std::list<MAT::Task*> m_timerQueue;
         Event                 m_event;
         MAT::Task*            m_itemInProgress;
@@ -237,7 +237,7 @@ namespace PAL_NS_BEGIN {
 
                     // Item wasn't cancelled before it could be executed
                     if (self->m_itemInProgress != nullptr) {
-                        LOG_TRACE("%10llu Execute item=%p type=%s\n", wakeupCount, item.get(), item.get()->TypeName.c_str() );
+                        LOG_TRACE("%10llu Execute item=%p type=%s\n", wakeupCount, item.get(), item->GetTypeName().c_str());
                         (*item)();
                         self->m_itemInProgress = nullptr;
                     }
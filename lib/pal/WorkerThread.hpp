@@ -6,6 +6,7 @@
 #define WORKER_THREAD_HPP
 
 #include <functional>
+#include <deque>
 #include <list>
 #include <mutex>
 #include <stdint.h>
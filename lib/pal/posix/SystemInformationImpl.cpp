@@ -13,7 +13,20 @@ namespace PAL_NS_BEGIN {
 
     SystemInformationImpl::SystemInformationImpl(IRuntimeConfig& configuration) : m_info_helper()
     {
-        auto sysInfo = sysinfo_sources_impl::GetSysInfo();
+        auto& sysInfo = sysinfo_sources_impl::GetSysInfo();
+        if (configuration.HasConfig(CFG_MAP_SYSTEM_INFO))
+        {
+            // Values provided by the host are used as-is, instead of being collected
+            VariantMap& provided = configuration[CFG_MAP_SYSTEM_INFO];
+            for (auto& kv : provided)
+            {
+                const char* value = kv.second;
+                if (value != nullptr)
+                {
+                    sysInfo.set(kv.first, value);
+                }
+            }
+        }
         m_user_timezone = sysInfo.get("tz");
         m_app_id = sysInfo.get("appId");
         m_os_name = sysInfo.get("osName");
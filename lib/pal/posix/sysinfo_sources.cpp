@@ -17,7 +17,6 @@
 
 #include <string.h>
 
-#include <sstream>
 #include <fstream>
 #include <streambuf>
 #include <list>
@@ -25,11 +24,6 @@
 #include <unistd.h>
 #include <sys/utsname.h>
 
-#include <regex>
-
-#include <iostream>
-#include <iomanip>
-
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -98,6 +92,44 @@ inline std::string ReadFile(const char *filename)
     return str;
 }
 
+/**
+ * Read the first line of a file, or up to the first NUL for NUL-separated files
+ *
+ * @param filename
+ * @param separator
+ * @return
+ */
+static std::string ReadFirstLine(const char *filename, char separator = '\n')
+{
+    std::ifstream t(filename);
+    std::string str;
+    std::getline(t, str, separator);
+    return str;
+}
+
+/**
+ * Get system name and version from uname
+ */
+static struct utsname GetUname()
+{
+    struct utsname buf;
+    memset(&buf, 0, sizeof(buf));
+    uname(&buf);
+    return buf;
+}
+
+/**
+ * Format UTC offset in minutes as +hh:mm or -hh:mm
+ */
+static std::string FormatTimeZone(long minsFromGMT)
+{
+    char buffer[16] = { 0 };
+    // Real offsets stay within a day; clamping lets the compiler see the two-digit fields fit
+    int mins = static_cast<int>(std::min(std::abs(minsFromGMT), 99L * 60 + 59));
+    snprintf(buffer, sizeof(buffer), "%c%02d:%02d", (minsFromGMT < 0) ? '-' : '+', mins / 60, mins % 60);
+    return buffer;
+}
+
 /**
  * Execute command and get output
  * @param cmd Command to execute
@@ -130,166 +162,220 @@ static std::string Exec(const char* cmd)
 }
 
 /**
- * Read node value, preprocess it using regexp and store result in cache
+ * Add field and the source that computes its value.
  *
- * @param key       Field name
- * @return          true if field value is found and saved in cache
+ * @param key
+ * @param source
  */
-bool sysinfo_sources::fetch(std::string key)
+void sysinfo_sources::add(const std::string& key, sysinfo_source_t source)
 {
-	for(auto &kv : (*this))
-	{
-		if(kv.first == key)
-		{
-			const std::string star("*");
-			const std::string empty("");
-
-			std::string contents = ReadFile(kv.second.path);
-			if((kv.second.selector == star) || (kv.second.selector == empty))
-			{
-				cache[key] = contents;
-				return true;
-			}
-			// Run regexp
-			std::regex selector_regex(kv.second.selector);
-			std::smatch match;
-			if(std::regex_search(contents, match, selector_regex))
-			{
-				cache[key] = match[1];
-				return true;
-			}
-		}
-	}
-	return false;
+    slots[key].source = std::move(source);
 }
 
 /**
- * Add source descriptor to multimap.
+ * Provide a precomputed field value instead of computing it.
  *
  * @param key
- * @param val
+ * @param value
+ * @return
  */
-void sysinfo_sources::add(const std::string& key, const sysinfo_source_t& val)
+bool sysinfo_sources::set(const std::string& key, const std::string& value)
 {
-    (*this).insert(std::pair<std::string, sysinfo_source_t>(key, val));
+    auto it = slots.find(key);
+    if (it == slots.end())
+    {
+        return false;
+    }
+    bool provided = false;
+    slot_t& slot = it->second;
+    std::call_once(slot.once, [&slot, &value, &provided]()
+    {
+        slot.value = value;
+        provided = true;
+    });
+    return provided;
 }
 
-/**
- * Static configuration provisioning for where to fetch the props from
- */
-sysinfo_sources::sysinfo_sources() :
-        std::multimap<std::string, sysinfo_source_t>()
+sysinfo_sources::sysinfo_sources()
 {
 }
 
 /**
- * Retrieve value by key from sysinfo_sources. Try to fetch from cache,
- * if not found, then fetch from filesystem and save to in-ram cache.
+ * Retrieve value by key from sysinfo_sources. The value is computed
+ * on first access and cached.
  *
  * @param key
  * @return
  */
-const std::string& sysinfo_sources::get(std::string key)
+const std::string& sysinfo_sources::get(const std::string& key)
 {
-    if(cache.find(key) == cache.end())
-        fetch(key);
-    return cache[key];
+    static const std::string empty;
+    auto it = slots.find(key);
+    if (it == slots.end())
+    {
+        return empty;
+    }
+    slot_t& slot = it->second;
+    std::call_once(slot.once, [&slot]()
+    {
+        if (slot.source)
+        {
+            slot.value = slot.source();
+        }
+    });
+    return slot.value;
 }
 
 /**
- * Obtain system hardware and application information
+ * Parse the contents of os-release(5) in a single pass
+ *
+ * @param contents
+ * @return
  */
-sysinfo_sources_impl::sysinfo_sources_impl() : sysinfo_sources()
+std::map<std::string, std::string> sysinfo_sources_impl::parse_os_release(const std::string& contents)
 {
-    struct utsname buf;
-    uname(&buf);
-#if defined(__linux__)
-    // Obtain Linux system information from filesystem
-    add("devId", { "/etc/machine-id", "*"});
-    add("osName", {"/etc/os-release", ".*ID=(.*)[\n]+"});
-    add("osVer", {"/etc/os-release", ".*VERSION_ID=\"(.*)\".*"});
-    add("osRel", {"/etc/os-release", ".*VERSION=\"(.*)\".*"});
-    add("osBuild", {"/proc/version", "(.*)[\n]+"});
-    // add("proc_loadavg", {"/proc/loadavg", "(.*)[\n]*"});
-    // add("proc_uptime", {"/proc/uptime", "(.*)[\n]*"});
-
-    time_t t = time(NULL);
-    struct tm lt = { 0 };
-    localtime_r(&t, &lt);
-    int hh = lt.tm_gmtoff / 3600;
-    int mm = (lt.tm_gmtoff / 60) % 60;
-    std::ostringstream oss;
-    oss << ((hh<0)?"-":"+"); // +hh:mm or -hh:mm
-    oss << std::setw(2) << std::setfill('0') << std::abs(hh);
-    oss << std::setw(1) << ":";
-    oss << std::setw(2) << std::setfill('0') << std::abs(mm);
-    cache["tz"] = oss.str();
-#endif
-
-#if defined(__MINGW32__) || defined(__MSYS__)
-    // Obtain MinGW Device ID from registry
-    add("devId",    { "/proc/registry/HKEY_LOCAL_MACHINE/SYSTEM/CurrentControlSet/Control/SystemInformation/ComputerHardwareId", "*"});
-    add("devMake",  { "/proc/registry/HKEY_LOCAL_MACHINE/SYSTEM/CurrentControlSet/Control/SystemInformation/SystemManufacturer", "*"});
-    add("devModel", { "/proc/registry/HKEY_LOCAL_MACHINE/SYSTEM/CurrentControlSet/Control/SystemInformation/SystemProductName",  "*"});
-#endif
+    std::map<std::string, std::string> result;
+    auto it = contents.begin();
+    while (it != contents.end())
+    {
+        auto eol = std::find(it, contents.end(), '\n');
+        auto eq = std::find(it, eol, '=');
+        if ((eq != eol) && (eq != it) && (*it != '#'))
+        {
+            auto valueBegin = eq + 1;
+            auto valueEnd = eol;
+            if ((valueEnd != valueBegin) && (*(valueEnd - 1) == '\r'))
+            {
+                --valueEnd;
+            }
+            if ((valueEnd - valueBegin >= 2) && ((*valueBegin == '"') || (*valueBegin == '\'')) && (*(valueEnd - 1) == *valueBegin))
+            {
+                ++valueBegin;
+                --valueEnd;
+            }
+            result[std::string(it, eq)] = std::string(valueBegin, valueEnd);
+        }
+        it = (eol == contents.end()) ? eol : eol + 1;
+    }
+    return result;
+}
 
-#if defined(__APPLE__)
-    cache["devMake"] = "Apple";
-    cache["devModel"] = GetDeviceModel();
-    cache["osName"] = GetDeviceOsName();
-    cache["osVer"] = GetDeviceOsVersion();
-    cache["osRel"] = GetDeviceOsRelease();
-    cache["osBuild"] = GetDeviceOsBuild();
+const std::map<std::string, std::string>& sysinfo_sources_impl::os_release()
+{
+    std::call_once(os_release_once, [this]()
+    {
+        os_release_values = parse_os_release(ReadFile("/etc/os-release"));
+    });
+    return os_release_values;
+}
 
-    // Populate user timezone as hh:mm offset from UTC timezone. Example for PST: "-08:00"
-    CFTimeZoneRef tz = CFTimeZoneCopySystem();
-    CFTimeInterval minsFromGMT = CFTimeZoneGetSecondsFromGMT(tz, CFAbsoluteTimeGetCurrent()) / 60.0;
-    CFRelease(tz);
-    std::ostringstream oss;
-    int hh = std::abs((int)minsFromGMT / 60);
-    int mm = std::abs((int)minsFromGMT % 60);
-    if (minsFromGMT<0)
+/**
+ * Obtain system hardware and application information.
+ *
+ * Only registers the sources: each field is computed on first use.
+ */
+sysinfo_sources_impl::sysinfo_sources_impl() : sysinfo_sources()
+{
+    // Fields that may be provided by the host on every platform
+    for (const char* key : { "devId", "devMake", "devModel", "osName", "osVer", "osRel", "osBuild", "appId", "tz" })
     {
-        oss << "-";
+        add(key, nullptr);
     }
-    oss << std::setw(2) << std::setfill('0') << hh;
-    oss << std::setw(1) << ":";
-    oss << std::setw(2) << std::setfill('0') << mm;
-    cache["tz"] = oss.str();
-#endif
 
-    // Fallback to uname if above methods failed
-    if (!get("osVer").compare(""))
+#if defined(__linux__)
+    // Obtain Linux system information from filesystem
+    add("osName", [this]()
     {
-        cache["osVer"]  = (const char *)(buf.version);
-    }
+        auto it = os_release().find("ID");
+        return ((it != os_release().end()) && !it->second.empty()) ? it->second : std::string(GetUname().sysname);
+    });
+    add("osVer", [this]()
+    {
+        auto it = os_release().find("VERSION_ID");
+        return ((it != os_release().end()) && !it->second.empty()) ? it->second : std::string(GetUname().version);
+    });
+    add("osRel", [this]()
+    {
+        auto it = os_release().find("VERSION");
+        return ((it != os_release().end()) && !it->second.empty()) ? it->second : std::string(GetUname().release);
+    });
+    add("osBuild", []() { return ReadFirstLine("/proc/version"); });
 
-    if (!get("osName").compare(""))
+    add("tz", []()
     {
-        cache["osName"] = (const char *)(buf.sysname);
-    }
+        time_t t = time(NULL);
+        struct tm lt = { 0 };
+        localtime_r(&t, &lt);
+        return FormatTimeZone(lt.tm_gmtoff / 60);
+    });
+#elif defined(__APPLE__)
+    add("devMake", []() { return std::string("Apple"); });
+    add("devModel", []() { return GetDeviceModel(); });
+    add("osName", []()
+    {
+        std::string value = GetDeviceOsName();
+        return (!value.empty()) ? value : std::string(GetUname().sysname);
+    });
+    add("osVer", []()
+    {
+        std::string value = GetDeviceOsVersion();
+        return (!value.empty()) ? value : std::string(GetUname().version);
+    });
+    add("osRel", []()
+    {
+        std::string value = GetDeviceOsRelease();
+        return (!value.empty()) ? value : std::string(GetUname().release);
+    });
+    add("osBuild", []() { return GetDeviceOsBuild(); });
 
-    if (!get("osRel").compare(""))
+    // Populate user timezone as hh:mm offset from UTC timezone. Example for PST: "-08:00"
+    add("tz", []()
     {
-        cache["osRel"]  = (const char *)(buf.release);
-    }
+        CFTimeZoneRef tz = CFTimeZoneCopySystem();
+        CFTimeInterval minsFromGMT = CFTimeZoneGetSecondsFromGMT(tz, CFAbsoluteTimeGetCurrent()) / 60.0;
+        CFRelease(tz);
+        return FormatTimeZone(static_cast<long>(minsFromGMT));
+    });
+#else
+    add("osName", []() { return std::string(GetUname().sysname); });
+    add("osVer", []() { return std::string(GetUname().version); });
+    add("osRel", []() { return std::string(GetUname().release); });
+#endif
+
+#if defined(__MINGW32__) || defined(__MSYS__)
+    // Obtain MinGW Device ID from registry
+    add("devMake",  []() { return ReadFile("/proc/registry/HKEY_LOCAL_MACHINE/SYSTEM/CurrentControlSet/Control/SystemInformation/SystemManufacturer"); });
+    add("devModel", []() { return ReadFile("/proc/registry/HKEY_LOCAL_MACHINE/SYSTEM/CurrentControlSet/Control/SystemInformation/SystemProductName"); });
+#endif
 
 #ifndef __APPLE__
-    add("appId", {"/proc/self/cmdline", "(.*)[ ]*.*[\n]*"});
+    // Executable path: the first of the NUL-separated command line arguments
+    add("appId", []() { return ReadFirstLine("/proc/self/cmdline", '\0'); });
 #else
-    cache["appId"] = get_app_name();
+    add("appId", []() { return get_app_name(); });
 #endif
 
-    if (!get("devId").compare(""))
+    add("devId", []()
     {
+#if defined(__linux__)
+        std::string devId = ReadFile("/etc/machine-id");
+#elif defined(__MINGW32__) || defined(__MSYS__)
+        std::string devId = ReadFile("/proc/registry/HKEY_LOCAL_MACHINE/SYSTEM/CurrentControlSet/Control/SystemInformation/ComputerHardwareId");
+#else
+        std::string devId;
+#endif
+        if (!devId.empty())
+        {
+            return devId;
+        }
 #ifdef __APPLE__
         std::string contents = GetDeviceId();
 #if TARGET_OS_IPHONE
-        cache["devId"] = "i:";
+        devId = "i:";
 #else
-        cache["devId"] = "u:";
+        devId = "u:";
 #endif // TARGET_OS_IPHONE
-        cache["devId"] += MAT::GUID_t(contents.c_str()).to_string();
+        devId += MAT::GUID_t(contents.c_str()).to_string();
 #else
         // We were unable to obtain Device Id using standard means.
         // Try to use hash of blkid + hostname instead. Both blkid
@@ -303,10 +389,9 @@ sysinfo_sources_impl::sysinfo_sources_impl() : sysinfo_sources()
             {   // Simple XOR of contents to generate a UUID
                 guid_bytes[i % 16] ^= contents.at(i);
             }
-            cache["devId"] = MAT::GUID_t(guid_bytes).to_string();
+            devId = MAT::GUID_t(guid_bytes).to_string();
         }
 #endif
-    }
-
+        return devId;
+    });
 }
-
@@ -1,3 +1,4 @@
+
 #ifndef LIB_PAL_POSIX_SYSINFO_SOURCES_HPP_
 #define LIB_PAL_POSIX_SYSINFO_SOURCES_HPP_
 //
@@ -5,16 +6,15 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <functional>
 #include <map>
+#include <mutex>
 #include <string>
 
 /**
- * System information source path and selector
+ * Function that computes the value of a system information field
  */
-typedef struct {
-    const char * path;
-    const char * selector;
-} sysinfo_source_t;
+typedef std::function<std::string()> sysinfo_source_t;
 
 /**
  * Helper class to retrieve various key-value pairs from system info sources.
@@ -22,42 +22,52 @@ typedef struct {
  * Everything is a file in POSIX / UNIX, so this file helps to retrieve and
  * cache info obtained from various files.
  *
+ * Every field is a slot that is computed on first access, at most once, and
+ * safely from any thread. The set of fields is fixed after construction.
  */
-class sysinfo_sources : public std::multimap<std::string, sysinfo_source_t> {
+class sysinfo_sources {
 
 protected:
-    std::map<std::string, std::string> cache;
+
+    struct slot_t
+    {
+        std::once_flag      once;
+        sysinfo_source_t    source;
+        std::string         value;
+    };
+
+    std::map<std::string, slot_t> slots;
+
+public:
 
     /**
-     * Read node value, preprocess it using regexp and store result in cache
+     * Add field and the source that computes its value.
      *
      * @param key       Field name
-     * @return          true if field value is found and saved in cache
+     * @param source    Function computing the field value, may be empty
      */
-    bool fetch(std::string key);
-
-public:
+    void add(const std::string& key, sysinfo_source_t source);
 
     /**
-     * Add source descriptor to multimap.
+     * Provide a precomputed field value, e.g. from the host, instead of computing it.
      *
-     * @param key
-     * @param val
+     * @param key       Field name
+     * @param value     Field value
+     * @return          false if the field is unknown or its value has already been computed
      */
-    void add(const std::string& key, const sysinfo_source_t& val);
+    bool set(const std::string& key, const std::string& value);
 
     sysinfo_sources();
 
     /**
-     * Retrieve value by key from sysinfo_sources. Try to fetch from cache,
-     * if not found, then fetch from filesystem and save to in-ram cache.
+     * Retrieve value by key from sysinfo_sources. The value is computed
+     * on first access and cached.
      *
      * @param key
-     * @return
+     * @return          Field value, empty for unknown fields
      */
-    const std::string& get(std::string key);
+    const std::string& get(const std::string& key);
 
 };
 
 #endif /* LIB_PAL_POSIX_SYSINFO_SOURCES_HPP_ */
-
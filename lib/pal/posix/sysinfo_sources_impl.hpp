@@ -12,7 +12,16 @@ class sysinfo_sources_impl: public sysinfo_sources {
 public:
 
     sysinfo_sources_impl();
-    
+
+    /**
+     * Parse the contents of os-release(5): one KEY=value pair per line, value
+     * optionally quoted. Comments and malformed lines are skipped.
+     *
+     * @param contents  File contents
+     * @return          Map of keys to unquoted values
+     */
+    static std::map<std::string, std::string> parse_os_release(const std::string& contents);
+
     /**
      * Get instance for serving all singleton calls
      */
@@ -21,7 +30,16 @@ public:
         static sysinfo_sources_impl instance;
         return instance;
     }
+
+protected:
+
+    /**
+     * Parsed /etc/os-release, read once for all fields that come from it
+     */
+    const std::map<std::string, std::string>& os_release();
+
+    std::once_flag                          os_release_once;
+    std::map<std::string, std::string>      os_release_values;
 };
 
 #endif /* LIB_PAL_POSIX_SYSINFO_SOURCES_IMPL_HPP_ */
-
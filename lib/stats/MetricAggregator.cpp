@@ -0,0 +1,202 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "MetricAggregator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace MAT_NS_BEGIN
+{
+    constexpr unsigned LogLinearHistogram::SubBucketBits;
+    constexpr unsigned LogLinearHistogram::SubBucketCount;
+    constexpr size_t MetricAggregator::StripeCount;
+
+    // Highest power of two whose buckets still have lower bounds representable as long
+    static const int MaxExponent = std::numeric_limits<long>::digits - 1;
+
+    size_t LogLinearHistogram::GetBucketIndex(double magnitude)
+    {
+        if (magnitude < SubBucketCount)
+        {
+            return static_cast<size_t>(magnitude);
+        }
+
+        // magnitude = mantissa * 2^exponent, mantissa in [0.5, 1)
+        int exponent = 0;
+        double mantissa = std::frexp(magnitude, &exponent);
+        exponent -= 1;
+        if (exponent > MaxExponent)
+        {
+            exponent = MaxExponent;
+            mantissa = 1.0 - std::numeric_limits<double>::epsilon();
+        }
+        size_t subBucket = static_cast<size_t>((mantissa * 2.0 - 1.0) * SubBucketCount);
+        return SubBucketCount + static_cast<size_t>(exponent - static_cast<int>(SubBucketBits)) * SubBucketCount + subBucket;
+    }
+
+    long LogLinearHistogram::GetBucketLowerBound(size_t index)
+    {
+        if (index < SubBucketCount)
+        {
+            return static_cast<long>(index);
+        }
+        unsigned exponent = SubBucketBits + static_cast<unsigned>((index - SubBucketCount) / SubBucketCount);
+        unsigned long subBucket = static_cast<unsigned long>((index - SubBucketCount) % SubBucketCount);
+        unsigned long base = 1ul << exponent;
+        return static_cast<long>(base + subBucket * (base >> SubBucketBits));
+    }
+
+    void LogLinearHistogram::Add(double value)
+    {
+        std::vector<uint64_t>& counts = (value < 0) ? m_negative : m_positive;
+        size_t index = GetBucketIndex(std::fabs(value));
+        if (index >= counts.size())
+        {
+            counts.resize(index + 1, 0);
+        }
+        counts[index]++;
+    }
+
+    static void mergeCounts(std::vector<uint64_t>& target, std::vector<uint64_t> const& source)
+    {
+        if (source.size() > target.size())
+        {
+            target.resize(source.size(), 0);
+        }
+        for (size_t i = 0; i < source.size(); i++)
+        {
+            target[i] += source[i];
+        }
+    }
+
+    void LogLinearHistogram::Merge(LogLinearHistogram const& other)
+    {
+        mergeCounts(m_positive, other.m_positive);
+        mergeCounts(m_negative, other.m_negative);
+    }
+
+    void LogLinearHistogram::Reset()
+    {
+        // Keep the capacity: the same value range is likely to show up in the next interval
+        std::fill(m_positive.begin(), m_positive.end(), 0);
+        std::fill(m_negative.begin(), m_negative.end(), 0);
+    }
+
+    void LogLinearHistogram::Export(std::map<long, long>& buckets) const
+    {
+        for (size_t i = 0; i < m_positive.size(); i++)
+        {
+            if (m_positive[i] != 0)
+            {
+                buckets[GetBucketLowerBound(i)] += static_cast<long>(m_positive[i]);
+            }
+        }
+        for (size_t i = 0; i < m_negative.size(); i++)
+        {
+            if (m_negative[i] != 0)
+            {
+                buckets[-GetBucketLowerBound(i)] += static_cast<long>(m_negative[i]);
+            }
+        }
+    }
+
+    MetricAccumulator::MetricAccumulator()
+    {
+        Reset();
+    }
+
+    void MetricAccumulator::Add(double value)
+    {
+        if (m_count == 0)
+        {
+            m_min = value;
+            m_max = value;
+        }
+        else
+        {
+            m_min = (std::min)(m_min, value);
+            m_max = (std::max)(m_max, value);
+        }
+        m_count++;
+        m_sum += value;
+        m_sumOfSquares += value * value;
+        m_histogram.Add(value);
+    }
+
+    void MetricAccumulator::Merge(MetricAccumulator const& other)
+    {
+        if (other.m_count == 0)
+        {
+            return;
+        }
+        if (m_count == 0)
+        {
+            m_min = other.m_min;
+            m_max = other.m_max;
+        }
+        else
+        {
+            m_min = (std::min)(m_min, other.m_min);
+            m_max = (std::max)(m_max, other.m_max);
+        }
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_sumOfSquares += other.m_sumOfSquares;
+        m_histogram.Merge(other.m_histogram);
+    }
+
+    void MetricAccumulator::Reset()
+    {
+        m_count = 0;
+        m_sum = 0;
+        m_sumOfSquares = 0;
+        m_min = 0;
+        m_max = 0;
+        m_histogram.Reset();
+    }
+
+    void MetricAccumulator::Export(AggregatedMetricData& data) const
+    {
+        data.count = static_cast<long>(m_count);
+        data.aggregates[AggregateType_Sum] = m_sum;
+        data.aggregates[AggregateType_Minimum] = m_min;
+        data.aggregates[AggregateType_Maximum] = m_max;
+        data.aggregates[AggregateType_SumOfSquares] = m_sumOfSquares;
+        m_histogram.Export(data.buckets);
+    }
+
+    size_t MetricAggregator::getStripeIndex()
+    {
+        // Thread ids are often aligned addresses: mix the hash before taking the stripe
+        uint64_t hash = static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        hash *= 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(hash >> 32) % StripeCount;
+    }
+
+    void MetricAggregator::Add(double value)
+    {
+        if (!std::isfinite(value))
+        {
+            return;
+        }
+        Stripe& stripe = m_stripes[getStripeIndex()];
+        std::lock_guard<std::mutex> lock(stripe.lock);
+        stripe.accumulator.Add(value);
+    }
+
+    void MetricAggregator::Collect(MetricAccumulator& result)
+    {
+        for (Stripe& stripe : m_stripes)
+        {
+            std::lock_guard<std::mutex> lock(stripe.lock);
+            result.Merge(stripe.accumulator);
+            stripe.accumulator.Reset();
+        }
+    }
+
+} MAT_NS_END
@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef METRICAGGREGATOR_HPP
+#define METRICAGGREGATOR_HPP
+
+#include "Version.hpp"
+#include "ILogger.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Mergeable log-linear histogram of metric values.
+    /// Magnitudes below 2^SubBucketBits fall into unit-wide buckets; above that, every
+    /// power-of-two range is split into 2^SubBucketBits linear buckets, which bounds the
+    /// relative bucket width to about 6%. Negative values are bucketed by magnitude and
+    /// reported with negated bucket keys. Bucket keys are the lower bounds of the buckets.
+    /// </summary>
+    class LogLinearHistogram
+    {
+    public:
+        static constexpr unsigned SubBucketBits = 4;
+        static constexpr unsigned SubBucketCount = 1u << SubBucketBits;
+
+        void Add(double value);
+
+        void Merge(LogLinearHistogram const& other);
+
+        void Reset();
+
+        /// <summary>
+        /// Adds the non-empty buckets to a frequency table, keyed by bucket lower bound.
+        /// </summary>
+        void Export(std::map<long, long>& buckets) const;
+
+        /// <summary>
+        /// Returns the bucket index of a non-negative value.
+        /// </summary>
+        static size_t GetBucketIndex(double magnitude);
+
+        /// <summary>
+        /// Returns the lower bound of the bucket at the given index.
+        /// </summary>
+        static long GetBucketLowerBound(size_t index);
+
+    protected:
+        std::vector<uint64_t> m_positive;
+        std::vector<uint64_t> m_negative;
+    };
+
+    /// <summary>
+    /// Count, sum, sum of squares, minimum, maximum and histogram of a set of metric values.
+    /// </summary>
+    class MetricAccumulator
+    {
+    public:
+        MetricAccumulator();
+
+        void Add(double value);
+
+        void Merge(MetricAccumulator const& other);
+
+        void Reset();
+
+        bool Empty() const
+        {
+            return m_count == 0;
+        }
+
+        uint64_t GetCount() const
+        {
+            return m_count;
+        }
+
+        /// <summary>
+        /// Fills the count, aggregates and buckets of a metric record.
+        /// </summary>
+        void Export(AggregatedMetricData& data) const;
+
+    protected:
+        uint64_t           m_count;
+        double             m_sum;
+        double             m_sumOfSquares;
+        double             m_min;
+        double             m_max;
+        LogLinearHistogram m_histogram;
+    };
+
+    /// <summary>
+    /// Lock-light aggregation of a metric pushed from many threads.
+    /// Every thread is mapped to one of StripeCount accumulators, each guarded by its own
+    /// mutex, so concurrent producers rarely contend with each other. Collect merges and
+    /// resets all stripes; it is meant to be called periodically from the SDK timer.
+    /// </summary>
+    class MetricAggregator
+    {
+    public:
+        static constexpr size_t StripeCount = 16;
+
+        /// <summary>
+        /// Adds a value to the accumulator of the calling thread. Non-finite values are ignored.
+        /// </summary>
+        void Add(double value);
+
+        /// <summary>
+        /// Moves the values aggregated so far into the result accumulator.
+        /// </summary>
+        void Collect(MetricAccumulator& result);
+
+    protected:
+        struct Stripe
+        {
+            std::mutex        lock;
+            MetricAccumulator accumulator;
+            // Keeps neighbouring stripes out of the same cache line
+            char              padding[64];
+        };
+
+        static size_t getStripeIndex();
+
+        Stripe m_stripes[StripeCount];
+    };
+
+} MAT_NS_END
+
+#endif // METRICAGGREGATOR_HPP
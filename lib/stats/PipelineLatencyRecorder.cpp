@@ -0,0 +1,169 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "PipelineLatencyRecorder.hpp"
+#include "MetricAggregator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace MAT_NS_BEGIN
+{
+    constexpr unsigned PipelineLatencyRecorder::MaxExponent;
+    constexpr size_t PipelineLatencyRecorder::BucketCount;
+
+    static_assert(PipelineLatencyRecorder::BucketCount == LogLinearHistogram::SubBucketCount * (PipelineLatencyRecorder::MaxExponent - LogLinearHistogram::SubBucketBits + 1),
+        "Pipeline latency buckets must cover LogLinearHistogram buckets up to 2^MaxExponent");
+
+    /// <summary>
+    /// Uses the LogLinearHistogram bucket layout, with durations beyond the last bucket clamped into it.
+    /// </summary>
+    size_t PipelineLatencyRecorder::GetBucketIndex(uint64_t durationUs)
+    {
+        return std::min(LogLinearHistogram::GetBucketIndex(static_cast<double>(durationUs)), BucketCount - 1);
+    }
+
+    PipelineLatencyRecorder::PipelineLatencyRecorder(ILogManager& logManager) :
+        m_logManager(logManager),
+        m_enabled(true),
+        m_debugEvents(false)
+    {
+        for (Histogram& histogram : m_histograms)
+        {
+            clear(histogram);
+        }
+    }
+
+    void PipelineLatencyRecorder::Configure(IRuntimeConfig& config)
+    {
+        m_enabled = static_cast<bool>(config[CFG_MAP_PIPELINE_LATENCY][CFG_BOOL_PIPELINE_LATENCY_ENABLED]);
+        m_debugEvents = static_cast<bool>(config[CFG_MAP_PIPELINE_LATENCY][CFG_BOOL_PIPELINE_LATENCY_DEBUG_EVENTS]);
+    }
+
+    uint64_t PipelineLatencyRecorder::Now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void PipelineLatencyRecorder::clear(Histogram& histogram)
+    {
+        histogram.sumUs = 0;
+        histogram.minUs = std::numeric_limits<uint64_t>::max();
+        histogram.maxUs = 0;
+        for (auto& bucket : histogram.buckets)
+        {
+            bucket = 0;
+        }
+    }
+
+    void PipelineLatencyRecorder::Record(PipelineStage stage, uint64_t durationUs)
+    {
+        if (stage >= PipelineStage_Count || !IsEnabled())
+        {
+            return;
+        }
+
+        Histogram& histogram = m_histograms[stage];
+        histogram.buckets[GetBucketIndex(durationUs)].fetch_add(1, std::memory_order_relaxed);
+        histogram.sumUs.fetch_add(durationUs, std::memory_order_relaxed);
+
+        uint64_t current = histogram.minUs.load(std::memory_order_relaxed);
+        while (durationUs < current && !histogram.minUs.compare_exchange_weak(current, durationUs, std::memory_order_relaxed))
+        {
+        }
+        current = histogram.maxUs.load(std::memory_order_relaxed);
+        while (durationUs > current && !histogram.maxUs.compare_exchange_weak(current, durationUs, std::memory_order_relaxed))
+        {
+        }
+
+        if (m_debugEvents.load(std::memory_order_relaxed))
+        {
+            m_logManager.DispatchEvent(DebugEvent(DebugEventType::EVT_PIPELINE_LATENCY, static_cast<size_t>(stage), static_cast<size_t>(durationUs)));
+        }
+    }
+
+    void PipelineLatencyRecorder::GetLatencies(std::vector<PipelineStageLatency>& stages, bool reset)
+    {
+        static const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+        stages.clear();
+        stages.reserve(PipelineStage_Count);
+        for (size_t i = 0; i < PipelineStage_Count; i++)
+        {
+            Histogram& histogram = m_histograms[i];
+
+            // Counters are read one by one: with concurrent writers the snapshot may miss samples
+            // in flight, so the count is derived from the buckets to keep percentiles consistent.
+            uint64_t buckets[BucketCount];
+            uint64_t count = 0;
+            for (size_t b = 0; b < BucketCount; b++)
+            {
+                buckets[b] = reset ? histogram.buckets[b].exchange(0) : histogram.buckets[b].load();
+                count += buckets[b];
+            }
+            uint64_t sumUs = reset ? histogram.sumUs.exchange(0) : histogram.sumUs.load();
+            uint64_t minUs = reset ? histogram.minUs.exchange(std::numeric_limits<uint64_t>::max()) : histogram.minUs.load();
+            uint64_t maxUs = reset ? histogram.maxUs.exchange(0) : histogram.maxUs.load();
+
+            PipelineStageLatency latency {};
+            latency.stage = static_cast<PipelineStage>(i);
+            latency.name = GetStageName(latency.stage);
+            latency.count = count;
+            if (count != 0)
+            {
+                minUs = (minUs > maxUs) ? maxUs : minUs;
+                latency.minUs = minUs;
+                latency.maxUs = maxUs;
+                latency.meanUs = static_cast<double>(sumUs) / static_cast<double>(count);
+
+                uint64_t* results[] = { &latency.p50Us, &latency.p90Us, &latency.p99Us, &latency.p999Us };
+                size_t bucket = 0;
+                uint64_t seen = 0;
+                for (size_t p = 0; p < sizeof(percentiles) / sizeof(percentiles[0]); p++)
+                {
+                    uint64_t rank = static_cast<uint64_t>(percentiles[p] * static_cast<double>(count) + 0.5);
+                    rank = (rank == 0) ? 1 : rank;
+                    while (bucket < BucketCount - 1 && seen + buckets[bucket] < rank)
+                    {
+                        seen += buckets[bucket++];
+                    }
+                    // Report the highest value of the bucket, clipped to the observed range
+                    uint64_t value = (bucket + 1 < BucketCount) ? static_cast<uint64_t>(LogLinearHistogram::GetBucketLowerBound(bucket + 1)) - 1 : maxUs;
+                    value = (value > maxUs) ? maxUs : value;
+                    *results[p] = (value < minUs) ? minUs : value;
+                }
+            }
+            stages.push_back(latency);
+        }
+    }
+
+    const char* PipelineLatencyRecorder::GetStageName(PipelineStage stage)
+    {
+        switch (stage)
+        {
+        case PipelineStage_Decorate:
+            return "decorate";
+        case PipelineStage_Serialize:
+            return "serialize";
+        case PipelineStage_Store:
+            return "store";
+        case PipelineStage_Retrieve:
+            return "retrieve";
+        case PipelineStage_Package:
+            return "package";
+        case PipelineStage_Compress:
+            return "compress";
+        case PipelineStage_Encode:
+            return "encode";
+        case PipelineStage_Send:
+            return "send";
+        case PipelineStage_Response:
+            return "response";
+        default:
+            return "unknown";
+        }
+    }
+
+} MAT_NS_END
@@ -0,0 +1,198 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef PIPELINELATENCYRECORDER_HPP
+#define PIPELINELATENCYRECORDER_HPP
+
+#include "pal/PAL.hpp"
+
+#include "ILogManager.hpp"
+#include "api/IRuntimeConfig.hpp"
+#include "PipelineLatency.hpp"
+
+#include "system/Contexts.hpp"
+#include "system/Route.hpp"
+
+#include <atomic>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Lock-free per-stage latency histograms of the event pipeline.
+    /// Every stage keeps atomic sum, minimum, maximum and log-linear bucket counters
+    /// (see LogLinearHistogram), so recording a sample from any thread is a handful of relaxed
+    /// atomic increments. Durations are in microseconds of a monotonic clock.
+    /// </summary>
+    class PipelineLatencyRecorder
+    {
+    public:
+        /// <summary>
+        /// Durations of 2^MaxExponent microseconds (about 36 minutes) and above share the last bucket.
+        /// </summary>
+        static constexpr unsigned MaxExponent = 31;
+        static constexpr size_t   BucketCount = 16 * (MaxExponent - 4) + 16;
+
+        PipelineLatencyRecorder(ILogManager& logManager);
+
+        PipelineLatencyRecorder(PipelineLatencyRecorder const&) = delete;
+        PipelineLatencyRecorder& operator=(PipelineLatencyRecorder const&) = delete;
+
+        /// <summary>
+        /// Reads the CFG_MAP_PIPELINE_LATENCY settings.
+        /// </summary>
+        void Configure(IRuntimeConfig& config);
+
+        bool IsEnabled() const
+        {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Current monotonic timestamp in microseconds.
+        /// </summary>
+        static uint64_t Now();
+
+        /// <summary>
+        /// Adds a sample to the histogram of a stage and optionally dispatches an EVT_PIPELINE_LATENCY DebugEvent.
+        /// </summary>
+        void Record(PipelineStage stage, uint64_t durationUs);
+
+        /// <summary>
+        /// Fills in the statistics of all stages, optionally clearing the histograms.
+        /// </summary>
+        void GetLatencies(std::vector<PipelineStageLatency>& stages, bool reset);
+
+        static const char* GetStageName(PipelineStage stage);
+
+        static size_t GetBucketIndex(uint64_t durationUs);
+
+    protected:
+        struct Histogram
+        {
+            std::atomic<uint64_t> sumUs;
+            std::atomic<uint64_t> minUs;
+            std::atomic<uint64_t> maxUs;
+            std::atomic<uint64_t> buckets[BucketCount];
+        };
+
+        static void clear(Histogram& histogram);
+
+        ILogManager&       m_logManager;
+        std::atomic<bool>  m_enabled;
+        std::atomic<bool>  m_debugEvents;
+        Histogram          m_histograms[PipelineStage_Count];
+    };
+
+    /// <summary>
+    /// Times a scope and records it under a pipeline stage. A null or disabled recorder makes it a no-op.
+    /// </summary>
+    class PipelineLatencyTimer
+    {
+    public:
+        PipelineLatencyTimer(PipelineLatencyRecorder* recorder, PipelineStage stage) :
+            m_recorder((recorder != nullptr && recorder->IsEnabled()) ? recorder : nullptr),
+            m_stage(stage),
+            m_startUs((m_recorder != nullptr) ? PipelineLatencyRecorder::Now() : 0)
+        {
+        }
+
+        ~PipelineLatencyTimer()
+        {
+            if (m_recorder != nullptr)
+            {
+                m_recorder->Record(m_stage, PipelineLatencyRecorder::Now() - m_startUs);
+            }
+        }
+
+        PipelineLatencyTimer(PipelineLatencyTimer const&) = delete;
+        PipelineLatencyTimer& operator=(PipelineLatencyTimer const&) = delete;
+
+    protected:
+        PipelineLatencyRecorder* m_recorder;
+        PipelineStage            m_stage;
+        uint64_t                 m_startUs;
+    };
+
+    /// <summary>
+    /// Route hops that timestamp events and uploads as they flow through TelemetrySystem.
+    /// A "started" hop stamps the context; a stage hop records the time elapsed since the
+    /// previous stamp under its stage and stamps the context again for the next stage.
+    /// </summary>
+    class PipelineLatencyHops
+    {
+    public:
+        PipelineLatencyHops(PipelineLatencyRecorder& recorder) :
+            m_recorder(recorder)
+        {
+        }
+
+    protected:
+        bool handleIncomingStarted(IncomingEventContextPtr const& ctx)
+        {
+            ctx->stageStartUs = m_recorder.IsEnabled() ? PipelineLatencyRecorder::Now() : 0;
+            return true;
+        }
+
+        template<PipelineStage Stage>
+        bool handleIncomingStage(IncomingEventContextPtr const& ctx)
+        {
+            ctx->stageStartUs = lap(Stage, ctx->stageStartUs);
+            return true;
+        }
+
+        template<PipelineStage Stage>
+        bool handleIncomingBatchStage(IncomingEventContextBatch const& events)
+        {
+            for (auto const& ctx : events)
+            {
+                ctx->stageStartUs = lap(Stage, ctx->stageStartUs);
+            }
+            return true;
+        }
+
+        bool handleUploadStarted(EventsUploadContextPtr const& ctx)
+        {
+            ctx->stageStartUs = m_recorder.IsEnabled() ? PipelineLatencyRecorder::Now() : 0;
+            return true;
+        }
+
+        template<PipelineStage Stage>
+        bool handleUploadStage(EventsUploadContextPtr const& ctx)
+        {
+            ctx->stageStartUs = lap(Stage, ctx->stageStartUs);
+            return true;
+        }
+
+        uint64_t lap(PipelineStage stage, uint64_t startUs)
+        {
+            if (startUs == 0 || !m_recorder.IsEnabled())
+            {
+                return 0;
+            }
+            uint64_t now = PipelineLatencyRecorder::Now();
+            m_recorder.Record(stage, (now > startUs) ? (now - startUs) : 0);
+            return now;
+        }
+
+        PipelineLatencyRecorder& m_recorder;
+
+    public:
+        RoutePassThrough<PipelineLatencyHops, IncomingEventContextPtr const&> incomingStarted{ this, &PipelineLatencyHops::handleIncomingStarted };
+        RoutePassThrough<PipelineLatencyHops, IncomingEventContextPtr const&> serialized{ this, &PipelineLatencyHops::handleIncomingStage<PipelineStage_Serialize> };
+        RoutePassThrough<PipelineLatencyHops, IncomingEventContextPtr const&> stored{ this, &PipelineLatencyHops::handleIncomingStage<PipelineStage_Store> };
+        RoutePassThrough<PipelineLatencyHops, IncomingEventContextBatch const&> batchStored{ this, &PipelineLatencyHops::handleIncomingBatchStage<PipelineStage_Store> };
+
+        RoutePassThrough<PipelineLatencyHops, EventsUploadContextPtr const&>  uploadStarted{ this, &PipelineLatencyHops::handleUploadStarted };
+        RoutePassThrough<PipelineLatencyHops, EventsUploadContextPtr const&>  retrieved{ this, &PipelineLatencyHops::handleUploadStage<PipelineStage_Retrieve> };
+        RoutePassThrough<PipelineLatencyHops, EventsUploadContextPtr const&>  packaged{ this, &PipelineLatencyHops::handleUploadStage<PipelineStage_Package> };
+        RoutePassThrough<PipelineLatencyHops, EventsUploadContextPtr const&>  compressed{ this, &PipelineLatencyHops::handleUploadStage<PipelineStage_Compress> };
+        RoutePassThrough<PipelineLatencyHops, EventsUploadContextPtr const&>  encoded{ this, &PipelineLatencyHops::handleUploadStage<PipelineStage_Encode> };
+        RoutePassThrough<PipelineLatencyHops, EventsUploadContextPtr const&>  sent{ this, &PipelineLatencyHops::handleUploadStage<PipelineStage_Send> };
+        RoutePassThrough<PipelineLatencyHops, EventsUploadContextPtr const&>  responded{ this, &PipelineLatencyHops::handleUploadStage<PipelineStage_Response> };
+    };
+
+} MAT_NS_END
+
+#endif // PIPELINELATENCYRECORDER_HPP
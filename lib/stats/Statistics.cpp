@@ -156,6 +156,48 @@ namespace MAT_NS_BEGIN {
         return true;
     }
 
+    bool Statistics::handleOnIncomingEventsAccepted(IncomingEventContextBatch const& events)
+    {
+        std::string metaStatsToken = m_config.GetMetaStatsTenantToken();
+        {
+            LOCKGUARD(m_metaStats_mtx);
+            for (auto const& ctx : events)
+            {
+                bool metastats = (ctx->record.tenantToken == metaStatsToken);
+                m_metaStats.updateOnEventIncoming(ctx->record.tenantToken, static_cast<unsigned>(ctx->record.blob.size()), ctx->record.latency, metastats);
+            }
+        }
+        scheduleSend();
+
+        DebugEvent evt;
+        evt.type = DebugEventType::EVT_ADDED;
+        evt.param1 = events.size();
+        OnDebugEvent(evt);
+
+        return true;
+    }
+
+    bool Statistics::handleOnIncomingEventsFailed(IncomingEventContextBatch const& events)
+    {
+        std::map<std::string, size_t> failedData;
+        for (auto const& ctx : events)
+        {
+            failedData[ctx->record.tenantToken]++;
+        }
+        {
+            LOCKGUARD(m_metaStats_mtx);
+            m_metaStats.updateOnRecordsDropped(DROPPED_REASON_OFFLINE_STORAGE_SAVE_FAILED, failedData);
+        }
+        scheduleSend();
+
+        DebugEvent evt;
+        evt.type = DebugEventType::EVT_DROPPED;
+        evt.param1 = events.size();
+        OnDebugEvent(evt);
+
+        return true;
+    }
+
     bool Statistics::handleOnUploadStarted(EventsUploadContextPtr const& ctx)
     {
         bool metastatsOnly = (ctx->packageIds.count(m_config.GetMetaStatsTenantToken()) == ctx->packageIds.size());
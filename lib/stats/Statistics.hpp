@@ -43,6 +43,8 @@ namespace MAT_NS_BEGIN {
         bool handleOnIncomingEventAccepted(IncomingEventContextPtr const& ctx);
         // bool handleOnIncomingEventRejected(DebugEvent &evt); 
         bool handleOnIncomingEventFailed(IncomingEventContextPtr const& ctx);
+        bool handleOnIncomingEventsAccepted(IncomingEventContextBatch const& events);
+        bool handleOnIncomingEventsFailed(IncomingEventContextBatch const& events);
 
         bool handleOnUploadStarted(EventsUploadContextPtr const& ctx);
         bool handleOnPackagingFailed(EventsUploadContextPtr const& ctx);
@@ -85,6 +87,8 @@ namespace MAT_NS_BEGIN {
 #if 1   // TODO: [MG] - verify this codepath
         RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventAccepted{ this, &Statistics::handleOnIncomingEventAccepted };
         RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventFailed{ this, &Statistics::handleOnIncomingEventFailed };
+        RoutePassThrough<Statistics, IncomingEventContextBatch const&>  onIncomingEventsAccepted{ this, &Statistics::handleOnIncomingEventsAccepted };
+        RoutePassThrough<Statistics, IncomingEventContextBatch const&>  onIncomingEventsFailed{ this, &Statistics::handleOnIncomingEventsFailed };
 #else
         bool dummy_IncomingEventContextPtr(IncomingEventContextPtr const& ctx)
         {
@@ -94,6 +98,15 @@ namespace MAT_NS_BEGIN {
 
         RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventAccepted{ this, &Statistics::dummy_IncomingEventContextPtr };
         RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventFailed{ this, &Statistics::dummy_IncomingEventContextPtr };
+
+        bool dummy_IncomingEventContextBatch(IncomingEventContextBatch const& events)
+        {
+            UNREFERENCED_PARAMETER(events);
+            return true;
+        }
+
+        RoutePassThrough<Statistics, IncomingEventContextBatch const&>  onIncomingEventsAccepted{ this, &Statistics::dummy_IncomingEventContextBatch };
+        RoutePassThrough<Statistics, IncomingEventContextBatch const&>  onIncomingEventsFailed{ this, &Statistics::dummy_IncomingEventContextBatch };
 #endif
 
 #if 1   // TODO: [MG] - verify this codepath
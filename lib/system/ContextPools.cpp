@@ -0,0 +1,268 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "ContextPools.hpp"
+
+namespace MAT_NS_BEGIN
+{
+    // Enough for the loggers of a busy process, most records and contexts are a few KB at most
+    constexpr static size_t kMaxPooledEvents = 64;
+    constexpr static size_t kMaxPooledEventBytes = 1024 * 1024;
+
+    // Uploads run on the worker thread, a few of them at most are in flight
+    constexpr static size_t kMaxPooledUploads = 4;
+    constexpr static size_t kMaxPooledUploadBytes = 4 * 1024 * 1024;
+
+    template<typename TVector>
+    static size_t clearKeepingCapacity(TVector& vector)
+    {
+        vector.clear();
+        return vector.capacity() * sizeof(typename TVector::value_type);
+    }
+
+    static size_t clearKeepingCapacity(std::string& value)
+    {
+        value.clear();
+        return value.capacity();
+    }
+
+    // Every logged event gets one of these extensions from the decorators, which fill in element 0.
+    // The element is kept with its fields reset so that its strings keep their buffers.
+    static size_t resetKeepingCapacity(::CsProtocol::App& app)
+    {
+        size_t bytes = clearKeepingCapacity(app.expId);
+        bytes += clearKeepingCapacity(app.userId);
+        bytes += clearKeepingCapacity(app.env);
+        app.asId = 0;
+        bytes += clearKeepingCapacity(app.id);
+        bytes += clearKeepingCapacity(app.ver);
+        bytes += clearKeepingCapacity(app.locale);
+        bytes += clearKeepingCapacity(app.name);
+#ifdef HAVE_CS4
+        bytes += clearKeepingCapacity(app.sesId);
+#endif
+        return bytes;
+    }
+
+    static size_t resetKeepingCapacity(::CsProtocol::Device& device)
+    {
+        size_t bytes = clearKeepingCapacity(device.id);
+        bytes += clearKeepingCapacity(device.localId);
+        bytes += clearKeepingCapacity(device.authId);
+        bytes += clearKeepingCapacity(device.authSecId);
+        bytes += clearKeepingCapacity(device.deviceClass);
+        bytes += clearKeepingCapacity(device.orgId);
+        bytes += clearKeepingCapacity(device.orgAuthId);
+        bytes += clearKeepingCapacity(device.make);
+        bytes += clearKeepingCapacity(device.model);
+#ifdef HAVE_CS4
+        bytes += clearKeepingCapacity(device.authIdEnt);
+#endif
+        return bytes;
+    }
+
+    static size_t resetKeepingCapacity(::CsProtocol::Os& os)
+    {
+        size_t bytes = clearKeepingCapacity(os.locale);
+        bytes += clearKeepingCapacity(os.expId);
+        os.bootId = 0;
+        bytes += clearKeepingCapacity(os.name);
+        bytes += clearKeepingCapacity(os.ver);
+        return bytes;
+    }
+
+    static size_t resetKeepingCapacity(::CsProtocol::User& user)
+    {
+        size_t bytes = clearKeepingCapacity(user.id);
+        bytes += clearKeepingCapacity(user.localId);
+        bytes += clearKeepingCapacity(user.authId);
+        bytes += clearKeepingCapacity(user.locale);
+        return bytes;
+    }
+
+    static size_t resetKeepingCapacity(::CsProtocol::Loc& loc)
+    {
+        size_t bytes = clearKeepingCapacity(loc.id);
+        bytes += clearKeepingCapacity(loc.country);
+        bytes += clearKeepingCapacity(loc.timezone);
+        return bytes;
+    }
+
+    static size_t resetKeepingCapacity(::CsProtocol::Net& net)
+    {
+        size_t bytes = clearKeepingCapacity(net.provider);
+        bytes += clearKeepingCapacity(net.cost);
+        bytes += clearKeepingCapacity(net.type);
+        return bytes;
+    }
+
+    static size_t resetKeepingCapacity(::CsProtocol::Protocol& protocol)
+    {
+        protocol.metadataCrc = 0;
+        // Only events of loggers with tickets have ticket keys
+        protocol.ticketKeys.clear();
+        size_t bytes = clearKeepingCapacity(protocol.devMake);
+        bytes += clearKeepingCapacity(protocol.devModel);
+#ifdef HAVE_CS4
+        protocol.msp = 0;
+#endif
+        return bytes;
+    }
+
+    static size_t resetKeepingCapacity(::CsProtocol::Sdk& sdk)
+    {
+        size_t bytes = clearKeepingCapacity(sdk.libVer);
+#ifdef HAVE_CS4
+        bytes += clearKeepingCapacity(sdk.ver);
+#endif
+        bytes += clearKeepingCapacity(sdk.epoch);
+        sdk.seq = 0;
+        bytes += clearKeepingCapacity(sdk.installId);
+        return bytes;
+    }
+
+    static size_t resetKeepingCapacity(::CsProtocol::M365a& m365a)
+    {
+        size_t bytes = clearKeepingCapacity(m365a.enrolledTenantId);
+#ifdef HAVE_CS4
+        m365a.msp = 0;
+#endif
+        return bytes;
+    }
+
+    static size_t resetKeepingCapacity(::CsProtocol::Data& data)
+    {
+        // Map nodes cannot be kept without their keys
+        data.properties.clear();
+        return 0;
+    }
+
+    template<typename T>
+    static size_t resetFirstKeepingCapacity(std::vector<T>& vector)
+    {
+        if (vector.size() > 1)
+        {
+            vector.resize(1);
+        }
+        size_t bytes = vector.capacity() * sizeof(T);
+        if (!vector.empty())
+        {
+            bytes += resetKeepingCapacity(vector[0]);
+        }
+        return bytes;
+    }
+
+    ObjectPool<::CsProtocol::Record>& ContextPools::Records()
+    {
+        static auto* pool = new ObjectPool<::CsProtocol::Record>(kMaxPooledEvents, kMaxPooledEventBytes, &ContextPools::RecycleRecord);
+        return *pool;
+    }
+
+    ObjectPool<IncomingEventContext>& ContextPools::IncomingEventContexts()
+    {
+        static auto* pool = new ObjectPool<IncomingEventContext>(kMaxPooledEvents, kMaxPooledEventBytes, &ContextPools::RecycleIncomingEventContext);
+        return *pool;
+    }
+
+    ObjectPool<EventsUploadContext>& ContextPools::EventsUploadContexts()
+    {
+        static auto* pool = new ObjectPool<EventsUploadContext>(kMaxPooledUploads, kMaxPooledUploadBytes, &ContextPools::RecycleEventsUploadContext);
+        return *pool;
+    }
+
+    EventsUploadContextPtr ContextPools::AcquireEventsUploadContext()
+    {
+        ObjectPool<EventsUploadContext>::Ptr context = EventsUploadContexts().Acquire();
+        return EventsUploadContextPtr(context.release(), context.get_deleter());
+    }
+
+    size_t ContextPools::RecycleRecord(::CsProtocol::Record& record)
+    {
+        size_t bytes = sizeof(record);
+        bytes += clearKeepingCapacity(record.ver);
+        bytes += clearKeepingCapacity(record.name);
+        record.time = 0;
+        record.popSample = 100;
+        bytes += clearKeepingCapacity(record.iKey);
+        record.flags = 0;
+        bytes += clearKeepingCapacity(record.cV);
+#ifdef HAVE_CS4_FULL
+        bytes += clearKeepingCapacity(record.extIngest);
+#endif
+        bytes += resetFirstKeepingCapacity(record.extProtocol);
+        bytes += resetFirstKeepingCapacity(record.extUser);
+        bytes += resetFirstKeepingCapacity(record.extDevice);
+        bytes += resetFirstKeepingCapacity(record.extOs);
+        bytes += resetFirstKeepingCapacity(record.extApp);
+        bytes += clearKeepingCapacity(record.extUtc);
+#ifdef HAVE_CS4_FULL
+        bytes += clearKeepingCapacity(record.extXbl);
+        bytes += clearKeepingCapacity(record.extJavascript);
+        bytes += clearKeepingCapacity(record.extReceipts);
+#endif
+        bytes += resetFirstKeepingCapacity(record.extNet);
+        bytes += resetFirstKeepingCapacity(record.extSdk);
+        bytes += resetFirstKeepingCapacity(record.extLoc);
+#ifdef HAVE_CS4_FULL
+        bytes += clearKeepingCapacity(record.extCloud);
+        bytes += clearKeepingCapacity(record.extService);
+        bytes += clearKeepingCapacity(record.extCs);
+#endif
+        bytes += resetFirstKeepingCapacity(record.extM365a);
+        bytes += clearKeepingCapacity(record.ext);
+#ifdef HAVE_CS4_FULL
+        bytes += clearKeepingCapacity(record.extMscv);
+        bytes += clearKeepingCapacity(record.extIntWeb);
+        bytes += clearKeepingCapacity(record.extIntService);
+        bytes += clearKeepingCapacity(record.extWeb);
+#endif
+        record.tags.clear();
+        bytes += clearKeepingCapacity(record.baseType);
+        bytes += clearKeepingCapacity(record.baseData);
+        bytes += resetFirstKeepingCapacity(record.data);
+        return bytes;
+    }
+
+    size_t ContextPools::RecycleIncomingEventContext(IncomingEventContext& context)
+    {
+        size_t bytes = sizeof(context);
+        context.source = nullptr;
+        context.policyBitFlags = 0;
+        context.stageStartUs = 0;
+        StorageRecord& record = context.record;
+        bytes += clearKeepingCapacity(record.id);
+        bytes += clearKeepingCapacity(record.tenantToken);
+        record.latency = EventLatency_Unspecified;
+        record.persistence = EventPersistence_Normal;
+        record.timestamp = 0;
+        bytes += clearKeepingCapacity(record.blob);
+        record.retryCount = 0;
+        record.reservedUntil = 0;
+        return bytes;
+    }
+
+    size_t ContextPools::RecycleEventsUploadContext(EventsUploadContext& context)
+    {
+        size_t bytes = sizeof(context);
+        context.clear();
+        context.requestedMinLatency = EventLatency_Unspecified;
+        context.requestedMaxCount = 0;
+        context.splicer->clear();
+        context.maxUploadSize = 0;
+        context.latency = EventLatency_Unspecified;
+        context.packageIds.clear();
+        context.recordIdsAndTenantIds.clear();
+        bytes += clearKeepingCapacity(context.recordTimestamps);
+        context.maxRetryCountSeen = 0;
+        context.packagingMemory.Reset();
+        bytes += clearKeepingCapacity(context.body);
+        context.compressed = false;
+        bytes += clearKeepingCapacity(context.httpRequestId);
+        context.durationMs = -1;
+        context.fromMemory = false;
+        context.stageStartUs = 0;
+        return bytes;
+    }
+
+} MAT_NS_END
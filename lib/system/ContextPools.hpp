@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef CONTEXTPOOLS_HPP
+#define CONTEXTPOOLS_HPP
+
+#include "system/Contexts.hpp"
+#include "utils/ObjectPool.hpp"
+
+#include "CsProtocol_types.hpp"
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Process-wide pools of the per-event and per-upload objects, so that the steady state
+    /// of logging and uploading reuses their buffers instead of allocating new ones.
+    /// </summary>
+    /// <remarks>
+    /// The pools are never destroyed, so that objects released during static destruction,
+    /// e.g. by a LogManager torn down at exit, are safe to return.
+    /// </remarks>
+    class ContextPools
+    {
+    public:
+        static ObjectPool<::CsProtocol::Record>& Records();
+        static ObjectPool<IncomingEventContext>& IncomingEventContexts();
+        static ObjectPool<EventsUploadContext>& EventsUploadContexts();
+
+        /// <summary>
+        /// Takes an upload context from the pool, returned to it when the last reference is released
+        /// </summary>
+        static EventsUploadContextPtr AcquireEventsUploadContext();
+
+        /// <summary>
+        /// Resets a record for reuse, keeping its string and vector capacity
+        /// </summary>
+        /// <returns>Estimate of the bytes the record keeps allocated</returns>
+        static size_t RecycleRecord(::CsProtocol::Record& record);
+        static size_t RecycleIncomingEventContext(IncomingEventContext& context);
+        static size_t RecycleEventsUploadContext(EventsUploadContext& context);
+    };
+
+} MAT_NS_END
+
+#endif // CONTEXTPOOLS_HPP
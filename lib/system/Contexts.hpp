@@ -9,6 +9,7 @@
 #include "packager/ISplicer.hpp"
 #include "packager/BondSplicer.hpp"
 #include "pal/PAL.hpp"
+#include "system/MemoryBudget.hpp"
 #include "utils/Utils.hpp"
 
 #include <map>
@@ -24,18 +25,21 @@ namespace MAT_NS_BEGIN {
         ::CsProtocol::Record*  source;
         StorageRecord          record;
         std::uint64_t          policyBitFlags;
+        std::uint64_t          stageStartUs;
 
     public:
         IncomingEventContext() :
             source(nullptr),
-            policyBitFlags(0)
+            policyBitFlags(0),
+            stageStartUs(0)
         {
         }
 
         IncomingEventContext(std::string const& id, std::string const& tenantToken, EventLatency latency, EventPersistence persistence, ::CsProtocol::Record* source)
             : source(source),
             record{ id, tenantToken, latency, persistence },
-	    policyBitFlags(0)
+	    policyBitFlags(0),
+            stageStartUs(0)
         {
         }
 
@@ -46,6 +50,8 @@ namespace MAT_NS_BEGIN {
 
     typedef IncomingEventContext* IncomingEventContextPtr;
 
+    typedef std::vector<IncomingEventContextPtr> IncomingEventContextBatch;
+
     //---
 
     class EventsUploadContext {
@@ -91,6 +97,7 @@ namespace MAT_NS_BEGIN {
         std::map<std::string, std::string>   recordIdsAndTenantIds;
         std::vector<int64_t>                 recordTimestamps;
         unsigned                             maxRetryCountSeen = 0;
+        MemoryCharge                         packagingMemory;
 
         // Encoding
         std::vector<uint8_t>                 body;
@@ -106,6 +113,9 @@ namespace MAT_NS_BEGIN {
         int                                  durationMs = -1;
         bool                                 fromMemory = false;
 
+        // Pipeline latency: monotonic start of the current stage in microseconds, 0 if not tracked
+        uint64_t                             stageStartUs = 0;
+
         EventsUploadContext() noexcept : 
             EventsUploadContext(std::unique_ptr<ISplicer>(new BondSplicer()))
         {
@@ -35,16 +35,14 @@ namespace MAT_NS_BEGIN {
     {
         for (auto &kv : properties)
         {
-            auto key = kv.first;
-            auto val = kv.second;
-            m_storage->properties[key] = val;
+            m_storage->setProperty(kv.first, EventProperty(kv.second));
         }
         return (*this);
     }
 
     EventProperties& EventProperties::operator=(const std::map<std::string, EventProperty> &properties)
     {
-        m_storage->properties.clear();
+        m_storage->clearProperties();
         (*this) += properties;
         return (*this);
     }
@@ -83,6 +81,28 @@ namespace MAT_NS_BEGIN {
         SetLevel(diagnosticLevel);
     }
 
+    EventProperties::EventProperties(const string& name, PropertyStorageMode storageMode, size_t expectedPropertyCount)
+        : m_storage(new EventPropertiesStorage())
+    {
+        if (storageMode == PropertyStorageMode_Flat)
+        {
+            m_storage->useFlatStorage = true;
+            // Level is always set below, reserve room for it as well.
+            // 32 bytes per property covers typical names plus short string values.
+            m_storage->flatProperties.reserve(expectedPropertyCount + 1, (expectedPropertyCount + 1) * 32);
+        }
+
+        if (!name.empty())
+        {
+            SetName(name);
+        }
+        else {
+            SetName(DefaultEventName);
+        }
+
+        SetLevel(DIAG_LEVEL_OPTIONAL);
+    }
+
     EventProperties::EventProperties(EventProperties const& copy)
     {
         m_storage = new EventPropertiesStorage(*copy.m_storage);
@@ -114,15 +134,12 @@ namespace MAT_NS_BEGIN {
     /// </summary>
     EventProperties& EventProperties::operator=(std::initializer_list<std::pair<std::string const, EventProperty> > properties)
     {
-        m_storage->properties.clear();
+        m_storage->clearProperties();
         m_storage->propertiesPartB.clear();
 
         for (auto &kv : properties)
         {
-            auto key = kv.first;
-            auto val = kv.second;
-
-            m_storage->properties[key] = val;
+            m_storage->setProperty(kv.first, EventProperty(kv.second));
         }
 
         return (*this);
@@ -310,11 +327,28 @@ namespace MAT_NS_BEGIN {
 
     std::tuple<bool, uint8_t> EventProperties::TryGetLevel() const
     {
-        const auto& findResult = GetProperties().find(COMMONFIELDS_EVENT_LEVEL);
-        if (findResult == GetProperties().cend())
+        const EventProperty* found = nullptr;
+        if (m_storage->useFlatStorage)
+        {
+            static const size_t levelLength = sizeof(COMMONFIELDS_EVENT_LEVEL) - 1;
+            const FlatProperty* entry = m_storage->flatProperties.find(COMMONFIELDS_EVENT_LEVEL, levelLength);
+            if ((entry != nullptr) && !entry->isString)
+            {
+                found = &entry->value;
+            }
+        }
+        else
+        {
+            const auto& findResult = m_storage->properties.find(COMMONFIELDS_EVENT_LEVEL);
+            if (findResult != m_storage->properties.cend())
+            {
+                found = &findResult->second;
+            }
+        }
+        if (found == nullptr)
             return std::make_tuple<bool, uint8_t>(false, 0);
-        
-        const auto& property = findResult->second;
+
+        const auto& property = *found;
         if (property.type != EventProperty::TYPE_INT64)
             return std::make_tuple<bool, uint8_t>(false, 0);
 
@@ -344,7 +378,73 @@ namespace MAT_NS_BEGIN {
             return;
         }
 
-        m_storage->properties[name] = prop;
+        m_storage->setProperty(name, std::move(prop));
+    }
+
+    /// <summary>
+    /// Validates a property name, broadcasting EVT_REJECTED if it is invalid.
+    /// </summary>
+    static bool acceptPropertyName(string_view_t name)
+    {
+        EventRejectedReason isValidPropertyName = validatePropertyName(name.data, name.size);
+        if (isValidPropertyName != REJECTED_REASON_OK)
+        {
+            LOG_ERROR("Context name is invalid: %.*s", static_cast<int>(std::min<size_t>(name.size, 256)), name.data);
+            DebugEvent evt;
+            evt.type = DebugEventType::EVT_REJECTED;
+            evt.param1 = isValidPropertyName;
+            ILogManager::DispatchEventBroadcast(evt);
+            return false;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Specify a property of an event from a non-owning name
+    /// It creates a new property if none exists or overwrites an existing one
+    /// </summary>
+    void EventProperties::setPropertyView(string_view_t name, EventProperty&& prop)
+    {
+        if (!acceptPropertyName(name))
+        {
+            return;
+        }
+
+        if (m_storage->useFlatStorage)
+        {
+            m_storage->setFlatProperty(name.data, name.size, std::move(prop), name.is_static);
+        }
+        else
+        {
+            m_storage->setProperty(name.str(), std::move(prop));
+        }
+    }
+
+    void EventProperties::SetPropertyView(string_view_t name, string_view_t value, PiiKind piiKind, DataCategory category)
+    {
+        if (!m_storage->useFlatStorage)
+        {
+            setPropertyView(name, EventProperty(value.str(), piiKind, category));
+            return;
+        }
+
+        // Flat storage copies the value straight into the arena, skipping the intermediate EventProperty string
+        if (!acceptPropertyName(name))
+        {
+            return;
+        }
+        m_storage->flatProperties.setString(name.data, name.size, value.data, value.size, piiKind, category, name.is_static);
+    }
+
+    void EventProperties::SetPropertyView(string_view_t name, double       value, PiiKind piiKind, DataCategory category) { setPropertyView(name, EventProperty(value, piiKind, category)); }
+    void EventProperties::SetPropertyView(string_view_t name, int64_t      value, PiiKind piiKind, DataCategory category) { setPropertyView(name, EventProperty(value, piiKind, category)); }
+    void EventProperties::SetPropertyView(string_view_t name, bool         value, PiiKind piiKind, DataCategory category) { setPropertyView(name, EventProperty(value, piiKind, category)); }
+    void EventProperties::SetPropertyView(string_view_t name, time_ticks_t value, PiiKind piiKind, DataCategory category) { setPropertyView(name, EventProperty(value, piiKind, category)); }
+    void EventProperties::SetPropertyView(string_view_t name, GUID_t       value, PiiKind piiKind, DataCategory category) { setPropertyView(name, EventProperty(value, piiKind, category)); }
+
+    PropertyStorageMode EventProperties::GetStorageMode() const
+    {
+        return m_storage->useFlatStorage ? PropertyStorageMode_Flat : PropertyStorageMode_Map;
     }
 
     //
@@ -365,6 +465,7 @@ namespace MAT_NS_BEGIN {
     {
         if (category == DataCategory_PartC)
         {
+            m_storage->materializeFlatProperties();
             return m_storage->properties;
         }
         else
@@ -373,12 +474,21 @@ namespace MAT_NS_BEGIN {
         }
     }
 
+    const FlatProperties* EventProperties::GetFlatProperties() const
+    {
+        return m_storage->useFlatStorage ? &m_storage->flatProperties : nullptr;
+    }
+
     /// <summary>
     /// Erase property from event.
     /// </summary>
     size_t EventProperties::erase(const std::string& key, DataCategory category)
     {
         size_t result = 0;
+        if (m_storage->useFlatStorage && (category == DataCategory_PartC))
+        {
+            return m_storage->flatProperties.erase(key.data(), key.length());
+        }
         auto &props = (category == DataCategory_PartC) ? m_storage->properties : m_storage->propertiesPartB;
         result = props.erase(key);
         return result;
@@ -391,7 +501,7 @@ namespace MAT_NS_BEGIN {
     const map<string, pair<string, PiiKind> > EventProperties::GetPiiProperties(DataCategory category) const
     {
         std::map<string, pair<string, PiiKind> > pIIExtensions;
-        auto &props = (category == DataCategory_PartC) ? m_storage->properties : m_storage->propertiesPartB;
+        auto &props = GetProperties(category);
         for (const auto &kv : props)
         {
             auto k = kv.first;
@@ -448,6 +558,7 @@ namespace MAT_NS_BEGIN {
 
     evt_prop* EventProperties::pack()
     {
+        m_storage->materializeFlatProperties();
         size_t size = m_storage->properties.size() + m_storage->propertiesPartB.size() + 1;
         evt_prop * result = static_cast<evt_prop *>(calloc(sizeof(evt_prop), size));
         if (result==nullptr)
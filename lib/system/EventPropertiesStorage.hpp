@@ -3,8 +3,13 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "Enums.hpp"
 #include "EventProperty.hpp"
@@ -14,6 +19,326 @@
 
 namespace MAT_NS_BEGIN {
 
+    /// <summary>
+    /// Bump allocator for property names and string values of EventProperties
+    /// that use flat storage. Memory is only released when the arena is reset
+    /// or destroyed, so that building an event does not allocate per property.
+    /// </summary>
+    class PropertyArena
+    {
+    public:
+        static const size_t MinChunkSize = 512;
+
+        PropertyArena() noexcept :
+            m_cursor(nullptr),
+            m_remaining(0),
+            m_nextChunkSize(MinChunkSize)
+        {
+        }
+
+        PropertyArena(const PropertyArena&) = delete;
+        PropertyArena& operator=(const PropertyArena&) = delete;
+
+        PropertyArena(PropertyArena&& other) noexcept :
+            m_chunks(std::move(other.m_chunks)),
+            m_cursor(other.m_cursor),
+            m_remaining(other.m_remaining),
+            m_nextChunkSize(other.m_nextChunkSize)
+        {
+            other.m_cursor = nullptr;
+            other.m_remaining = 0;
+            other.m_nextChunkSize = MinChunkSize;
+        }
+
+        PropertyArena& operator=(PropertyArena&& other) noexcept
+        {
+            m_chunks = std::move(other.m_chunks);
+            m_cursor = other.m_cursor;
+            m_remaining = other.m_remaining;
+            m_nextChunkSize = other.m_nextChunkSize;
+            other.m_cursor = nullptr;
+            other.m_remaining = 0;
+            other.m_nextChunkSize = MinChunkSize;
+            return *this;
+        }
+
+        /// <summary>
+        /// Makes sure that at least the given number of bytes can be copied without allocating.
+        /// </summary>
+        void reserve(size_t bytes)
+        {
+            if (bytes > m_remaining)
+            {
+                addChunk(bytes);
+            }
+        }
+
+        /// <summary>
+        /// Copies the characters into the arena and returns a NUL-terminated pointer to the copy.
+        /// </summary>
+        const char* copy(const char* data, size_t length)
+        {
+            reserve(length + 1);
+            char* result = m_cursor;
+            if (length > 0)
+            {
+                memcpy(result, data, length);
+            }
+            result[length] = 0;
+            m_cursor += length + 1;
+            m_remaining -= length + 1;
+            return result;
+        }
+
+        /// <summary>
+        /// Releases all memory held by the arena.
+        /// </summary>
+        void reset() noexcept
+        {
+            m_chunks.clear();
+            m_cursor = nullptr;
+            m_remaining = 0;
+            m_nextChunkSize = MinChunkSize;
+        }
+
+    private:
+        void addChunk(size_t minSize)
+        {
+            size_t chunkSize = std::max(m_nextChunkSize, minSize);
+            m_chunks.emplace_back(new char[chunkSize]);
+            m_cursor = m_chunks.back().get();
+            m_remaining = chunkSize;
+            m_nextChunkSize = chunkSize * 2;
+        }
+
+        std::vector<std::unique_ptr<char[]>> m_chunks;
+        char*  m_cursor;
+        size_t m_remaining;
+        size_t m_nextChunkSize;
+    };
+
+    /// <summary>
+    /// Property entry of flat EventProperties storage. Name and string value
+    /// point into the owning PropertyArena (static names are referenced in place),
+    /// all other value types (and the Pii kind / data category of every entry)
+    /// are kept in the EventProperty.
+    /// </summary>
+    struct FlatProperty
+    {
+        const char*   name;
+        size_t        nameLength;
+        const char*   stringValue;
+        size_t        stringLength;
+        bool          isString;
+        bool          isStaticName;
+        EventProperty value;
+
+        FlatProperty(const char* name, size_t nameLength, bool isStaticName, EventProperty&& value) noexcept :
+            name(name),
+            nameLength(nameLength),
+            stringValue(nullptr),
+            stringLength(0),
+            isString(false),
+            isStaticName(isStaticName),
+            value(std::move(value))
+        {
+        }
+
+        FlatProperty(FlatProperty&& other) noexcept = default;
+        FlatProperty& operator=(FlatProperty&& other) noexcept = default;
+
+        std::string GetName() const
+        {
+            return std::string(name, nameLength);
+        }
+
+        /// <summary>
+        /// Materializes the entry as a regular owning EventProperty.
+        /// </summary>
+        EventProperty ToEventProperty() const
+        {
+            if (isString)
+            {
+                return EventProperty(stringValue, value.piiKind, value.dataCategory);
+            }
+            return value;
+        }
+
+        static int compare(const char* lhs, size_t lhsLength, const char* rhs, size_t rhsLength) noexcept
+        {
+            int result = memcmp(lhs, rhs, std::min(lhsLength, rhsLength));
+            if (result != 0)
+            {
+                return result;
+            }
+            return (lhsLength < rhsLength) ? -1 : ((lhsLength > rhsLength) ? 1 : 0);
+        }
+    };
+
+    /// <summary>
+    /// Flat, name-sorted property collection backed by a PropertyArena.
+    /// Lookups are binary searches, insertions keep the vector sorted,
+    /// so iteration order matches the std::map based storage.
+    /// </summary>
+    class FlatProperties
+    {
+    public:
+        FlatProperties() noexcept :
+            m_version(0)
+        {
+        }
+
+        FlatProperties(const FlatProperties& other) :
+            m_version(0)
+        {
+            *this = other;
+        }
+
+        FlatProperties& operator=(const FlatProperties& other)
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+            clear();
+            m_entries.reserve(other.m_entries.size());
+            for (const auto& entry : other.m_entries)
+            {
+                const char* name = entry.isStaticName ? entry.name : m_arena.copy(entry.name, entry.nameLength);
+                m_entries.emplace_back(name, entry.nameLength, entry.isStaticName, EventProperty(entry.value));
+                FlatProperty& copy = m_entries.back();
+                if (entry.isString)
+                {
+                    copy.isString = true;
+                    copy.stringValue = m_arena.copy(entry.stringValue, entry.stringLength);
+                    copy.stringLength = entry.stringLength;
+                }
+            }
+            m_version++;
+            return *this;
+        }
+
+        FlatProperties(FlatProperties&& other) noexcept = default;
+        FlatProperties& operator=(FlatProperties&& other) noexcept = default;
+
+        void reserve(size_t count, size_t bytes)
+        {
+            m_entries.reserve(count);
+            m_arena.reserve(bytes);
+        }
+
+        /// <summary>
+        /// Inserts or overwrites the property with a non-string value.
+        /// A static name must outlive the storage and is not copied into the arena.
+        /// </summary>
+        void set(const char* name, size_t nameLength, EventProperty&& value, bool isStaticName = false)
+        {
+            FlatProperty& entry = findOrInsert(name, nameLength, isStaticName);
+            entry.isString = false;
+            entry.stringValue = nullptr;
+            entry.stringLength = 0;
+            entry.value = std::move(value);
+            m_version++;
+        }
+
+        /// <summary>
+        /// Inserts or overwrites the property with a string value copied into the arena.
+        /// </summary>
+        void setString(const char* name, size_t nameLength, const char* data, size_t length, PiiKind piiKind, DataCategory category, bool isStaticName = false)
+        {
+            FlatProperty& entry = findOrInsert(name, nameLength, isStaticName);
+            entry.isString = true;
+            entry.stringValue = m_arena.copy(data, length);
+            entry.stringLength = length;
+            entry.value = EventProperty(static_cast<int64_t>(0), piiKind, category);
+            m_version++;
+        }
+
+        const FlatProperty* find(const char* name, size_t nameLength) const
+        {
+            auto it = lowerBound(name, nameLength);
+            if ((it != m_entries.end()) && (FlatProperty::compare(it->name, it->nameLength, name, nameLength) == 0))
+            {
+                return &(*it);
+            }
+            return nullptr;
+        }
+
+        size_t erase(const char* name, size_t nameLength)
+        {
+            auto it = lowerBound(name, nameLength);
+            if ((it != m_entries.end()) && (FlatProperty::compare(it->name, it->nameLength, name, nameLength) == 0))
+            {
+                // Arena memory of the erased entry is reclaimed when the storage is destroyed
+                m_entries.erase(it);
+                m_version++;
+                return 1;
+            }
+            return 0;
+        }
+
+        void clear() noexcept
+        {
+            m_entries.clear();
+            m_arena.reset();
+            m_version++;
+        }
+
+        size_t size() const noexcept
+        {
+            return m_entries.size();
+        }
+
+        bool empty() const noexcept
+        {
+            return m_entries.empty();
+        }
+
+        std::vector<FlatProperty>::const_iterator begin() const noexcept
+        {
+            return m_entries.begin();
+        }
+
+        std::vector<FlatProperty>::const_iterator end() const noexcept
+        {
+            return m_entries.end();
+        }
+
+        /// <summary>
+        /// Monotonic modification counter, used to invalidate materialized std::map views.
+        /// </summary>
+        uint64_t version() const noexcept
+        {
+            return m_version;
+        }
+
+    private:
+        std::vector<FlatProperty>::const_iterator lowerBound(const char* name, size_t nameLength) const
+        {
+            return std::lower_bound(m_entries.begin(), m_entries.end(), std::make_pair(name, nameLength),
+                [](const FlatProperty& entry, const std::pair<const char*, size_t>& key) {
+                    return FlatProperty::compare(entry.name, entry.nameLength, key.first, key.second) < 0;
+                });
+        }
+
+        FlatProperty& findOrInsert(const char* name, size_t nameLength, bool isStaticName)
+        {
+            auto it = lowerBound(name, nameLength);
+            size_t index = static_cast<size_t>(it - m_entries.begin());
+            if ((it != m_entries.end()) && (FlatProperty::compare(it->name, it->nameLength, name, nameLength) == 0))
+            {
+                return m_entries[index];
+            }
+            const char* nameCopy = isStaticName ? name : m_arena.copy(name, nameLength);
+            auto inserted = m_entries.emplace(m_entries.begin() + index, nameCopy, nameLength, isStaticName, EventProperty(static_cast<int64_t>(0)));
+            return *inserted;
+        }
+
+        PropertyArena             m_arena;
+        std::vector<FlatProperty> m_entries;
+        uint64_t                  m_version;
+    };
+
     struct EventPropertiesStorage
     {
        std::string      eventName;
@@ -27,6 +352,12 @@ namespace MAT_NS_BEGIN {
        std::map<std::string, EventProperty> properties;
        std::map<std::string, EventProperty> propertiesPartB;
 
+       // Flat storage mode: properties live in flatProperties, and the std::map
+       // above is only materialized on demand for GetProperties() callers.
+       bool             useFlatStorage = false;
+       FlatProperties   flatProperties;
+       uint64_t         materializedVersion = UINT64_MAX;
+
        EventPropertiesStorage() noexcept {}
 
        EventPropertiesStorage(const EventPropertiesStorage& other) noexcept
@@ -40,6 +371,9 @@ namespace MAT_NS_BEGIN {
           timestampInMillis = other.timestampInMillis;
           properties = other.properties;
           propertiesPartB = other.propertiesPartB;
+          useFlatStorage = other.useFlatStorage;
+          flatProperties = other.flatProperties;
+          materializedVersion = UINT64_MAX;
        }
 
        EventPropertiesStorage(EventPropertiesStorage&& other) noexcept 
@@ -53,6 +387,9 @@ namespace MAT_NS_BEGIN {
           timestampInMillis = std::move(other.timestampInMillis);
           properties = std::move(other.properties);
           propertiesPartB = std::move(other.propertiesPartB);
+          useFlatStorage = other.useFlatStorage;
+          flatProperties = std::move(other.flatProperties);
+          materializedVersion = UINT64_MAX;
        }
 
        EventPropertiesStorage& operator=(const EventPropertiesStorage& other) noexcept
@@ -66,9 +403,72 @@ namespace MAT_NS_BEGIN {
           eventPopSample = other.eventPopSample;
           eventPolicyBitflags = other.eventPolicyBitflags;
           timestampInMillis = other.timestampInMillis;
+          useFlatStorage = other.useFlatStorage;
+          flatProperties = other.flatProperties;
+          materializedVersion = UINT64_MAX;
 
           return *this;
        }
+
+       /// <summary>
+       /// Inserts or overwrites a property in whichever storage layout is in use.
+       /// </summary>
+       void setProperty(const std::string& name, EventProperty&& prop)
+       {
+          if (useFlatStorage)
+          {
+             setFlatProperty(name.data(), name.length(), std::move(prop));
+             return;
+          }
+          auto it = properties.find(name);
+          if (it != properties.end())
+          {
+             it->second = std::move(prop);
+          }
+          else
+          {
+             properties.emplace(name, std::move(prop));
+          }
+       }
+
+       void setFlatProperty(const char* name, size_t nameLength, EventProperty&& prop, bool isStaticName = false)
+       {
+          if (prop.type == EventProperty::TYPE_STRING)
+          {
+             const char* value = (prop.as_string != nullptr) ? prop.as_string : "";
+             flatProperties.setString(name, nameLength, value, strlen(value), prop.piiKind, prop.dataCategory, isStaticName);
+          }
+          else
+          {
+             flatProperties.set(name, nameLength, std::move(prop), isStaticName);
+          }
+       }
+
+       /// <summary>
+       /// Removes all Part C properties.
+       /// </summary>
+       void clearProperties() noexcept
+       {
+          properties.clear();
+          flatProperties.clear();
+       }
+
+       /// <summary>
+       /// Rebuilds the std::map view of flat properties if they changed since the last call.
+       /// </summary>
+       void materializeFlatProperties()
+       {
+          if (!useFlatStorage || (materializedVersion == flatProperties.version()))
+          {
+             return;
+          }
+          properties.clear();
+          for (const auto& entry : flatProperties)
+          {
+             properties.emplace_hint(properties.end(), entry.GetName(), entry.ToEventProperty());
+          }
+          materializedVersion = flatProperties.version();
+       }
     };
 
 } MAT_NS_END
@@ -326,11 +326,11 @@ namespace MAT_NS_BEGIN {
     /// EventProperty move constructor
     /// </summary>
     /// <param name="source">Right-hand side value of object</param>
-    EventProperty::EventProperty(EventProperty&& source) /* noexcept */ :
+    EventProperty::EventProperty(EventProperty&& source) noexcept :
         type(source.type)
     {
         memcpy((void*)this, (void*)&source, sizeof(EventProperty));
-        copydata(&source);
+        source.release();
     }
 
 
@@ -441,6 +441,20 @@ namespace MAT_NS_BEGIN {
         return (*this);
     }
 
+    /// <summary>
+    /// EventProperty move assignment operator
+    /// </summary>
+    EventProperty& EventProperty::operator=(EventProperty&& source) noexcept
+    {
+        if (this != &source)
+        {
+            clear();
+            memcpy((void*)this, (void*)&source, sizeof(EventProperty));
+            source.release();
+        }
+        return (*this);
+    }
+
     /// <summary>
     /// EventProperty assignment operator
     /// </summary>
@@ -650,6 +664,16 @@ namespace MAT_NS_BEGIN {
         dataCategory = DataCategory_PartC;
     }
 
+    /// <summary>
+    /// Detaches heap-allocated value (if any) after ownership has been transferred to another object.
+    /// </summary>
+    void EventProperty::release() noexcept
+    {
+        type = TYPE_INT64;
+        as_int64 = 0;
+    }
+
+    /// <summary>
     /// EventProperty destructor
     /// </summary>
     EventProperty::~EventProperty()
@@ -47,6 +47,15 @@ namespace MAT_NS_BEGIN {
         // Core sendEvent
         virtual void sendEvent(IncomingEventContextPtr const& event) = 0;
 
+        // Batched sendEvent: implementations may serialize, store and schedule the events in one pass
+        virtual void sendEvents(IncomingEventContextBatch const& events)
+        {
+            for (auto const& event : events)
+            {
+                sendEvent(event);
+            }
+        }
+
     protected:
         virtual void handleFlushTaskDispatcher() = 0;
         virtual void signalDone() = 0;
@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "MemoryBudget.hpp"
+
+namespace MAT_NS_BEGIN
+{
+    MemoryBudget::MemoryBudget(std::shared_ptr<IMemoryResource> resource) :
+        m_resource(std::move(resource)),
+        m_limit(0),
+        m_shedEvents(0)
+    {
+        for (size_t i = 0; i < MemorySubsystem_Count; i++)
+        {
+            m_bytes[i] = 0;
+            m_peakBytes[i] = 0;
+        }
+    }
+
+    void MemoryBudget::Configure(IRuntimeConfig& config)
+    {
+        uint32_t limit = config[CFG_INT_MEMORY_BUDGET];
+        m_limit = limit;
+    }
+
+    void* MemoryBudget::Allocate(size_t bytes, size_t alignment)
+    {
+        if (m_resource == nullptr)
+        {
+            return ::operator new(bytes);
+        }
+        void* ptr = m_resource->Allocate(bytes, alignment);
+        if (ptr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void MemoryBudget::Deallocate(void* ptr, size_t bytes, size_t alignment) noexcept
+    {
+        if (m_resource == nullptr)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+        m_resource->Deallocate(ptr, bytes, alignment);
+    }
+
+    void MemoryBudget::Charge(MemorySubsystem subsystem, size_t bytes) noexcept
+    {
+        size_t usage = m_bytes[subsystem].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        size_t peak = m_peakBytes[subsystem].load(std::memory_order_relaxed);
+        while ((usage > peak) && !m_peakBytes[subsystem].compare_exchange_weak(peak, usage, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void MemoryBudget::Discharge(MemorySubsystem subsystem, size_t bytes) noexcept
+    {
+        m_bytes[subsystem].fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    size_t MemoryBudget::GetTotalUsage() const noexcept
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < MemorySubsystem_Count; i++)
+        {
+            total += m_bytes[i].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void MemoryBudget::GetMemoryUsage(MemoryUsage& usage) const noexcept
+    {
+        for (size_t i = 0; i < MemorySubsystem_Count; i++)
+        {
+            usage.bytes[i] = m_bytes[i].load(std::memory_order_relaxed);
+            usage.peakBytes[i] = m_peakBytes[i].load(std::memory_order_relaxed);
+        }
+        usage.totalBytes = GetTotalUsage();
+        usage.limitBytes = GetLimit();
+        usage.shedEvents = m_shedEvents.load(std::memory_order_relaxed);
+    }
+
+} MAT_NS_END
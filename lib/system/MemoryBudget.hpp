@@ -0,0 +1,255 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include "pal/PAL.hpp"
+
+#include "IMemoryResource.hpp"
+#include "api/IRuntimeConfig.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Memory budget of a log manager: the memory resource its RAM queue allocates from,
+    /// and per-subsystem gauges of the bytes held by the RAM queue, request packaging and
+    /// HTTP, checked against the CFG_INT_MEMORY_BUDGET cap.
+    /// </summary>
+    /// <remarks>
+    /// Buffers with internal types are allocated through Allocator, which uses the host
+    /// IMemoryResource if one is configured. Buffers passed through public types
+    /// (StorageRecord, IHttpRequest and IHttpResponse bodies) cannot change allocator;
+    /// their owners report their sizes with MemoryCharge instead. Gauges are updated with
+    /// relaxed atomics, so any thread may charge without locking.
+    /// </remarks>
+    class MemoryBudget
+    {
+    public:
+        MemoryBudget(std::shared_ptr<IMemoryResource> resource = nullptr);
+
+        MemoryBudget(MemoryBudget const&) = delete;
+        MemoryBudget& operator=(MemoryBudget const&) = delete;
+
+        /// <summary>
+        /// Reads the CFG_INT_MEMORY_BUDGET setting.
+        /// </summary>
+        void Configure(IRuntimeConfig& config);
+
+        void* Allocate(size_t bytes, size_t alignment);
+
+        void Deallocate(void* ptr, size_t bytes, size_t alignment) noexcept;
+
+        void Charge(MemorySubsystem subsystem, size_t bytes) noexcept;
+
+        void Discharge(MemorySubsystem subsystem, size_t bytes) noexcept;
+
+        size_t GetUsage(MemorySubsystem subsystem) const noexcept
+        {
+            return m_bytes[subsystem].load(std::memory_order_relaxed);
+        }
+
+        size_t GetTotalUsage() const noexcept;
+
+        size_t GetLimit() const noexcept
+        {
+            return m_limit.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Returns true if using the given number of additional bytes would exceed the cap.
+        /// </summary>
+        bool WouldExceed(size_t bytes) const noexcept
+        {
+            size_t limit = GetLimit();
+            return (limit != 0) && (GetTotalUsage() + bytes > limit);
+        }
+
+        /// <summary>
+        /// Counts events dropped to stay within the cap.
+        /// </summary>
+        void AddShedEvents(size_t count) noexcept
+        {
+            m_shedEvents.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void GetMemoryUsage(MemoryUsage& usage) const noexcept;
+
+        /// <summary>
+        /// Bytes of the heap buffer of a string, 0 if its contents fit in the string object.
+        /// </summary>
+        static size_t GetHeapSize(std::string const& value) noexcept
+        {
+            char const* object = reinterpret_cast<char const*>(&value);
+            bool isInline = (value.data() >= object) && (value.data() < object + sizeof(value));
+            return isInline ? 0 : value.capacity() + 1;
+        }
+
+        template<typename T, typename A>
+        static size_t GetHeapSize(std::vector<T, A> const& value) noexcept
+        {
+            return value.capacity() * sizeof(T);
+        }
+
+        /// <summary>
+        /// Standard allocator over the memory resource of a budget, or over the global heap
+        /// if it has none. Containers using it must not outlive the budget.
+        /// </summary>
+        template<typename T>
+        class Allocator
+        {
+        public:
+            typedef T value_type;
+            typedef std::true_type propagate_on_container_copy_assignment;
+            typedef std::true_type propagate_on_container_move_assignment;
+            typedef std::true_type propagate_on_container_swap;
+
+            Allocator(MemoryBudget* budget = nullptr) noexcept : m_budget(budget) {}
+
+            template<typename U>
+            Allocator(Allocator<U> const& other) noexcept : m_budget(other.GetBudget()) {}
+
+            T* allocate(size_t count)
+            {
+                if (m_budget == nullptr)
+                {
+                    return static_cast<T*>(::operator new(count * sizeof(T)));
+                }
+                return static_cast<T*>(m_budget->Allocate(count * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T* ptr, size_t count) noexcept
+            {
+                if (m_budget == nullptr)
+                {
+                    ::operator delete(ptr);
+                    return;
+                }
+                m_budget->Deallocate(ptr, count * sizeof(T), alignof(T));
+            }
+
+            MemoryBudget* GetBudget() const noexcept
+            {
+                return m_budget;
+            }
+
+            template<typename U>
+            bool operator==(Allocator<U> const& other) const noexcept
+            {
+                return m_budget == other.GetBudget();
+            }
+
+            template<typename U>
+            bool operator!=(Allocator<U> const& other) const noexcept
+            {
+                return m_budget != other.GetBudget();
+            }
+
+        protected:
+            MemoryBudget* m_budget;
+        };
+
+    protected:
+        std::shared_ptr<IMemoryResource> m_resource;
+        std::atomic<size_t>              m_limit;
+        std::atomic<size_t>              m_bytes[MemorySubsystem_Count];
+        std::atomic<size_t>              m_peakBytes[MemorySubsystem_Count];
+        std::atomic<uint64_t>            m_shedEvents;
+    };
+
+    /// <summary>
+    /// Bytes charged by one owner to a subsystem of a budget, discharged when the owner
+    /// resets or destroys it. Without a budget it only counts them. Not thread-safe: the
+    /// owner serializes its updates.
+    /// </summary>
+    class MemoryCharge
+    {
+    public:
+        MemoryCharge(MemoryBudget* budget = nullptr, MemorySubsystem subsystem = MemorySubsystem_Storage) noexcept :
+            m_budget(budget),
+            m_subsystem(subsystem),
+            m_bytes(0)
+        {
+        }
+
+        MemoryCharge(MemoryCharge const&) = delete;
+        MemoryCharge& operator=(MemoryCharge const&) = delete;
+
+        ~MemoryCharge() noexcept
+        {
+            Reset();
+        }
+
+        /// <summary>
+        /// Charges the given number of bytes instead of the current ones, moving the charge
+        /// to another budget or subsystem if needed.
+        /// </summary>
+        void Assign(MemoryBudget* budget, MemorySubsystem subsystem, size_t bytes) noexcept
+        {
+            if ((budget != m_budget) || (subsystem != m_subsystem))
+            {
+                Reset();
+                m_budget = budget;
+                m_subsystem = subsystem;
+            }
+            Set(bytes);
+        }
+
+        void Set(size_t bytes) noexcept
+        {
+            if (bytes > m_bytes)
+            {
+                Add(bytes - m_bytes);
+            }
+            else
+            {
+                Subtract(m_bytes - bytes);
+            }
+        }
+
+        void Add(size_t bytes) noexcept
+        {
+            m_bytes += bytes;
+            if ((m_budget != nullptr) && (bytes != 0))
+            {
+                m_budget->Charge(m_subsystem, bytes);
+            }
+        }
+
+        void Subtract(size_t bytes) noexcept
+        {
+            bytes = std::min(bytes, m_bytes);
+            m_bytes -= bytes;
+            if ((m_budget != nullptr) && (bytes != 0))
+            {
+                m_budget->Discharge(m_subsystem, bytes);
+            }
+        }
+
+        void Reset() noexcept
+        {
+            Subtract(m_bytes);
+        }
+
+        size_t GetBytes() const noexcept
+        {
+            return m_bytes;
+        }
+
+    protected:
+        MemoryBudget*    m_budget;
+        MemorySubsystem  m_subsystem;
+        size_t           m_bytes;
+    };
+
+} MAT_NS_END
+
+#endif // MEMORYBUDGET_HPP
@@ -0,0 +1,713 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "SharedRuntime.hpp"
+
+#include "ILogConfiguration.hpp"
+#include "NullObjects.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "offline/OfflineStorageFactory.hpp"
+#include "utils/StringUtils.hpp"
+#include "utils/Utils.hpp"
+#ifdef HAVE_MAT_DEFAULT_HTTP_CLIENT
+#include "http/HttpClientFactory.hpp"
+#endif
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    MATSDK_LOG_INST_COMPONENT_CLASS(SharedRuntime, "EventsSDK.SharedRuntime", "Events telemetry client - SharedRuntime class");
+
+    /// <summary>
+    /// Disk storage of the members posting to one collector. Acts as the log manager and the
+    /// observer of the storage it wraps: debug events go to every member, storage notifications
+    /// that feed statistics only to the earliest member still attached, so they are counted once.
+    /// Also counts the pending records of every tenant token stored through the partitions, so
+    /// that a member can report its own records: stored records are counted, records reserved for
+    /// an upload are remembered until they are deleted or released, and trimmed or dropped ones
+    /// are uncounted from the lowest latency up. Records left by a previous run are counted once
+    /// when the storage opens.
+    /// </summary>
+    class SharedRuntime::StorageEngine : public NullLogManager, public IOfflineStorageObserver
+    {
+    public:
+        StorageEngine(ILogConfiguration& memberConfiguration, std::string const& filePath)
+        {
+            // Settings only: the modules of the member stay with the member
+            *m_configuration = *memberConfiguration;
+            m_configuration[CFG_STR_CACHE_FILE_PATH] = filePath;
+            m_config.reset(new RuntimeConfig_Default(m_configuration));
+        }
+
+        IOfflineStorage* Attach(ILogManager& logManager, IOfflineStorageObserver& observer)
+        {
+            LOCKGUARD(m_lock);
+            m_members.push_back(Member { &logManager, &observer });
+            if (m_storage == nullptr)
+            {
+                m_storage = OfflineStorageFactory::Create(*this, *m_config);
+                m_storage->Initialize(*this);
+                countPendingRecords();
+            }
+            else if (!m_storageType.empty())
+            {
+                observer.OnStorageOpened(m_storageType);
+            }
+            return m_storage.get();
+        }
+
+        void Detach(IOfflineStorageObserver& observer)
+        {
+            std::shared_ptr<IOfflineStorage> storage;
+            {
+                LOCKGUARD(m_lock);
+                auto it = std::find_if(m_members.begin(), m_members.end(), [&observer](Member const& member) { return member.observer == &observer; });
+                if (it == m_members.end())
+                {
+                    return;
+                }
+                m_members.erase(it);
+                if (m_members.empty())
+                {
+                    storage.swap(m_storage);
+                    m_storageType.clear();
+                    LOCKGUARD(m_countsLock);
+                    m_tenants.clear();
+                    m_reserved.clear();
+                }
+            }
+            // Outside of the lock: the storage notifies this engine while holding locks of its own
+            if (storage != nullptr)
+            {
+                storage->Shutdown();
+            }
+        }
+
+        void CountRecord(StorageRecord const& record)
+        {
+            LOCKGUARD(m_countsLock);
+            TenantRecords& tenant = m_tenants[record.tenantToken];
+            tenant.counts[latencyIndex(record.latency)]++;
+            tenant.bytes += record.blob.size();
+        }
+
+        void UncountRecord(std::string const& tenantToken, EventLatency latency, size_t bytes)
+        {
+            LOCKGUARD(m_countsLock);
+            auto it = m_tenants.find(tenantToken);
+            if (it == m_tenants.end())
+            {
+                return;
+            }
+            size_t& count = it->second.counts[latencyIndex(latency)];
+            count -= std::min<size_t>(count, 1);
+            it->second.bytes -= std::min(it->second.bytes, bytes);
+        }
+
+        void ReserveRecord(StorageRecordId const& id, std::string const& tenantToken, EventLatency latency, size_t bytes)
+        {
+            LOCKGUARD(m_countsLock);
+            m_reserved[id] = Reservation { tenantToken, latency, bytes };
+        }
+
+        /// <summary>
+        /// Uncounts the reserved records deleted after their upload.
+        /// </summary>
+        void DeleteReservations(std::vector<StorageRecordId> const& ids)
+        {
+            for (auto const& id : ids)
+            {
+                Reservation reservation;
+                {
+                    LOCKGUARD(m_countsLock);
+                    auto it = m_reserved.find(id);
+                    if (it == m_reserved.end())
+                    {
+                        continue;
+                    }
+                    reservation = std::move(it->second);
+                    m_reserved.erase(it);
+                }
+                UncountRecord(reservation.tenantToken, reservation.latency, reservation.bytes);
+            }
+        }
+
+        /// <summary>
+        /// Forgets the reservations of records back in the pending state.
+        /// </summary>
+        void ReleaseReservations(std::vector<StorageRecordId> const& ids)
+        {
+            LOCKGUARD(m_countsLock);
+            for (auto const& id : ids)
+            {
+                m_reserved.erase(id);
+            }
+        }
+
+        void ReleaseAllReservations()
+        {
+            LOCKGUARD(m_countsLock);
+            m_reserved.clear();
+        }
+
+        /// <summary>
+        /// Forgets the counts and reservations of a tenant token whose records were all deleted.
+        /// </summary>
+        void UncountTenant(std::string const& tenantToken)
+        {
+            LOCKGUARD(m_countsLock);
+            m_tenants.erase(tenantToken);
+            for (auto it = m_reserved.begin(); it != m_reserved.end();)
+            {
+                it = (it->second.tenantToken == tenantToken) ? m_reserved.erase(it) : std::next(it);
+            }
+        }
+
+        size_t GetRecordCount(std::set<std::string> const& tenantTokens, EventLatency latency)
+        {
+            LOCKGUARD(m_countsLock);
+            size_t count = 0;
+            for (auto const& tenantToken : tenantTokens)
+            {
+                auto it = m_tenants.find(tenantToken);
+                if (it == m_tenants.end())
+                {
+                    continue;
+                }
+                for (int i = 0; i <= EventLatency_Max; i++)
+                {
+                    if ((latency == EventLatency_Unspecified) || (latency == i))
+                    {
+                        count += it->second.counts[i];
+                    }
+                }
+            }
+            return count;
+        }
+
+        size_t GetSize(std::set<std::string> const& tenantTokens)
+        {
+            LOCKGUARD(m_countsLock);
+            size_t bytes = 0;
+            for (auto const& tenantToken : tenantTokens)
+            {
+                auto it = m_tenants.find(tenantToken);
+                if (it != m_tenants.end())
+                {
+                    bytes += it->second.bytes;
+                }
+            }
+            return bytes;
+        }
+
+        // ILogManager
+        virtual bool DispatchEvent(DebugEvent evt) override
+        {
+            LOCKGUARD(m_lock);
+            bool dispatched = false;
+            for (auto const& member : m_members)
+            {
+                dispatched = member.logManager->DispatchEvent(evt) || dispatched;
+            }
+            return dispatched;
+        }
+
+        virtual ILogConfiguration& GetLogConfiguration() override
+        {
+            return m_configuration;
+        }
+
+        // IOfflineStorageObserver
+        virtual void OnStorageOpened(std::string const& type) override
+        {
+            LOCKGUARD(m_lock);
+            m_storageType = type;
+            for (auto const& member : m_members)
+            {
+                member.observer->OnStorageOpened(type);
+            }
+        }
+
+        virtual void OnStorageFailed(std::string const& reason) override
+        {
+            LOCKGUARD(m_lock);
+            for (auto const& member : m_members)
+            {
+                member.observer->OnStorageFailed(reason);
+            }
+        }
+
+        virtual void OnStorageOpenFailed(std::string const& reason) override
+        {
+            LOCKGUARD(m_lock);
+            for (auto const& member : m_members)
+            {
+                member.observer->OnStorageOpenFailed(reason);
+            }
+        }
+
+        virtual void OnStorageTrimmed(std::map<std::string, size_t> const& numRecords) override
+        {
+            uncountRemoved(numRecords);
+            LOCKGUARD(m_lock);
+            if (!m_members.empty())
+            {
+                m_members.front().observer->OnStorageTrimmed(numRecords);
+            }
+        }
+
+        virtual void OnStorageRecordsDropped(std::map<std::string, size_t> const& numRecords) override
+        {
+            uncountRemoved(numRecords);
+            LOCKGUARD(m_lock);
+            if (!m_members.empty())
+            {
+                m_members.front().observer->OnStorageRecordsDropped(numRecords);
+            }
+        }
+
+        virtual void OnStorageRecordsRejected(std::map<std::string, size_t> const& numRecords) override
+        {
+            LOCKGUARD(m_lock);
+            if (!m_members.empty())
+            {
+                m_members.front().observer->OnStorageRecordsRejected(numRecords);
+            }
+        }
+
+        virtual void OnStorageRecordsSaved(size_t numRecords) override
+        {
+            LOCKGUARD(m_lock);
+            if (!m_members.empty())
+            {
+                m_members.front().observer->OnStorageRecordsSaved(numRecords);
+            }
+        }
+
+    protected:
+        struct Member
+        {
+            ILogManager*                logManager;
+            IOfflineStorageObserver*    observer;
+        };
+
+        struct TenantRecords
+        {
+            size_t counts[EventLatency_Max + 1] {};
+            size_t bytes {};
+        };
+
+        struct Reservation
+        {
+            std::string     tenantToken;
+            EventLatency    latency;
+            size_t          bytes;
+        };
+
+        static int latencyIndex(EventLatency latency)
+        {
+            return std::min(std::max(static_cast<int>(latency), static_cast<int>(EventLatency_Off)), static_cast<int>(EventLatency_Max));
+        }
+
+        void countPendingRecords()
+        {
+            for (auto const& record : m_storage->GetRecords(false))
+            {
+                CountRecord(record);
+            }
+        }
+
+        // The storage trims and drops the lowest latencies first and does not report sizes
+        void uncountRemoved(std::map<std::string, size_t> const& numRecords)
+        {
+            LOCKGUARD(m_countsLock);
+            for (auto const& removed : numRecords)
+            {
+                auto it = m_tenants.find(removed.first);
+                if (it == m_tenants.end())
+                {
+                    continue;
+                }
+                TenantRecords& tenant = it->second;
+                size_t total = 0;
+                for (size_t count : tenant.counts)
+                {
+                    total += count;
+                }
+                size_t remaining = std::min(removed.second, total);
+                if (total > 0)
+                {
+                    tenant.bytes -= std::min(tenant.bytes, tenant.bytes / total * remaining);
+                }
+                for (int i = 0; (i <= EventLatency_Max) && (remaining > 0); i++)
+                {
+                    size_t uncounted = std::min(tenant.counts[i], remaining);
+                    tenant.counts[i] -= uncounted;
+                    remaining -= uncounted;
+                }
+            }
+        }
+
+        std::recursive_mutex                m_lock;
+        ILogConfiguration                   m_configuration;
+        std::unique_ptr<IRuntimeConfig>     m_config;
+        std::shared_ptr<IOfflineStorage>    m_storage;
+        std::string                         m_storageType;
+        std::vector<Member>                 m_members;
+
+        std::mutex                                          m_countsLock;
+        std::map<std::string, TenantRecords>                m_tenants;
+        std::unordered_map<StorageRecordId, Reservation>    m_reserved;
+    };
+
+    /// <summary>
+    /// Storage of one member on top of the shared engine, attached between Initialize and Shutdown.
+    /// Records are partitioned by tenant token: the member owns its primary token and the tokens it
+    /// stores records for, counts and deletes only their records, and reads back only their records
+    /// with GetRecords. Members logging with the same tenant token share its records. Uploads are not
+    /// partitioned, GetAndReserveRecords hands out the pending records of all the members. Settings
+    /// are prefixed with the identity of the member (its cache file path and primary token), so that
+    /// each member keeps its own session settings as if it had a database of its own.
+    /// </summary>
+    class SharedRuntime::StoragePartition : public IOfflineStorage
+    {
+    public:
+        StoragePartition(std::shared_ptr<StorageEngine> const& engine, ILogManager& logManager, std::string const& memberId, std::string const& primaryToken) :
+            m_engine(engine),
+            m_logManager(logManager),
+            m_observer(nullptr),
+            m_storage(nullptr),
+            m_settingPrefix("member-" + memberId + ".")
+        {
+            if (!primaryToken.empty())
+            {
+                m_tenantTokens.insert(primaryToken);
+            }
+        }
+
+        virtual ~StoragePartition() override
+        {
+            Shutdown();
+        }
+
+        virtual void Initialize(IOfflineStorageObserver& observer) override
+        {
+            m_observer = &observer;
+            m_storage = m_engine->Attach(m_logManager, observer);
+        }
+
+        virtual void Shutdown() override
+        {
+            if (m_storage != nullptr)
+            {
+                m_storage = nullptr;
+                m_engine->Detach(*m_observer);
+            }
+        }
+
+        virtual void Flush() override
+        {
+            if (m_storage != nullptr)
+            {
+                m_storage->Flush();
+            }
+        }
+
+        virtual bool StoreRecord(StorageRecord const& record) override
+        {
+            if (m_storage == nullptr)
+            {
+                return false;
+            }
+            // Counted first, so that an upload deleting the record right away finds it counted
+            addTenantToken(record.tenantToken);
+            m_engine->CountRecord(record);
+            if (!m_storage->StoreRecord(record))
+            {
+                m_engine->UncountRecord(record.tenantToken, record.latency, record.blob.size());
+                return false;
+            }
+            return true;
+        }
+
+        virtual size_t StoreRecords(std::vector<StorageRecord>& records) override
+        {
+            if (m_storage == nullptr)
+            {
+                return 0;
+            }
+            for (auto const& record : records)
+            {
+                addTenantToken(record.tenantToken);
+                m_engine->CountRecord(record);
+            }
+            size_t stored = m_storage->StoreRecords(records);
+            // The storage moves the records it failed to store behind the stored ones
+            for (size_t i = stored; i < records.size(); i++)
+            {
+                m_engine->UncountRecord(records[i].tenantToken, records[i].latency, records[i].blob.size());
+            }
+            return stored;
+        }
+
+        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency = EventLatency_Unspecified, unsigned maxCount = 0) override
+        {
+            if (m_storage == nullptr)
+            {
+                return false;
+            }
+            StorageEngine& engine = *m_engine;
+            return m_storage->GetAndReserveRecords([&engine, &consumer](StorageRecord&& record)
+            {
+                StorageRecordId id = record.id;
+                std::string tenantToken = record.tenantToken;
+                EventLatency latency = record.latency;
+                size_t bytes = record.blob.size();
+                if (!consumer(std::move(record)))
+                {
+                    return false;
+                }
+                engine.ReserveRecord(id, tenantToken, latency, bytes);
+                return true;
+            }, leaseTimeMs, minLatency, maxCount);
+        }
+
+        virtual bool IsLastReadFromMemory() override
+        {
+            return (m_storage != nullptr) && m_storage->IsLastReadFromMemory();
+        }
+
+        virtual unsigned LastReadRecordCount() override
+        {
+            return (m_storage != nullptr) ? m_storage->LastReadRecordCount() : 0;
+        }
+
+        virtual void DeleteRecords(const std::map<std::string, std::string>& whereFilter) override
+        {
+            if (m_storage == nullptr)
+            {
+                return;
+            }
+            auto tenantFilter = whereFilter.find("tenant_token");
+            for (auto const& tenantToken : getTenantTokens())
+            {
+                if ((tenantFilter != whereFilter.end()) && (tenantFilter->second != tenantToken))
+                {
+                    continue;
+                }
+                std::map<std::string, std::string> filter = whereFilter;
+                filter["tenant_token"] = tenantToken;
+                m_storage->DeleteRecords(filter);
+                if (filter.size() == 1)
+                {
+                    m_engine->UncountTenant(tenantToken);
+                }
+            }
+        }
+
+        virtual void DeleteRecords(std::vector<StorageRecordId> const& ids, HttpHeaders headers, bool& fromMemory) override
+        {
+            if (m_storage != nullptr)
+            {
+                m_storage->DeleteRecords(ids, headers, fromMemory);
+                m_engine->DeleteReservations(ids);
+            }
+        }
+
+        virtual void DeleteAllRecords() override
+        {
+            DeleteRecords(std::map<std::string, std::string>());
+        }
+
+        virtual void ReleaseRecords(std::vector<StorageRecordId> const& ids, bool incrementRetryCount, HttpHeaders headers, bool& fromMemory) override
+        {
+            if (m_storage != nullptr)
+            {
+                // Records over the retry limit are deleted and reported as dropped
+                m_engine->ReleaseReservations(ids);
+                m_storage->ReleaseRecords(ids, incrementRetryCount, headers, fromMemory);
+            }
+        }
+
+        virtual bool StoreSetting(std::string const& name, std::string const& value) override
+        {
+            return (m_storage != nullptr) && m_storage->StoreSetting(m_settingPrefix + name, value);
+        }
+
+        virtual std::string GetSetting(std::string const& name) override
+        {
+            return (m_storage != nullptr) ? m_storage->GetSetting(m_settingPrefix + name) : std::string();
+        }
+
+        virtual bool DeleteSetting(std::string const& name) override
+        {
+            return (m_storage != nullptr) && m_storage->DeleteSetting(m_settingPrefix + name);
+        }
+
+        virtual size_t GetSize() override
+        {
+            return (m_storage != nullptr) ? m_engine->GetSize(getTenantTokens()) : 0;
+        }
+
+        virtual size_t GetRecordCount(EventLatency latency = EventLatency_Unspecified) const override
+        {
+            return (m_storage != nullptr) ? m_engine->GetRecordCount(getTenantTokens(), latency) : 0;
+        }
+
+        virtual std::vector<StorageRecord> GetRecords(bool shutdown, EventLatency minLatency = EventLatency_Unspecified, unsigned maxCount = 0) override
+        {
+            std::vector<StorageRecord> records;
+            if (m_storage == nullptr)
+            {
+                return records;
+            }
+            std::set<std::string> tenantTokens = getTenantTokens();
+            for (auto& record : m_storage->GetRecords(shutdown, minLatency, 0))
+            {
+                if ((maxCount != 0) && (records.size() >= maxCount))
+                {
+                    break;
+                }
+                if (tenantTokens.count(record.tenantToken) != 0)
+                {
+                    records.push_back(std::move(record));
+                }
+            }
+            return records;
+        }
+
+        virtual bool ResizeDb() override
+        {
+            return (m_storage != nullptr) && m_storage->ResizeDb();
+        }
+
+        virtual void ReleaseAllRecords() override
+        {
+            if (m_storage != nullptr)
+            {
+                m_engine->ReleaseAllReservations();
+                m_storage->ReleaseAllRecords();
+            }
+        }
+
+    protected:
+        void addTenantToken(std::string const& tenantToken)
+        {
+            LOCKGUARD(m_tenantTokensLock);
+            m_tenantTokens.insert(tenantToken);
+        }
+
+        std::set<std::string> getTenantTokens() const
+        {
+            LOCKGUARD(m_tenantTokensLock);
+            return m_tenantTokens;
+        }
+
+        std::shared_ptr<StorageEngine>  m_engine;
+        ILogManager&                    m_logManager;
+        IOfflineStorageObserver*        m_observer;
+        IOfflineStorage*                m_storage;
+        std::string                     m_settingPrefix;
+        mutable std::mutex              m_tenantTokensLock;
+        std::set<std::string>           m_tenantTokens;
+    };
+
+    static std::mutex& runtimesLock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static std::map<std::string, std::weak_ptr<SharedRuntime>>& runtimes()
+    {
+        static std::map<std::string, std::weak_ptr<SharedRuntime>> registry;
+        return registry;
+    }
+
+    std::shared_ptr<SharedRuntime> SharedRuntime::Acquire(const std::string& name)
+    {
+        LOCKGUARD(runtimesLock());
+        auto& registry = runtimes();
+        std::shared_ptr<SharedRuntime> runtime = registry[name].lock();
+        if (runtime == nullptr)
+        {
+            LOG_TRACE("Creating shared runtime %s", name.c_str());
+            runtime.reset(new SharedRuntime(name));
+            registry[name] = runtime;
+        }
+        return runtime;
+    }
+
+    SharedRuntime::SharedRuntime(const std::string& name) :
+        m_name(name)
+    {
+    }
+
+    SharedRuntime::~SharedRuntime() noexcept
+    {
+        LOG_TRACE("Destroying shared runtime %s", m_name.c_str());
+        LOCKGUARD(runtimesLock());
+        auto& registry = runtimes();
+        auto it = registry.find(m_name);
+        if ((it != registry.end()) && it->second.expired())
+        {
+            registry.erase(it);
+        }
+    }
+
+    std::shared_ptr<ITaskDispatcher> SharedRuntime::GetTaskDispatcher()
+    {
+        // The PAL worker is a single process-wide queue as long as any LogManager is alive
+        return PAL::getDefaultTaskDispatcher();
+    }
+
+#ifdef HAVE_MAT_DEFAULT_HTTP_CLIENT
+    std::shared_ptr<IHttpClient> SharedRuntime::GetHttpClient()
+    {
+        LOCKGUARD(m_lock);
+        if (m_httpClient == nullptr)
+        {
+            m_httpClient = HttpClientFactory::Create();
+        }
+        return m_httpClient;
+    }
+#endif
+
+    std::string SharedRuntime::getEngineFilePath(const std::string& name, const std::string& memberPath, const std::string& collectorUrl)
+    {
+        if (memberPath.empty() || memberPath == ":memory:")
+        {
+            return ":memory:";
+        }
+        std::string directory = memberPath.substr(0, memberPath.rfind(PATH_SEPARATOR_CHAR) + 1);
+        return directory + name + "-" + toString(hashCode(collectorUrl.c_str())) + ".db";
+    }
+
+    std::shared_ptr<IOfflineStorage> SharedRuntime::GetStorage(ILogManager& logManager, IRuntimeConfig& config)
+    {
+        const char* url = config[CFG_STR_COLLECTOR_URL];
+        std::string collectorUrl = (url != nullptr) ? url : "";
+        const char* path = config[CFG_STR_CACHE_FILE_PATH];
+        std::string memberPath = (path != nullptr) ? path : "";
+        const char* token = config[CFG_STR_PRIMARY_TOKEN];
+        std::string primaryToken = (token != nullptr) ? token : "";
+
+        LOCKGUARD(m_lock);
+        std::shared_ptr<StorageEngine> engine = m_engines[collectorUrl].lock();
+        if (engine == nullptr)
+        {
+            std::string filePath = getEngineFilePath(m_name, memberPath, collectorUrl);
+            LOG_TRACE("Shared runtime %s: storage %s for %s", m_name.c_str(), filePath.c_str(), collectorUrl.c_str());
+            engine = std::make_shared<StorageEngine>(logManager.GetLogConfiguration(), filePath);
+            m_engines[collectorUrl] = engine;
+        }
+        std::string memberId = toString(hashCode((memberPath + "|" + primaryToken).c_str()));
+        return std::make_shared<StoragePartition>(engine, logManager, memberId, primaryToken);
+    }
+
+} MAT_NS_END
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef SHAREDRUNTIME_HPP
+#define SHAREDRUNTIME_HPP
+
+#include "pal/PAL.hpp"
+
+#include "IHttpClient.hpp"
+#include "ILogManager.hpp"
+#include "IOfflineStorage.hpp"
+#include "ITaskDispatcher.hpp"
+#include "api/IRuntimeConfig.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Process-wide resources shared by the LogManager instances joining the runtime of the same
+    /// name (CFG_STR_SHARED_RUNTIME), so that many embedded components do not each bring their own
+    /// worker thread, HTTP client, database and upload schedule.
+    ///
+    /// Members share the default task dispatcher, one HTTP client and, per collector URI, one disk
+    /// storage engine. Each member gets its own partition view of the engine: records keep the tenant
+    /// token they were logged with, and a member counts and deletes only the records of its tenant
+    /// tokens and keeps its own settings. Whichever member uploads packages the pending records of all
+    /// the members posting to that collector into the same requests. The runtime is destroyed with
+    /// its last member, the storage engine of a collector when its last member shuts its storage down.
+    /// </summary>
+    class SharedRuntime
+    {
+    public:
+        /// <summary>
+        /// Returns the runtime registered under the name, creating it if there is none.
+        /// </summary>
+        static std::shared_ptr<SharedRuntime> Acquire(const std::string& name);
+
+        ~SharedRuntime() noexcept;
+
+        SharedRuntime(const SharedRuntime&) = delete;
+        SharedRuntime& operator=(const SharedRuntime&) = delete;
+
+        const std::string& GetName() const noexcept
+        {
+            return m_name;
+        }
+
+        std::shared_ptr<ITaskDispatcher> GetTaskDispatcher();
+
+#ifdef HAVE_MAT_DEFAULT_HTTP_CLIENT
+        /// <summary>
+        /// Returns the HTTP client of the runtime, created by the first member asking for it.
+        /// </summary>
+        std::shared_ptr<IHttpClient> GetHttpClient();
+#endif
+
+        /// <summary>
+        /// Returns a partition of the disk storage engine shared by the members posting to the
+        /// collector URI of the configuration. The engine uses a database of its own, next to the
+        /// cache file of the first member, and the settings of that member.
+        /// </summary>
+        /// <param name="logManager">Member owning the partition, notified of the engine debug events.</param>
+        /// <param name="config">Runtime configuration of the member.</param>
+        std::shared_ptr<IOfflineStorage> GetStorage(ILogManager& logManager, IRuntimeConfig& config);
+
+    protected:
+        class StorageEngine;
+        class StoragePartition;
+
+        explicit SharedRuntime(const std::string& name);
+
+        static std::string getEngineFilePath(const std::string& name, const std::string& memberPath, const std::string& collectorUrl);
+
+        std::mutex                                          m_lock;
+        std::string                                         m_name;
+        std::shared_ptr<IHttpClient>                        m_httpClient;
+        std::map<std::string, std::weak_ptr<StorageEngine>> m_engines;
+
+        MATSDK_LOG_DECL_COMPONENT_CLASS();
+    };
+
+} MAT_NS_END
+
+#endif // SHAREDRUNTIME_HPP
@@ -20,6 +20,10 @@ namespace MAT_NS_BEGIN {
 /// <param name="httpClient">The HTTP client.</param>
 /// <param name="taskDispatcher">The async task dispatcher.</param>
 /// <param name="bandwidthController">The bandwidth controller.</param>
+/// <param name="logSessionDataProvider">The log session data provider.</param>
+/// <param name="pipelineLatency">The per-stage pipeline latency recorder.</param>
+/// <param name="transmitProfiles">The transmit profiles of the log manager.</param>
+/// <param name="memoryBudget">The memory budget of the log manager.</param>
     TelemetrySystem::TelemetrySystem(
         ILogManager& logManager,
         IRuntimeConfig& runtimeConfig,
@@ -27,16 +31,20 @@ namespace MAT_NS_BEGIN {
         IHttpClient& httpClient,
         ITaskDispatcher& taskDispatcher,
         IBandwidthController* bandwidthController,
-        LogSessionDataProvider& logSessionDataProvider)
+        LogSessionDataProvider& logSessionDataProvider,
+        PipelineLatencyRecorder& pipelineLatency,
+        TransmitProfiles& transmitProfiles,
+        MemoryBudget& memoryBudget)
         :
         TelemetrySystemBase(logManager, runtimeConfig, taskDispatcher),
         compression(runtimeConfig),
-        hcm(logManager, httpClient, taskDispatcher),
+        hcm(logManager, httpClient, taskDispatcher, &memoryBudget),
         httpEncoder(*this, httpClient),
         httpDecoder(*this),
         storage(*this, offlineStorage),
-        packager(runtimeConfig),
-        tpm(*this, taskDispatcher, bandwidthController)
+        packager(runtimeConfig, &memoryBudget),
+        tpm(*this, taskDispatcher, bandwidthController, transmitProfiles),
+        latency(pipelineLatency)
     {
 
         // Handler for start
@@ -149,39 +157,44 @@ namespace MAT_NS_BEGIN {
         tpm.allUploadsFinished >> stats.onStop >> this->flushTaskDispatcher;
 
         // On an arbitrary user thread
-        this->sending >> bondSerializer.serialize >> this->incomingEventPrepared;
+        this->sending >> latency.incomingStarted >> bondSerializer.serialize >> latency.serialized >> this->incomingEventPrepared;
 
         // On the inner worker thread
-        this->preparedIncomingEvent >> storage.storeRecord >> stats.onIncomingEventAccepted >> tpm.eventArrived;
+        this->preparedIncomingEvent >> storage.storeRecord >> latency.stored >> stats.onIncomingEventAccepted >> tpm.eventArrived;
 
 
         storage.storeRecordFailed >> stats.onIncomingEventFailed;
 
-        tpm.initiateUpload >> storage.retrieveEvents;
+        // Batched events share one storage write and one upload scheduling decision
+        this->preparedIncomingEvents >> storage.storeRecords;
+        storage.recordsStored >> latency.batchStored >> stats.onIncomingEventsAccepted >> tpm.eventsArrived;
+        storage.storeRecordsFailed >> stats.onIncomingEventsFailed;
+
+        tpm.initiateUpload >> latency.uploadStarted >> storage.retrieveEvents;
 
         storage.retrievedEvent >> packager.addEventToPackage;
-        storage.retrievalFinished >> packager.finalizePackage;
+        storage.retrievalFinished >> latency.retrieved >> packager.finalizePackage;
 
         storage.retrievalFailed >> tpm.nothingToUpload;
         packager.emptyPackage >> tpm.nothingToUpload;
 
-        packager.packagedEvents >>
+        packager.packagedEvents >> latency.packaged >>
 #ifdef HAVE_MAT_ZLIB
-        compression.compress >>
+        compression.compress >> latency.compressed >>
 #endif
-        httpEncoder.encode >> clockSkewDelta.encode >> stats.onUploadStarted >> hcm.sendRequest;
+        httpEncoder.encode >> clockSkewDelta.encode >> latency.encoded >> stats.onUploadStarted >> tpm.uploadStarting >> hcm.sendRequest;
 
 #ifdef HAVE_MAT_ZLIB
         compression.compressionFailed >> storage.releaseRecords >> stats.onPackagingFailed >> tpm.packagingFailed;
 #endif
 
-        hcm.requestDone >> clockSkewDelta.decode >> httpDecoder.decode;
+        hcm.requestDone >> latency.sent >> clockSkewDelta.decode >> httpDecoder.decode;
 
-        httpDecoder.eventsAccepted >> storage.deleteRecords >> stats.onUploadSuccessful >> tpm.eventsUploadSuccessful;
-        httpDecoder.eventsRejected >> storage.deleteRecords >> stats.onUploadRejected >> tpm.eventsUploadRejected;
-        httpDecoder.temporaryNetworkFailure >> storage.releaseRecords >> stats.onUploadFailed >> tpm.eventsUploadFailed;
-        httpDecoder.temporaryServerFailure >> storage.releaseRecordsIncRetryCount >> stats.onUploadFailed >> tpm.eventsUploadFailed;
-        httpDecoder.requestAborted >> storage.releaseRecords >> stats.onUploadFailed >> tpm.eventsUploadAborted;
+        httpDecoder.eventsAccepted >> storage.deleteRecords >> latency.responded >> stats.onUploadSuccessful >> tpm.eventsUploadSuccessful;
+        httpDecoder.eventsRejected >> storage.deleteRecords >> latency.responded >> stats.onUploadRejected >> tpm.eventsUploadRejected;
+        httpDecoder.temporaryNetworkFailure >> storage.releaseRecords >> latency.responded >> stats.onUploadFailed >> tpm.eventsUploadFailed;
+        httpDecoder.temporaryServerFailure >> storage.releaseRecordsIncRetryCount >> latency.responded >> stats.onUploadFailed >> tpm.eventsUploadFailed;
+        httpDecoder.requestAborted >> storage.releaseRecords >> latency.responded >> stats.onUploadFailed >> tpm.eventsUploadAborted;
 
 
         //
@@ -211,7 +224,7 @@ namespace MAT_NS_BEGIN {
         return false;
     }
 
-    void TelemetrySystem::handleIncomingEventPrepared(IncomingEventContextPtr const& event)
+    bool TelemetrySystem::isEventSizeAccepted(IncomingEventContextPtr const& event)
     {
         uint32_t maxBlobSize = m_config[CFG_MAP_TPM][CFG_INT_TPM_MAX_BLOB_BYTES];
         if (event->record.blob.size() > maxBlobSize)
@@ -222,6 +235,15 @@ namespace MAT_NS_BEGIN {
             m_logManager.DispatchEvent(evt);
             LOG_INFO("Event %s/%s dropped because size more than 2 MB",
                 tenantTokenToId(event->record.tenantToken).c_str(), event->source->baseType.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void TelemetrySystem::handleIncomingEventPrepared(IncomingEventContextPtr const& event)
+    {
+        if (!isEventSizeAccepted(event))
+        {
             return;
         }
 
@@ -229,6 +251,26 @@ namespace MAT_NS_BEGIN {
         preparedIncomingEventAsync(event);
     }
 
+    void TelemetrySystem::sendEvents(IncomingEventContextBatch const& events)
+    {
+        // Same stages as the sending route, but the serialized events are stored together
+        IncomingEventContextBatch prepared;
+        prepared.reserve(events.size());
+        for (auto const& event : events)
+        {
+            if (latency.incomingStarted(event) && bondSerializer.serialize(event) && latency.serialized(event) && isEventSizeAccepted(event))
+            {
+                event->source = nullptr;
+                prepared.push_back(event);
+            }
+        }
+
+        if (!prepared.empty())
+        {
+            preparedIncomingEvents(prepared);
+        }
+    }
+
     void TelemetrySystem::handleFlushTaskDispatcher()
     {
         signalDone();
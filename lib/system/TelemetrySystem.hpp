@@ -26,6 +26,10 @@
 
 #include "packager/Packager.hpp"
 
+#include "stats/PipelineLatencyRecorder.hpp"
+
+#include "system/MemoryBudget.hpp"
+
 #include "tpm/TransmissionPolicyManager.hpp"
 #include "ClockSkewDelta.h"
 
@@ -49,16 +53,22 @@ namespace MAT_NS_BEGIN {
             IHttpClient& httpClient,
             ITaskDispatcher& taskDispatcher,
             IBandwidthController* bandwidthController,
-            LogSessionDataProvider& logSessionDataProvider
+            LogSessionDataProvider& logSessionDataProvider,
+            PipelineLatencyRecorder& pipelineLatency,
+            TransmitProfiles& transmitProfiles,
+            MemoryBudget& memoryBudget
         );
 
         ~TelemetrySystem();
 
         virtual bool upload() override;
         virtual void handleIncomingEventPrepared(IncomingEventContextPtr const& event) override;
+        virtual void sendEvents(IncomingEventContextBatch const& events) override;
 
     protected:
 
+        bool isEventSizeAccepted(IncomingEventContextPtr const& event);
+
         virtual void handleFlushTaskDispatcher() override;
 
 #ifdef HAVE_MAT_ZLIB
@@ -74,6 +84,7 @@ namespace MAT_NS_BEGIN {
         Packager                  packager;
         TransmissionPolicyManager tpm;
         ClockSkewDelta            clockSkewDelta;
+        PipelineLatencyHops       latency;
 
     public:
         RouteSink<TelemetrySystem>                                 flushTaskDispatcher{ this, &TelemetrySystem::handleFlushTaskDispatcher };
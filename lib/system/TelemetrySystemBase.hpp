@@ -5,6 +5,7 @@
 #ifndef TELEMETRYSYSTEMBASE_HPP
 #define TELEMETRYSYSTEMBASE_HPP
 
+#include "system/ContextPools.hpp"
 #include "system/ITelemetrySystem.hpp"
 #include "ITaskDispatcher.hpp"
 #include "stats/Statistics.hpp"
@@ -164,7 +165,7 @@ namespace MAT_NS_BEGIN {
 
         EventsUploadContextPtr createEventsUploadContext() override
         {
-            return std::make_shared<EventsUploadContext>();
+            return ContextPools::AcquireEventsUploadContext();
         }
 
         virtual bool DispatchEvent(DebugEvent evt) override
@@ -192,6 +193,7 @@ namespace MAT_NS_BEGIN {
     public:
         RouteSource<IncomingEventContextPtr const&>                sending;
         RouteSource<IncomingEventContextPtr const&>                preparedIncomingEvent;
+        RouteSource<IncomingEventContextBatch const&>              preparedIncomingEvents;
 
     };
 
@@ -23,8 +23,10 @@ using namespace PAL;
 * Initialize and start the DeviceStateHandler
 *
 ******************************************************************************/
-void DeviceStateHandler::Start()
+void DeviceStateHandler::Start(TransmitProfiles& transmitProfiles)
 {
+	m_transmitProfiles = &transmitProfiles;
+
 	// TRACE("_RetrieveAndRegisterForDeviceConditionChange");
 
 	m_networkInformation = PAL::GetNetworkInformation();
@@ -141,7 +143,10 @@ void DeviceStateHandler::OnChanged(
      //m_networkCost, NetworkCostNames[m_networkCost].c_str(),
      //m_powerSource, PowerSourceNames[m_powerSource].c_str());
 
-     TransmitProfiles::updateStates(m_networkCost, m_powerSource);
+     if (m_transmitProfiles != nullptr)
+     {
+         m_transmitProfiles->updateStates(m_networkCost, m_powerSource);
+     }
 
 	 //do we need to stop current timer?? and restart
  }
@@ -17,11 +17,13 @@
 
 namespace MAT_NS_BEGIN {
 
+class TransmitProfiles;
+
 class DeviceStateHandler
     : public PAL::IPropertyChangedCallback
 {
 public:
-    void Start();
+    void Start(TransmitProfiles& transmitProfiles);
     void Stop();
 
     // Callback functions
@@ -32,6 +34,7 @@ protected:
     NetworkType m_networkType;
     NetworkCost m_networkCost { NetworkCost_Unmetered };
     PowerSource m_powerSource { PowerSource_Charging };
+    TransmitProfiles* m_transmitProfiles { nullptr };
 
     virtual void _UpdateDeviceCondition();
 
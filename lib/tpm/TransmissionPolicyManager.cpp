@@ -7,6 +7,7 @@
 #include "TransmitProfiles.hpp"
 #include "utils/Utils.hpp"
 
+#include <algorithm>
 #include <limits>
 
 namespace MAT_NS_BEGIN {
@@ -19,15 +20,19 @@ namespace MAT_NS_BEGIN {
 
     MATSDK_LOG_INST_COMPONENT_CLASS(TransmissionPolicyManager, "EventsSDK.TPM", "Events telemetry client - TransmissionPolicyManager class");
 
-    TransmissionPolicyManager::TransmissionPolicyManager(ITelemetrySystem& system, ITaskDispatcher& taskDispatcher, IBandwidthController* bandwidthController) :
+    TransmissionPolicyManager::TransmissionPolicyManager(ITelemetrySystem& system, ITaskDispatcher& taskDispatcher, IBandwidthController* bandwidthController, TransmitProfiles& transmitProfiles) :
         m_system(system),
         m_taskDispatcher(taskDispatcher),
         m_config(m_system.getConfig()),
-        m_bandwidthController(bandwidthController)
+        m_bandwidthController(bandwidthController),
+        m_transmitProfiles(transmitProfiles)
     {
         m_backoff = IBackoff::createFromConfig(m_backoffConfig);
         assert(m_backoff);
-        m_deviceStateHandler.Start();
+        // Other processes store into a shared database without this instance being notified,
+        // and this instance may have to take over as uploader: keep the timer running when idle
+        m_pollStorage = m_config[CFG_BOOL_ENABLE_MULTIPROCESS_STORAGE];
+        m_deviceStateHandler.Start(m_transmitProfiles);
     }
 
     TransmissionPolicyManager::~TransmissionPolicyManager()
@@ -161,30 +166,69 @@ namespace MAT_NS_BEGIN {
             }
         }
 
-#ifdef ENABLE_BW_CONTROLLER   /* Bandwidth controller is not currently supported */
+        unsigned maxUploadSize = 0;
         if (m_bandwidthController) {
-            unsigned proposedBandwidthBps = m_bandwidthController->GetProposedBandwidthBps();
-            unsigned minimumBandwidthBps = m_config.GetMinimumUploadBandwidthBps();
-            if (proposedBandwidthBps >= minimumBandwidthBps) {
-                LOG_TRACE("Bandwidth controller proposed sufficient bandwidth %u bytes/sec (minimum accepted is %u)",
-                    proposedBandwidthBps, minimumBandwidthBps);
+            // A byte budget is charged once the request body is known, so paced uploads go one at a time.
+            // The active upload reschedules the next one when it finishes.
+            unsigned availableBytes = m_bandwidthController->GetAvailableBytes();
+            if ((availableBytes != (std::numeric_limits<unsigned>::max)()) && (uploadCount() > 0)) {
+                LOG_TRACE("Paced upload in progress, not starting another one");
+                return;
             }
-            else {
-                unsigned delayMs = 1000;
-                LOG_INFO("Bandwidth controller proposed bandwidth %u bytes/sec but minimum accepted is %u, will retry %u ms later",
-                    proposedBandwidthBps, minimumBandwidthBps, delayMs);
-                scheduleUpload(delayMs, latency); // reschedule uploadAsync to run again 1000 ms later
+            std::chrono::milliseconds delay = getPacingDelay(availableBytes, maxUploadSize);
+            if (delay.count() > 0) {
+                scheduleUpload(delay, latency); // reschedule uploadAsync to run again once the budget allows
                 return;
             }
         }
-#endif
 
         auto ctx = m_system.createEventsUploadContext();
         ctx->requestedMinLatency = m_runningLatency;
+        ctx->maxUploadSize = maxUploadSize;
         addUpload(ctx);
         initiateUpload(ctx);
     }
 
+    /// <summary>
+    /// Sizes the next package to the available bandwidth budget, or returns how long to wait for it.
+    /// A package is sent once the budget covers a full package or one second worth of bandwidth,
+    /// whichever is smaller, so that uploads are paced rather than split into tiny requests.
+    /// </summary>
+    std::chrono::milliseconds TransmissionPolicyManager::getPacingDelay(unsigned availableBytes, unsigned& maxUploadSize)
+    {
+        unsigned proposedBandwidthBps = m_bandwidthController->GetProposedBandwidthBps();
+        unsigned minimumBandwidthBps = m_config.GetMinimumUploadBandwidthBps();
+        if (proposedBandwidthBps == 0 || proposedBandwidthBps < minimumBandwidthBps) {
+            LOG_INFO("Bandwidth controller proposed bandwidth %u bytes/sec but minimum accepted is %u, will retry %u ms later",
+                proposedBandwidthBps, minimumBandwidthBps, static_cast<unsigned>(BandwidthRetryDelay.count()));
+            return BandwidthRetryDelay;
+        }
+
+        unsigned maximumUploadSize = m_config.GetMaximumUploadSizeBytes();
+        unsigned packageSize = (std::min)(maximumUploadSize, proposedBandwidthBps);
+        if (availableBytes >= packageSize) {
+            maxUploadSize = (std::min)(maximumUploadSize, availableBytes);
+            LOG_TRACE("Bandwidth controller allows %u bytes (%u bytes/sec)", maxUploadSize, proposedBandwidthBps);
+            return std::chrono::milliseconds {};
+        }
+
+        uint64_t missingBytes = packageSize - availableBytes;
+        std::chrono::milliseconds delay { (missingBytes * 1000 + proposedBandwidthBps - 1) / proposedBandwidthBps };
+        LOG_TRACE("Bandwidth controller allows %u bytes (%u bytes/sec), pacing upload by %u ms",
+            availableBytes, proposedBandwidthBps, static_cast<unsigned>(delay.count()));
+        return delay;
+    }
+
+    bool TransmissionPolicyManager::handleUploadStarting(EventsUploadContextPtr const& ctx)
+    {
+        if (m_bandwidthController) {
+            // The encoder hands the body over to the HTTP request, whose estimate includes the headers
+            size_t size = (ctx->httpRequest != nullptr) ? ctx->httpRequest->GetSizeEstimate() : ctx->body.size();
+            m_bandwidthController->OnBytesUploaded(static_cast<unsigned>(size));
+        }
+        return true;
+    }
+
     void TransmissionPolicyManager::finishUpload(EventsUploadContextPtr const& ctx, const std::chrono::milliseconds& nextUpload)
     {
         LOG_TRACE("HTTP upload finished for ctx=%p", ctx.get());
@@ -205,10 +249,10 @@ namespace MAT_NS_BEGIN {
 
     bool TransmissionPolicyManager::updateTimersIfNecessary()
     {
-        bool needsUpdate = TransmitProfiles::isTimerUpdateRequired();
+        bool needsUpdate = m_transmitProfiles.isTimerUpdateRequired();
         if (needsUpdate)
         {
-            TransmitProfiles::getTimers(m_timers);
+            m_transmitProfiles.getTimers(m_timers);
         }
         return needsUpdate;
     }
@@ -301,7 +345,7 @@ namespace MAT_NS_BEGIN {
         }
 
         // Schedule async upload if not scheduled yet
-        if (!m_isUploadScheduled || TransmitProfiles::isTimerUpdateRequired())
+        if (!m_isUploadScheduled || m_transmitProfiles.isTimerUpdateRequired())
         {
             if (updateTimersIfNecessary())
             {
@@ -316,6 +360,23 @@ namespace MAT_NS_BEGIN {
         }
     }
 
+    void TransmissionPolicyManager::handleEventsArrived(IncomingEventContextBatch const& events)
+    {
+        // One scheduling decision for the whole batch, driven by its most urgent event
+        IncomingEventContextPtr urgent = nullptr;
+        for (auto const& event : events)
+        {
+            if (urgent == nullptr || event->record.latency > urgent->record.latency)
+            {
+                urgent = event;
+            }
+        }
+        if (urgent != nullptr)
+        {
+            handleEventArrived(urgent);
+        }
+    }
+
     // We do only Normal if too few values or timers[0] == timers[2]
     // We do only RealTime if timers[0] < 0 (do not transmit)
     // We alternate RealTime and Normal otherwise (timers differ)
@@ -345,7 +406,7 @@ namespace MAT_NS_BEGIN {
     {
         LOG_TRACE("No stored events to send at the moment");
         resetBackoff();
-        if (ctx->requestedMinLatency == EventLatency_Normal)
+        if (ctx->requestedMinLatency == EventLatency_Normal && !m_pollStorage)
         {
             finishUpload(ctx, std::chrono::milliseconds{ -1 });
         }
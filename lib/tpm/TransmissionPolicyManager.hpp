@@ -42,11 +42,14 @@ constexpr std::chrono::milliseconds DefaultTaskCancelTime { 500 };
 
 constexpr const char* const DefaultBackoffConfig = "E,3000,300000,2,1";
 
+// Retry delay while the bandwidth controller proposes no usable bandwidth at all
+constexpr std::chrono::milliseconds BandwidthRetryDelay { 1000 };
+
     class TransmissionPolicyManager
     {
 
     public:
-        TransmissionPolicyManager(ITelemetrySystem& system, ITaskDispatcher& taskDispatcher, IBandwidthController* bandwidthController);
+        TransmissionPolicyManager(ITelemetrySystem& system, ITaskDispatcher& taskDispatcher, IBandwidthController* bandwidthController, TransmitProfiles& transmitProfiles);
         virtual ~TransmissionPolicyManager();
         virtual void scheduleUpload(const std::chrono::milliseconds& delay, EventLatency latency, bool force = false);
 
@@ -59,6 +62,8 @@ constexpr const char* const DefaultBackoffConfig = "E,3000,300000,2,1";
         void uploadAsync(EventLatency priority);
         void finishUpload(EventsUploadContextPtr const& ctx, const std::chrono::milliseconds& nextUpload);
         bool updateTimersIfNecessary();
+        std::chrono::milliseconds getPacingDelay(unsigned availableBytes, unsigned& maxUploadSize);
+        bool handleUploadStarting(EventsUploadContextPtr const& ctx);
 
         bool handleStart();
         bool handlePause();
@@ -67,6 +72,7 @@ constexpr const char* const DefaultBackoffConfig = "E,3000,300000,2,1";
         void handleFinishAllUploads();
 
         void handleEventArrived(IncomingEventContextPtr const& event);
+        void handleEventsArrived(IncomingEventContextBatch const& events);
 
         void handleNothingToUpload(EventsUploadContextPtr const& ctx);
         void handlePackagingFailed(EventsUploadContextPtr const& ctx);
@@ -83,6 +89,7 @@ constexpr const char* const DefaultBackoffConfig = "E,3000,300000,2,1";
         ITaskDispatcher&                 m_taskDispatcher;
         IRuntimeConfig&                  m_config;
         IBandwidthController*            m_bandwidthController;
+        TransmitProfiles&                m_transmitProfiles;
 
         std::recursive_mutex             m_backoffMutex;
         std::string                      m_backoffConfig { DefaultBackoffConfig };
@@ -95,6 +102,7 @@ constexpr const char* const DefaultBackoffConfig = "E,3000,300000,2,1";
         std::mutex                       m_scheduledUploadMutex;
         PAL::DeferredCallbackHandle      m_scheduledUpload;
         bool                             m_scheduledUploadAborted { false };
+        bool                             m_pollStorage { false };
 
         mutable std::mutex               m_activeUploads_lock;
         std::set<EventsUploadContextPtr> m_activeUploads;
@@ -143,8 +151,10 @@ constexpr const char* const DefaultBackoffConfig = "E,3000,300000,2,1";
         RouteSource<>                                                        allUploadsFinished;
 
         RouteSink<TransmissionPolicyManager, IncomingEventContextPtr const&> eventArrived{ this, &TransmissionPolicyManager::handleEventArrived };
+        RouteSink<TransmissionPolicyManager, IncomingEventContextBatch const&> eventsArrived{ this, &TransmissionPolicyManager::handleEventsArrived };
 
         RouteSource<EventsUploadContextPtr const&>                           initiateUpload;
+        RoutePassThrough<TransmissionPolicyManager, EventsUploadContextPtr const&> uploadStarting{ this, &TransmissionPolicyManager::handleUploadStarting };
         RouteSink<TransmissionPolicyManager, EventsUploadContextPtr const&>  nothingToUpload{ this, &TransmissionPolicyManager::handleNothingToUpload };
         RouteSink<TransmissionPolicyManager, EventsUploadContextPtr const&>  packagingFailed{ this, &TransmissionPolicyManager::handlePackagingFailed };
         RouteSink<TransmissionPolicyManager, EventsUploadContextPtr const&>  eventsUploadSuccessful{ this, &TransmissionPolicyManager::handleEventsUploadSuccessful };
@@ -40,38 +40,46 @@ static const char* DEFAULT_PROFILE = defaultRealTimeProfileName;
 /// This map greatly helps to simplify the serialization from JSON to binary.
 /// </summary>
 #ifdef HAVE_MAT_JSONHPP
-static std::map<std::string, int > transmitProfileNetCost;
-static std::map<std::string, int > transmitProfilePowerState;
+static const std::map<std::string, int>& transmitProfileNetCost()
+{
+    static const std::map<std::string, int> fields = {
+        { "any", NetworkCost_Any },
+        { "unknown", NetworkCost_Unknown },
+        { "unmetered", NetworkCost_Unmetered },
+        { "low", NetworkCost_Unmetered },
+        { "metered", NetworkCost_Metered },
+        { "high", NetworkCost_Metered },
+        { "restricted", NetworkCost_Roaming },
+        { "roaming", NetworkCost_Roaming }
+    };
+    return fields;
+}
 
-static void initTransmitProfileFields()
+static const std::map<std::string, int>& transmitProfilePowerState()
 {
-    transmitProfileNetCost["any"] = (NetworkCost_Any);
-    transmitProfileNetCost["unknown"] = (NetworkCost_Unknown);
-    transmitProfileNetCost["unmetered"] = (NetworkCost_Unmetered);
-    transmitProfileNetCost["low"] = (NetworkCost_Unmetered);
-    transmitProfileNetCost["metered"] = (NetworkCost_Metered);
-    transmitProfileNetCost["high"] = (NetworkCost_Metered);
-    transmitProfileNetCost["restricted"] = (NetworkCost_Roaming);
-    transmitProfileNetCost["roaming"] = (NetworkCost_Roaming);
-
-    transmitProfilePowerState["any"] = (PowerSource_Any);
-    transmitProfilePowerState["unknown"] = (PowerSource_Unknown);
-    transmitProfilePowerState["battery"] = (PowerSource_Battery);
-    transmitProfilePowerState["charging"] = (PowerSource_Charging);
-};
+    static const std::map<std::string, int> fields = {
+        { "any", PowerSource_Any },
+        { "unknown", PowerSource_Unknown },
+        { "battery", PowerSource_Battery },
+        { "charging", PowerSource_Charging }
+    };
+    return fields;
+}
 #endif
 
-#define LOCK_PROFILES       std::lock_guard<std::recursive_mutex> lock(profiles_mtx)
+/// <summary>
+/// Both timers fit in one word, which is published and read as a whole
+/// </summary>
+static uint64_t packTimers(int first, int second) noexcept
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(first)) << 32) | static_cast<uint32_t>(second);
+}
 
-namespace MAT_NS_BEGIN {
+static const uint64_t disabledTimers = packTimers(-1, -1);
 
-    static std::recursive_mutex profiles_mtx;
-    map<string, TransmitProfileRules>      TransmitProfiles::profiles;
-    string      TransmitProfiles::currProfileName = DEFAULT_PROFILE;
-    size_t      TransmitProfiles::currRule = 0;
-    NetworkCost TransmitProfiles::currNetCost = NetworkCost::NetworkCost_Any;
-    PowerSource TransmitProfiles::currPowState = PowerSource::PowerSource_Any;
-    bool        TransmitProfiles::isTimerUpdated = true;
+#define LOCK_PROFILES       std::lock_guard<std::recursive_mutex> lock(profilesLock)
+
+namespace MAT_NS_BEGIN {
 
     /// <summary>
     /// Get current transmit profile name
@@ -231,8 +239,8 @@ namespace MAT_NS_BEGIN {
                                     if (itRule.value().end() != itnetCost)
                                     {
                                         std::string netCost = itRule.value()["netCost"];
-                                        std::map<std::string, int>::const_iterator iter = transmitProfileNetCost.find(netCost);
-                                        if (iter != transmitProfileNetCost.end())
+                                        std::map<std::string, int>::const_iterator iter = transmitProfileNetCost().find(netCost);
+                                        if (iter != transmitProfileNetCost().end())
                                         {
                                             rule.netCost = static_cast<NetworkCost>(iter->second);
                                         }
@@ -242,8 +250,8 @@ namespace MAT_NS_BEGIN {
                                     if (itRule.value().end() != itpowerState)
                                     {
                                         std::string powerState = itRule.value()["powerState"];
-                                        std::map<std::string, int>::const_iterator iter = transmitProfilePowerState.find(powerState);
-                                        if (iter != transmitProfilePowerState.end())
+                                        std::map<std::string, int>::const_iterator iter = transmitProfilePowerState().find(powerState);
+                                        if (iter != transmitProfilePowerState().end())
                                         {
                                             rule.powerState = static_cast<PowerSource>(iter->second);
                                         }
@@ -457,71 +465,54 @@ namespace MAT_NS_BEGIN {
     /// </summary>
     /// <returns></returns>
     void TransmitProfiles::getTimers(TimerArray& out) {
-        EnsureDefaultProfiles();
+        // Clear the flag first: a concurrent update then raises it again for the next check
+        isTimerUpdated.exchange(false, std::memory_order_acq_rel);
+        uint64_t timers = activeTimers.load(std::memory_order_acquire);
+        out[0] = static_cast<int>(static_cast<uint32_t>(timers >> 32));
+        out[1] = static_cast<int>(static_cast<uint32_t>(timers));
+    }
 
-        LOCK_PROFILES;
+    /// <summary>
+    /// This function is called only from updateStates
+    /// </summary>
+    void TransmitProfiles::onTimersUpdated() {
+        uint64_t timers = disabledTimers;
         auto it = profiles.find(currProfileName);
-        // When we can't get timers, we won't set isTimerUpdated to false,
-        // so we will keep calling getTimers from TransmissionPolicyManager.
         if (it == profiles.end()) {
-            out.fill(-1);
             LOG_WARN("No active profile found, disabling all transmission timers.");
-            return;
         }
-        if (currRule >= it->second.rules.size()) {
-            out.fill(-1);
+        else if (currRule >= it->second.rules.size()) {
             LOG_ERROR(
                 "Profile %s current rule %iz >= profile length %iz",
                 currProfileName.c_str(),
                 currRule,
                 it->second.rules.size()
             );
-            return;
         }
-        auto const & rule = (it->second).rules[currRule];
-        if (rule.timers.empty()) {
-            out.fill(-1);
+        else if ((it->second).rules[currRule].timers.empty()) {
             LOG_ERROR(
                 "Profile %s rule %iz has no timers",
                 currProfileName.c_str(),
                 currRule
             );
-            return;
         }
-        out[0] = 1000 * rule.timers[0];
-        out[1] = out[0];
-        if (rule.timers.size() > 2) {
-            out[1] = 1000 * rule.timers[2];
-        }
-        isTimerUpdated = false;
-    }
-
-    /// <summary>
-    /// 
-    /// </summary>
-    bool TransmitProfiles::isTimerUpdateRequired()
-    {
-        LOCK_PROFILES;
-        return isTimerUpdated;
-    }
-
-    /// <summary>
-    /// This function is called only from updateStates
-    /// </summary>
-    void TransmitProfiles::onTimersUpdated() {
-        isTimerUpdated = true;
+        else {
+            auto const & rule = (it->second).rules[currRule];
+            int first = 1000 * rule.timers[0];
+            int second = (rule.timers.size() > 2) ? 1000 * rule.timers[2] : first;
+            timers = packTimers(first, second);
 #ifdef HAVE_MAT_LOGGING
-        auto it = profiles.find(currProfileName);
-        if (it != profiles.end()) {
-            /* Debug routine to print the list of currently selected timers */
-            TransmitProfileRule &rule = (it->second).rules[currRule];
             // Print just 3 timers for now because we support only 3
-            LOG_INFO("timers=[%3d,%3d,%3d]",
-                rule.timers[0],
-                rule.timers[1],
-                rule.timers[2]);
-        }
+            if (rule.timers.size() > 2) {
+                LOG_INFO("timers=[%3d,%3d,%3d]",
+                    rule.timers[0],
+                    rule.timers[1],
+                    rule.timers[2]);
+            }
 #endif
+        }
+        activeTimers.store(timers, std::memory_order_release);
+        isTimerUpdated.store(true, std::memory_order_release);
     }
 
     /// <summary>
@@ -552,19 +543,20 @@ namespace MAT_NS_BEGIN {
                     break;
                 }
             }
-            onTimersUpdated();
         }
+        onTimersUpdated();
         return result;
     }
 
-    TransmitProfiles::TransmitProfiles()
+    TransmitProfiles::TransmitProfiles() :
+        currProfileName(DEFAULT_PROFILE),
+        currRule(0),
+        currNetCost(NetworkCost::NetworkCost_Any),
+        currPowState(PowerSource::PowerSource_Any),
+        isTimerUpdated(true),
+        activeTimers(disabledTimers)
     {
-#ifdef HAVE_MAT_JSONHPP
-        initTransmitProfileFields();
-#endif
+        reset();
     }
 
-    // Make sure we populate transmitProfileFields dynamically before start
-    static TransmitProfiles __profiles;
-
 } MAT_NS_END
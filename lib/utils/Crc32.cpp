@@ -0,0 +1,195 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "Crc32.hpp"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MAT_CRC32C_SSE42
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif (defined(__aarch64__) || defined(__arm__)) && defined(__ARM_FEATURE_CRC32)
+#define MAT_CRC32C_ARMV8
+#include <arm_acle.h>
+#endif
+
+namespace MAT_NS_BEGIN
+{
+    // Reflected CRC-32C polynomial
+    static const uint32_t Crc32cPolynomial = 0x82F63B78;
+
+    /// <summary>
+    /// Tables of the slice-by-8 algorithm: values[k][b] is the CRC of byte b followed by k zero bytes.
+    /// </summary>
+    struct Crc32cTable
+    {
+        uint32_t values[8][256];
+
+        Crc32cTable()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc >> 1) ^ ((crc & 1) ? Crc32cPolynomial : 0);
+                }
+                values[0][i] = crc;
+            }
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                for (int k = 1; k < 8; k++)
+                {
+                    values[k][i] = (values[k - 1][i] >> 8) ^ values[0][values[k - 1][i] & 0xFF];
+                }
+            }
+        }
+    };
+
+    static uint32_t crc32cSoftware(const uint8_t* bytes, size_t size, uint32_t crc)
+    {
+        static const Crc32cTable table;
+        auto const& t = table.values;
+
+        while (size != 0 && (reinterpret_cast<uintptr_t>(bytes) & 7) != 0)
+        {
+            crc = t[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+            size--;
+        }
+        while (size >= 8)
+        {
+            // Little-endian reading of the next 8 bytes, without relying on the host byte order
+            uint32_t low = crc ^ (static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+                                  (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24));
+            crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+                  t[3][bytes[4]] ^ t[2][bytes[5]] ^ t[1][bytes[6]] ^ t[0][bytes[7]];
+            bytes += 8;
+            size -= 8;
+        }
+        while (size != 0)
+        {
+            crc = t[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+            size--;
+        }
+        return crc;
+    }
+
+#if defined(MAT_CRC32C_SSE42)
+
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("sse4.2")))
+#endif
+    static uint32_t crc32cHardware(const uint8_t* bytes, size_t size, uint32_t crc)
+    {
+        while (size != 0 && (reinterpret_cast<uintptr_t>(bytes) & 7) != 0)
+        {
+            crc = _mm_crc32_u8(crc, *bytes++);
+            size--;
+        }
+#if defined(__x86_64__) || defined(_M_X64)
+        uint64_t crc64 = crc;
+        while (size >= 8)
+        {
+            uint64_t value;
+            memcpy(&value, bytes, sizeof(value));
+            crc64 = _mm_crc32_u64(crc64, value);
+            bytes += 8;
+            size -= 8;
+        }
+        crc = static_cast<uint32_t>(crc64);
+#endif
+        while (size >= 4)
+        {
+            uint32_t value;
+            memcpy(&value, bytes, sizeof(value));
+            crc = _mm_crc32_u32(crc, value);
+            bytes += 4;
+            size -= 4;
+        }
+        while (size != 0)
+        {
+            crc = _mm_crc32_u8(crc, *bytes++);
+            size--;
+        }
+        return crc;
+    }
+
+    static bool hasHardwareSupport()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2") != 0;
+#endif
+    }
+
+#elif defined(MAT_CRC32C_ARMV8)
+
+    static uint32_t crc32cHardware(const uint8_t* bytes, size_t size, uint32_t crc)
+    {
+        while (size != 0 && (reinterpret_cast<uintptr_t>(bytes) & 7) != 0)
+        {
+            crc = __crc32cb(crc, *bytes++);
+            size--;
+        }
+        while (size >= 8)
+        {
+            uint64_t value;
+            memcpy(&value, bytes, sizeof(value));
+            crc = __crc32cd(crc, value);
+            bytes += 8;
+            size -= 8;
+        }
+        while (size != 0)
+        {
+            crc = __crc32cb(crc, *bytes++);
+            size--;
+        }
+        return crc;
+    }
+
+    static bool hasHardwareSupport()
+    {
+        // The compiler was told the target has the CRC extension (mandatory from ARMv8.1)
+        return true;
+    }
+
+#else
+
+    static uint32_t crc32cHardware(const uint8_t* bytes, size_t size, uint32_t crc)
+    {
+        return crc32cSoftware(bytes, size, crc);
+    }
+
+    static bool hasHardwareSupport()
+    {
+        return false;
+    }
+
+#endif
+
+    bool Crc32::IsHardwareAccelerated()
+    {
+        static const bool accelerated = hasHardwareSupport();
+        return accelerated;
+    }
+
+    uint32_t Crc32::Crc32c(const void* data, size_t size, uint32_t crc)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        return ~(IsHardwareAccelerated() ? crc32cHardware(bytes, size, ~crc) : crc32cSoftware(bytes, size, ~crc));
+    }
+
+    uint32_t Crc32::Crc32cSoftware(const void* data, size_t size, uint32_t crc)
+    {
+        return ~crc32cSoftware(static_cast<const uint8_t*>(data), size, ~crc);
+    }
+
+} MAT_NS_END
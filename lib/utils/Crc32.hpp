@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef LIB_CRC32_HPP
+#define LIB_CRC32_HPP
+
+#include "Version.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace MAT_NS_BEGIN
+{
+    class Crc32
+    {
+        public:
+            /// <summary>
+            /// CRC-32C (Castagnoli polynomial) of a buffer. Pass the previous result as
+            /// <paramref name="crc"/> to continue a checksum over several buffers.
+            /// </summary>
+            static uint32_t Crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+            /// <summary>
+            /// Portable slice-by-8 implementation, used when the CPU has no CRC32C instruction.
+            /// </summary>
+            static uint32_t Crc32cSoftware(const void* data, size_t size, uint32_t crc = 0);
+
+            /// <summary>
+            /// Whether Crc32c() runs on SSE4.2 or ARMv8 CRC32C instructions.
+            /// </summary>
+            static bool IsHardwareAccelerated();
+    };
+
+} MAT_NS_END
+
+#endif
@@ -9,6 +9,12 @@
 #include <fstream>
 #include <streambuf>
 
+#ifndef _WIN32
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#endif
+
 namespace MAT_NS_BEGIN
 {
 
@@ -169,5 +175,92 @@ namespace MAT_NS_BEGIN
 #endif
     }
 
+    /**
+     * Rename file, replacing the destination if it exists.
+     *
+     * @param       from    UTF-8 source file name
+     * @param       to      UTF-8 destination file name
+     * @return      true on success, false on failure
+     */
+    bool FileRename(const char* from, const char* to)
+    {
+#ifdef _WIN32
+        std::wstring from_w = to_utf16_string(from);
+        std::wstring to_w = to_utf16_string(to);
+        return ::MoveFileExW(from_w.c_str(), to_w.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return std::rename(from, to) == 0;
+#endif
+    }
+
+    /**
+     * Create directory if it does not exist yet.
+     *
+     * @param       name    UTF-8 directory name
+     * @return      true if the directory exists after the call
+     */
+    bool DirectoryCreate(const char* name)
+    {
+#ifdef _WIN32
+        std::wstring name_w = to_utf16_string(name);
+        if (::CreateDirectoryW(name_w.c_str(), NULL))
+        {
+            return true;
+        }
+        DWORD dwAttrib = GetFileAttributesW(name_w.c_str());
+        return (dwAttrib != INVALID_FILE_ATTRIBUTES && (dwAttrib & FILE_ATTRIBUTE_DIRECTORY));
+#else
+        if (::mkdir(name, 0700) == 0)
+        {
+            return true;
+        }
+        struct stat info;
+        return (errno == EEXIST) && (::stat(name, &info) == 0) && S_ISDIR(info.st_mode);
+#endif
+    }
+
+    /**
+     * List regular files in a directory.
+     *
+     * @param       name    UTF-8 directory name
+     * @return      File names without the directory part, empty if the directory cannot be read
+     */
+    std::vector<std::string> DirectoryGetFiles(const char* name)
+    {
+        std::vector<std::string> result;
+#ifdef _WIN32
+        std::wstring pattern = to_utf16_string(name) + L"\\*";
+        WIN32_FIND_DATAW findData;
+        HANDLE hFind = ::FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, 0);
+        if (hFind != INVALID_HANDLE_VALUE)
+        {
+            do
+            {
+                if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+                {
+                    result.push_back(to_utf8_string(findData.cFileName));
+                }
+            } while (::FindNextFileW(hFind, &findData));
+            ::FindClose(hFind);
+        }
+#else
+        DIR* dir = ::opendir(name);
+        if (dir != nullptr)
+        {
+            std::string prefix = std::string(name) + "/";
+            while (struct dirent* entry = ::readdir(dir))
+            {
+                struct stat info;
+                if ((::stat((prefix + entry->d_name).c_str(), &info) == 0) && S_ISREG(info.st_mode))
+                {
+                    result.push_back(entry->d_name);
+                }
+            }
+            ::closedir(dir);
+        }
+#endif
+        return result;
+    }
+
 } MAT_NS_END
 
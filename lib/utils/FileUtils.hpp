@@ -9,6 +9,9 @@
 #include "Version.hpp"
 #include "pal/PAL.hpp"
 
+#include <string>
+#include <vector>
+
 namespace MAT_NS_BEGIN
 {
     size_t      FileGetSize(const char* filename);
@@ -18,6 +21,9 @@ namespace MAT_NS_BEGIN
     std::string FileGetContents(const char *filename);
     bool        FileWrite(const char* filename, const char* contents);
     bool        FileExists(const char* name);
+    bool        FileRename(const char* from, const char* to);
+    bool        DirectoryCreate(const char* name);
+    std::vector<std::string> DirectoryGetFiles(const char* name);
 
 } MAT_NS_END
 
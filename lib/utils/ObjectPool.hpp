@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef OBJECTPOOL_HPP
+#define OBJECTPOOL_HPP
+
+#include "pal/PAL.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Pool of reusable objects that keep the capacity of their buffers between uses.
+    /// Released objects are reset by the recycler, which reports how many bytes they
+    /// keep allocated, and are retained only while the pool stays under its caps.
+    /// </summary>
+    template<typename T>
+    class ObjectPool
+    {
+    public:
+        /// <summary>
+        /// Resets the object for reuse and returns the number of bytes it keeps allocated
+        /// </summary>
+        using Recycler = std::function<size_t(T&)>;
+
+        /// <summary>
+        /// Returns the object to the pool on destruction of the Ptr that owns it
+        /// </summary>
+        class Releaser
+        {
+        public:
+            Releaser(ObjectPool* pool = nullptr) noexcept : m_pool(pool) {}
+
+            void operator()(T* object) const
+            {
+                if (m_pool != nullptr)
+                {
+                    m_pool->Release(object);
+                }
+                else
+                {
+                    delete object;
+                }
+            }
+
+        protected:
+            ObjectPool* m_pool;
+        };
+
+        using Ptr = std::unique_ptr<T, Releaser>;
+
+        ObjectPool(size_t maxObjects, size_t maxBytes, Recycler recycler) :
+            m_maxObjects(maxObjects),
+            m_maxBytes(maxBytes),
+            m_retainedBytes(0),
+            m_recycler(std::move(recycler))
+        {
+            m_objects.reserve(maxObjects);
+        }
+
+        ObjectPool(ObjectPool const&) = delete;
+        ObjectPool& operator=(ObjectPool const&) = delete;
+
+        /// <summary>
+        /// Takes a retained object, or creates a new one if there is none
+        /// </summary>
+        Ptr Acquire()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (!m_objects.empty())
+                {
+                    Entry entry = std::move(m_objects.back());
+                    m_objects.pop_back();
+                    m_retainedBytes -= entry.bytes;
+                    return Ptr(entry.object.release(), Releaser(this));
+                }
+            }
+            return Ptr(new T(), Releaser(this));
+        }
+
+        /// <summary>
+        /// Resets the object and retains it for reuse, or destroys it if the pool is full
+        /// </summary>
+        void Release(T* object)
+        {
+            std::unique_ptr<T> owned(object);
+            size_t bytes = m_recycler(*owned);
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            if ((m_objects.size() < m_maxObjects) && (m_retainedBytes + bytes <= m_maxBytes))
+            {
+                m_objects.push_back(Entry { std::move(owned), bytes });
+                m_retainedBytes += bytes;
+            }
+        }
+
+        size_t GetRetainedCount()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_objects.size();
+        }
+
+        size_t GetRetainedBytes()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_retainedBytes;
+        }
+
+    protected:
+        struct Entry
+        {
+            std::unique_ptr<T> object;
+            size_t             bytes;
+        };
+
+        std::mutex          m_lock;
+        std::vector<Entry>  m_objects;
+        size_t              m_maxObjects;
+        size_t              m_maxBytes;
+        size_t              m_retainedBytes;
+        Recycler            m_recycler;
+    };
+
+} MAT_NS_END
+
+#endif // OBJECTPOOL_HPP
@@ -171,26 +171,32 @@ namespace MAT_NS_BEGIN {
     }
 
     EventRejectedReason validatePropertyName(std::string const& name)
+    {
+        return validatePropertyName(name.data(), name.length());
+    }
+
+    EventRejectedReason validatePropertyName(const char* name, size_t length)
     {
         // Data collector does not seem to validate property names at all.
         // The ObjC SDK uses this regex (avoided here for code size reasons):
         // ^[a-zA-Z0-9](([a-zA-Z0-9|_|.]){0,98}[a-zA-Z0-9])?$
 
-        if (name.length() < 1 + 0 || name.length() > 1 + 98 + 1) {
-            LOG_ERROR("Invalid property name - \"%s\": must be between 1 and 100 characters long", name.c_str());
+        const int printLength = static_cast<int>(std::min<size_t>(length, 256));
+        if (length < 1 + 0 || length > 1 + 98 + 1) {
+            LOG_ERROR("Invalid property name - \"%.*s\": must be between 1 and 100 characters long", printLength, name);
             return REJECTED_REASON_VALIDATION_FAILED;
         }
 
         auto filter = [](char ch) -> bool { return !isalnum(static_cast<uint8_t>(ch)) && (ch != '_') && (ch != '.'); };
 
-        if (std::find_if(name.begin(), name.end(), filter) != name.end()) {
-            LOG_ERROR("Invalid property name - \"%s\": must contain [0-9A-Za-z_.] characters only", name.c_str());
+        if (std::find_if(name, name + length, filter) != name + length) {
+            LOG_ERROR("Invalid property name - \"%.*s\": must contain [0-9A-Za-z_.] characters only", printLength, name);
             return REJECTED_REASON_VALIDATION_FAILED;
         }
 
-        if ((name.front() == '.' || name.back() == '.') /* || (name.front() == '_' || name.back() == '_') */)
+        if ((name[0] == '.' || name[length - 1] == '.') /* || (name.front() == '_' || name.back() == '_') */)
         {
-            LOG_ERROR("Invalid property name - \"%s\": must not start or end with _ or . characters", name.c_str());
+            LOG_ERROR("Invalid property name - \"%.*s\": must not start or end with _ or . characters", printLength, name);
             return REJECTED_REASON_VALIDATION_FAILED;
         }
         return REJECTED_REASON_OK;
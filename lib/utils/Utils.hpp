@@ -75,6 +75,8 @@ namespace MAT_NS_BEGIN {
 
     EventRejectedReason validatePropertyName(std::string const& name);
 
+    EventRejectedReason validatePropertyName(const char* name, size_t length);
+
     inline std::string tenantTokenToId(std::string const& tenantToken)
     {
         return tenantToken.substr(0, tenantToken.find('-'));
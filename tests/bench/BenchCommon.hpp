@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef BENCHCOMMON_HPP
+#define BENCHCOMMON_HPP
+
+#include "pal/PAL.hpp"
+
+#include "EventProperties.hpp"
+#include "IOfflineStorage.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace benchmarks
+{
+    /// <summary>
+    /// Typical application event: a dozen properties of mixed types.
+    /// </summary>
+    inline MAT::EventProperties CreateSampleEvent(std::string const& name)
+    {
+        MAT::EventProperties props(name);
+        props.SetProperty("App.Version", "16.0.12345.20000");
+        props.SetProperty("App.Session", "5d6a3b8e-2f0c-4c7f-9c1c-0e2e4b1f3a7d");
+        props.SetProperty("Doc.Extension", "docx");
+        props.SetProperty("Doc.SizeInBytes", static_cast<int64_t>(1048576));
+        props.SetProperty("Doc.PageCount", static_cast<int64_t>(42));
+        props.SetProperty("Doc.IsShared", true);
+        props.SetProperty("Perf.LoadTimeMs", 123.45);
+        props.SetProperty("Perf.RenderTimeMs", 67.89);
+        props.SetProperty("User.Locale", "en-US");
+        props.SetProperty("User.Email", "user@contoso.com", MAT::PiiKind_Identity);
+        props.SetProperty("Net.Type", "wifi");
+        props.SetProperty("Net.Cost", "unmetered");
+        return props;
+    }
+
+    /// <summary>
+    /// Storage record with a blob of the given size.
+    /// </summary>
+    inline MAT::StorageRecord CreateStorageRecord(size_t blobSize, MAT::EventLatency latency = MAT::EventLatency_Normal)
+    {
+        return MAT::StorageRecord(PAL::generateUuidString(), "bench-token", latency, MAT::EventPersistence_Normal,
+            PAL::getUtcSystemTimeMs(), std::vector<uint8_t>(blobSize, 0x5A));
+    }
+
+    /// <summary>
+    /// Storage observer that ignores all notifications.
+    /// </summary>
+    class NullStorageObserver : public MAT::IOfflineStorageObserver
+    {
+    public:
+        virtual void OnStorageOpened(std::string const&) override {}
+        virtual void OnStorageFailed(std::string const&) override {}
+        virtual void OnStorageOpenFailed(std::string const&) override {}
+        virtual void OnStorageTrimmed(std::map<std::string, size_t> const&) override {}
+        virtual void OnStorageRecordsDropped(std::map<std::string, size_t> const&) override {}
+        virtual void OnStorageRecordsRejected(std::map<std::string, size_t> const&) override {}
+        virtual void OnStorageRecordsSaved(size_t) override {}
+    };
+
+} // namespace benchmarks
+
+#endif // BENCHCOMMON_HPP
@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "BenchCommon.hpp"
+
+#include "CorrelationVector.hpp"
+#include "ILogManager.hpp"
+#include "NullObjects.hpp"
+#include "api/LogManagerFactory.hpp"
+#include "decorators/EventPropertiesDecorator.hpp"
+#include "utils/Utils.hpp"
+
+#include <cstdio>
+#include <memory>
+
+using namespace MAT;
+
+namespace
+{
+    /// <summary>
+    /// Log manager writing to a private offline storage file, with uploads paused,
+    /// so that LogEvent runs through filtering, decoration, serialization and storage.
+    /// </summary>
+    class PausedLogManager
+    {
+    public:
+        PausedLogManager()
+        {
+            m_cacheFile = GetTempDirectory() + "mat-bench-logger.db";
+            std::remove(m_cacheFile.c_str());
+
+            m_config[CFG_STR_COLLECTOR_URL] = "http://127.0.0.1:1/";
+            m_config[CFG_STR_CACHE_FILE_PATH] = m_cacheFile;
+            m_config[CFG_INT_MAX_TEARDOWN_TIME] = 0;
+            m_config[CFG_INT_TRACE_LEVEL_MIN] = ACTTraceLevel_Fatal;
+            m_config[CFG_MAP_METASTATS_CONFIG][CFG_INT_METASTATS_INTERVAL] = 0;
+            m_logManager.reset(LogManagerFactory::Create(m_config));
+            m_logManager->GetLogController()->PauseTransmission();
+        }
+
+        ~PausedLogManager()
+        {
+            m_logManager.reset();
+            std::remove(m_cacheFile.c_str());
+        }
+
+        ILogger* GetLogger()
+        {
+            return m_logManager->GetLogger("bench-token");
+        }
+
+    protected:
+        ILogConfiguration            m_config;
+        std::string                  m_cacheFile;
+        std::unique_ptr<ILogManager> m_logManager;
+    };
+} // namespace
+
+static void BM_Logger_LogEvent(benchmark::State& state)
+{
+    PausedLogManager logManager;
+    ILogger* logger = logManager.GetLogger();
+    EventProperties props = benchmarks::CreateSampleEvent("Bench.Logger.LogEvent");
+
+    for (auto _ : state)
+    {
+        logger->LogEvent(props);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Logger_LogEvent)->Unit(benchmark::kMicrosecond);
+
+static void BM_EventPropertiesDecorator_Decorate(benchmark::State& state)
+{
+    NullLogManager logManager;
+    EventPropertiesDecorator decorator(logManager);
+    EventProperties props = benchmarks::CreateSampleEvent("Bench.Decorator");
+
+    for (auto _ : state)
+    {
+        ::CsProtocol::Record record;
+        EventLatency latency = EventLatency_Normal;
+        bool result = decorator.decorate(record, latency, props);
+        benchmark::DoNotOptimize(result);
+        benchmark::DoNotOptimize(record);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EventPropertiesDecorator_Decorate);
+
+static void BM_CorrelationVector_GetNextValue(benchmark::State& state)
+{
+    CorrelationVector cv;
+    cv.Initialize(static_cast<int>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        std::string value = cv.GetNextValue();
+        benchmark::DoNotOptimize(value);
+        if (!cv.CanIncrement())
+        {
+            cv.Initialize(static_cast<int>(state.range(0)));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CorrelationVector_GetNextValue)->Arg(1)->Arg(2);
+
+static void BM_CorrelationVector_Extend(benchmark::State& state)
+{
+    CorrelationVector cv;
+    cv.Initialize(2);
+
+    for (auto _ : state)
+    {
+        if (!cv.CanExtend())
+        {
+            cv.Initialize(2);
+        }
+        cv.Extend();
+        benchmark::DoNotOptimize(cv.GetValue());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CorrelationVector_Extend);
@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "BenchCommon.hpp"
+
+#include <cstring>
+#include <vector>
+
+// Results are written as JSON to mat-bench.json unless --benchmark_out is given,
+// so that every run leaves a machine-readable report for regression tracking.
+int main(int argc, char** argv)
+{
+    static char defaultOut[] = "--benchmark_out=mat-bench.json";
+    static char defaultFormat[] = "--benchmark_out_format=json";
+
+    std::vector<char*> args(argv, argv + argc);
+    bool hasOut = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--benchmark_out=", strlen("--benchmark_out=")) == 0)
+        {
+            hasOut = true;
+        }
+    }
+    if (!hasOut)
+    {
+        args.push_back(defaultOut);
+        args.push_back(defaultFormat);
+    }
+    args.push_back(nullptr);
+
+    int count = static_cast<int>(args.size()) - 1;
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "BenchCommon.hpp"
+
+#include "NullObjects.hpp"
+#include "bond/BondSerializer.hpp"
+#include "compression/HttpDeflateCompression.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "decorators/EventPropertiesDecorator.hpp"
+#include "packager/BondSplicer.hpp"
+#include "utils/Crc32.hpp"
+
+using namespace MAT;
+
+namespace
+{
+    /// <summary>
+    /// Returns a record decorated the same way Logger::LogEvent decorates it.
+    /// </summary>
+    ::CsProtocol::Record createSampleRecord()
+    {
+        NullLogManager logManager;
+        EventPropertiesDecorator decorator(logManager);
+        ::CsProtocol::Record record;
+        EventLatency latency = EventLatency_Normal;
+        decorator.decorate(record, latency, benchmarks::CreateSampleEvent("Bench.Serialization"));
+        record.iKey = "o:bench-token";
+        record.time = PAL::getUtcSystemTimeMs();
+        return record;
+    }
+
+    std::vector<uint8_t> serializeRecord(::CsProtocol::Record& record)
+    {
+        BondSerializer serializer;
+        IncomingEventContext event(PAL::generateUuidString(), "bench-token", EventLatency_Normal, EventPersistence_Normal, &record);
+        serializer.serialize(&event);
+        return event.record.blob;
+    }
+} // namespace
+
+static void BM_BondSerializer_Serialize(benchmark::State& state)
+{
+    BondSerializer serializer;
+    ::CsProtocol::Record record = createSampleRecord();
+    size_t bytes = 0;
+
+    for (auto _ : state)
+    {
+        IncomingEventContext event(std::string(), "bench-token", EventLatency_Normal, EventPersistence_Normal, &record);
+        serializer.serialize(&event);
+        bytes += event.record.blob.size();
+        benchmark::DoNotOptimize(event.record.blob.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_BondSerializer_Serialize);
+
+static void BM_BondSplicer_Splice(benchmark::State& state)
+{
+    ::CsProtocol::Record record = createSampleRecord();
+    std::vector<uint8_t> blob = serializeRecord(record);
+    const size_t recordCount = static_cast<size_t>(state.range(0));
+    size_t bytes = 0;
+
+    for (auto _ : state)
+    {
+        BondSplicer splicer;
+        size_t package = splicer.addTenantToken("bench-token");
+        for (size_t i = 0; i < recordCount; i++)
+        {
+            splicer.addRecord(package, blob);
+        }
+        std::vector<uint8_t> body = splicer.splice();
+        bytes += body.size();
+        benchmark::DoNotOptimize(body.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * recordCount));
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_BondSplicer_Splice)->Arg(1)->Arg(100)->Arg(500);
+
+static void BM_HttpDeflateCompression_Compress(benchmark::State& state)
+{
+    ILogConfiguration logConfig;
+    RuntimeConfig_Default config(logConfig);
+    config[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = true;
+    HttpDeflateCompression compression(config);
+
+    ::CsProtocol::Record record = createSampleRecord();
+    std::vector<uint8_t> blob = serializeRecord(record);
+    BondSplicer splicer;
+    size_t package = splicer.addTenantToken("bench-token");
+    for (int64_t i = 0; i < state.range(0); i++)
+    {
+        splicer.addRecord(package, blob);
+    }
+    std::vector<uint8_t> body = splicer.splice();
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        EventsUploadContextPtr ctx = std::make_shared<EventsUploadContext>();
+        ctx->body = body;
+        state.ResumeTiming();
+
+        compression.compress(ctx);
+        benchmark::DoNotOptimize(ctx->body.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * body.size()));
+}
+BENCHMARK(BM_HttpDeflateCompression_Compress)->Arg(100)->Arg(500);
+
+// Arg 0 is the accelerated path where the CPU has one, arg 1 the portable slice-by-8 fallback
+static void BM_Crc32_Crc32c(benchmark::State& state)
+{
+    ::CsProtocol::Record record = createSampleRecord();
+    std::vector<uint8_t> blob = serializeRecord(record);
+    bool software = state.range(0) != 0;
+
+    for (auto _ : state)
+    {
+        uint32_t crc = software ? Crc32::Crc32cSoftware(blob.data(), blob.size()) : Crc32::Crc32c(blob.data(), blob.size());
+        benchmark::DoNotOptimize(crc);
+    }
+    state.SetLabel(software ? "software" : (Crc32::IsHardwareAccelerated() ? "hardware" : "software"));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * blob.size()));
+}
+BENCHMARK(BM_Crc32_Crc32c)->Arg(0)->Arg(1);
@@ -0,0 +1,44 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "BenchCommon.hpp"
+
+#include "ILogManager.hpp"
+#include "api/LogManagerFactory.hpp"
+#include "utils/Utils.hpp"
+
+#include <cstdio>
+#include <memory>
+
+using namespace MAT;
+
+/// <summary>
+/// Time for LogManager creation to return, with the offline storage opened during
+/// initialization (0) or deferred to the worker thread (1). Teardown is not timed.
+/// </summary>
+static void BM_Startup_CreateLogManager(benchmark::State& state)
+{
+    std::string cacheFile = GetTempDirectory() + "mat-bench-startup.db";
+    std::remove(cacheFile.c_str());
+
+    for (auto _ : state)
+    {
+        ILogConfiguration config;
+        config[CFG_STR_COLLECTOR_URL] = "http://127.0.0.1:1/";
+        config[CFG_STR_CACHE_FILE_PATH] = cacheFile;
+        config[CFG_INT_MAX_TEARDOWN_TIME] = 0;
+        config[CFG_INT_TRACE_LEVEL_MIN] = ACTTraceLevel_Fatal;
+        config[CFG_MAP_METASTATS_CONFIG][CFG_INT_METASTATS_INTERVAL] = 0;
+        config[CFG_BOOL_DEFER_STORAGE_OPEN] = (state.range(0) != 0);
+
+        std::unique_ptr<ILogManager> logManager(LogManagerFactory::Create(config));
+        benchmark::DoNotOptimize(logManager.get());
+
+        state.PauseTiming();
+        logManager.reset();
+        state.ResumeTiming();
+    }
+    std::remove(cacheFile.c_str());
+}
+BENCHMARK(BM_Startup_CreateLogManager)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
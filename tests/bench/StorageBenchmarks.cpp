@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "BenchCommon.hpp"
+
+#include "NullObjects.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "offline/MemoryStorage.hpp"
+#include "offline/OfflineStorage_SQLite.hpp"
+#include "utils/Utils.hpp"
+
+#include <cstdio>
+#include <memory>
+
+using namespace MAT;
+
+namespace
+{
+    const size_t RecordBlobSize = 512;
+
+    /// <summary>
+    /// Storage under test, initialized on construction and shut down on destruction.
+    /// </summary>
+    template<typename TStorage>
+    class StorageFixture
+    {
+    public:
+        StorageFixture() :
+            m_config(m_logConfig)
+        {
+            m_cacheFile = GetTempDirectory() + "mat-bench-storage.db";
+            std::remove(m_cacheFile.c_str());
+            m_logConfig[CFG_STR_CACHE_FILE_PATH] = m_cacheFile;
+            m_storage.reset(new TStorage(m_logManager, m_config));
+            m_storage->Initialize(m_observer);
+        }
+
+        ~StorageFixture()
+        {
+            m_storage->Shutdown();
+            m_storage.reset();
+            std::remove(m_cacheFile.c_str());
+        }
+
+        IOfflineStorage& storage()
+        {
+            return *m_storage;
+        }
+
+    protected:
+        NullLogManager                       m_logManager;
+        ILogConfiguration                    m_logConfig;
+        RuntimeConfig_Default                m_config;
+        benchmarks::NullStorageObserver      m_observer;
+        std::string                          m_cacheFile;
+        std::unique_ptr<IOfflineStorage>     m_storage;
+    };
+
+    std::vector<StorageRecord> createRecords(size_t count)
+    {
+        std::vector<StorageRecord> records;
+        records.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            records.push_back(benchmarks::CreateStorageRecord(RecordBlobSize));
+        }
+        return records;
+    }
+} // namespace
+
+template<typename TStorage>
+static void BM_Storage_Store(benchmark::State& state)
+{
+    StorageFixture<TStorage> fixture;
+    std::vector<StorageRecord> records = createRecords(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        for (auto const& record : records)
+        {
+            fixture.storage().StoreRecord(record);
+        }
+        state.PauseTiming();
+        fixture.storage().DeleteAllRecords();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * records.size()));
+}
+BENCHMARK_TEMPLATE(BM_Storage_Store, MemoryStorage)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_Storage_Store, OfflineStorage_SQLite)->Arg(100)->Arg(1000);
+
+template<typename TStorage>
+static void BM_Storage_ReserveAndDelete(benchmark::State& state)
+{
+    StorageFixture<TStorage> fixture;
+    std::vector<StorageRecord> records = createRecords(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (auto const& record : records)
+        {
+            fixture.storage().StoreRecord(record);
+        }
+        std::vector<StorageRecordId> ids;
+        ids.reserve(records.size());
+        state.ResumeTiming();
+
+        fixture.storage().GetAndReserveRecords([&ids](StorageRecord&& record) -> bool {
+            ids.push_back(record.id);
+            return true;
+        }, 60000, EventLatency_Normal);
+
+        HttpHeaders headers;
+        bool fromMemory = false;
+        fixture.storage().DeleteRecords(ids, headers, fromMemory);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * records.size()));
+}
+BENCHMARK_TEMPLATE(BM_Storage_ReserveAndDelete, MemoryStorage)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_Storage_ReserveAndDelete, OfflineStorage_SQLite)->Arg(100)->Arg(1000);
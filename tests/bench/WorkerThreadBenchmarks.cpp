@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "BenchCommon.hpp"
+
+#include "pal/TaskDispatcher.hpp"
+#include "pal/WorkerThread.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace MAT;
+
+namespace
+{
+    class Counter
+    {
+    public:
+        std::atomic<size_t> calls { 0 };
+
+        void Increment()
+        {
+            calls++;
+        }
+    };
+} // namespace
+
+static void BM_WorkerThread_DispatchTask(benchmark::State& state)
+{
+    const size_t batchSize = static_cast<size_t>(state.range(0));
+    Counter counter;
+    auto workerThread = PAL::WorkerThreadFactory::Create();
+    size_t expected = 0;
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < batchSize; i++)
+        {
+            PAL::dispatchTask(workerThread.get(), &counter, &Counter::Increment);
+        }
+        expected += batchSize;
+        // Measure end-to-end throughput: queueing plus execution on the worker thread
+        while (counter.calls.load() < expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(expected));
+}
+BENCHMARK(BM_WorkerThread_DispatchTask)->Arg(1)->Arg(1000)->UseRealTime();
+
+static void BM_WorkerThread_ScheduleAndCancel(benchmark::State& state)
+{
+    Counter counter;
+    auto workerThread = PAL::WorkerThreadFactory::Create();
+
+    for (auto _ : state)
+    {
+        auto handle = PAL::scheduleTask(workerThread.get(), 60000, &counter, &Counter::Increment);
+        handle.Cancel();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WorkerThread_ScheduleAndCancel);
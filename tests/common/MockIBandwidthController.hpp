@@ -14,6 +14,8 @@ class MockIBandwidthController : public MAT::IBandwidthController
 {
   public:
     MOCK_METHOD0(GetProposedBandwidthBps, unsigned());
+    MOCK_METHOD0(GetAvailableBytes, unsigned());
+    MOCK_METHOD1(OnBytesUploaded, void(unsigned));
 };
 
 
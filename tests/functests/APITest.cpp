@@ -449,6 +449,49 @@ TEST(APITest, LogManager_Initialize_DebugEventListener)
     removeAllListeners(debugListener);
 }
 
+TEST(APITest, LogManager_LogEvents_Batch)
+{
+    constexpr static unsigned BATCH_SIZE = 150;
+
+    TestDebugEventListener debugListener;
+
+    auto &configuration = LogManager::GetLogConfiguration();
+    configuration[CFG_INT_TRACE_LEVEL_MASK] = 0xFFFFFFFF ^ 128;
+    configuration[CFG_INT_TRACE_LEVEL_MIN] = ACTTraceLevel_Warn;
+    configuration[CFG_STR_COLLECTOR_URL] = COLLECTOR_URL_PROD;
+    configuration[CFG_MAP_METASTATS_CONFIG][CFG_INT_METASTATS_INTERVAL] = 0;
+    configuration[CFG_STR_CACHE_FILE_PATH] = GetStoragePath();
+    configuration[CFG_INT_MAX_TEARDOWN_TIME] = 0;
+    configuration[CFG_INT_RAM_QUEUE_SIZE] = 524288;
+
+    std::vector<EventProperties> events;
+    for (unsigned i = 0; i < BATCH_SIZE; i++)
+    {
+        EventProperties event("batch_event");
+        event.SetProperty("index", static_cast<int64_t>(i));
+        events.push_back(event);
+    }
+
+    CleanStorage();
+    addAllListeners(debugListener);
+    ILogger *logger = LogManager::Initialize(TEST_TOKEN, configuration);
+    LogManager::PauseTransmission();
+
+    logger->LogEvents(events);
+    EXPECT_EQ(BATCH_SIZE, debugListener.numLogged);
+    EXPECT_EQ(STATUS_SUCCESS, LogManager::LogEvents(events));
+    EXPECT_EQ(2 * BATCH_SIZE, debugListener.numLogged);
+    EXPECT_EQ(0u, debugListener.numDropped);
+
+    // All the batched events were stored
+    LogManager::Flush();
+    EXPECT_EQ(2 * BATCH_SIZE, debugListener.numCached);
+
+    LogManager::FlushAndTeardown();
+    EXPECT_EQ(STATUS_EFAIL, LogManager::LogEvents(events));
+    removeAllListeners(debugListener);
+}
+
 #ifdef _WIN32
 TEST(APITest, LogManager_UTCSingleEventSent) {
     auto &configuration = LogManager::GetLogConfiguration();
@@ -740,6 +783,83 @@ TEST(APITest, C_API_Test)
     ASSERT_EQ(capi_get_client(handle), nullptr);
 }
 
+TEST(APITest, C_API_LoggerHandle_Batch_Test)
+{
+    TestDebugEventListener debugListener;
+
+    const char* config = JSON_CONFIG(
+        {
+            "cacheFilePath": "MyOfflineStorage.db",
+            "config" : {
+                "host": "*"
+            },
+            "stats" : {
+                "interval": 0
+            },
+            "name" : "C-API-Client-1",
+            "version" : "1.0.0",
+            "primaryToken" : "7c8b1796cbc44bd5a03803c01c2b9d61-b6e370dd-28d9-4a52-9556-762543cf7aa7-6991",
+            "eventCollectorUri" : "http://127.0.0.1:1/OneCollector/1.0/",
+            "maxTeardownUploadTimeInSec" : 0,
+            "hostMode" : false,
+            "minimumTraceLevel" : 0,
+            "sdkmode" : 0
+        }
+    );
+
+    evt_prop event[] = TELEMETRY_EVENT
+    (
+        _STR(COMMONFIELDS_EVENT_NAME, EVENT_NAME_PURE_C),
+        _STR("strKey", "value1")
+    );
+    evt_prop routedEvent[] = TELEMETRY_EVENT
+    (
+        _STR(COMMONFIELDS_EVENT_NAME, EVENT_NAME_PURE_C),
+        _STR(COMMONFIELDS_IKEY, TEST_TOKEN2)
+    );
+
+    std::vector<std::string> iKeys;
+    debugListener.OnLogX = [&](::CsProtocol::Record & record)
+    {
+        EXPECT_EQ(record.name, EVENT_NAME_PURE_C);
+        iKeys.push_back(record.iKey);
+    };
+
+    evt_handle_t handle = evt_open(config);
+    ASSERT_NE(handle, 0);
+    capi_client *client = capi_get_client(handle);
+    ASSERT_NE(client, nullptr);
+    client->logmanager->AddEventListener(EVT_LOG_EVENT, debugListener);
+
+    // Same token and source give the same handle, the primary token is used when none is given
+    evt_handle_t logger = evt_get_logger(handle, TEST_TOKEN, NULL);
+    EXPECT_NE(logger, 0);
+    EXPECT_EQ(evt_get_logger(handle, TEST_TOKEN, NULL), logger);
+    EXPECT_EQ(evt_get_logger(handle, NULL, NULL), logger);
+    EXPECT_NE(evt_get_logger(handle, TEST_TOKEN2, NULL), logger);
+
+    evt_batch_item_t batch[] = { { event, 0 }, { event, 0 }, { event, 0 } };
+    uint32_t logged = 0;
+    EXPECT_EQ(evt_log_batch(handle, logger, batch, 3, &logged), EOK);
+    EXPECT_EQ(logged, 3u);
+
+    // Without a logger handle, every event goes to the tenant of its iKey
+    evt_batch_item_t routed[] = { { routedEvent, 0 }, { routedEvent, 0 } };
+    EXPECT_EQ(evt_log_batch(handle, 0, routed, 2, &logged), EOK);
+    EXPECT_EQ(logged, 2u);
+
+    EXPECT_EQ(evt_log_batch(handle, logger + 100, batch, 3, &logged), ENOENT);
+    EXPECT_EQ(logged, 0u);
+
+    ASSERT_EQ(iKeys.size(), 5u);
+    EXPECT_EQ(iKeys[0], "o:7c8b1796cbc44bd5a03803c01c2b9d61");
+    EXPECT_EQ(iKeys[4], "o:0ae6cd22d8264818933f4857dd3c1472");
+
+    client->logmanager->RemoveEventListener(EVT_LOG_EVENT, debugListener);
+    evt_close(handle);
+    ASSERT_EQ(capi_get_client(handle), nullptr);
+}
+
 #ifdef HAVE_MAT_JSONHPP
 #if defined(_WIN32)
 TEST(APITest, UTC_Callback_Test)
@@ -756,6 +756,75 @@ TEST_F(BasicFuncTests, configDecorations)
     FlushAndTeardown();
 }
 
+TEST_F(BasicFuncTests, bandwidthBudgetPacesUploads)
+{
+    CleanStorage();
+
+    static unsigned const BANDWIDTH_BPS = 32 * 1024;
+    static size_t const EVENT_COUNT = 100;
+
+    auto &configuration = LogManager::GetLogConfiguration();
+    configuration[CFG_MAP_TPM][CFG_INT_TPM_BANDWIDTH_BPS] = BANDWIDTH_BPS;
+    configuration[CFG_MAP_TPM][CFG_INT_TPM_BANDWIDTH_BURST_BYTES] = BANDWIDTH_BPS;
+    Initialize();
+
+    for (size_t i = 0; i < EVENT_COUNT; i++)
+    {
+        EventProperties event("paced_event");
+        event.SetLatency(EventLatency_RealTime);
+        event.SetProperty("data", std::string(1024, 'x'));
+        logger->LogEvent(event);
+    }
+    LogManager::UploadNow();
+
+    // The first request may use the whole burst, the throughput is measured past it
+    size_t received = 0;
+    size_t firstBytes = 0;
+    size_t totalBytes = 0;
+    uint64_t firstMs = 0;
+    uint64_t lastMs = 0;
+    size_t seen = 0;
+    auto start = PAL::getMonotonicTimeMs();
+    while (received < EVENT_COUNT && PAL::getMonotonicTimeMs() - start < 30000)
+    {
+        {
+            LOCKGUARD(mtx_requests);
+            for (; seen < receivedRequests.size(); seen++)
+            {
+                auto const& request = receivedRequests[seen];
+                size_t count = 0;
+                for (auto const& record : decodeRequest(request, false))
+                {
+                    count += (record.name == "paced_event") ? 1 : 0;
+                }
+                if (count == 0)
+                {
+                    continue;
+                }
+                auto now = PAL::getMonotonicTimeMs();
+                if (received == 0)
+                {
+                    firstMs = now;
+                    firstBytes = request.content.size();
+                }
+                lastMs = now;
+                totalBytes += request.content.size();
+                received += count;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    configuration[CFG_MAP_TPM][CFG_INT_TPM_BANDWIDTH_BPS] = 0;
+    configuration[CFG_MAP_TPM][CFG_INT_TPM_BANDWIDTH_BURST_BYTES] = 0;
+    FlushAndTeardown();
+
+    ASSERT_EQ(received, EVENT_COUNT);
+    ASSERT_GT(totalBytes, firstBytes + BANDWIDTH_BPS);
+    double throughputBps = 1000.0 * (totalBytes - firstBytes) / (lastMs - firstMs);
+    EXPECT_LE(throughputBps, 1.25 * BANDWIDTH_BPS);
+}
+
 TEST_F(BasicFuncTests, restartRecoversEventsFromStorage)
 {
     {
@@ -13,6 +13,8 @@
 
 #include "api/LogManagerFactory.hpp"
 #include "api/LogManagerImpl.hpp"
+#include "utils/StringUtils.hpp"
+#include "utils/Utils.hpp"
 
 #include "CsProtocol_types.hpp"
 #include "bond/All.hpp"
@@ -20,6 +22,14 @@
 
 #include "sqlite3.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "NullObjects.hpp"
 
 #if defined __has_include && defined(HAVE_MAT_PRIVACYGUARD)
@@ -36,10 +46,14 @@
 using namespace testing;
 using namespace MAT;
 
+#undef LOCKGUARD
+#define LOCKGUARD(macro_mutex) std::lock_guard<decltype(macro_mutex)> TOKENPASTE2(__guard_, __LINE__)(macro_mutex);
+
 class MultipleLogManagersTests : public ::testing::Test,
                                  public HttpServer::Callback
 {
    protected:
+    std::mutex mtx_requests;
     std::list<HttpServer::Request> receivedRequests;
     std::string serverAddress;
     ILogConfiguration config1, config2;
@@ -93,15 +107,22 @@ class MultipleLogManagersTests : public ::testing::Test,
     virtual int onHttpRequest(HttpServer::Request const& request, HttpServer::Response& response) override
     {
         UNREFERENCED_PARAMETER(response);
+        LOCKGUARD(mtx_requests);
         receivedRequests.push_back(request);
         return 200;
     }
 
+    size_t receivedRequestCount()
+    {
+        LOCKGUARD(mtx_requests);
+        return receivedRequests.size();
+    }
+
     void waitForRequests(unsigned timeout, unsigned expectedCount = 1)
     {
-        auto sz = receivedRequests.size();
+        auto sz = receivedRequestCount();
         auto start = PAL::getUtcSystemTimeMs();
-        while (receivedRequests.size() - sz < expectedCount)
+        while (receivedRequestCount() - sz < expectedCount)
         {
             if (PAL::getUtcSystemTimeMs() - start >= timeout)
             {
@@ -186,6 +207,154 @@ TEST_F(MultipleLogManagersTests, MultiProcessesLogManager)
     CAPTURE_PERF_STATS("Log Manager deleted");
 }
 
+TEST_F(MultipleLogManagersTests, SharedRuntimeCoalescesUploads)
+{
+    for (ILogConfiguration* config : { &config1, &config2 })
+    {
+        (*config)[CFG_STR_SHARED_RUNTIME] = "MultipleLogManagersTests";
+        (*config)[CFG_STR_COLLECTOR_URL] = serverAddress + "/1/";
+        (*config)[CFG_INT_RAM_QUEUE_SIZE] = 0;
+        (*config)[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = false;
+    }
+    std::unique_ptr<ILogManager> lm1(LogManagerFactory::Create(config1));
+    std::unique_ptr<ILogManager> lm2(LogManagerFactory::Create(config2));
+
+    lm1->GetLogger("aaa")->LogEvent("shared_runtime_first");
+    lm2->GetLogger("bbb")->LogEvent("shared_runtime_second");
+
+    // A single upload carries the events of both instances
+    lm1->GetLogController()->UploadNow();
+    auto start = PAL::getUtcSystemTimeMs();
+    while ((receivedRequestCount() == 0) && (PAL::getUtcSystemTimeMs() - start < 5000))
+    {
+        PAL::sleep(100);
+    }
+    std::string content;
+    {
+        LOCKGUARD(mtx_requests);
+        ASSERT_FALSE(receivedRequests.empty());
+        content = receivedRequests.front().content;
+    }
+    EXPECT_NE(content.find("shared_runtime_first"), std::string::npos);
+    EXPECT_NE(content.find("shared_runtime_second"), std::string::npos);
+
+    lm1.reset();
+    lm2.reset();
+    std::string engineFile = GetAppLocalTempDirectory() + "MultipleLogManagersTests-" + toString(hashCode((serverAddress + "/1/").c_str())) + ".db";
+    ::remove(engineFile.c_str());
+}
+
+#ifndef _WIN32
+TEST_F(MultipleLogManagersTests, MultiProcessStorageFailsOverToSurvivingProcess)
+{
+    std::string cacheFilePath = GetTempDirectory() + "MultipleLogManagersTests-multiprocess.db";
+    std::string lockFilePath = cacheFilePath + ".lock";
+    config1[CFG_STR_CACHE_FILE_PATH] = cacheFilePath;
+    config1[CFG_BOOL_ENABLE_MULTIPROCESS_STORAGE] = true;
+    config1[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = false;
+
+    char const* childPipes = ::getenv("MAT_MULTIPROCESS_TEST_PIPES");
+    if (childPipes != nullptr)
+    {
+        // Re-executed as the other process: it opens the shared database first and so becomes its uploader,
+        // stores an event of its own, and then holds on without uploading until the parent kills it
+        int readyFd = -1;
+        int quitFd = -1;
+        ASSERT_EQ(::sscanf(childPipes, "%d %d", &readyFd, &quitFd), 2);
+        std::unique_ptr<ILogManager> lm(LogManagerFactory::Create(config1));
+        lm->PauseTransmission();
+        lm->GetLogger("bbb")->LogEvent("multi_process_child_event");
+        bool stored = false;
+        auto start = PAL::getUtcSystemTimeMs();
+        while (!stored && (PAL::getUtcSystemTimeMs() - start < 10000))
+        {
+            lm->Flush();
+            sqlite3* db = nullptr;
+            sqlite3_stmt* stmt = nullptr;
+            if (sqlite3_open(cacheFilePath.c_str(), &db) == SQLITE_OK && sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM events", -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+            {
+                stored = sqlite3_column_int(stmt, 0) > 0;
+            }
+            sqlite3_finalize(stmt);
+            sqlite3_close(db);
+            PAL::sleep(100);
+        }
+        // The storage took the uploader lock when it opened the database, so a lock of our own fails
+        int fd = ::open(lockFilePath.c_str(), O_RDWR | O_CREAT, 0600);
+        char locked = (stored && (fd >= 0) && (::flock(fd, LOCK_EX | LOCK_NB) != 0)) ? 1 : 0;
+        if (::write(readyFd, &locked, 1) == 1)
+        {
+            ssize_t result = ::read(quitFd, &locked, 1);
+            (void)result;
+        }
+        ::_exit(0);
+    }
+    ::remove(cacheFilePath.c_str());
+    ::remove(lockFilePath.c_str());
+
+    // The child only execs, the parent having other threads running; the pipes tell it where to report back
+    int ready[2];
+    int quit[2];
+    ASSERT_EQ(::pipe(ready), 0);
+    ASSERT_EQ(::pipe(quit), 0);
+    std::string pipes = toString(ready[1]) + " " + toString(quit[0]);
+    std::string executable = ::testing::internal::GetArgvs()[0];
+    std::string filter = std::string("--gtest_filter=") + ::testing::UnitTest::GetInstance()->current_test_info()->test_case_name() +
+                         "." + ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    char* const childArgv[] = { &executable[0], &filter[0], nullptr };
+    ::setenv("MAT_MULTIPROCESS_TEST_PIPES", pipes.c_str(), 1);
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        int devNull = ::open("/dev/null", O_WRONLY);
+        ::dup2(devNull, STDOUT_FILENO);
+        ::execv(childArgv[0], childArgv);
+        ::_exit(127);
+    }
+    ::unsetenv("MAT_MULTIPROCESS_TEST_PIPES");
+    ASSERT_NE(pid, -1);
+    char locked = 0;
+    ASSERT_EQ(::read(ready[0], &locked, 1), 1);
+    ASSERT_EQ(locked, 1);
+
+    std::unique_ptr<ILogManager> lm(LogManagerFactory::Create(config1));
+    lm->GetLogger("aaa")->LogEvent("multi_process_event");
+    lm->GetLogController()->UploadNow();
+    PAL::sleep(2000);
+    {
+        LOCKGUARD(mtx_requests);
+        EXPECT_TRUE(receivedRequests.empty());
+    }
+
+    // The uploader dies: the lock is released and the surviving process sends the shared records, its own and the dead one's
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+    auto start = PAL::getUtcSystemTimeMs();
+    bool uploaded = false;
+    bool uploadedChild = false;
+    while (!(uploaded && uploadedChild) && (PAL::getUtcSystemTimeMs() - start < 10000))
+    {
+        PAL::sleep(100);
+        LOCKGUARD(mtx_requests);
+        for (auto const& request : receivedRequests)
+        {
+            uploaded = uploaded || (request.content.find("multi_process_event") != std::string::npos);
+            uploadedChild = uploadedChild || (request.content.find("multi_process_child_event") != std::string::npos);
+        }
+    }
+    EXPECT_TRUE(uploaded);
+    EXPECT_TRUE(uploadedChild);
+
+    lm.reset();
+    for (int fd : { ready[0], ready[1], quit[0], quit[1] })
+    {
+        ::close(fd);
+    }
+    ::remove(cacheFilePath.c_str());
+    ::remove(lockFilePath.c_str());
+}
+#endif
+
 #ifdef HAVE_MAT_PRIVACYGUARD
 class MockLogger : public NullLogger
 {
@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+#include "bond/All.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
+#include "api/ContextFieldsProvider.hpp"
+#include "decorators/BaseDecorator.hpp"
+#include "decorators/EventPropertiesDecorator.hpp"
+#include "decorators/SemanticContextDecorator.hpp"
+#include "system/ContextPools.hpp"
+
+#include "NullObjects.hpp"
+
+#include <cstdlib>
+#include <new>
+
+using namespace testing;
+using namespace MAT;
+
+namespace {
+
+    // Counter of the allocations made by the test thread, set only while an AllocationCounter is alive
+    thread_local size_t* allocationCount = nullptr;
+
+    class AllocationCounter
+    {
+    public:
+        AllocationCounter() : m_count(0)
+        {
+            allocationCount = &m_count;
+        }
+
+        ~AllocationCounter()
+        {
+            allocationCount = nullptr;
+        }
+
+        size_t Count() const
+        {
+            return m_count;
+        }
+
+    protected:
+        size_t m_count;
+    };
+
+    EventProperties createEvent()
+    {
+        EventProperties props("ContextPoolsTests.Event");
+        props.SetProperty("App.Session", "5d6a3b8e-2f0c-4c7f-9c1c-0e2e4b1f3a7d");
+        props.SetProperty("Doc.SizeInBytes", static_cast<int64_t>(1048576));
+        props.SetProperty("Perf.LoadTimeMs", 123.45);
+        return props;
+    }
+
+    // The per-event work of the logger on a record and an incoming event context
+    class EventLogger
+    {
+    public:
+        EventLogger() :
+            m_baseDecorator(m_logManager),
+            m_semanticContextDecorator(m_logManager, m_context),
+            m_eventPropertiesDecorator(m_logManager)
+        {
+            m_context.SetAppId("ContextPoolsTests");
+            m_context.SetAppVersion("1.0.0");
+            m_context.SetOsName("Linux");
+        }
+
+        void LogEvent(EventProperties const& props, ::CsProtocol::Record& record, IncomingEventContext& event)
+        {
+            EventLatency latency = EventLatency_Normal;
+            m_baseDecorator.decorate(record);
+            m_semanticContextDecorator.decorate(record);
+            m_eventPropertiesDecorator.decorate(record, latency, props);
+
+            event.record.tenantToken = "0123456789abcdef0123456789abcdef-01234567-0123-0123-0123-0123456789ab-0123";
+            event.source = &record;
+            bond_lite::CompactBinaryProtocolWriter writer(event.record.blob);
+            bond_lite::Serialize(writer, record);
+        }
+
+    protected:
+        NullLogManager            m_logManager;
+        ContextFieldsProvider     m_context;
+        BaseDecorator             m_baseDecorator;
+        SemanticContextDecorator  m_semanticContextDecorator;
+        EventPropertiesDecorator  m_eventPropertiesDecorator;
+    };
+
+} // namespace
+
+// Same behavior as the default operators for the other tests of the binary, the hook only
+// counts on a thread that has an AllocationCounter in scope
+void* operator new(size_t size)
+{
+    if (allocationCount != nullptr)
+    {
+        (*allocationCount)++;
+    }
+    for (;;)
+    {
+        void* ptr = std::malloc(size ? size : 1);
+        if (ptr != nullptr)
+        {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+TEST(ContextPoolsTests, ObjectPool_RetainsObjectsUpToItsCaps)
+{
+    ObjectPool<std::string> pool(2, 150, [](std::string& value) { value.clear(); return size_t { 50 }; });
+    auto first = pool.Acquire();
+    auto second = pool.Acquire();
+    auto third = pool.Acquire();
+    std::string* recycled = first.get();
+    *first = "first";
+
+    first.reset();
+    second.reset();
+    third.reset();
+    EXPECT_EQ(pool.GetRetainedCount(), 2u);
+    EXPECT_EQ(pool.GetRetainedBytes(), 100u);
+
+    // Most recently released first
+    pool.Acquire().reset();
+    auto again = pool.Acquire();
+    auto reused = pool.Acquire();
+    EXPECT_EQ(reused.get(), recycled);
+    EXPECT_TRUE(reused->empty());
+    EXPECT_EQ(pool.GetRetainedCount(), 0u);
+
+    ObjectPool<std::string> small(4, 120, [](std::string&) { return size_t { 100 }; });
+    small.Acquire().reset();
+    small.Acquire().reset();
+    auto one = small.Acquire();
+    auto two = small.Acquire();
+    one.reset();
+    two.reset();
+    EXPECT_EQ(small.GetRetainedCount(), 1u);
+}
+
+TEST(ContextPoolsTests, RecycleRecord_KeepsCapacity)
+{
+    EventLogger logger;
+    EventProperties props = createEvent();
+    ::CsProtocol::Record record;
+    IncomingEventContext event;
+    logger.LogEvent(props, record, event);
+    record.extApp.push_back(::CsProtocol::App());
+    record.extUtc.push_back(::CsProtocol::Utc());
+    record.tags["tag"] = "value";
+    size_t nameCapacity = record.name.capacity();
+    size_t appIdCapacity = record.extApp[0].id.capacity();
+    size_t epochCapacity = record.extSdk[0].epoch.capacity();
+
+    EXPECT_GT(ContextPools::RecycleRecord(record), sizeof(record));
+    EXPECT_EQ(record.name.capacity(), nameCapacity);
+
+    // The extensions every event gets keep their first element, reset
+    ::CsProtocol::Record expected;
+    expected.extProtocol.resize(1);
+    expected.extUser.resize(1);
+    expected.extDevice.resize(1);
+    expected.extOs.resize(1);
+    expected.extApp.resize(1);
+    expected.extNet.resize(1);
+    expected.extSdk.resize(1);
+    expected.extLoc.resize(1);
+    expected.extM365a.resize(1);
+    expected.data.resize(1);
+    EXPECT_EQ(record, expected);
+    EXPECT_EQ(record.extApp[0].id.capacity(), appIdCapacity);
+    EXPECT_EQ(record.extSdk[0].epoch.capacity(), epochCapacity);
+    EXPECT_GE(record.extUtc.capacity(), 1u);
+
+    size_t blobCapacity = event.record.blob.capacity();
+    ContextPools::RecycleIncomingEventContext(event);
+    EXPECT_EQ(event.source, nullptr);
+    EXPECT_TRUE(event.record.blob.empty());
+    EXPECT_TRUE(event.record.tenantToken.empty());
+    EXPECT_EQ(event.record.blob.capacity(), blobCapacity);
+}
+
+TEST(ContextPoolsTests, PooledEventsAllocateLessThanFreshOnes)
+{
+    EventLogger logger;
+    EventProperties props = createEvent();
+
+    size_t fresh = 0;
+    {
+        AllocationCounter counter;
+        ::CsProtocol::Record record;
+        IncomingEventContext event;
+        logger.LogEvent(props, record, event);
+        fresh = counter.Count();
+    }
+
+    // Warm up the pools, then measure the steady state
+    for (int i = 0; i < 2; i++)
+    {
+        auto record = ContextPools::Records().Acquire();
+        auto event = ContextPools::IncomingEventContexts().Acquire();
+        logger.LogEvent(props, *record, *event);
+    }
+    size_t pooled = 0;
+    size_t properties = 0;
+    {
+        // Formatting debug traces allocates, it is compiled out of release builds
+        PAL::LogLevel logLevel = PAL::detail::g_logLevel;
+        MATSDK_SET_LOG_LEVEL_(PAL::Warning);
+        AllocationCounter counter;
+        auto record = ContextPools::Records().Acquire();
+        auto event = ContextPools::IncomingEventContexts().Acquire();
+        logger.LogEvent(props, *record, *event);
+        pooled = counter.Count();
+        properties = record->data[0].properties.size();
+        MATSDK_SET_LOG_LEVEL_(logLevel);
+    }
+
+    // The maps of event properties are node-based, one allocation per property remains
+    EXPECT_LE(pooled, properties + 2);
+    EXPECT_LT(pooled, fresh);
+}
+
+TEST(ContextPoolsTests, PooledUploadContextOnlyAllocatesItsReference)
+{
+    ContextPools::AcquireEventsUploadContext().reset();
+
+    size_t fresh = 0;
+    {
+        AllocationCounter counter;
+        auto ctx = std::make_shared<EventsUploadContext>();
+        fresh = counter.Count();
+    }
+
+    size_t pooled = 0;
+    EventsUploadContextPtr ctx;
+    {
+        AllocationCounter counter;
+        ctx = ContextPools::AcquireEventsUploadContext();
+        pooled = counter.Count();
+    }
+    EXPECT_EQ(pooled, 1u);
+    EXPECT_LT(pooled, fresh);
+    EXPECT_NE(ctx->splicer, nullptr);
+    EXPECT_EQ(ctx->durationMs, -1);
+}
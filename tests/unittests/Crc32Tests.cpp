@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "utils/Crc32.hpp"
+
+#include <random>
+
+using namespace testing;
+using namespace MAT;
+
+TEST(Crc32Tests, KnownVectors)
+{
+    EXPECT_EQ(0u, Crc32::Crc32c("", 0));
+    EXPECT_EQ(0xE3069283u, Crc32::Crc32c("123456789", 9));
+    EXPECT_EQ(0xE3069283u, Crc32::Crc32cSoftware("123456789", 9));
+
+    // RFC 3720, B.4: 32 bytes of zeros and of ones
+    std::vector<uint8_t> zeros(32, 0x00);
+    std::vector<uint8_t> ones(32, 0xFF);
+    EXPECT_EQ(0x8A9136AAu, Crc32::Crc32c(zeros.data(), zeros.size()));
+    EXPECT_EQ(0x62A8AB43u, Crc32::Crc32c(ones.data(), ones.size()));
+}
+
+TEST(Crc32Tests, AcceleratedMatchesSoftwareForAllAlignments)
+{
+    std::mt19937 random(12345);
+    std::vector<uint8_t> buffer(4096 + 16);
+    for (auto& value : buffer)
+    {
+        value = static_cast<uint8_t>(random());
+    }
+
+    for (size_t start = 0; start < 16; start++)
+    {
+        for (size_t size : { 0, 1, 3, 7, 8, 9, 15, 16, 17, 63, 100, 1023, 4096 })
+        {
+            EXPECT_EQ(Crc32::Crc32cSoftware(buffer.data() + start, size), Crc32::Crc32c(buffer.data() + start, size))
+                << "start " << start << ", size " << size;
+        }
+    }
+}
+
+TEST(Crc32Tests, ChainsAcrossCalls)
+{
+    std::string text = "The quick brown fox jumps over the lazy dog";
+    uint32_t whole = Crc32::Crc32c(text.data(), text.size());
+    for (size_t split = 0; split <= text.size(); split++)
+    {
+        uint32_t crc = Crc32::Crc32c(text.data(), split);
+        EXPECT_EQ(whole, Crc32::Crc32c(text.data() + split, text.size() - split, crc));
+        crc = Crc32::Crc32cSoftware(text.data(), split);
+        EXPECT_EQ(whole, Crc32::Crc32cSoftware(text.data() + split, text.size() - split, crc));
+    }
+}
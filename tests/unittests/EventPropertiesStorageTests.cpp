@@ -76,3 +76,37 @@ TEST(EventPropertiesStorageTests, AssignmentOperator)
     EXPECT_THAT(secondStorage.eventPolicyBitflags, storage.eventPolicyBitflags);
     EXPECT_THAT(secondStorage.timestampInMillis, storage.timestampInMillis);
 }
+
+TEST(EventPropertiesStorageTests, FlatPropertiesAreSortedAndCopied)
+{
+    EventPropertiesStorage storage;
+    storage.useFlatStorage = true;
+    storage.setProperty("b", EventProperty("second"));
+    storage.setProperty("a", EventProperty(int64_t(1)));
+    storage.setProperty("c", EventProperty(2.0));
+    ASSERT_EQ(storage.flatProperties.size(), 3u);
+    EXPECT_EQ(std::string(storage.flatProperties.begin()->name), "a");
+
+    EventPropertiesStorage copy { storage };
+    storage.clearProperties();
+    EXPECT_TRUE(storage.flatProperties.empty());
+
+    const FlatProperty* entry = copy.flatProperties.find("b", 1);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_TRUE(entry->isString);
+    EXPECT_EQ(std::string(entry->stringValue, entry->stringLength), "second");
+
+    copy.materializeFlatProperties();
+    EXPECT_EQ(copy.properties.size(), 3u);
+    EXPECT_EQ(copy.properties.at("c").as_double, 2.0);
+}
+
+TEST(EventPropertiesStorageTests, PropertyArenaGrows)
+{
+    PropertyArena arena;
+    std::string large(PropertyArena::MinChunkSize * 3, 'x');
+    const char* small = arena.copy("abc", 3);
+    const char* copy = arena.copy(large.data(), large.size());
+    EXPECT_STREQ(small, "abc");
+    EXPECT_EQ(std::string(copy), large);
+}
@@ -5,6 +5,8 @@
 
 #include "common/Common.hpp"
 #include "api/ContextFieldsProvider.hpp"
+#include "NullObjects.hpp"
+#include "decorators/EventPropertiesDecorator.hpp"
 
 using namespace testing;
 using namespace MAT;
@@ -241,3 +243,130 @@ TEST(EventPropertiesTests, TryGetLevel_ValueSetBySetLevel_ReturnsTrueAndCorrectV
     EXPECT_TRUE(std::get<0>(result));
     EXPECT_EQ(std::get<1>(result), 42);
 }
+
+TEST(EventPropertiesTests, FlatStorage_MatchesMapStorage)
+{
+    EventProperties mapProps("test");
+    EventProperties flatProps("test", PropertyStorageMode_Flat, 4);
+    EXPECT_EQ(mapProps.GetStorageMode(), PropertyStorageMode_Map);
+    EXPECT_EQ(flatProps.GetStorageMode(), PropertyStorageMode_Flat);
+
+    for (EventProperties* props : { &mapProps, &flatProps })
+    {
+        props->SetPropertyView("zeta", "last");
+        props->SetPropertyView("alpha", 42);
+        props->SetPropertyView("beta", 3.5);
+        props->SetPropertyView("gamma", true, PiiKind_Identity);
+        props->SetProperty("delta", std::string("std string"), PiiKind_None, DataCategory_PartB);
+        props->SetPropertyView("zeta", string_view_t("overwritten!", 11));
+    }
+
+    const auto& expected = mapProps.GetProperties();
+    const auto& actual = flatProps.GetProperties();
+    ASSERT_EQ(actual.size(), expected.size());
+    auto it = actual.begin();
+    for (const auto& kv : expected)
+    {
+        EXPECT_EQ(it->first, kv.first);
+        EXPECT_EQ(it->second, kv.second);
+        EXPECT_EQ(it->second.piiKind, kv.second.piiKind);
+        EXPECT_EQ(it->second.dataCategory, kv.second.dataCategory);
+        ++it;
+    }
+    EXPECT_EQ(actual.at("zeta").as_string, std::string("overwritten"));
+    EXPECT_EQ(flatProps.GetPiiProperties().size(), 1u);
+}
+
+TEST(EventPropertiesTests, FlatStorage_EraseCopyAndLevel)
+{
+    EventProperties props("test", PropertyStorageMode_Flat);
+    props.SetLevel(7);
+    props.SetPropertyView("name", "value");
+    EXPECT_THAT(props.GetProperties(), SizeIs(2));
+
+    EventProperties copy(props);
+    EXPECT_EQ(props.erase("name"), 1u);
+    EXPECT_EQ(props.erase("name"), 0u);
+    EXPECT_THAT(props.GetProperties(), SizeIs(1));
+    EXPECT_EQ(std::get<1>(props.TryGetLevel()), 7);
+
+    EXPECT_EQ(copy.GetStorageMode(), PropertyStorageMode_Flat);
+    ASSERT_THAT(copy.GetProperties(), SizeIs(2));
+    EXPECT_EQ(copy.GetProperties().at("name").as_string, std::string("value"));
+    EXPECT_TRUE(std::get<0>(copy.TryGetLevel()));
+    EXPECT_EQ(std::get<1>(copy.TryGetLevel()), 7);
+}
+
+TEST(EventPropertiesTests, FlatStorage_StaticNamesAreNotCopied)
+{
+    static const char staticName[] = "static.name";
+    EventProperties props("test", PropertyStorageMode_Flat);
+    props.SetPropertyView(string_view_t::literal(staticName), "value");
+    props.SetPropertyView(string_view_t("copied.name"), 1);
+
+    const FlatProperties* flat = props.GetFlatProperties();
+    ASSERT_NE(flat, nullptr);
+    const FlatProperty* level = flat->find(COMMONFIELDS_EVENT_LEVEL, sizeof(COMMONFIELDS_EVENT_LEVEL) - 1);
+    ASSERT_NE(level, nullptr);
+    EXPECT_TRUE(level->isStaticName);
+    const FlatProperty* literal = flat->find(staticName, sizeof(staticName) - 1);
+    ASSERT_NE(literal, nullptr);
+    EXPECT_EQ(literal->name, staticName);
+    const FlatProperty* copied = flat->find("copied.name", 11);
+    ASSERT_NE(copied, nullptr);
+    EXPECT_FALSE(copied->isStaticName);
+
+    EventProperties copy(props);
+    EXPECT_EQ(copy.GetFlatProperties()->find(staticName, sizeof(staticName) - 1)->name, staticName);
+    EXPECT_EQ(EventProperties("test").GetFlatProperties(), nullptr);
+}
+
+TEST(EventPropertiesTests, FlatStorage_DecoratesLikeMapStorage)
+{
+    NullLogManager logManager;
+    EventPropertiesDecorator decorator(logManager);
+    EventProperties mapProps("test.event");
+    EventProperties flatProps("test.event", PropertyStorageMode_Flat, 6);
+    for (EventProperties* props : { &mapProps, &flatProps })
+    {
+        props->SetPropertyView("text", "value");
+        props->SetPropertyView("number", 42);
+        props->SetPropertyView("user", "someone@example.com", PiiKind_Identity);
+        props->SetPropertyView("flag", true);
+        props->SetProperty("partB", std::string("b"), PiiKind_None, DataCategory_PartB);
+    }
+
+    CsProtocol::Record expected;
+    CsProtocol::Record actual;
+    EventLatency latency = EventLatency_Normal;
+    ASSERT_TRUE(decorator.decorate(expected, latency, mapProps));
+    ASSERT_TRUE(decorator.decorate(actual, latency, flatProps));
+    ASSERT_THAT(actual.data, SizeIs(1));
+    EXPECT_EQ(actual.data[0].properties, expected.data[0].properties);
+    EXPECT_EQ(actual.data[0].properties.at("text").stringValue, "value");
+    EXPECT_THAT(actual.data[0].properties.at("user").attributes, SizeIs(1));
+    ASSERT_THAT(actual.baseData, SizeIs(1));
+    EXPECT_EQ(actual.baseData[0].properties, expected.baseData[0].properties);
+}
+
+TEST(EventPropertiesTests, FlatStorage_InvalidNameIsRejected)
+{
+    EventProperties props("test", PropertyStorageMode_Flat);
+    props.SetPropertyView(".invalid", "value");
+    props.SetPropertyView(string_view_t("bad name"), int64_t(1));
+    EXPECT_THAT(props.GetProperties(), SizeIs(1));
+}
+
+TEST(EventPropertiesTests, FlatStorage_ManyProperties)
+{
+    EventProperties props("test", PropertyStorageMode_Flat);
+    for (int i = 0; i < 500; i++)
+    {
+        std::string name = "prop_" + std::to_string(i);
+        props.SetPropertyView(name, name);
+    }
+    const auto& properties = props.GetProperties();
+    ASSERT_THAT(properties, SizeIs(501));
+    EXPECT_EQ(properties.at("prop_123").as_string, std::string("prop_123"));
+    EXPECT_EQ(properties.at("prop_499").as_string, std::string("prop_499"));
+}
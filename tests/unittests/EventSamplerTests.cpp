@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "filter/EventSampler.hpp"
+
+using namespace testing;
+using namespace MAT;
+
+class EventSamplerTests : public ::testing::Test
+{
+public:
+    EventSamplerTests() noexcept
+        : runtimeConfig(configuration)
+    { }
+
+    ILogConfiguration configuration;
+    RuntimeConfig_Default runtimeConfig;
+    EventSampler sampler;
+
+    void Configure(const std::string& tenantId, const std::string& deviceId)
+    {
+        sampler.Configure(runtimeConfig, tenantId, [deviceId]() { return deviceId; });
+    }
+};
+
+TEST_F(EventSamplerTests, NoConfiguration_KeepsAllEvents)
+{
+    Configure("tenant", "device");
+    EXPECT_FALSE(sampler.IsEnabled());
+    EXPECT_EQ(sampler.GetSampleRate("Any.Event"), EventSampler::FullSampleRate);
+    EXPECT_TRUE(sampler.IsSampledIn("Any.Event"));
+}
+
+TEST_F(EventSamplerTests, ZeroRate_DropsAllEvents)
+{
+    configuration[CFG_MAP_SAMPLING][CFG_DBL_SAMPLING_RATE] = 0;
+    Configure("tenant", "device");
+    EXPECT_TRUE(sampler.IsEnabled());
+    EXPECT_FALSE(sampler.IsSampledIn("Any.Event"));
+}
+
+TEST_F(EventSamplerTests, RatePrecedence_EventThenTenantThenDefault)
+{
+    configuration[CFG_MAP_SAMPLING][CFG_DBL_SAMPLING_RATE] = 50.0;
+    configuration[CFG_MAP_SAMPLING][CFG_MAP_SAMPLING_TENANTS]["tenant"] = 10;
+    configuration[CFG_MAP_SAMPLING][CFG_MAP_SAMPLING_TENANTS]["other"] = 20;
+    configuration[CFG_MAP_SAMPLING][CFG_MAP_SAMPLING_EVENTS]["Rare.Event"] = 0.5;
+    configuration[CFG_MAP_SAMPLING][CFG_MAP_SAMPLING_EVENTS]["Clamped.Event"] = 250;
+    Configure("tenant", "device");
+    EXPECT_EQ(sampler.GetSampleRate("Any.Event"), 10.0);
+    EXPECT_EQ(sampler.GetSampleRate("Rare.Event"), 0.5);
+    EXPECT_EQ(sampler.GetSampleRate("Clamped.Event"), 100.0);
+    EXPECT_TRUE(sampler.IsSampledIn("Clamped.Event"));
+}
+
+TEST_F(EventSamplerTests, DecisionIsDeterministicPerDevice)
+{
+    configuration[CFG_MAP_SAMPLING][CFG_DBL_SAMPLING_RATE] = 50;
+    Configure("tenant", "device-1");
+    double bucket = EventSampler::GetBucket("device-1");
+    EXPECT_EQ(sampler.GetDeviceBucket(), bucket);
+    EXPECT_GE(bucket, 0.0);
+    EXPECT_LT(bucket, 100.0);
+    bool sampledIn = sampler.IsSampledIn("Any.Event");
+    EXPECT_EQ(sampledIn, bucket < 50.0);
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT_EQ(sampler.IsSampledIn("Any.Event"), sampledIn);
+    }
+}
+
+TEST_F(EventSamplerTests, BucketsAreUniformlyDistributed)
+{
+    const size_t devices = 20000;
+    size_t sampledIn = 0;
+    for (size_t i = 0; i < devices; i++)
+    {
+        if (EventSampler::GetBucket(PAL::generateUuidString()) < 25.0)
+        {
+            sampledIn++;
+        }
+    }
+    double ratio = static_cast<double>(sampledIn) / devices;
+    EXPECT_NEAR(ratio, 0.25, 0.02);
+}
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+
+#include "EventSchema.hpp"
+#include "NullObjects.hpp"
+#include "decorators/EventPropertiesDecorator.hpp"
+
+using namespace testing;
+using namespace MAT;
+
+namespace
+{
+    MAT_SCHEMA_EVENT_NAME(FileOpenedName, "Test.FileOpened");
+    MAT_SCHEMA_FIELD(FileSize, "File.Size", int64_t);
+    MAT_SCHEMA_FIELD(FileType, "File.Type", std::string);
+    MAT_SCHEMA_FIELD(FileRatio, "File.Ratio", double);
+    MAT_SCHEMA_FIELD(FileCached, "File.Cached", bool);
+    MAT_SCHEMA_FIELD(FileCount, "File.Count", uint32_t);
+    MAT_SCHEMA_FIELD(FileId, "File.Id", GUID_t);
+
+    typedef EventSchema<FileOpenedName, FileSize, FileType, FileRatio, FileCached, FileCount, FileId> FileOpened;
+
+    static_assert(schema::isValidPropertyName("a.b_c"), "valid property name");
+    static_assert(!schema::isValidPropertyName(""), "empty property name");
+    static_assert(!schema::isValidPropertyName(".ab"), "leading dot");
+    static_assert(!schema::isValidPropertyName("ab."), "trailing dot");
+    static_assert(!schema::isValidPropertyName("a b"), "space");
+    static_assert(schema::isValidEventName("Test.Event"), "valid event name");
+    static_assert(!schema::isValidEventName("abc"), "event name too short");
+    static_assert(!schema::isValidEventName("Test-Event"), "dash in event name");
+
+    FileOpened makeEvent()
+    {
+        FileOpened event;
+        event.Set<FileSize>(1024);
+        event.Set<FileType>("docx");
+        event.Set<FileRatio>(0.5);
+        event.Set<FileCached>(true);
+        event.Set<FileCount>(7u);
+        event.Set<FileId>(GUID_t("{01020304-0506-0708-090a-0b0c0d0e0f00}"));
+        return event;
+    }
+} // namespace
+
+TEST(EventSchemaTests, SetAndGet)
+{
+    FileOpened event = makeEvent();
+    EXPECT_EQ(event.GetName(), "Test.FileOpened");
+    EXPECT_EQ(event.Get<FileSize>(), 1024);
+    EXPECT_EQ(event.Get<FileType>(), "docx");
+    EXPECT_EQ(event.Get<FileRatio>(), 0.5);
+    EXPECT_TRUE(event.Get<FileCached>());
+    EXPECT_EQ(event.Get<FileCount>(), 7u);
+    EXPECT_EQ(event.GetLevel(), DIAG_LEVEL_OPTIONAL);
+}
+
+TEST(EventSchemaTests, ToEventProperties)
+{
+    FileOpened event = makeEvent();
+    event.SetLatency(EventLatency_RealTime);
+    event.SetLevel(DIAG_LEVEL_REQUIRED);
+
+    EventProperties props = event.ToEventProperties();
+    EXPECT_EQ(props.GetName(), "Test.FileOpened");
+    EXPECT_EQ(props.GetLatency(), EventLatency_RealTime);
+    EXPECT_EQ(std::get<1>(props.TryGetLevel()), DIAG_LEVEL_REQUIRED);
+    EXPECT_EQ(props.GetProperties().at("File.Size").as_int64, 1024);
+    EXPECT_EQ(props.GetProperties().at("File.Type").as_string, std::string("docx"));
+    EXPECT_EQ(props.GetProperties().at("File.Count").as_int64, 7);
+}
+
+TEST(EventSchemaTests, DefaultLoggerLogsEquivalentEventProperties)
+{
+    class PropertiesLogger : public NullLogger
+    {
+    public:
+        using NullLogger::LogEvent;
+
+        virtual void LogEvent(EventProperties const& properties) override
+        {
+            logged.push_back(properties);
+        }
+
+        std::vector<EventProperties> logged;
+    };
+
+    PropertiesLogger logger;
+    FileOpened event = makeEvent();
+    logger.ILogger::LogEvent(event);
+    ASSERT_THAT(logger.logged, SizeIs(1));
+    EXPECT_EQ(logger.logged[0].GetName(), "Test.FileOpened");
+    EXPECT_EQ(logger.logged[0].GetProperties().at("File.Size").as_int64, 1024);
+}
+
+TEST(EventSchemaTests, DecoratedRecordMatchesEventProperties)
+{
+    NullLogManager logManager;
+    EventPropertiesDecorator decorator(logManager);
+    FileOpened event = makeEvent();
+    event.SetPolicyBitFlags(MICROSOFT_EVENTTAG_MARK_PII);
+
+    ::CsProtocol::Record expected;
+    EventLatency expectedLatency = event.GetLatency();
+    ASSERT_TRUE(decorator.decorate(expected, expectedLatency, event.ToEventProperties()));
+
+    ::CsProtocol::Record actual;
+    EventLatency actualLatency = event.GetLatency();
+    ASSERT_TRUE(decorator.decorate(actual, actualLatency, event));
+
+    EXPECT_EQ(actualLatency, expectedLatency);
+    EXPECT_EQ(actual.flags, expected.flags);
+    EXPECT_EQ(actual.popSample, expected.popSample);
+    ASSERT_EQ(actual.data.size(), 1u);
+    EXPECT_EQ(actual.data[0].properties.size(), 7u);
+    EXPECT_TRUE(actual.data[0].properties == expected.data[0].properties);
+}
+
+TEST(EventSchemaTests, CorrelationVectorFieldMovesToEnvelope)
+{
+    MAT_SCHEMA_FIELD(CorrelationVectorField, "__TlgCV__", std::string);
+    typedef EventSchema<FileOpenedName, CorrelationVectorField> WithCorrelationVector;
+
+    NullLogManager logManager;
+    EventPropertiesDecorator decorator(logManager);
+    WithCorrelationVector event;
+    event.Set<CorrelationVectorField>("cv.1");
+
+    ::CsProtocol::Record record;
+    EventLatency latency = EventLatency_Normal;
+    ASSERT_TRUE(decorator.decorate(record, latency, event));
+    EXPECT_EQ(record.cV, "cv.1");
+    EXPECT_EQ(record.data[0].properties.count("__TlgCV__"), 0u);
+}
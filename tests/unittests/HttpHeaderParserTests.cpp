@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "http/HttpHeaderParser.hpp"
+
+#include <cstring>
+#include <iterator>
+
+using namespace testing;
+using namespace MAT;
+
+static size_t parse(char const* raw, HttpHeaders& headers)
+{
+    return HttpHeaderParser::Parse(raw, strlen(raw), headers);
+}
+
+TEST(HttpHeadersTests, KeepsTheMultimapInterface)
+{
+    HttpHeaders headers;
+    headers.insert(std::make_pair("kill-tokens", "a"));
+    headers.add("Other", "x");
+    headers.add("kill-tokens", "b");
+    EXPECT_TRUE(headers.has("Other"));
+    EXPECT_EQ("", headers.get("Content-Length"));
+
+    auto range = headers.equal_range("kill-tokens");
+    ASSERT_EQ(2, std::distance(range.first, range.second));
+    EXPECT_EQ("a", range.first->second);
+    EXPECT_THAT(headers, ElementsAre(Pair("Other", "x"), Pair("kill-tokens", "a"), Pair("kill-tokens", "b")));
+}
+
+TEST(HttpHeadersTests, SetReplacesAllValuesAndAddKeepsThem)
+{
+    HttpHeaders headers;
+    headers.add("kill-tokens", "a");
+    headers.add("Other", "x");
+    headers.add("kill-tokens", "b");
+    EXPECT_EQ(std::vector<std::string>({ "a", "b" }), headers.getAll("kill-tokens"));
+
+    headers.set("kill-tokens", "c");
+    EXPECT_EQ(std::vector<std::string>({ "c" }), headers.getAll("kill-tokens"));
+    EXPECT_EQ(2u, headers.size());
+    EXPECT_THAT(headers, ElementsAre(Pair("Other", "x"), Pair("kill-tokens", "c")));
+}
+
+TEST(HttpHeaderParserTests, ParsesNamesAndValues)
+{
+    HttpHeaders headers;
+    EXPECT_EQ(4u, parse(
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json\r\n"
+        "Date: Mon, 01 Jan 2020 10:00:00 GMT\r\n"
+        "time-delta-millis:\t1234  \r\n"
+        "X-Empty:\r\n"
+        "not a header\r\n"
+        ": no name\r\n"
+        "\r\n", headers));
+    EXPECT_THAT(headers, ElementsAre(
+        Pair("Content-Type", "application/json"),
+        Pair("Date", "Mon, 01 Jan 2020 10:00:00 GMT"),
+        Pair("X-Empty", ""),
+        Pair("time-delta-millis", "1234")));
+}
+
+TEST(HttpHeaderParserTests, KeepsRepeatedHeadersAndJoinsFoldedLines)
+{
+    HttpHeaders headers;
+    parse(
+        "HTTP/1.1 200 OK\n"
+        "kill-tokens: tenant1:all\n"
+        "kill-tokens: tenant2:all\n"
+        "X-Folded: first\n"
+        "  second\n", headers);
+    EXPECT_EQ(std::vector<std::string>({ "tenant1:all", "tenant2:all" }), headers.getAll("kill-tokens"));
+    EXPECT_EQ("first second", headers.get("X-Folded"));
+}
+
+TEST(HttpHeaderParserTests, KeepsOnlyTheFinalResponse)
+{
+    HttpHeaders headers;
+    headers.add("Existing", "kept");
+    EXPECT_EQ(1u, parse(
+        "HTTP/1.1 100 Continue\r\n"
+        "X-Interim: 1\r\n"
+        "\r\n"
+        "HTTP/1.1 200 OK\r\n"
+        "Retry-After: 10", headers));
+    EXPECT_THAT(headers, ElementsAre(Pair("Existing", "kept"), Pair("Retry-After", "10")));
+}
@@ -2,8 +2,10 @@
 
 #include "common/Common.hpp"
 #include "common/MockIHttpClient.hpp"
+#include "common/MockITelemetrySystem.hpp"
 #include "http/HttpRequestEncoder.hpp"
 #include "config/RuntimeConfig_Default.hpp"
+#include "api/AuthTokensController.hpp"
 
 using namespace testing;
 using namespace MAT;
@@ -25,6 +27,33 @@ public:
     StorageBlob dataPacket;
 };
 
+class AuthTokensTelemetrySystem : public MockITelemetrySystem
+{
+public:
+    class AuthTokensLogManager : public NullLogManager
+    {
+    public:
+        IAuthTokensController* GetAuthTokensController() override
+        {
+            return &authTokens;
+        }
+
+        AuthTokensController authTokens;
+    };
+
+    ILogManager& getLogManager() override
+    {
+        return logManager;
+    }
+
+    IRuntimeConfig& getConfig() override
+    {
+        return testing::getSystem().getConfig();
+    }
+
+    AuthTokensLogManager logManager;
+};
+
 class HttpRequestEncoderTests : public Test {
 
 public:
@@ -92,6 +121,23 @@ TEST_F(HttpRequestEncoderTests, AddsCompressionHeader)
     EXPECT_THAT(req->m_headers, Contains(Pair("Content-Encoding", "deflate")));
 }
 
+TEST_F(HttpRequestEncoderTests, AddsChecksumHeaderWhenEnabled)
+{
+    EventsUploadContextPtr ctx = std::make_shared<EventsUploadContext>();
+    ctx->body = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+    encoder.encode(ctx);
+    SimpleHttpRequest const* req = static_cast<SimpleHttpRequest*>(ctx->httpRequest);
+    EXPECT_THAT(req->m_headers.find("Payload-CRC32C"), Eq(req->m_headers.end()));
+
+    system.getConfig()[CFG_BOOL_ENABLE_CRC32] = true;
+    ctx->body = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    encoder.encode(ctx);
+    system.getConfig()[CFG_BOOL_ENABLE_CRC32] = false;
+    req = static_cast<SimpleHttpRequest*>(ctx->httpRequest);
+    EXPECT_THAT(req->m_headers, Contains(Pair("Payload-CRC32C", "e3069283")));
+}
+
 TEST_F(HttpRequestEncoderTests, BuildsApiKeyCorrectly)
 {
     EventsUploadContextPtr ctx = std::make_shared<EventsUploadContext>();
@@ -126,3 +172,47 @@ TEST_F(HttpRequestEncoderTests, DispatchDataViewerEventCorrectly)
 
     EXPECT_THAT(mockEncoder.dataPacket, Eq(std::vector<uint8_t>{1, 127, 255}));
 }
+
+TEST(HttpRequestEncoderAuthTests, TokenHeadersFollowTokenChanges)
+{
+    AuthTokensTelemetrySystem system;
+    MockIHttpClient mockHttpClient;
+    EXPECT_CALL(mockHttpClient, CreateRequest())
+        .WillRepeatedly(Invoke([]() { return new SimpleHttpRequest("HttpRequestEncoderAuthTests"); }));
+    HttpRequestEncoder encoder(system, mockHttpClient);
+    auto& tokens = system.logManager.authTokens;
+
+    EventsUploadContextPtr ctx = std::make_shared<EventsUploadContext>();
+    encoder.encode(ctx);
+    SimpleHttpRequest const* req = static_cast<SimpleHttpRequest*>(ctx->httpRequest);
+    EXPECT_FALSE(req->m_headers.has("Tickets"));
+    EXPECT_FALSE(req->m_headers.has("Strict"));
+
+    tokens.SetTicketToken(TicketType_MSA_User, "user-ticket");
+    tokens.SetTicketToken(TicketType_AAD, "device-token");
+    tokens.SetStrictMode(true);
+    encoder.encode(ctx);
+    req = static_cast<SimpleHttpRequest*>(ctx->httpRequest);
+    EXPECT_THAT(req->m_headers, Contains(Pair("Tickets", "\"10001\"=\"p:user-ticket\"")));
+    EXPECT_THAT(req->m_headers, Contains(Pair("Aad-Token", "device-token")));
+    EXPECT_THAT(req->m_headers, Contains(Pair("Strict", "true")));
+    EXPECT_THAT(req->m_headers, Contains(Pair("Expect", "100-continue")));
+
+    // Headers built once are reused as long as the tokens stay the same
+    encoder.encode(ctx);
+    req = static_cast<SimpleHttpRequest*>(ctx->httpRequest);
+    EXPECT_EQ(1u, req->m_headers.getAll("Tickets").size());
+
+    tokens.SetTicketToken(TicketType_MSA_User, "renewed-ticket");
+    encoder.encode(ctx);
+    req = static_cast<SimpleHttpRequest*>(ctx->httpRequest);
+    EXPECT_THAT(req->m_headers, Contains(Pair("Tickets", "\"10001\"=\"p:renewed-ticket\"")));
+
+    tokens.Clear();
+    tokens.SetStrictMode(false);
+    encoder.encode(ctx);
+    req = static_cast<SimpleHttpRequest*>(ctx->httpRequest);
+    EXPECT_FALSE(req->m_headers.has("Tickets"));
+    EXPECT_FALSE(req->m_headers.has("Aad-Token"));
+    EXPECT_FALSE(req->m_headers.has("Strict"));
+}
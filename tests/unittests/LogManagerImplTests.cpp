@@ -5,6 +5,8 @@
 #include "api/LogManagerImpl.hpp"
 #include "common/Common.hpp"
 
+#include <thread>
+
 using namespace testing;
 using namespace MAT;
 
@@ -145,6 +147,64 @@ TEST_F(LogManagerModuleTests, TeardownModules_OneModuleRegistered_SizeOfModulesI
     ASSERT_EQ(logManager.m_modules.size(), size_t{0});
 }
 
+TEST(LogManagerImplTests, GetLogger_SameTokenAndSourceIgnoringCase_ReturnsSameLogger)
+{
+    ILogConfiguration configuration;
+    auto httpClient = std::make_shared<TestHttpClient>();
+    configuration.AddModule(CFG_MODULE_HTTP_CLIENT, httpClient);
+    TestLogManagerImpl logManager{configuration, true};
+
+    auto logger = logManager.GetLogger("Token", "Source");
+    ASSERT_NE(logger, nullptr);
+    EXPECT_EQ(logManager.GetLogger("token", "SOURCE"), logger);
+    EXPECT_NE(logManager.GetLogger("token", "other"), logger);
+
+    // Enough loggers to outgrow the registry a few times
+    std::vector<ILogger*> loggers;
+    for (int i = 0; i < 200; i++)
+    {
+        loggers.push_back(logManager.GetLogger("token" + std::to_string(i), "source"));
+    }
+    for (int i = 0; i < 200; i++)
+    {
+        EXPECT_EQ(logManager.GetLogger("TOKEN" + std::to_string(i), "Source"), loggers[i]);
+    }
+    EXPECT_EQ(logManager.GetLogger("token", "source"), logger);
+
+    logManager.FlushAndTeardown();
+    EXPECT_EQ(logManager.GetLogger("token", "source"), nullptr);
+}
+
+TEST(LogManagerImplTests, GetLogger_ConcurrentCallers_ShareLoggers)
+{
+    ILogConfiguration configuration;
+    auto httpClient = std::make_shared<TestHttpClient>();
+    configuration.AddModule(CFG_MODULE_HTTP_CLIENT, httpClient);
+    TestLogManagerImpl logManager{configuration, true};
+
+    const int count = 64;
+    std::vector<std::vector<ILogger*>> results(4, std::vector<ILogger*>(count));
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < results.size(); t++)
+    {
+        threads.emplace_back([&logManager, &results, t, count]()
+        {
+            for (int i = 0; i < count; i++)
+            {
+                results[t][i] = logManager.GetLogger("token" + std::to_string(i), "source");
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (size_t t = 1; t < results.size(); t++)
+    {
+        EXPECT_EQ(results[t], results[0]);
+    }
+}
+
 TEST(LogManagerImplTests, Constructor_DataViewerCollectionIsNotNullptr_DataViewerCollectionIsSet)
 {
     ILogConfiguration configuration;
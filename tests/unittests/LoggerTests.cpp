@@ -27,6 +27,32 @@ public:
     }
 };
 
+class BatchLogManager : public LogManagerImpl
+{
+public:
+    explicit BatchLogManager(ILogConfiguration& configuration)
+        : LogManagerImpl(configuration, true) { }
+
+    size_t SendEventCalls = {};
+    size_t SendEventsCalls = {};
+    std::vector<std::string> SentNames;
+
+    void sendEvent(IncomingEventContextPtr const& event) override
+    {
+        SendEventCalls++;
+        SentNames.push_back(event->source->name);
+    }
+
+    void sendEvents(IncomingEventContextBatch const& events) override
+    {
+        SendEventsCalls++;
+        for (auto const& event : events)
+        {
+            SentNames.push_back(event->source->name);
+        }
+    }
+};
+
 class LoggerTests : public ::testing::Test
 {
 public:
@@ -325,3 +351,49 @@ TEST_F(LoggerTests, LogSession_CanEventPropertiesBeSentReturnsTrue_CallsSubmit)
 }
 
 
+
+TEST_F(LoggerTests, LogEvent_SampledOut_DoesNotCallSubmit)
+{
+    configuration[CFG_MAP_SAMPLING][CFG_DBL_SAMPLING_RATE] = 0;
+    TestLogger sampledLogger("", "", "", logManager, contextFieldsProvider, runtimeConfig);
+    sampledLogger.LogEvent(EventProperties{});
+    EXPECT_FALSE(sampledLogger.SubmitCalled);
+}
+
+TEST_F(LoggerTests, LogEvent_EventRateOverridesDefaultRate_CallsSubmit)
+{
+    configuration[CFG_MAP_SAMPLING][CFG_DBL_SAMPLING_RATE] = 0;
+    configuration[CFG_MAP_SAMPLING][CFG_MAP_SAMPLING_EVENTS]["Always.Sent"] = 100;
+    TestLogger sampledLogger("", "", "", logManager, contextFieldsProvider, runtimeConfig);
+    sampledLogger.LogEvent(EventProperties{"Always.Sent"});
+    EXPECT_TRUE(sampledLogger.SubmitCalled);
+}
+
+TEST_F(LoggerTests, LogEvents_SendsAcceptedEventsAsOneBatch)
+{
+    configuration[CFG_MAP_SAMPLING][CFG_MAP_SAMPLING_EVENTS]["Sampled.Out"] = 0;
+    BatchLogManager batchLogManager(configuration);
+    Logger batchLogger("", "", "", batchLogManager, contextFieldsProvider, runtimeConfig);
+
+    std::vector<EventProperties> events { EventProperties("First"), EventProperties("Sampled.Out"), EventProperties("Latency.Off"), EventProperties("Last") };
+    events[2].SetLatency(EventLatency_Off);
+    batchLogger.LogEvents(events);
+
+    EXPECT_EQ(batchLogManager.SendEventCalls, 0u);
+    EXPECT_EQ(batchLogManager.SendEventsCalls, 1u);
+    EXPECT_THAT(batchLogManager.SentNames, ElementsAre("First", "Last"));
+}
+
+TEST_F(LoggerTests, LogEvents_AllEventsFiltered_SendsNothing)
+{
+    BatchLogManager batchLogManager(configuration);
+    Logger batchLogger("", "", "", batchLogManager, contextFieldsProvider, runtimeConfig);
+    batchLogger.GetEventFilters().RegisterEventFilter(MakeTestEventFilter(false));
+
+    std::vector<EventProperties> events { EventProperties("First"), EventProperties("Last") };
+    batchLogger.LogEvents(events);
+    batchLogger.LogEvents(nullptr, 0);
+
+    EXPECT_EQ(batchLogManager.SendEventsCalls, 0u);
+    EXPECT_TRUE(batchLogManager.SentNames.empty());
+}
@@ -0,0 +1,169 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+#include "common/MockIOfflineStorageObserver.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "offline/MemoryStorage.hpp"
+#include "system/MemoryBudget.hpp"
+
+#include "NullObjects.hpp"
+
+#include <atomic>
+
+using namespace testing;
+using namespace MAT;
+
+namespace {
+
+    // Memory resource that counts the bytes it has handed out
+    class CountingMemoryResource : public IMemoryResource
+    {
+    public:
+        std::atomic<size_t> bytes { 0 };
+        std::atomic<size_t> allocations { 0 };
+
+        void Initialize(ILogManager*) noexcept override {}
+
+        void Teardown() noexcept override {}
+
+        void* Allocate(size_t size, size_t) override
+        {
+            bytes += size;
+            allocations++;
+            return ::operator new(size);
+        }
+
+        void Deallocate(void* ptr, size_t size, size_t) noexcept override
+        {
+            bytes -= size;
+            ::operator delete(ptr);
+        }
+    };
+
+    StorageRecord makeRecord(std::string const& tenantToken, EventLatency latency, EventPersistence persistence = EventPersistence_Normal)
+    {
+        return StorageRecord(PAL::generateUuidString(), tenantToken, latency, persistence, PAL::getUtcSystemTimeMs(), StorageBlob(100));
+    }
+
+}
+
+class MemoryBudgetTests : public Test
+{
+protected:
+    std::shared_ptr<CountingMemoryResource>  resource { std::make_shared<CountingMemoryResource>() };
+    MemoryBudget                             budget { resource };
+    NullLogManager                           logManager;
+    ILogConfiguration                        configuration;
+    std::unique_ptr<RuntimeConfig_Default>   config;
+    NiceMock<MockIOfflineStorageObserver>    observer;
+    std::unique_ptr<MemoryStorage>           storage;
+
+    void initialize(size_t limit)
+    {
+        configuration[CFG_INT_MEMORY_BUDGET] = limit;
+        config.reset(new RuntimeConfig_Default(configuration));
+        budget.Configure(*config);
+        storage.reset(new MemoryStorage(logManager, *config, &budget));
+        storage->Initialize(observer);
+    }
+
+    static size_t recordSize()
+    {
+        return MemoryRecord(makeRecord("token", EventLatency_Normal), nullptr).GetSize();
+    }
+};
+
+TEST_F(MemoryBudgetTests, Allocator_AllocatesFromTheMemoryResource)
+{
+    {
+        std::vector<int, MemoryBudget::Allocator<int>> values { MemoryBudget::Allocator<int>(&budget) };
+        values.resize(1000);
+        EXPECT_GE(resource->bytes, 1000 * sizeof(int));
+        EXPECT_GE(resource->allocations, 1u);
+    }
+    EXPECT_EQ(resource->bytes, 0u);
+
+    std::vector<int, MemoryBudget::Allocator<int>> unbudgeted;
+    unbudgeted.resize(1000);
+    EXPECT_EQ(resource->bytes, 0u);
+}
+
+TEST_F(MemoryBudgetTests, MemoryCharge_ReportsCurrentAndPeakUsage)
+{
+    {
+        MemoryCharge charge(&budget, MemorySubsystem_Http);
+        charge.Add(300);
+        charge.Set(100);
+        EXPECT_EQ(budget.GetUsage(MemorySubsystem_Http), 100u);
+
+        MemoryCharge other;
+        other.Assign(&budget, MemorySubsystem_Packaging, 50);
+        MemoryUsage usage;
+        budget.GetMemoryUsage(usage);
+        EXPECT_EQ(usage.bytes[MemorySubsystem_Http], 100u);
+        EXPECT_EQ(usage.peakBytes[MemorySubsystem_Http], 300u);
+        EXPECT_EQ(usage.bytes[MemorySubsystem_Packaging], 50u);
+        EXPECT_EQ(usage.totalBytes, 150u);
+    }
+    EXPECT_EQ(budget.GetTotalUsage(), 0u);
+    EXPECT_FALSE(budget.WouldExceed(SIZE_MAX / 2));
+}
+
+TEST_F(MemoryBudgetTests, MemoryStorage_ChargesRecordsUntilTheyAreDeleted)
+{
+    initialize(0);
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT_TRUE(storage->StoreRecord(makeRecord("token", EventLatency_Normal)));
+    }
+    EXPECT_GE(resource->bytes, 10 * 100u);
+    EXPECT_EQ(budget.GetUsage(MemorySubsystem_Storage), storage->GetSize());
+    EXPECT_EQ(storage->GetSize(), 10 * recordSize());
+
+    std::vector<StorageRecordId> ids;
+    storage->GetAndReserveRecords([&ids](StorageRecord&& record) { ids.push_back(record.id); return true; }, 1000);
+    EXPECT_EQ(ids.size(), 10u);
+    EXPECT_EQ(storage->GetSize(), 0u);
+    EXPECT_EQ(budget.GetUsage(MemorySubsystem_Storage), 10 * recordSize());
+
+    bool fromMemory = false;
+    storage->DeleteRecords(ids, HttpHeaders(), fromMemory);
+    EXPECT_EQ(budget.GetUsage(MemorySubsystem_Storage), 0u);
+}
+
+TEST_F(MemoryBudgetTests, MemoryStorage_ShedsNonCriticalLowerLatencyRecordsFirst)
+{
+    initialize(4 * recordSize() + recordSize() / 2);
+    EXPECT_TRUE(storage->StoreRecord(makeRecord("critical", EventLatency_Normal, EventPersistence_Critical)));
+    EXPECT_TRUE(storage->StoreRecord(makeRecord("normal", EventLatency_Normal)));
+    EXPECT_TRUE(storage->StoreRecord(makeRecord("realtime", EventLatency_RealTime)));
+    EXPECT_TRUE(storage->StoreRecord(makeRecord("realtime", EventLatency_RealTime)));
+
+    EXPECT_CALL(observer, OnStorageTrimmed(ElementsAre(Pair("normal", 1u)))).Times(1);
+    EXPECT_TRUE(storage->StoreRecord(makeRecord("realtime", EventLatency_RealTime)));
+    EXPECT_EQ(storage->GetRecordCount(EventLatency_Normal), 1u);
+    EXPECT_EQ(storage->GetRecordCount(EventLatency_RealTime), 3u);
+
+    MemoryUsage usage;
+    budget.GetMemoryUsage(usage);
+    EXPECT_EQ(usage.shedEvents, 1u);
+    EXPECT_LE(usage.totalBytes, usage.limitBytes);
+}
+
+TEST_F(MemoryBudgetTests, MemoryStorage_DropsRecordsOfLowerLatencyThanTheQueuedOnes)
+{
+    initialize(2 * recordSize() + recordSize() / 2);
+    EXPECT_TRUE(storage->StoreRecord(makeRecord("realtime", EventLatency_RealTime)));
+    EXPECT_TRUE(storage->StoreRecord(makeRecord("realtime", EventLatency_RealTime)));
+
+    EXPECT_CALL(observer, OnStorageTrimmed(ElementsAre(Pair("normal", 1u)))).Times(1);
+    EXPECT_FALSE(storage->StoreRecord(makeRecord("normal", EventLatency_Normal)));
+    EXPECT_EQ(storage->GetRecordCount(), 2u);
+    EXPECT_EQ(storage->GetRecordCount(EventLatency_Normal), 0u);
+
+    MemoryUsage usage;
+    budget.GetMemoryUsage(usage);
+    EXPECT_EQ(usage.shedEvents, 1u);
+}
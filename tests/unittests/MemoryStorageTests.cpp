@@ -100,7 +100,7 @@ size_t addEvents(MemoryStorage& storage)
         for (const EventLatency &lat : latencies)
         {
             StorageRecord record{ PAL::generateUuidString(), "token", lat, EventPersistence_Critical, INT64_MIN + 1, { 5, 4, 3, 2, 1 }, 77, INT64_MAX - 1 };
-            total_db_size += record.blob.size() + sizeof(record);
+            total_db_size += MemoryRecord(record, nullptr).GetSize();
             storage.StoreRecord(record);
         }
     }
@@ -293,6 +293,36 @@ TEST(MemoryStorageTests, ResizeDb)
     EXPECT_THAT(storage.ResizeDb(), true);
 }
 
+TEST(MemoryStorageTests, GetAndReserveRecordsInterleavesTenantsWhenFair)
+{
+    ILogConfiguration fairConfiguration;
+    fairConfiguration[CFG_MAP_TENANT_FAIRNESS][CFG_INT_TENANT_FAIRNESS_QUANTUM] = 100;
+    RuntimeConfig_Default fairConfig(fairConfiguration);
+    MemoryStorage storage(testLogManager, fairConfig);
+
+    for (auto id : { "heavy0", "heavy1", "heavy2", "heavy3" })
+    {
+        storage.StoreRecord(StorageRecord(id, "heavy-token", EventLatency_Normal, EventPersistence_Normal, 1, StorageBlob(100)));
+    }
+    storage.StoreRecord(StorageRecord("light0", "light-token", EventLatency_Normal, EventPersistence_Normal, 1, StorageBlob(100)));
+    storage.StoreRecord(StorageRecord("light1", "light-token", EventLatency_Normal, EventPersistence_Normal, 1, StorageBlob(100)));
+
+    std::vector<std::string> ids;
+    storage.GetAndReserveRecords([&ids](StorageRecord&& record)
+    {
+        ids.push_back(record.id);
+        return true;
+    }, 1000, EventLatency_Normal, 4);
+    EXPECT_THAT(ids, ElementsAre("heavy3", "light1", "heavy2", "light0"));
+    EXPECT_THAT(storage.LastReadRecordCount(), 4u);
+    EXPECT_THAT(storage.GetReservedCount(), 4u);
+
+    auto remaining = storage.GetRecords();
+    ASSERT_THAT(remaining.size(), 2u);
+    EXPECT_THAT(remaining[0].id, "heavy1");
+    EXPECT_THAT(remaining[1].id, "heavy0");
+}
+
 constexpr size_t MAX_STRESS_THREADS = 20;
 
 TEST(MemoryStorageTests, MultiThreadPerfTest)
@@ -0,0 +1,180 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+
+#include "AggregatedMetric.hpp"
+#include "NullObjects.hpp"
+#include "stats/MetricAggregator.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace testing;
+using namespace MAT;
+
+namespace
+{
+    class AggregatedMetricLogger : public NullLogger
+    {
+    public:
+        std::mutex lock;
+        std::vector<AggregatedMetricData> metrics;
+
+        virtual void LogAggregatedMetric(AggregatedMetricData const& metricData, EventProperties const&) override
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            metrics.push_back(metricData);
+        }
+
+        size_t size()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            return metrics.size();
+        }
+    };
+} // namespace
+
+TEST(MetricAggregatorTests, BucketBoundaries)
+{
+    for (size_t i = 0; i < LogLinearHistogram::SubBucketCount; i++)
+    {
+        EXPECT_EQ(LogLinearHistogram::GetBucketIndex(static_cast<double>(i)), i);
+        EXPECT_EQ(LogLinearHistogram::GetBucketLowerBound(i), static_cast<long>(i));
+    }
+    EXPECT_EQ(LogLinearHistogram::GetBucketLowerBound(LogLinearHistogram::GetBucketIndex(16.0)), 16);
+    EXPECT_EQ(LogLinearHistogram::GetBucketLowerBound(LogLinearHistogram::GetBucketIndex(33.9)), 32);
+    EXPECT_EQ(LogLinearHistogram::GetBucketLowerBound(LogLinearHistogram::GetBucketIndex(34.0)), 34);
+    EXPECT_EQ(LogLinearHistogram::GetBucketLowerBound(LogLinearHistogram::GetBucketIndex(1000.0)), 992);
+
+    // Every value falls into a bucket whose width is at most 1/16th of its lower bound
+    for (double value = 16.0; value < 1e9; value *= 1.37)
+    {
+        size_t index = LogLinearHistogram::GetBucketIndex(value);
+        double lower = static_cast<double>(LogLinearHistogram::GetBucketLowerBound(index));
+        double upper = static_cast<double>(LogLinearHistogram::GetBucketLowerBound(index + 1));
+        EXPECT_LE(lower, value);
+        EXPECT_GT(upper, value);
+        EXPECT_LE(upper - lower, lower / LogLinearHistogram::SubBucketCount);
+    }
+
+    // Huge values are clamped into the last representable bucket
+    size_t last = LogLinearHistogram::GetBucketIndex(1e300);
+    EXPECT_GT(LogLinearHistogram::GetBucketLowerBound(last), 0);
+}
+
+TEST(MetricAggregatorTests, AccumulatorsMergeLikeASingleAccumulator)
+{
+    MetricAccumulator single;
+    MetricAccumulator left;
+    MetricAccumulator right;
+    for (int i = -50; i < 200; i++)
+    {
+        double value = i * 1.5;
+        single.Add(value);
+        ((i % 2) ? left : right).Add(value);
+    }
+    left.Merge(right);
+
+    AggregatedMetricData expected("metric", 0, 0);
+    single.Export(expected);
+    AggregatedMetricData actual("metric", 0, 0);
+    left.Export(actual);
+
+    EXPECT_EQ(actual.count, 250);
+    EXPECT_EQ(actual.count, expected.count);
+    EXPECT_EQ(actual.aggregates[AggregateType_Minimum], -75.0);
+    EXPECT_EQ(actual.aggregates[AggregateType_Maximum], 298.5);
+    EXPECT_EQ(actual.aggregates[AggregateType_Sum], expected.aggregates[AggregateType_Sum]);
+    EXPECT_EQ(actual.buckets, expected.buckets);
+
+    long total = 0;
+    for (auto const& bucket : actual.buckets)
+    {
+        total += bucket.second;
+    }
+    EXPECT_EQ(total, 250);
+    EXPECT_GT(actual.buckets.count(-64), 0u);
+}
+
+TEST(MetricAggregatorTests, CollectDrainsAllThreads)
+{
+    const size_t threadCount = 8;
+    const size_t valuesPerThread = 10000;
+
+    MetricAggregator aggregator;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&aggregator, t]() {
+            for (size_t i = 0; i < valuesPerThread; i++)
+            {
+                aggregator.Add(static_cast<double>(t + 1));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    aggregator.Add(std::numeric_limits<double>::quiet_NaN());
+
+    MetricAccumulator total;
+    aggregator.Collect(total);
+    AggregatedMetricData data("metric", 0, 0);
+    total.Export(data);
+    EXPECT_EQ(data.count, static_cast<long>(threadCount * valuesPerThread));
+    EXPECT_EQ(data.aggregates[AggregateType_Sum], 36.0 * valuesPerThread);
+    EXPECT_EQ(data.aggregates[AggregateType_Minimum], 1.0);
+    EXPECT_EQ(data.aggregates[AggregateType_Maximum], 8.0);
+    EXPECT_EQ(data.buckets.size(), threadCount);
+
+    MetricAccumulator empty;
+    aggregator.Collect(empty);
+    EXPECT_TRUE(empty.Empty());
+}
+
+TEST(MetricAggregatorTests, AggregatedMetricFlushesOnDestruction)
+{
+    AggregatedMetricLogger logger;
+    {
+        Models::AggregatedMetric metric("latency", "ms", 0, "instance", "class", "id", EventProperties("Test.Metric"), &logger);
+        for (int i = 1; i <= 1000; i++)
+        {
+            metric.PushMetric(i);
+        }
+        EXPECT_EQ(logger.size(), 0u);
+    }
+    ASSERT_EQ(logger.size(), 1u);
+    AggregatedMetricData& data = logger.metrics[0];
+    EXPECT_EQ(data.name, "latency");
+    EXPECT_EQ(data.units, "ms");
+    EXPECT_EQ(data.instanceName, "instance");
+    EXPECT_EQ(data.objectClass, "class");
+    EXPECT_EQ(data.objectId, "id");
+    EXPECT_EQ(data.count, 1000);
+    EXPECT_EQ(data.aggregates[AggregateType_Sum], 500500.0);
+    // Unit-wide buckets 1..15, plus 16 buckets for each power of two from 16 to 512
+    EXPECT_EQ(data.buckets.size(), 111u);
+}
+
+TEST(MetricAggregatorTests, AggregatedMetricFlushesOnTimer)
+{
+    AggregatedMetricLogger logger;
+    Models::AggregatedMetric metric("latency", "ms", 1, EventProperties("Test.Metric"), &logger);
+    metric.PushMetric(42.0);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((logger.size() == 0) && (std::chrono::steady_clock::now() < deadline))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ASSERT_EQ(logger.size(), 1u);
+    EXPECT_EQ(logger.metrics[0].count, 1);
+    EXPECT_GE(logger.metrics[0].duration, 1000000);
+
+    // Empty intervals are not reported
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    EXPECT_EQ(logger.size(), 1u);
+}
@@ -0,0 +1,207 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+#include "common/MockIOfflineStorageObserver.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "offline/OfflineStorageHandler.hpp"
+#include "offline/OfflineStorage_SQLite.hpp"
+#include "utils/Utils.hpp"
+
+#include "NullObjects.hpp"
+
+#include <cstdio>
+
+#ifdef HAVE_MAT_STORAGE
+using namespace testing;
+using namespace MAT;
+
+namespace {
+
+    // Dispatcher that runs queued tasks only when asked to
+    class ManualTaskDispatcher : public ITaskDispatcher
+    {
+    public:
+        std::vector<std::unique_ptr<Task>> tasks;
+
+        void Join() override {}
+
+        void Queue(Task* task) override
+        {
+            tasks.emplace_back(task);
+        }
+
+        bool Cancel(Task* task, uint64_t) override
+        {
+            for (auto it = tasks.begin(); it != tasks.end(); ++it)
+            {
+                if (it->get() == task)
+                {
+                    tasks.erase(it);
+                    break;
+                }
+            }
+            return true;
+        }
+
+        void RunAll()
+        {
+            std::vector<std::unique_ptr<Task>> pending;
+            pending.swap(tasks);
+            for (auto& task : pending)
+            {
+                (*task)();
+            }
+        }
+    };
+
+    class DebugEventsLogManager : public NullLogManager
+    {
+    public:
+        virtual bool DispatchEvent(DebugEvent evt) override
+        {
+            if (evt.type == DebugEventType::EVT_STORAGE_READY)
+            {
+                storageReady++;
+            }
+            return true;
+        }
+
+        unsigned storageReady = 0;
+    };
+
+    StorageRecord makeRecord(std::string const& id)
+    {
+        return StorageRecord(id, "tenant-token", EventLatency_Normal, EventPersistence_Normal, PAL::getUtcSystemTimeMs(), StorageBlob(10));
+    }
+
+}
+
+class OfflineStorageHandlerTests : public Test
+{
+protected:
+    DebugEventsLogManager                    logManager;
+    ILogConfiguration                        configuration;
+    std::unique_ptr<RuntimeConfig_Default>   config;
+    ManualTaskDispatcher                     taskDispatcher;
+    NiceMock<MockIOfflineStorageObserver>    observer;
+    std::string                              cacheFile;
+    std::unique_ptr<OfflineStorageHandler>   handler;
+
+    virtual void SetUp() override
+    {
+        cacheFile = GetTempDirectory() + "OfflineStorageHandlerTests.db";
+        std::remove(cacheFile.c_str());
+        configuration[CFG_STR_CACHE_FILE_PATH] = cacheFile;
+        configuration[CFG_INT_RAM_QUEUE_SIZE] = 512 * 1024;
+        configuration[CFG_BOOL_DEFER_STORAGE_OPEN] = true;
+    }
+
+    virtual void TearDown() override
+    {
+        handler.reset();
+        std::remove(cacheFile.c_str());
+    }
+
+    void initialize()
+    {
+        config.reset(new RuntimeConfig_Default(configuration));
+        handler.reset(new OfflineStorageHandler(logManager, *config, taskDispatcher));
+        handler->Initialize(observer);
+    }
+
+    size_t countRecordsOnDisk()
+    {
+        NullLogManager nullLogManager;
+        NiceMock<MockIOfflineStorageObserver> diskObserver;
+        OfflineStorage_SQLite storage(nullLogManager, *config);
+        storage.Initialize(diskObserver);
+        size_t count = storage.GetRecordCount(EventLatency_Unspecified);
+        storage.Shutdown();
+        return count;
+    }
+};
+
+TEST_F(OfflineStorageHandlerTests, DeferredOpen_BuffersRecordsUntilTheWorkerOpensTheStorage)
+{
+    EXPECT_CALL(observer, OnStorageOpened(_)).Times(0);
+    initialize();
+    EXPECT_EQ(taskDispatcher.tasks.size(), 1u);
+    EXPECT_EQ(logManager.storageReady, 0u);
+
+    EXPECT_TRUE(handler->StoreRecord(makeRecord("early")));
+    EXPECT_EQ(handler->GetRecordCount(), 1u);
+    Mock::VerifyAndClearExpectations(&observer);
+
+    EXPECT_CALL(observer, OnStorageOpened("SQLite/Default")).Times(1);
+    taskDispatcher.RunAll();
+    EXPECT_EQ(logManager.storageReady, 1u);
+    EXPECT_EQ(handler->GetRecordCount(), 1u);
+
+    handler->Shutdown();
+    EXPECT_EQ(countRecordsOnDisk(), 1u);
+}
+
+TEST_F(OfflineStorageHandlerTests, DeferredOpen_ShutdownOpensThePendingStorage)
+{
+    initialize();
+    EXPECT_TRUE(handler->StoreRecord(makeRecord("early")));
+
+    handler->Shutdown();
+    EXPECT_TRUE(taskDispatcher.tasks.empty());
+    EXPECT_EQ(logManager.storageReady, 1u);
+    EXPECT_EQ(countRecordsOnDisk(), 1u);
+}
+
+TEST_F(OfflineStorageHandlerTests, DeferredOpen_SettingsOpenTheStorageOnDemand)
+{
+    initialize();
+    EXPECT_TRUE(handler->StoreSetting("name", "value"));
+    EXPECT_EQ(logManager.storageReady, 1u);
+    EXPECT_EQ(handler->GetSetting("name"), "value");
+
+    // The queued open finds the storage ready
+    taskDispatcher.RunAll();
+    EXPECT_EQ(logManager.storageReady, 1u);
+    handler->Shutdown();
+}
+
+TEST_F(OfflineStorageHandlerTests, WithoutRamQueue_OpensDuringInitialize)
+{
+    configuration[CFG_INT_RAM_QUEUE_SIZE] = 0;
+    initialize();
+    EXPECT_TRUE(taskDispatcher.tasks.empty());
+    EXPECT_EQ(logManager.storageReady, 1u);
+
+    EXPECT_TRUE(handler->StoreRecord(makeRecord("direct")));
+    EXPECT_EQ(handler->GetRecordCount(), 1u);
+    handler->Shutdown();
+}
+
+TEST_F(OfflineStorageHandlerTests, WithoutRamQueue_StoreRecordsMovesKilledRecordsBehindStoredOnes)
+{
+    configuration[CFG_INT_RAM_QUEUE_SIZE] = 0;
+    initialize();
+
+    HttpHeaders headers;
+    headers.add("kill-tokens", "killed-token");
+    headers.add("kill-duration", "3600");
+    bool fromMemory = false;
+    handler->DeleteRecords({ "unknown" }, headers, fromMemory);
+
+    StorageRecordVector records;
+    records.push_back(makeRecord("first"));
+    records.push_back(makeRecord("killed"));
+    records.back().tenantToken = "killed-token";
+    records.push_back(makeRecord("second"));
+
+    EXPECT_EQ(handler->StoreRecords(records), 2u);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].id, "first");
+    EXPECT_EQ(records[1].id, "second");
+    EXPECT_EQ(records[2].id, "killed");
+    EXPECT_EQ(handler->GetRecordCount(), 2u);
+    handler->Shutdown();
+}
+#endif
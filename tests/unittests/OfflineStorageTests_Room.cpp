@@ -16,6 +16,8 @@
 #include "offline/OfflineStorage_Room.hpp"
 #endif
 #include "offline/OfflineStorage_SQLite.hpp"
+#include "offline/OfflineStorage_Segments.hpp"
+#include "utils/FileUtils.hpp"
 #include "NullObjects.hpp"
 #include <functional>
 #include <string>
@@ -30,7 +32,8 @@ using namespace testing;
 enum class StorageImplementation {
     Room,
     SQLite,
-    Memory
+    Memory,
+    Segments
 };
 
 std::ostream & operator<<(std::ostream &o, StorageImplementation i) {
@@ -41,6 +44,8 @@ std::ostream & operator<<(std::ostream &o, StorageImplementation i) {
             return o << "SQLite";
         case StorageImplementation ::Memory:
             return o << "Memory";
+        case StorageImplementation::Segments:
+            return o << "Segments";
         default:
             return o << static_cast<int>(i);
     }
@@ -83,6 +88,13 @@ public:
             case StorageImplementation::Memory:
                 offlineStorage = std::make_unique<MAE::MemoryStorage>(nullLogManager, configMock);
                 break;
+            case StorageImplementation::Segments:
+                name << MAE::GetTempDirectory() << "OfflineStorageTestsSegments.db";
+                configMock[CFG_STR_CACHE_FILE_PATH] = name.str();
+                offlineStorage = std::make_unique<MAE::OfflineStorage_Segments>(nullLogManager, configMock);
+                EXPECT_CALL(observerMock, OnStorageOpened("Segments/Default"))
+                        .RetiresOnSaturation();
+                break;
         }
 
         offlineStorage->Initialize(observerMock);
@@ -161,6 +173,11 @@ TEST_P(OfflineStorageTestsRoom, TestBadFile)
         case StorageImplementation::SQLite:
             path = path + "BadDatabase.db";
             break;
+        case StorageImplementation::Segments:
+            path = MAE::OfflineStorage_Segments::GetSegmentDirectory(path + "BadDatabase.db");
+            MAE::DirectoryCreate(path.c_str());
+            path = path + PATH_SEPARATOR_CHAR + "1-0000000000000000.seg";
+            break;
     }
     auto badFile = std::ofstream(path);
     badFile << "this is a BAD database" << std::endl;
@@ -183,6 +200,12 @@ TEST_P(OfflineStorageTestsRoom, TestBadFile)
                 .RetiresOnSaturation();
             EXPECT_CALL(observerMock, OnStorageFailed("1")).RetiresOnSaturation();
             break;
+        case StorageImplementation::Segments:
+            configMock[CFG_STR_CACHE_FILE_PATH] = GetTempDirectory() + "BadDatabase.db";
+            badStorage = std::make_unique<MAE::OfflineStorage_Segments>(nullLogManager, configMock);
+            EXPECT_CALL(observerMock, OnStorageOpened("Segments/Default"))
+                .RetiresOnSaturation();
+            break;
         default:
             return;
     }
@@ -558,6 +581,9 @@ TEST_P(OfflineStorageTestsRoom, ResizeDB)
         index += 1;
     }
     auto preCount = offlineStorage->GetRecordCount();
+    if (implementation == StorageImplementation::Segments) {
+        EXPECT_CALL(observerMock, OnStorageTrimmed(_)).WillOnce(Return());
+    }
     offlineStorage->ResizeDb();
     auto postCount = offlineStorage->GetRecordCount();
     EXPECT_GT(preCount, postCount);
@@ -605,9 +631,9 @@ TEST_P(OfflineStorageTestsRoom, StoreManyRecords)
 }
 
 #ifdef ANDROID
-auto values = Values(StorageImplementation::Room, StorageImplementation::SQLite, StorageImplementation::Memory);
+auto values = Values(StorageImplementation::Room, StorageImplementation::SQLite, StorageImplementation::Memory, StorageImplementation::Segments);
 #else
-auto values = Values(StorageImplementation::SQLite, StorageImplementation::Memory);
+auto values = Values(StorageImplementation::SQLite, StorageImplementation::Memory, StorageImplementation::Segments);
 #endif
 
 INSTANTIATE_TEST_CASE_P(Storage,
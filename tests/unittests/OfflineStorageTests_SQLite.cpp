@@ -2,11 +2,11 @@
 // Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
 // SPDX-License-Identifier: Apache-2.0
 //
-#if 0
 #include "common/Common.hpp"
 #include "common/MockIOfflineStorageObserver.hpp"
 #include "common/MockIRuntimeConfig.hpp"
 #include "offline/OfflineStorage_SQLite.hpp"
+#include "sqlite3.h"
 #include <stdio.h>
 #include <fstream>
 
@@ -46,7 +46,7 @@ struct OfflineStorageTests_SQLite : public Test
         static NullLogManager nullLogManager;
         logManager = &nullLogManager;
 
-        configuration["cacheFilePath"] = TEST_STORAGE_FILENAME;
+        configMock[CFG_STR_CACHE_FILE_PATH] = TEST_STORAGE_FILENAME;
         EXPECT_CALL(configMock, GetOfflineStorageMaximumSizeBytes()).WillRepeatedly(Return(UINT_MAX));
 
         offlineStorage.reset(new OfflineStorage_SQLiteNoAutoCommit(*logManager, configMock));
@@ -61,6 +61,39 @@ struct OfflineStorageTests_SQLite : public Test
         shutdownAndRemoveFile();
     }
 
+    // Opens the database again with a new storage instance, which picks up configuration changes
+    void reopen()
+    {
+        offlineStorage->Shutdown();
+        offlineStorage.reset(new OfflineStorage_SQLiteNoAutoCommit(*logManager, configMock));
+        EXPECT_CALL(observerMock, OnStorageOpened("SQLite/Default"))
+            .RetiresOnSaturation();
+        offlineStorage->Initialize(observerMock);
+    }
+
+    // Changes the database behind the storage's back, through a connection of its own
+    void executeSql(char const* sql)
+    {
+        sqlite3* db = nullptr;
+        ASSERT_EQ(SQLITE_OK, sqlite3_open(TEST_STORAGE_FILENAME, &db));
+        EXPECT_EQ(SQLITE_OK, sqlite3_exec(db, sql, nullptr, nullptr, nullptr)) << sqlite3_errmsg(db);
+        sqlite3_close(db);
+    }
+
+    int queryInt(char const* sql)
+    {
+        sqlite3* db = nullptr;
+        sqlite3_stmt* stmt = nullptr;
+        int value = -1;
+        if (sqlite3_open(TEST_STORAGE_FILENAME, &db) == SQLITE_OK && sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            value = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return value;
+    }
+
     void shutdownAndRemoveFile()
     {
         offlineStorage->Shutdown();
@@ -75,6 +108,142 @@ struct OfflineStorageTests_SQLite : public Test
     }
 };
 
+TEST_F(OfflineStorageTests_SQLite, CorruptPayloadIsDroppedOnRetrieval)
+{
+    configMock[CFG_BOOL_ENABLE_CRC32] = true;
+    reopen();
+
+    auto now = PAL::getUtcSystemTimeMs();
+    StorageRecordVector records;
+    records.emplace_back("a", "token-a", EventLatency_Normal, EventPersistence_Normal, now, StorageBlob(32, 0x11));
+    records.emplace_back("b", "token-b", EventLatency_Normal, EventPersistence_Normal, now, StorageBlob(32, 0x22));
+    offlineStorage->StoreRecords(records);
+    executeSql("UPDATE events SET payload=X'BAD0' WHERE record_id='b'");
+
+    // Only the damaged record goes away, the database itself is kept
+    EXPECT_CALL(observerMock, OnStorageRecordsDropped(std::map<std::string, size_t>{ { "token-b", 1 } }));
+    auto found = offlineStorage->GetRecords(false, EventLatency_Normal, 0);
+    ASSERT_EQ(1u, found.size());
+    EXPECT_EQ("a", found[0].id);
+    EXPECT_EQ(1u, offlineStorage->GetRecordCount(EventLatency_Unspecified));
+}
+
+TEST_F(OfflineStorageTests_SQLite, Version1DatabaseIsUpgradedInPlace)
+{
+    offlineStorage->Shutdown();
+    executeSql(
+        "DROP TABLE events;"
+        "CREATE TABLE events (record_id TEXT, tenant_token TEXT NOT NULL, latency INTEGER, persistence INTEGER,"
+        " timestamp INTEGER, retry_count INTEGER DEFAULT 0, reserved_until INTEGER DEFAULT 0, payload BLOB);"
+        "INSERT INTO events (record_id,tenant_token,latency,persistence,timestamp,payload) VALUES ('old','token-old',1,1,1000,X'010203');"
+        "PRAGMA user_version=1;");
+
+    // Records written before checksums existed are still delivered
+    configMock[CFG_BOOL_ENABLE_CRC32] = true;
+    reopen();
+    ASSERT_TRUE(offlineStorage->StoreRecord(StorageRecord("new", "token-new", EventLatency_Normal, EventPersistence_Normal, PAL::getUtcSystemTimeMs(), StorageBlob(8, 0x55))));
+    auto found = offlineStorage->GetRecords(false, EventLatency_Normal, 0);
+    ASSERT_EQ(2u, found.size());
+    EXPECT_EQ(StorageBlob({ 1, 2, 3 }), found[0].blob);
+    EXPECT_EQ(StorageBlob(8, 0x55), found[1].blob);
+}
+
+TEST_F(OfflineStorageTests_SQLite, TrimDropsNormalBeforeCriticalAndReclaimsSpace)
+{
+    size_t const limit = 64 * 1024;
+    EXPECT_CALL(configMock, GetOfflineStorageMaximumSizeBytes()).WillRepeatedly(Return(limit));
+    reopen();
+    EXPECT_EQ(2, queryInt("PRAGMA auto_vacuum")) << "expected INCREMENTAL";
+
+    auto now = PAL::getUtcSystemTimeMs();
+    size_t index = 0;
+    for (; index < 10; index++)
+    {
+        ASSERT_TRUE(offlineStorage->StoreRecord(StorageRecord(std::to_string(index), "token", EventLatency_Normal, EventPersistence_Critical, now - 1000, StorageBlob(1024, 0xCC))));
+    }
+    while (offlineStorage->GetSize() <= limit)
+    {
+        ASSERT_TRUE(offlineStorage->StoreRecord(StorageRecord(std::to_string(index++), "token", EventLatency_Normal, EventPersistence_Normal, now, StorageBlob(1024, 0x11))));
+    }
+    int pagesBefore = queryInt("PRAGMA page_count");
+
+    // Oldest normal records go first, and only as many as needed to get below three quarters of the limit
+    EXPECT_TRUE(offlineStorage->ResizeDb());
+    EXPECT_LE(offlineStorage->GetSize(), limit - limit / 4);
+    EXPECT_GT(offlineStorage->GetSize(), limit / 2);
+    auto records = offlineStorage->GetRecords(true, EventLatency_Normal, 0);
+    EXPECT_EQ(size_t(10), static_cast<size_t>(std::count_if(records.begin(), records.end(), [](StorageRecord const& record) {
+        return record.persistence == EventPersistence_Critical || record.blob[0] == 0xCC;
+    })));
+
+    // The freed pages were given back to the file system in the same pass
+    EXPECT_EQ(0, queryInt("PRAGMA freelist_count"));
+    EXPECT_LT(queryInt("PRAGMA page_count"), pagesBefore);
+}
+
+TEST_F(OfflineStorageTests_SQLite, RecordCountsFollowChangesAndAreReconciledOnOpen)
+{
+    EXPECT_EQ(0u, offlineStorage->GetRecordCount(EventLatency_Unspecified));
+
+    auto now = PAL::getUtcSystemTimeMs();
+    StorageRecordVector records;
+    records.emplace_back("a", "token", EventLatency_Normal, EventPersistence_Normal, now, StorageBlob(10, 0x11));
+    records.emplace_back("b", "token", EventLatency_Normal, EventPersistence_Normal, now, StorageBlob(20, 0x22));
+    records.emplace_back("c", "token", EventLatency_RealTime, EventPersistence_Normal, now, StorageBlob(40, 0x33));
+    offlineStorage->StoreRecords(records);
+    EXPECT_EQ(3u, offlineStorage->GetRecordCount(EventLatency_Unspecified));
+    EXPECT_EQ(2u, offlineStorage->GetRecordCount(EventLatency_Normal));
+    EXPECT_EQ(1u, offlineStorage->GetRecordCount(EventLatency_RealTime));
+    EXPECT_EQ(0u, offlineStorage->GetRecordCount(EventLatency_CostDeferred));
+    EXPECT_EQ(70u, offlineStorage->GetRecordBytes());
+    EXPECT_EQ(30u, offlineStorage->GetRecordBytes(EventLatency_Normal));
+
+    // Reserved records still count until they are deleted after upload
+    std::vector<StorageRecordId> reserved;
+    EXPECT_TRUE(offlineStorage->GetAndReserveRecords([&reserved](StorageRecord&& record) {
+        reserved.push_back(record.id);
+        return true;
+    }, 60000, EventLatency_RealTime));
+    ASSERT_EQ(std::vector<StorageRecordId>{ "c" }, reserved);
+    EXPECT_EQ(3u, offlineStorage->GetRecordCount(EventLatency_Unspecified));
+
+    bool fromMemory = false;
+    offlineStorage->DeleteRecords(reserved, HttpHeaders(), fromMemory);
+    EXPECT_EQ(2u, offlineStorage->GetRecordCount(EventLatency_Unspecified));
+    EXPECT_EQ(0u, offlineStorage->GetRecordCount(EventLatency_RealTime));
+    EXPECT_EQ(30u, offlineStorage->GetRecordBytes());
+
+    // Records that were never reserved are recounted from the database
+    offlineStorage->DeleteRecords(std::vector<StorageRecordId>{ "a" }, HttpHeaders(), fromMemory);
+    EXPECT_EQ(1u, offlineStorage->GetRecordCount(EventLatency_Normal));
+    EXPECT_EQ(20u, offlineStorage->GetRecordBytes(EventLatency_Normal));
+    offlineStorage->Shutdown();
+
+    // Whatever happened to the file while closed is picked up when it is opened again
+    executeSql(
+        "INSERT INTO events (record_id,tenant_token,latency,persistence,timestamp,payload) VALUES ('d','token',2,1,1000,X'0102030405');"
+        "INSERT INTO events (record_id,tenant_token,latency,persistence,timestamp,payload) VALUES ('e','token',2,1,1000,X'01');");
+    reopen();
+    EXPECT_EQ(3u, offlineStorage->GetRecordCount(EventLatency_Unspecified));
+    EXPECT_EQ(2u, offlineStorage->GetRecordCount(EventLatency_CostDeferred));
+    EXPECT_EQ(26u, offlineStorage->GetRecordBytes());
+
+    offlineStorage->DeleteAllRecords();
+    EXPECT_EQ(0u, offlineStorage->GetRecordCount(EventLatency_Unspecified));
+    EXPECT_EQ(0u, offlineStorage->GetRecordBytes());
+}
+
+TEST_F(OfflineStorageTests_SQLite, RecordCountMatchesRowsWhenAnIdIsStoredAgain)
+{
+    auto now = PAL::getUtcSystemTimeMs();
+    ASSERT_TRUE(offlineStorage->StoreRecord(StorageRecord("a", "token", EventLatency_Normal, EventPersistence_Normal, now, StorageBlob(10, 0x11))));
+    ASSERT_TRUE(offlineStorage->StoreRecord(StorageRecord("a", "token", EventLatency_Normal, EventPersistence_Normal, now, StorageBlob(10, 0x22))));
+    EXPECT_EQ(static_cast<size_t>(queryInt("SELECT COUNT(*) FROM events")), offlineStorage->GetRecordCount(EventLatency_Unspecified));
+    EXPECT_EQ(static_cast<size_t>(queryInt("SELECT SUM(LENGTH(payload)) FROM events")), offlineStorage->GetRecordBytes());
+}
+
+#if 0
+
 
 class TestRecordConsumer {
   public:
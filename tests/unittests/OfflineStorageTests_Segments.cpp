@@ -0,0 +1,379 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#ifdef HAVE_MAT_STORAGE
+#include "common/Common.hpp"
+#include "common/MockIOfflineStorageObserver.hpp"
+#include "common/MockIRuntimeConfig.hpp"
+#include "offline/OfflineStorageFactory.hpp"
+#include "offline/OfflineStorage_Segments.hpp"
+#include "utils/FileUtils.hpp"
+
+#include "NullObjects.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+using namespace testing;
+using namespace MAT;
+
+class OfflineStorageTests_Segments : public Test
+{
+protected:
+    ILogConfiguration                           configuration;
+    MockIRuntimeConfig                          configMock;
+    StrictMock<MockIOfflineStorageObserver>     observerMock;
+    NullLogManager                              nullLogManager;
+    std::unique_ptr<OfflineStorage_Segments>    offlineStorage;
+    std::string                                 directory;
+
+    OfflineStorageTests_Segments() : configMock(configuration)
+    {
+        configMock[CFG_STR_CACHE_FILE_PATH] = GetTempDirectory() + "OfflineStorageTests_Segments.db";
+        configMock[CFG_INT_STORAGE_SEGMENT_SIZE] = 4096;
+        EXPECT_CALL(configMock, GetOfflineStorageMaximumSizeBytes()).WillRepeatedly(Return(1024 * 1024));
+        EXPECT_CALL(configMock, GetMaximumRetryCount()).WillRepeatedly(Return(5));
+        directory = OfflineStorage_Segments::GetSegmentDirectory(GetTempDirectory() + "OfflineStorageTests_Segments.db");
+    }
+
+    virtual void SetUp() override
+    {
+        removeFiles();
+        open();
+    }
+
+    virtual void TearDown() override
+    {
+        offlineStorage->Shutdown();
+        removeFiles();
+    }
+
+    void open()
+    {
+        offlineStorage.reset(new OfflineStorage_Segments(nullLogManager, configMock));
+        EXPECT_CALL(observerMock, OnStorageOpened("Segments/Default"))
+            .RetiresOnSaturation();
+        offlineStorage->Initialize(observerMock);
+    }
+
+    void reopen()
+    {
+        offlineStorage->Shutdown();
+        open();
+    }
+
+    void removeFiles()
+    {
+        for (auto const& name : DirectoryGetFiles(directory.c_str()))
+        {
+            FileDelete((directory + PATH_SEPARATOR_CHAR + name).c_str());
+        }
+    }
+
+    std::vector<std::string> segmentFiles()
+    {
+        std::vector<std::string> result;
+        for (auto const& name : DirectoryGetFiles(directory.c_str()))
+        {
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".seg") == 0)
+            {
+                result.push_back(name);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    StorageRecord makeRecord(std::string const& id, EventLatency latency, size_t blobSize, uint8_t fill)
+    {
+        return StorageRecord(id, "token-" + id, latency, EventPersistence_Normal, 1000, StorageBlob(blobSize, fill));
+    }
+
+    void replaceBytes(std::string const& path, std::string const& from, std::string const& to)
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t position = contents.find(from);
+        ASSERT_NE(std::string::npos, position);
+        file.clear();
+        file.seekp(static_cast<std::streamoff>(position));
+        file.write(to.data(), static_cast<std::streamsize>(to.size()));
+    }
+
+    void corruptBlob(std::string const& path, std::string const& blob)
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t position = contents.find(blob);
+        ASSERT_NE(std::string::npos, position);
+        file.clear();
+        file.seekp(static_cast<std::streamoff>(position + 10));
+        file.put(static_cast<char>(blob[0] + 1));
+    }
+
+    std::vector<StorageRecord> reserveAll(unsigned leaseTimeMs = 60000)
+    {
+        std::vector<StorageRecord> records;
+        offlineStorage->GetAndReserveRecords([&records](StorageRecord&& record) -> bool {
+            records.push_back(std::move(record));
+            return true;
+        }, leaseTimeMs, EventLatency_Off);
+        return records;
+    }
+};
+
+TEST_F(OfflineStorageTests_Segments, RecordsSurviveReopen)
+{
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("a", EventLatency_Normal, 10, 1)));
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("b", EventLatency_RealTime, 20, 2)));
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("c", EventLatency_Normal, 30, 3)));
+    HttpHeaders headers;
+    bool fromMemory = false;
+    offlineStorage->DeleteRecords(std::vector<StorageRecordId>{ "c" }, headers, fromMemory);
+
+    reopen();
+
+    EXPECT_EQ(2u, offlineStorage->GetRecordCount(EventLatency_Unspecified));
+    auto records = offlineStorage->GetRecords(true, EventLatency_Off, 0);
+    ASSERT_EQ(2u, records.size());
+    EXPECT_EQ("b", records[0].id);
+    EXPECT_EQ("token-b", records[0].tenantToken);
+    EXPECT_EQ(EventLatency_RealTime, records[0].latency);
+    EXPECT_EQ(StorageBlob(20, 2), records[0].blob);
+    EXPECT_EQ(1000, records[0].timestamp);
+    EXPECT_EQ("a", records[1].id);
+    EXPECT_EQ(StorageBlob(10, 1), records[1].blob);
+}
+
+TEST_F(OfflineStorageTests_Segments, ReservationsAreReleasedByRestartButRetryCountsAreKept)
+{
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("a", EventLatency_Normal, 10, 1)));
+    auto records = reserveAll();
+    ASSERT_EQ(1u, records.size());
+    HttpHeaders headers;
+    bool fromMemory = false;
+    offlineStorage->ReleaseRecords(std::vector<StorageRecordId>{ "a" }, true, headers, fromMemory);
+    records = reserveAll();
+    ASSERT_EQ(1u, records.size());
+    EXPECT_EQ(1, records[0].retryCount);
+    EXPECT_TRUE(reserveAll().empty());
+
+    reopen();
+
+    records = reserveAll();
+    ASSERT_EQ(1u, records.size());
+    EXPECT_EQ("a", records[0].id);
+    EXPECT_EQ(1, records[0].retryCount);
+}
+
+TEST_F(OfflineStorageTests_Segments, StoringSameIdReplacesRecord)
+{
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("a", EventLatency_Normal, 10, 1)));
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("a", EventLatency_Normal, 10, 7)));
+    EXPECT_EQ(1u, offlineStorage->GetRecordCount(EventLatency_Unspecified));
+
+    reopen();
+
+    auto records = offlineStorage->GetRecords(true, EventLatency_Off, 0);
+    ASSERT_EQ(1u, records.size());
+    EXPECT_EQ(StorageBlob(10, 7), records[0].blob);
+}
+
+TEST_F(OfflineStorageTests_Segments, CorruptRecordIsSkippedOnRecovery)
+{
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("a", EventLatency_Normal, 64, 0x11)));
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("b", EventLatency_Normal, 64, 0x22)));
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("c", EventLatency_Normal, 64, 0x33)));
+    offlineStorage->Shutdown();
+
+    // Flip a byte in the blob of the middle record, as a bad sector would leave it
+    auto files = segmentFiles();
+    ASSERT_EQ(1u, files.size());
+    corruptBlob(directory + PATH_SEPARATOR_CHAR + files[0], std::string(64, '\x22'));
+
+    open();
+    EXPECT_EQ(2u, offlineStorage->GetRecordCount(EventLatency_Normal));
+
+    // Appends continue after the last record, the corrupt one stays deleted
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("d", EventLatency_Normal, 64, 0x44)));
+    reopen();
+    auto records = offlineStorage->GetRecords(true, EventLatency_Off, 0);
+    ASSERT_EQ(3u, records.size());
+    EXPECT_EQ("a", records[0].id);
+    EXPECT_EQ("c", records[1].id);
+    EXPECT_EQ("d", records[2].id);
+    EXPECT_EQ(StorageBlob(64, 0x44), records[2].blob);
+}
+
+TEST_F(OfflineStorageTests_Segments, CorruptRecordIsDroppedForGoodOnRecovery)
+{
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("a", EventLatency_Normal, 64, 0x11)));
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("b", EventLatency_Normal, 64, 0x22)));
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("c", EventLatency_Normal, 64, 0x33)));
+    offlineStorage->Shutdown();
+
+    auto files = segmentFiles();
+    ASSERT_EQ(1u, files.size());
+    std::string path = directory + PATH_SEPARATOR_CHAR + files[0];
+    corruptBlob(path, std::string(64, '\x22'));
+    open();
+    EXPECT_EQ(2u, offlineStorage->GetRecordCount(EventLatency_Normal));
+    offlineStorage->Shutdown();
+
+    // Recovery marks the record deleted in the file, so it stays gone even once its payload checks out again
+    replaceBytes(path, std::string(10, '\x22') + '\x23', std::string(11, '\x22'));
+    open();
+    auto records = offlineStorage->GetRecords(true, EventLatency_Off, 0);
+    ASSERT_EQ(2u, records.size());
+    EXPECT_EQ("a", records[0].id);
+    EXPECT_EQ("c", records[1].id);
+}
+
+TEST_F(OfflineStorageTests_Segments, CorruptRecordIsDroppedOnRetrievalWhenChecksumsEnabled)
+{
+    configMock[CFG_BOOL_ENABLE_CRC32] = true;
+    reopen();
+    configMock[CFG_BOOL_ENABLE_CRC32] = false;
+
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("a", EventLatency_Normal, 64, 0x11)));
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("b", EventLatency_Normal, 64, 0x22)));
+    offlineStorage->Flush();
+
+    // The file is shared with the live mapping, so the damage is visible without reopening
+    auto files = segmentFiles();
+    ASSERT_EQ(1u, files.size());
+    corruptBlob(directory + PATH_SEPARATOR_CHAR + files[0], std::string(64, '\x22'));
+
+    EXPECT_CALL(observerMock, OnStorageRecordsDropped(std::map<std::string, size_t>{ { "token-b", 1 } }));
+    auto records = reserveAll();
+    ASSERT_EQ(1u, records.size());
+    EXPECT_EQ("a", records[0].id);
+    EXPECT_EQ(1u, offlineStorage->GetRecordCount(EventLatency_Normal));
+}
+
+TEST_F(OfflineStorageTests_Segments, SegmentsAreRemovedOnceEmpty)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord(std::to_string(i), EventLatency_Normal, 1000, static_cast<uint8_t>(i))));
+    }
+    auto files = segmentFiles();
+    ASSERT_GT(files.size(), 2u);
+    // Only what was written counts, not the space the newest segment keeps for what comes next
+    EXPECT_GT(offlineStorage->GetSize(), 20u * 1000);
+    EXPECT_LT(offlineStorage->GetSize(), files.size() * 4096);
+
+    // Deleting everything but the newest record leaves only the segment it lives in
+    std::vector<StorageRecordId> ids;
+    for (int i = 0; i < 19; i++)
+    {
+        ids.push_back(std::to_string(i));
+    }
+    HttpHeaders headers;
+    bool fromMemory = false;
+    offlineStorage->DeleteRecords(ids, headers, fromMemory);
+    EXPECT_EQ(1u, segmentFiles().size());
+    EXPECT_LT(offlineStorage->GetSize(), 4096u);
+    EXPECT_EQ(1u, offlineStorage->GetRecordCount(EventLatency_Normal));
+}
+
+TEST_F(OfflineStorageTests_Segments, LargeRecordGetsItsOwnSegment)
+{
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("small", EventLatency_Normal, 10, 1)));
+    ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord("large", EventLatency_Normal, 10000, 2)));
+    EXPECT_EQ(2u, segmentFiles().size());
+
+    reopen();
+    auto records = offlineStorage->GetRecords(true, EventLatency_Off, 0);
+    ASSERT_EQ(2u, records.size());
+    EXPECT_EQ(StorageBlob(10000, 2), records[1].blob);
+}
+
+TEST_F(OfflineStorageTests_Segments, ResizeDropsOldestSegments)
+{
+    EXPECT_CALL(configMock, GetOfflineStorageMaximumSizeBytes()).WillRepeatedly(Return(16 * 4096));
+    reopen();
+
+    for (int i = 0; i < 80; i++)
+    {
+        ASSERT_TRUE(offlineStorage->StoreRecord(makeRecord(std::to_string(i), (i % 2) ? EventLatency_Normal : EventLatency_RealTime, 1000, 0)));
+    }
+    EXPECT_GT(offlineStorage->GetSize(), 16u * 4096);
+
+    std::map<std::string, size_t> trimmed;
+    EXPECT_CALL(observerMock, OnStorageTrimmed(_)).WillOnce(SaveArg<0>(&trimmed));
+    EXPECT_TRUE(offlineStorage->ResizeDb());
+    EXPECT_LE(offlineStorage->GetSize(), 12u * 4096);
+
+    size_t dropped = 0;
+    for (auto const& tenant : trimmed)
+    {
+        dropped += tenant.second;
+    }
+    EXPECT_EQ(80u, dropped + offlineStorage->GetRecordCount(EventLatency_Unspecified));
+    EXPECT_EQ(0u, trimmed.count("token-79"));
+    EXPECT_EQ(1u, trimmed.count("token-0"));
+}
+
+TEST_F(OfflineStorageTests_Segments, ResizeKeepsSegmentsWithCriticalRecords)
+{
+    EXPECT_CALL(configMock, GetOfflineStorageMaximumSizeBytes()).WillRepeatedly(Return(16 * 4096));
+    reopen();
+
+    for (int i = 0; i < 80; i++)
+    {
+        StorageRecord record = makeRecord(std::to_string(i), EventLatency_Normal, 1000, 0);
+        record.persistence = (i < 6) ? EventPersistence_Critical : EventPersistence_Normal;
+        ASSERT_TRUE(offlineStorage->StoreRecord(record));
+    }
+
+    std::map<std::string, size_t> trimmed;
+    EXPECT_CALL(observerMock, OnStorageTrimmed(_)).WillOnce(SaveArg<0>(&trimmed));
+    EXPECT_TRUE(offlineStorage->ResizeDb());
+    EXPECT_LE(offlineStorage->GetSize(), 12u * 4096);
+
+    // The oldest segments hold the critical records, so the normal ones after them go instead
+    for (int i = 0; i < 6; i++)
+    {
+        EXPECT_EQ(0u, trimmed.count("token-" + std::to_string(i)));
+    }
+    EXPECT_EQ(1u, trimmed.count("token-6"));
+    EXPECT_EQ(0u, trimmed.count("token-79"));
+}
+
+TEST_F(OfflineStorageTests_Segments, SettingsSurviveReopen)
+{
+    EXPECT_TRUE(offlineStorage->StoreSetting("name", "value"));
+    EXPECT_TRUE(offlineStorage->StoreSetting("other", std::string("with\nnewline")));
+    EXPECT_TRUE(offlineStorage->DeleteSetting("missing"));
+
+    reopen();
+
+    EXPECT_EQ("value", offlineStorage->GetSetting("name"));
+    EXPECT_EQ("with\nnewline", offlineStorage->GetSetting("other"));
+    EXPECT_TRUE(offlineStorage->DeleteSetting("name"));
+    EXPECT_TRUE(offlineStorage->StoreSetting("other", ""));
+
+    reopen();
+
+    EXPECT_EQ("", offlineStorage->GetSetting("name"));
+    EXPECT_EQ("", offlineStorage->GetSetting("other"));
+}
+
+TEST_F(OfflineStorageTests_Segments, FactoryCreatesSegmentsStorageWhenConfigured)
+{
+    auto storage = OfflineStorageFactory::Create(nullLogManager, configMock);
+    EXPECT_EQ(nullptr, std::dynamic_pointer_cast<OfflineStorage_Segments>(storage));
+
+    configMock[CFG_STR_OFFLINE_STORAGE_TYPE] = "segments";
+    storage = OfflineStorageFactory::Create(nullLogManager, configMock);
+    EXPECT_NE(nullptr, std::dynamic_pointer_cast<OfflineStorage_Segments>(storage));
+
+    configMock[CFG_STR_CACHE_FILE_PATH] = ":memory:";
+    storage = OfflineStorageFactory::Create(nullLogManager, configMock);
+    EXPECT_EQ(nullptr, std::dynamic_pointer_cast<OfflineStorage_Segments>(storage));
+}
+#endif // HAVE_MAT_STORAGE
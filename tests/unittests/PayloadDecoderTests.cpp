@@ -0,0 +1,292 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "PayloadDecoder.hpp"
+#include "bond/All.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
+#include "json.hpp"
+#include "zlib.h"
+
+#include <sstream>
+
+using namespace testing;
+using namespace MAT;
+
+namespace {
+
+    CsProtocol::Record makeRecord(std::string const& name)
+    {
+        CsProtocol::Record record;
+        record.ver = "3.0";
+        record.name = name;
+        record.time = 1234567890;
+        record.iKey = "o:tenant";
+        record.extProtocol.resize(1);
+        record.extUser.resize(1);
+        record.extDevice.resize(1);
+        record.extOs.resize(1);
+        record.extApp.resize(1);
+        record.extNet.resize(1);
+        record.extSdk.resize(1);
+        record.data.resize(1);
+        record.data[0].properties["text"].stringValue = "line1\nline2";
+        return record;
+    }
+
+    void appendRecord(std::vector<uint8_t>& body, CsProtocol::Record const& record)
+    {
+        bond_lite::CompactBinaryProtocolWriter writer(body);
+        bond_lite::Serialize(writer, record);
+    }
+
+    std::vector<uint8_t> deflate(std::vector<uint8_t> const& in)
+    {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        deflateInit2(&zs, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        std::vector<uint8_t> out(deflateBound(&zs, static_cast<uLong>(in.size())));
+        zs.next_in = const_cast<Bytef*>(in.data());
+        zs.avail_in = static_cast<uInt>(in.size());
+        zs.next_out = out.data();
+        zs.avail_out = static_cast<uInt>(out.size());
+        deflate(&zs, Z_FINISH);
+        out.resize(zs.total_out);
+        deflateEnd(&zs);
+        return out;
+    }
+
+    std::vector<std::string> splitLines(std::string const& text)
+    {
+        std::vector<std::string> lines;
+        std::istringstream in(text);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+}
+
+TEST(CompactBinaryProtocolReaderTests, ReadStringView_PointsIntoInput)
+{
+    std::vector<uint8_t> buffer;
+    bond_lite::CompactBinaryProtocolWriter writer(buffer);
+    writer.WriteString("hello");
+    writer.WriteString("");
+
+    bond_lite::CompactBinaryProtocolReader reader(buffer.data(), buffer.size());
+    char const* data = nullptr;
+    size_t size = 0;
+    ASSERT_TRUE(reader.ReadStringView(data, size));
+    EXPECT_EQ(std::string(data, size), "hello");
+    EXPECT_EQ(reinterpret_cast<uint8_t const*>(data), buffer.data() + 1);
+    ASSERT_TRUE(reader.ReadStringView(data, size));
+    EXPECT_EQ(size, 0u);
+    EXPECT_FALSE(reader.ReadStringView(data, size));
+}
+
+TEST(CompactBinaryProtocolReaderTests, Skip_FramesSerializedRecords)
+{
+    std::vector<uint8_t> body;
+    appendRecord(body, makeRecord("first"));
+    size_t firstSize = body.size();
+    appendRecord(body, makeRecord("second"));
+
+    bond_lite::CompactBinaryProtocolReader reader(body);
+    ASSERT_TRUE(reader.Skip(bond_lite::BT_STRUCT));
+    EXPECT_EQ(reader.getSize(), firstSize);
+    ASSERT_TRUE(reader.Skip(bond_lite::BT_STRUCT));
+    EXPECT_EQ(reader.getSize(), body.size());
+    EXPECT_FALSE(reader.Skip(bond_lite::BT_STRUCT));
+
+    bond_lite::CompactBinaryProtocolReader truncated(body.data(), firstSize - 1);
+    EXPECT_FALSE(truncated.Skip(bond_lite::BT_STRUCT));
+    EXPECT_TRUE(truncated.IsTruncated());
+
+    std::vector<uint8_t> malformed { static_cast<uint8_t>(0x1F), 0, 0 };
+    bond_lite::CompactBinaryProtocolReader invalidType(malformed);
+    EXPECT_FALSE(invalidType.Skip(bond_lite::BT_STRUCT));
+    EXPECT_FALSE(invalidType.IsTruncated());
+}
+
+TEST(CompactBinaryProtocolReaderTests, Skip_RejectsExcessiveNesting)
+{
+    std::vector<uint8_t> buffer;
+    bond_lite::CompactBinaryProtocolWriter writer(buffer);
+    for (int i = 0; i < 100; i++)
+    {
+        writer.WriteFieldBegin(bond_lite::BT_STRUCT, 1, nullptr);
+    }
+    for (int i = 0; i <= 100; i++)
+    {
+        writer.WriteStructEnd(false);
+    }
+
+    bond_lite::CompactBinaryProtocolReader reader(buffer);
+    EXPECT_FALSE(reader.Skip(bond_lite::BT_STRUCT));
+}
+
+TEST(PayloadDecoderTests, DecodeRequestRecords_OneLinePerRecord)
+{
+    std::vector<uint8_t> body;
+    appendRecord(body, makeRecord("first"));
+    appendRecord(body, makeRecord("second"));
+
+    std::vector<std::string> lines;
+    EXPECT_TRUE(exporters::DecodeRequestRecords(deflate(body), [&lines](std::string const& line)
+    {
+        lines.push_back(line);
+        return true;
+    }));
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_THAT(lines[0], HasSubstr("\"name\":\"first\""));
+    EXPECT_THAT(lines[1], HasSubstr("\"name\":\"second\""));
+    EXPECT_EQ(lines[0].find('\n'), std::string::npos);
+
+    // The consumer can stop the decoding early
+    size_t count = 0;
+    exporters::DecodeRequestRecords(body, [&count](std::string const&)
+    {
+        count++;
+        return false;
+    }, false);
+    EXPECT_EQ(count, 1u);
+}
+
+TEST(PayloadDecoderTests, DecodeRequestRecords_MatchesDecodeRecord)
+{
+    CsProtocol::Record record = makeRecord("rich");
+    record.popSample = 12.5;
+    record.flags = 514;
+    record.extProtocol[0].ticketKeys = { { "key1", "key2" }, { "key3" } };
+    record.extOs[0].bootId = -7;
+    record.extApp[0].asId = 42;
+    record.extDevice[0].orgId = "not written";
+    record.tags["tag"] = "value";
+    record.baseType = "base";
+    record.baseData.resize(1);
+    record.baseData[0].properties["count"].type = CsProtocol::ValueKind::ValueUInt32;
+    record.baseData[0].properties["count"].longValue = 123;
+    auto& properties = record.data[0].properties;
+    properties["bool"].type = CsProtocol::ValueKind::ValueBool;
+    properties["bool"].longValue = 1;
+    properties["double"].type = CsProtocol::ValueKind::ValueDouble;
+    properties["double"].doubleValue = 0.1;
+    properties["guid"].type = CsProtocol::ValueKind::ValueGuid;
+    properties["guid"].guidValue = { { 1, 2, 3, 255 } };
+    properties["longs"].type = CsProtocol::ValueKind::ValueArrayInt64;
+    properties["longs"].longArray = { { -1, 0, 1 } };
+    properties["strings"].type = CsProtocol::ValueKind::ValueArrayString;
+    properties["strings"].stringArray = { { "a", "\"quoted\"" } };
+    properties["pii"].stringValue = "user@example.com";
+    properties["pii"].attributes.resize(1);
+    properties["pii"].attributes[0].pii.resize(2);
+    properties["pii"].attributes[0].pii[0].Kind = CsProtocol::PIIKind::SmtpAddress;
+    properties["utf8"].stringValue = "caf\xC3\xA9 \x01";
+
+    std::vector<uint8_t> body;
+    appendRecord(body, record);
+    std::vector<std::string> lines;
+    EXPECT_TRUE(exporters::DecodeRequestRecords(body, [&lines](std::string const& line)
+    {
+        lines.push_back(line);
+        return true;
+    }, false));
+    ASSERT_EQ(lines.size(), 1u);
+
+    std::string expected;
+    ASSERT_TRUE(exporters::DecodeRecord(record, expected));
+    EXPECT_EQ(nlohmann::json::parse(lines[0]), nlohmann::json::parse(expected));
+    EXPECT_EQ(lines[0], nlohmann::json::parse(expected).dump());
+}
+
+TEST(PayloadDecoderTests, DecodeRequestStream_WritesNdjson)
+{
+    std::vector<uint8_t> body;
+    for (int i = 0; i < 500; i++)
+    {
+        appendRecord(body, makeRecord("event" + std::to_string(i)));
+    }
+    std::vector<uint8_t> compressed = deflate(body);
+
+    std::istringstream in(std::string(compressed.begin(), compressed.end()));
+    std::ostringstream out;
+    EXPECT_TRUE(exporters::DecodeRequestStream(in, out, true));
+
+    auto lines = splitLines(out.str());
+    ASSERT_EQ(lines.size(), 500u);
+    EXPECT_THAT(lines[0], HasSubstr("\"name\":\"event0\""));
+    EXPECT_THAT(lines[499], HasSubstr("\"name\":\"event499\""));
+}
+
+TEST(PayloadDecoderTests, DecodeRequestStream_SkipsMalformedRecord)
+{
+    std::vector<uint8_t> body;
+    appendRecord(body, makeRecord("first"));
+    {
+        // Well-framed struct with a field unknown to CsProtocol::Record
+        bond_lite::CompactBinaryProtocolWriter writer(body);
+        writer.WriteFieldBegin(bond_lite::BT_STRING, 200, nullptr);
+        writer.WriteString("unknown");
+        writer.WriteStructEnd(false);
+    }
+    appendRecord(body, makeRecord("last"));
+
+    std::istringstream in(std::string(body.begin(), body.end()));
+    std::ostringstream out;
+    EXPECT_FALSE(exporters::DecodeRequestStream(in, out, false));
+
+    auto lines = splitLines(out.str());
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_THAT(lines[0], HasSubstr("\"name\":\"first\""));
+    EXPECT_THAT(lines[1], HasSubstr("\"name\":\"last\""));
+}
+
+TEST(PayloadDecoderTests, DecodeRequestStream_FailsOnMalformedFraming)
+{
+    std::vector<uint8_t> body;
+    appendRecord(body, makeRecord("first"));
+    // Field of an invalid type: the record cannot be framed, so neither can the ones after it
+    body.push_back(0x1F);
+    body.push_back(0);
+    appendRecord(body, makeRecord("last"));
+
+    std::istringstream in(std::string(body.begin(), body.end()));
+    std::ostringstream out;
+    EXPECT_FALSE(exporters::DecodeRequestStream(in, out, false));
+
+    auto lines = splitLines(out.str());
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_THAT(lines[0], HasSubstr("\"name\":\"first\""));
+}
+
+TEST(PayloadDecoderTests, DecodeRequestStream_FailsOnTruncatedInput)
+{
+    std::vector<uint8_t> body;
+    appendRecord(body, makeRecord("first"));
+    appendRecord(body, makeRecord("second"));
+    body.resize(body.size() - 3);
+
+    std::istringstream in(std::string(body.begin(), body.end()));
+    std::ostringstream out;
+    EXPECT_FALSE(exporters::DecodeRequestStream(in, out, false));
+    EXPECT_EQ(splitLines(out.str()).size(), 1u);
+}
+
+TEST(PayloadDecoderTests, DecodeRequest_ReturnsJsonArray)
+{
+    std::vector<uint8_t> body;
+    appendRecord(body, makeRecord("first"));
+    appendRecord(body, makeRecord("second"));
+
+    std::string out;
+    ASSERT_TRUE(exporters::DecodeRequest(deflate(body), out));
+    EXPECT_EQ(out.front(), '[');
+    EXPECT_THAT(out, HasSubstr("\"name\": \"first\""));
+    EXPECT_THAT(out, HasSubstr("\"name\": \"second\""));
+}
@@ -0,0 +1,180 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+
+#include "NullObjects.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "stats/MetricAggregator.hpp"
+#include "stats/PipelineLatencyRecorder.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace testing;
+using namespace MAT;
+
+namespace
+{
+    class DebugEventLogManager : public NullLogManager
+    {
+    public:
+        std::vector<DebugEvent> events;
+
+        virtual bool DispatchEvent(DebugEvent evt) override
+        {
+            events.push_back(evt);
+            return true;
+        }
+    };
+
+    PipelineStageLatency const& getStage(std::vector<PipelineStageLatency> const& stages, PipelineStage stage)
+    {
+        return stages[static_cast<size_t>(stage)];
+    }
+} // namespace
+
+TEST(PipelineLatencyTests, BucketIndexIsMonotonicAndBounded)
+{
+    for (uint64_t i = 0; i < 16; i++)
+    {
+        EXPECT_EQ(PipelineLatencyRecorder::GetBucketIndex(i), i);
+    }
+    size_t previous = 0;
+    for (uint64_t value = 1; value < (1ull << 40); value = value * 3 / 2 + 1)
+    {
+        size_t index = PipelineLatencyRecorder::GetBucketIndex(value);
+        EXPECT_GE(index, previous);
+        EXPECT_LT(index, PipelineLatencyRecorder::BucketCount);
+        if (value < (1ull << PipelineLatencyRecorder::MaxExponent))
+        {
+            EXPECT_EQ(index, LogLinearHistogram::GetBucketIndex(static_cast<double>(value)));
+        }
+        previous = index;
+    }
+    EXPECT_EQ(PipelineLatencyRecorder::GetBucketIndex((1ull << PipelineLatencyRecorder::MaxExponent) - 1), PipelineLatencyRecorder::BucketCount - 1);
+    EXPECT_EQ(PipelineLatencyRecorder::GetBucketIndex(UINT64_MAX), PipelineLatencyRecorder::BucketCount - 1);
+}
+
+TEST(PipelineLatencyTests, RecordsCountsAndPercentiles)
+{
+    NullLogManager logManager;
+    PipelineLatencyRecorder recorder(logManager);
+
+    for (uint64_t us = 1; us <= 1000; us++)
+    {
+        recorder.Record(PipelineStage_Serialize, us);
+    }
+    recorder.Record(PipelineStage_Send, 250000);
+
+    std::vector<PipelineStageLatency> stages;
+    recorder.GetLatencies(stages, false);
+    ASSERT_EQ(stages.size(), static_cast<size_t>(PipelineStage_Count));
+
+    auto const& serialize = getStage(stages, PipelineStage_Serialize);
+    EXPECT_EQ(serialize.stage, PipelineStage_Serialize);
+    EXPECT_STREQ(serialize.name, "serialize");
+    EXPECT_EQ(serialize.count, 1000u);
+    EXPECT_EQ(serialize.minUs, 1u);
+    EXPECT_EQ(serialize.maxUs, 1000u);
+    EXPECT_DOUBLE_EQ(serialize.meanUs, 500.5);
+    // Percentiles are bucket upper bounds: within 1/16th above the exact value
+    EXPECT_GE(serialize.p50Us, 500u);
+    EXPECT_LE(serialize.p50Us, 500u + 500u / 16);
+    EXPECT_GE(serialize.p90Us, 900u);
+    EXPECT_LE(serialize.p90Us, 900u + 900u / 16);
+    EXPECT_GE(serialize.p99Us, 990u);
+    EXPECT_LE(serialize.p99Us, 1000u);
+    EXPECT_EQ(serialize.p999Us, 1000u);
+
+    auto const& send = getStage(stages, PipelineStage_Send);
+    EXPECT_EQ(send.count, 1u);
+    EXPECT_EQ(send.minUs, 250000u);
+    EXPECT_EQ(send.p50Us, 250000u);
+    EXPECT_EQ(send.p999Us, 250000u);
+
+    EXPECT_EQ(getStage(stages, PipelineStage_Decorate).count, 0u);
+    EXPECT_EQ(getStage(stages, PipelineStage_Decorate).p50Us, 0u);
+}
+
+TEST(PipelineLatencyTests, ResetClearsHistograms)
+{
+    NullLogManager logManager;
+    PipelineLatencyRecorder recorder(logManager);
+    recorder.Record(PipelineStage_Store, 42);
+
+    std::vector<PipelineStageLatency> stages;
+    recorder.GetLatencies(stages, true);
+    EXPECT_EQ(getStage(stages, PipelineStage_Store).count, 1u);
+
+    recorder.GetLatencies(stages, false);
+    EXPECT_EQ(getStage(stages, PipelineStage_Store).count, 0u);
+
+    recorder.Record(PipelineStage_Store, 7);
+    recorder.GetLatencies(stages, false);
+    EXPECT_EQ(getStage(stages, PipelineStage_Store).minUs, 7u);
+    EXPECT_EQ(getStage(stages, PipelineStage_Store).maxUs, 7u);
+}
+
+TEST(PipelineLatencyTests, ConfigurationControlsRecordingAndDebugEvents)
+{
+    DebugEventLogManager logManager;
+    ILogConfiguration logConfig;
+    RuntimeConfig_Default config(logConfig);
+    PipelineLatencyRecorder recorder(logManager);
+
+    recorder.Configure(config);
+    recorder.Record(PipelineStage_Encode, 10);
+    EXPECT_TRUE(logManager.events.empty());
+
+    config[CFG_MAP_PIPELINE_LATENCY][CFG_BOOL_PIPELINE_LATENCY_DEBUG_EVENTS] = true;
+    recorder.Configure(config);
+    recorder.Record(PipelineStage_Encode, 20);
+    ASSERT_EQ(logManager.events.size(), 1u);
+    EXPECT_EQ(logManager.events[0].type, EVT_PIPELINE_LATENCY);
+    EXPECT_EQ(logManager.events[0].param1, static_cast<size_t>(PipelineStage_Encode));
+    EXPECT_EQ(logManager.events[0].param2, 20u);
+
+    config[CFG_MAP_PIPELINE_LATENCY][CFG_BOOL_PIPELINE_LATENCY_ENABLED] = false;
+    recorder.Configure(config);
+    EXPECT_FALSE(recorder.IsEnabled());
+    recorder.Record(PipelineStage_Encode, 30);
+    EXPECT_EQ(logManager.events.size(), 1u);
+
+    std::vector<PipelineStageLatency> stages;
+    recorder.GetLatencies(stages, false);
+    EXPECT_EQ(getStage(stages, PipelineStage_Encode).count, 2u);
+}
+
+TEST(PipelineLatencyTests, RouteHopsRecordElapsedTimeBetweenStamps)
+{
+    NullLogManager logManager;
+    PipelineLatencyRecorder recorder(logManager);
+    PipelineLatencyHops hops(recorder);
+
+    RouteSource<EventsUploadContextPtr const&> initiateUpload;
+    RouteSource<EventsUploadContextPtr const&> retrievalFinished;
+    initiateUpload >> hops.uploadStarted;
+    retrievalFinished >> hops.retrieved >> hops.packaged;
+
+    EventsUploadContextPtr ctx = std::make_shared<EventsUploadContext>();
+    initiateUpload(ctx);
+    EXPECT_NE(ctx->stageStartUs, 0u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    retrievalFinished(ctx);
+
+    std::vector<PipelineStageLatency> stages;
+    recorder.GetLatencies(stages, false);
+    EXPECT_EQ(getStage(stages, PipelineStage_Retrieve).count, 1u);
+    EXPECT_GE(getStage(stages, PipelineStage_Retrieve).minUs, 5000u);
+    EXPECT_EQ(getStage(stages, PipelineStage_Package).count, 1u);
+
+    // A context that was never stamped is not recorded
+    RouteSource<IncomingEventContextPtr const&> prepared;
+    prepared >> hops.stored;
+    IncomingEventContext event;
+    prepared(&event);
+    recorder.GetLatencies(stages, false);
+    EXPECT_EQ(getStage(stages, PipelineStage_Store).count, 0u);
+}
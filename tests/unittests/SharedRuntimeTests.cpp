@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#include "common/Common.hpp"
+#include "common/MockIOfflineStorageObserver.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "system/SharedRuntime.hpp"
+#include "utils/Utils.hpp"
+
+#include "NullObjects.hpp"
+
+#include <cstdio>
+
+using namespace testing;
+using namespace MAT;
+
+namespace {
+
+    class SharedRuntime4Test : public SharedRuntime
+    {
+    public:
+        using SharedRuntime::getEngineFilePath;
+    };
+
+    class MemberLogManager : public NullLogManager
+    {
+    public:
+        MemberLogManager(std::string const& collectorUrl, std::string const& cacheFilePath)
+        {
+            configuration[CFG_STR_COLLECTOR_URL] = collectorUrl;
+            configuration[CFG_STR_CACHE_FILE_PATH] = cacheFilePath;
+            config.reset(new RuntimeConfig_Default(configuration));
+        }
+
+        virtual ILogConfiguration& GetLogConfiguration() override
+        {
+            return configuration;
+        }
+
+        ILogConfiguration                   configuration;
+        std::unique_ptr<IRuntimeConfig>     config;
+    };
+
+    StorageRecord makeRecord(std::string const& id, std::string const& tenantToken)
+    {
+        return StorageRecord(id, tenantToken, EventLatency_Normal, EventPersistence_Normal, 1, StorageBlob(10));
+    }
+
+}
+
+TEST(SharedRuntimeTests, Acquire_ReturnsTheRuntimeOfTheName)
+{
+    auto first = SharedRuntime::Acquire("SharedRuntimeTests");
+    auto second = SharedRuntime::Acquire("SharedRuntimeTests");
+    auto other = SharedRuntime::Acquire("SharedRuntimeTests-other");
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other);
+    EXPECT_EQ(first->GetName(), "SharedRuntimeTests");
+
+    std::weak_ptr<SharedRuntime> released = first;
+    first.reset();
+    second.reset();
+    EXPECT_TRUE(released.expired());
+}
+
+TEST(SharedRuntimeTests, GetEngineFilePath_IsNextToTheMemberCacheFile)
+{
+    std::string directory = std::string("dir") + PATH_SEPARATOR_CHAR;
+    std::string path = SharedRuntime4Test::getEngineFilePath("rt", directory + "member.db", "https://collector/");
+    EXPECT_EQ(path, directory + "rt-" + toString(hashCode("https://collector/")) + ".db");
+    EXPECT_NE(path, SharedRuntime4Test::getEngineFilePath("rt", directory + "member.db", "https://other/"));
+    EXPECT_EQ(SharedRuntime4Test::getEngineFilePath("rt", ":memory:", "https://collector/"), ":memory:");
+}
+
+#ifdef HAVE_MAT_STORAGE
+class SharedRuntimeTests_Storage : public Test
+{
+protected:
+    std::shared_ptr<SharedRuntime> runtime;
+    std::string memberFile;
+
+    virtual void SetUp() override
+    {
+        runtime = SharedRuntime::Acquire("SharedRuntimeTests");
+        memberFile = GetTempDirectory() + "SharedRuntimeTests-member.db";
+        TearDown();
+    }
+
+    virtual void TearDown() override
+    {
+        for (auto const& url : { "https://collector/", "https://other/" })
+        {
+            std::remove(SharedRuntime4Test::getEngineFilePath("SharedRuntimeTests", memberFile, url).c_str());
+        }
+    }
+
+    static std::vector<std::string> reserveAll(IOfflineStorage& storage)
+    {
+        std::vector<std::string> ids;
+        storage.GetAndReserveRecords([&ids](StorageRecord&& record)
+        {
+            ids.push_back(record.id);
+            return true;
+        }, 60000);
+        return ids;
+    }
+};
+
+TEST_F(SharedRuntimeTests_Storage, MembersOfACollectorShareTheEngine)
+{
+    MemberLogManager first("https://collector/", memberFile);
+    MemberLogManager second("https://collector/", memberFile);
+    NiceMock<MockIOfflineStorageObserver> firstObserver;
+    NiceMock<MockIOfflineStorageObserver> secondObserver;
+    EXPECT_CALL(firstObserver, OnStorageOpened(_)).Times(1);
+    EXPECT_CALL(secondObserver, OnStorageOpened(_)).Times(1);
+
+    auto firstStorage = runtime->GetStorage(first, *first.config);
+    auto secondStorage = runtime->GetStorage(second, *second.config);
+    firstStorage->Initialize(firstObserver);
+    secondStorage->Initialize(secondObserver);
+
+    EXPECT_TRUE(firstStorage->StoreRecord(makeRecord("first", "first-token")));
+    EXPECT_TRUE(secondStorage->StoreRecord(makeRecord("second", "second-token")));
+    EXPECT_EQ(firstStorage->GetRecordCount(EventLatency_Unspecified), 1u);
+    EXPECT_EQ(secondStorage->GetRecordCount(EventLatency_Unspecified), 1u);
+
+    // Whichever member uploads packages the records of both
+    auto ids = reserveAll(*secondStorage);
+    EXPECT_THAT(ids, UnorderedElementsAre("first", "second"));
+    bool fromMemory = false;
+    secondStorage->DeleteRecords(ids, HttpHeaders(), fromMemory);
+    EXPECT_EQ(firstStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+    EXPECT_EQ(secondStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+
+    firstStorage->Shutdown();
+    secondStorage->Shutdown();
+}
+
+TEST_F(SharedRuntimeTests_Storage, MembersDeleteOnlyTheirRecords)
+{
+    MemberLogManager first("https://collector/", memberFile);
+    MemberLogManager second("https://collector/", memberFile);
+    NiceMock<MockIOfflineStorageObserver> firstObserver;
+    NiceMock<MockIOfflineStorageObserver> secondObserver;
+
+    auto firstStorage = runtime->GetStorage(first, *first.config);
+    auto secondStorage = runtime->GetStorage(second, *second.config);
+    firstStorage->Initialize(firstObserver);
+    secondStorage->Initialize(secondObserver);
+    EXPECT_TRUE(firstStorage->StoreRecord(makeRecord("first", "first-token")));
+    EXPECT_TRUE(secondStorage->StoreRecord(makeRecord("second", "second-token")));
+
+    firstStorage->DeleteAllRecords();
+    EXPECT_EQ(firstStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+    EXPECT_EQ(secondStorage->GetRecordCount(EventLatency_Unspecified), 1u);
+    EXPECT_THAT(reserveAll(*firstStorage), ElementsAre("second"));
+
+    firstStorage->Shutdown();
+    secondStorage->Shutdown();
+
+    // Flushing a storage that was shut down does nothing
+    firstStorage->Flush();
+}
+
+TEST_F(SharedRuntimeTests_Storage, MembersKeepTheirOwnSettings)
+{
+    MemberLogManager first("https://collector/", memberFile);
+    MemberLogManager second("https://collector/", GetTempDirectory() + "SharedRuntimeTests-other.db");
+    NiceMock<MockIOfflineStorageObserver> observer;
+
+    auto firstStorage = runtime->GetStorage(first, *first.config);
+    auto secondStorage = runtime->GetStorage(second, *second.config);
+    firstStorage->Initialize(observer);
+    secondStorage->Initialize(observer);
+
+    EXPECT_TRUE(firstStorage->StoreSetting("sdkUuid", "first-uuid"));
+    EXPECT_TRUE(secondStorage->StoreSetting("sdkUuid", "second-uuid"));
+    EXPECT_EQ(firstStorage->GetSetting("sdkUuid"), "first-uuid");
+    EXPECT_EQ(secondStorage->GetSetting("sdkUuid"), "second-uuid");
+
+    EXPECT_TRUE(secondStorage->DeleteSetting("sdkUuid"));
+    EXPECT_EQ(firstStorage->GetSetting("sdkUuid"), "first-uuid");
+    EXPECT_EQ(secondStorage->GetSetting("sdkUuid"), "");
+
+    firstStorage->Shutdown();
+    secondStorage->Shutdown();
+}
+
+TEST_F(SharedRuntimeTests_Storage, CollectorsHaveSeparateEngines)
+{
+    MemberLogManager first("https://collector/", memberFile);
+    MemberLogManager second("https://other/", memberFile);
+    NiceMock<MockIOfflineStorageObserver> observer;
+
+    auto firstStorage = runtime->GetStorage(first, *first.config);
+    auto secondStorage = runtime->GetStorage(second, *second.config);
+    firstStorage->Initialize(observer);
+    secondStorage->Initialize(observer);
+
+    EXPECT_TRUE(firstStorage->StoreRecord(makeRecord("first", "first-token")));
+    EXPECT_EQ(firstStorage->GetRecordCount(EventLatency_Unspecified), 1u);
+    EXPECT_EQ(secondStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+
+    firstStorage->Shutdown();
+    secondStorage->Shutdown();
+}
+
+TEST_F(SharedRuntimeTests_Storage, EngineOutlivesAllButTheLastMember)
+{
+    MemberLogManager first("https://collector/", memberFile);
+    MemberLogManager second("https://collector/", memberFile);
+    NiceMock<MockIOfflineStorageObserver> firstObserver;
+    NiceMock<MockIOfflineStorageObserver> secondObserver;
+
+    auto firstStorage = runtime->GetStorage(first, *first.config);
+    auto secondStorage = runtime->GetStorage(second, *second.config);
+    firstStorage->Initialize(firstObserver);
+    secondStorage->Initialize(secondObserver);
+    EXPECT_TRUE(secondStorage->StoreRecord(makeRecord("second", "second-token")));
+
+    firstStorage->Shutdown();
+    firstStorage.reset();
+    std::vector<StorageRecord> records { makeRecord("third", "second-token") };
+    EXPECT_EQ(secondStorage->StoreRecords(records), 1u);
+    EXPECT_EQ(secondStorage->GetRecordCount(EventLatency_Unspecified), 2u);
+    secondStorage->Shutdown();
+
+    // The database persists the records of the runtime, the member finds those of its primary token
+    second.configuration[CFG_STR_PRIMARY_TOKEN] = "second-token";
+    auto storage = runtime->GetStorage(second, *second.config);
+    storage->Initialize(secondObserver);
+    EXPECT_EQ(storage->GetRecordCount(EventLatency_Unspecified), 2u);
+    storage->Shutdown();
+}
+#endif
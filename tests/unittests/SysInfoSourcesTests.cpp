@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "pal/posix/sysinfo_sources_impl.hpp"
+
+#include <thread>
+
+using namespace testing;
+
+TEST(SysInfoSourcesTests, ParseOsRelease_UnquotesValuesAndSkipsComments)
+{
+    auto values = sysinfo_sources_impl::parse_os_release(
+        "# comment=ignored\n"
+        "NAME=\"Ubuntu\"\n"
+        "ID=ubuntu\n"
+        "VERSION_ID='22.04'\r\n"
+        "VERSION=\"22.04.3 LTS (Jammy Jellyfish)\"\n"
+        "\n"
+        "malformed line\n"
+        "EMPTY=\n"
+        "LAST=no-newline");
+    EXPECT_EQ(values["NAME"], "Ubuntu");
+    EXPECT_EQ(values["ID"], "ubuntu");
+    EXPECT_EQ(values["VERSION_ID"], "22.04");
+    EXPECT_EQ(values["VERSION"], "22.04.3 LTS (Jammy Jellyfish)");
+    EXPECT_EQ(values["EMPTY"], "");
+    EXPECT_EQ(values["LAST"], "no-newline");
+    EXPECT_EQ(values.count("# comment"), 0u);
+    EXPECT_EQ(values.size(), 6u);
+}
+
+TEST(SysInfoSourcesTests, Get_ComputesEachFieldOnceOnFirstUse)
+{
+    sysinfo_sources sources;
+    std::atomic<int> calls(0);
+    sources.add("field", [&calls]() { calls++; return std::string("value"); });
+    EXPECT_EQ(calls, 0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&sources]() { EXPECT_EQ(sources.get("field"), "value"); });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(sources.get("unknown"), "");
+}
+
+TEST(SysInfoSourcesTests, Set_ProvidedValueIsNotComputed)
+{
+    sysinfo_sources sources;
+    bool computed = false;
+    sources.add("provided", [&computed]() { computed = true; return std::string("computed"); });
+    sources.add("computed", []() { return std::string("computed"); });
+
+    EXPECT_TRUE(sources.set("provided", "host"));
+    EXPECT_EQ(sources.get("provided"), "host");
+    EXPECT_FALSE(computed);
+
+    // Too late once computed, and unknown fields are not added
+    EXPECT_EQ(sources.get("computed"), "computed");
+    EXPECT_FALSE(sources.set("computed", "host"));
+    EXPECT_EQ(sources.get("computed"), "computed");
+    EXPECT_FALSE(sources.set("unknown", "host"));
+    EXPECT_EQ(sources.get("unknown"), "");
+}
+
+TEST(SysInfoSourcesTests, GetSysInfo_ProvidesTheSystemFields)
+{
+    auto& sysInfo = sysinfo_sources_impl::GetSysInfo();
+    EXPECT_FALSE(sysInfo.get("osName").empty());
+    EXPECT_FALSE(sysInfo.get("osRel").empty());
+    EXPECT_THAT(sysInfo.get("tz"), MatchesRegex("[+-][0-9][0-9]:[0-9][0-9]"));
+    EXPECT_EQ(&sysInfo.get("osName"), &sysinfo_sources_impl::GetSysInfo().get("osName"));
+}
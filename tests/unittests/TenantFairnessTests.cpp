@@ -0,0 +1,252 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#include "common/Common.hpp"
+#include "common/MockIOfflineStorageObserver.hpp"
+#include "common/MockIRuntimeConfig.hpp"
+#include "offline/TenantFairness.hpp"
+#ifdef HAVE_MAT_STORAGE
+#include "offline/OfflineStorage_SQLite.hpp"
+#endif
+#include "utils/Utils.hpp"
+
+#include "NullObjects.hpp"
+
+#include <cstdio>
+#include <set>
+
+using namespace testing;
+using namespace MAT;
+
+namespace {
+
+    StorageRecord makeRecord(std::string const& id, std::string const& tenantToken, EventLatency latency, size_t size, int64_t timestamp = 1)
+    {
+        return StorageRecord(id, tenantToken, latency, EventPersistence_Normal, timestamp, StorageBlob(size));
+    }
+
+    TenantFairness::RecordSource makeSource(std::vector<StorageRecord> records)
+    {
+        size_t next = 0;
+        return [records, next](StorageRecord& record) mutable
+        {
+            if (next == records.size())
+            {
+                return false;
+            }
+            record = records[next++];
+            return true;
+        };
+    }
+
+    std::vector<std::string> schedule(std::vector<TenantFairness::RecordSource>& sources, size_t quantum, size_t maxCount = SIZE_MAX)
+    {
+        std::vector<std::string> ids;
+        TenantFairness::Schedule(sources, quantum, [&ids, maxCount](StorageRecord&& record)
+        {
+            if (ids.size() >= maxCount)
+            {
+                return false;
+            }
+            ids.push_back(record.id);
+            return true;
+        });
+        return ids;
+    }
+
+}
+
+TEST(TenantFairnessTests, Schedule_AlternatesTenantsOfEqualRecordSizes)
+{
+    std::vector<TenantFairness::RecordSource> sources;
+    sources.push_back(makeSource({ makeRecord("a1", "a", EventLatency_Normal, 100), makeRecord("a2", "a", EventLatency_Normal, 100), makeRecord("a3", "a", EventLatency_Normal, 100) }));
+    sources.push_back(makeSource({ makeRecord("b1", "b", EventLatency_Normal, 100) }));
+    EXPECT_THAT(schedule(sources, 100), ElementsAre("a1", "b1", "a2", "a3"));
+}
+
+TEST(TenantFairnessTests, Schedule_SharesBytesNotRecords)
+{
+    // Tenant "a" logs records ten times larger: it gets one record for every ten of tenant "b"
+    std::vector<StorageRecord> large;
+    std::vector<StorageRecord> small;
+    for (int i = 0; i < 3; i++)
+    {
+        large.push_back(makeRecord("a" + std::to_string(i), "a", EventLatency_Normal, 1000));
+    }
+    for (int i = 0; i < 30; i++)
+    {
+        small.push_back(makeRecord("b" + std::to_string(i), "b", EventLatency_Normal, 100));
+    }
+    std::vector<TenantFairness::RecordSource> sources;
+    sources.push_back(makeSource(large));
+    sources.push_back(makeSource(small));
+
+    auto ids = schedule(sources, 500, 22);
+    ASSERT_EQ(ids.size(), 22u);
+    size_t largeCount = std::count_if(ids.begin(), ids.end(), [](std::string const& id) { return id[0] == 'a'; });
+    EXPECT_EQ(largeCount, 2u);
+    EXPECT_EQ(ids[0], "b0");
+}
+
+TEST(TenantFairnessTests, Schedule_ServesHigherLatencyFirst)
+{
+    std::vector<TenantFairness::RecordSource> sources;
+    sources.push_back(makeSource({ makeRecord("a-rt", "a", EventLatency_RealTime, 100), makeRecord("a-normal", "a", EventLatency_Normal, 100) }));
+    sources.push_back(makeSource({ makeRecord("b-normal1", "b", EventLatency_Normal, 100), makeRecord("b-normal2", "b", EventLatency_Normal, 100) }));
+    sources.push_back(makeSource({ makeRecord("c-max", "c", EventLatency_Max, 100) }));
+    EXPECT_THAT(schedule(sources, 100), ElementsAre("c-max", "a-rt", "a-normal", "b-normal1", "b-normal2"));
+}
+
+TEST(TenantFairnessTests, Schedule_StopsWhenConsumerRefuses)
+{
+    std::vector<TenantFairness::RecordSource> sources;
+    sources.push_back(makeSource({ makeRecord("a1", "a", EventLatency_Normal, 10), makeRecord("a2", "a", EventLatency_Normal, 10) }));
+    sources.push_back(makeSource({ makeRecord("b1", "b", EventLatency_Normal, 10) }));
+    size_t consumed = TenantFairness::Schedule(sources, 10, [](StorageRecord&& record) { return record.id != "b1"; });
+    EXPECT_EQ(consumed, 1u);
+}
+
+TEST(TenantFairnessTests, Configure_ReadsQuantumAndQuotas)
+{
+    ILogConfiguration configuration;
+    MockIRuntimeConfig config(configuration);
+    TenantFairness fairness;
+    fairness.Configure(config);
+    EXPECT_FALSE(fairness.IsFairQueueingEnabled());
+    EXPECT_FALSE(fairness.HasQuotas());
+
+    configuration[CFG_MAP_TENANT_FAIRNESS][CFG_INT_TENANT_FAIRNESS_QUANTUM] = 4096;
+    configuration[CFG_MAP_TENANT_FAIRNESS][CFG_INT_TENANT_FAIRNESS_QUOTA] = 100000;
+    configuration[CFG_MAP_TENANT_FAIRNESS][CFG_MAP_TENANT_FAIRNESS_TENANTS]["heavy"] = 1000;
+    fairness.Configure(config);
+    EXPECT_TRUE(fairness.IsFairQueueingEnabled());
+    EXPECT_EQ(fairness.GetQuantum(), 4096u);
+    EXPECT_TRUE(fairness.HasQuotas());
+    EXPECT_EQ(fairness.GetQuota("heavy-token"), 1000u);
+    EXPECT_EQ(fairness.GetQuota("other-token"), 100000u);
+}
+
+#ifdef HAVE_MAT_STORAGE
+class TenantFairnessTests_SQLite : public Test
+{
+protected:
+    ILogConfiguration                           configuration;
+    MockIRuntimeConfig                          configMock;
+    NiceMock<MockIOfflineStorageObserver>       observerMock;
+    NullLogManager                              nullLogManager;
+    std::unique_ptr<OfflineStorage_SQLite>      offlineStorage;
+    std::string                                 fileName;
+
+    TenantFairnessTests_SQLite() : configMock(configuration)
+    {
+        fileName = GetTempDirectory() + "TenantFairnessTests.db";
+        configMock[CFG_STR_CACHE_FILE_PATH] = fileName;
+        EXPECT_CALL(configMock, GetOfflineStorageMaximumSizeBytes()).WillRepeatedly(Return(0));
+    }
+
+    virtual void TearDown() override
+    {
+        if (offlineStorage)
+        {
+            offlineStorage->Shutdown();
+        }
+        std::remove(fileName.c_str());
+    }
+
+    void open()
+    {
+        std::remove(fileName.c_str());
+        offlineStorage.reset(new OfflineStorage_SQLite(nullLogManager, configMock));
+        offlineStorage->Initialize(observerMock);
+    }
+};
+
+TEST_F(TenantFairnessTests_SQLite, GetAndReserveRecords_InterleavesTenants)
+{
+    configuration[CFG_MAP_TENANT_FAIRNESS][CFG_INT_TENANT_FAIRNESS_QUANTUM] = 1000;
+    open();
+    for (int i = 0; i < 6; i++)
+    {
+        offlineStorage->StoreRecord(makeRecord("heavy" + std::to_string(i), "heavy-token", EventLatency_Normal, 1000, i + 1));
+    }
+    offlineStorage->StoreRecord(makeRecord("light0", "light-token", EventLatency_Normal, 1000, 10));
+    offlineStorage->StoreRecord(makeRecord("light1", "light-token", EventLatency_Normal, 1000, 11));
+    offlineStorage->StoreRecord(makeRecord("urgent", "heavy-token", EventLatency_RealTime, 1000, 12));
+
+    std::vector<std::string> ids;
+    EXPECT_TRUE(offlineStorage->GetAndReserveRecords([&ids](StorageRecord&& record)
+    {
+        ids.push_back(record.id);
+        return true;
+    }, 60000, EventLatency_Normal, 5));
+    ASSERT_EQ(ids.size(), 5u);
+    EXPECT_EQ(ids[0], "urgent");
+    // The light tenant is not queued behind the backlog of the heavy one
+    EXPECT_THAT(std::vector<std::string>(ids.begin() + 1, ids.end()), UnorderedElementsAre("heavy0", "heavy1", "light0", "light1"));
+    EXPECT_EQ(offlineStorage->LastReadRecordCount(), 5u);
+
+    // Only the handed out records were reserved
+    ids.clear();
+    offlineStorage->GetAndReserveRecords([&ids](StorageRecord&& record)
+    {
+        ids.push_back(record.id);
+        return true;
+    }, 60000, EventLatency_Normal);
+    EXPECT_THAT(ids, ElementsAre("heavy2", "heavy3", "heavy4", "heavy5"));
+}
+
+TEST_F(TenantFairnessTests_SQLite, GetAndReserveRecords_ReadsEachRecordOnceAcrossChunks)
+{
+    configuration[CFG_MAP_TENANT_FAIRNESS][CFG_INT_TENANT_FAIRNESS_QUANTUM] = 1000;
+    open();
+    // More records than a read chunk holds, most of them sharing a timestamp
+    std::set<std::string> expected;
+    for (int i = 0; i < 100; i++)
+    {
+        std::string id = "heavy" + std::to_string(i);
+        offlineStorage->StoreRecord(makeRecord(id, "heavy-token", (i % 10 == 0) ? EventLatency_RealTime : EventLatency_Normal, 100, (i < 90) ? 1 : i));
+        expected.insert(id);
+    }
+    offlineStorage->StoreRecord(makeRecord("light0", "light-token", EventLatency_Normal, 100, 1));
+    expected.insert("light0");
+
+    std::vector<std::string> ids;
+    EXPECT_TRUE(offlineStorage->GetAndReserveRecords([&ids](StorageRecord&& record)
+    {
+        ids.push_back(record.id);
+        return true;
+    }, 60000, EventLatency_Normal));
+    EXPECT_EQ(ids.size(), expected.size());
+    EXPECT_EQ(std::set<std::string>(ids.begin(), ids.end()), expected);
+}
+
+TEST_F(TenantFairnessTests_SQLite, ResizeDb_DropsOldestRecordsOfTenantsOverQuota)
+{
+    configuration[CFG_MAP_TENANT_FAIRNESS][CFG_MAP_TENANT_FAIRNESS_TENANTS]["heavy"] = 4000;
+    open();
+    for (int i = 0; i < 10; i++)
+    {
+        offlineStorage->StoreRecord(makeRecord("heavy" + std::to_string(i), "heavy-token", EventLatency_Normal, 1000, i + 1));
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        offlineStorage->StoreRecord(makeRecord("light" + std::to_string(i), "light-token", EventLatency_Normal, 1000, i + 1));
+    }
+
+    std::map<std::string, size_t> dropped;
+    dropped["heavy-token"] = 6;
+    EXPECT_CALL(observerMock, OnStorageRecordsDropped(dropped));
+    EXPECT_TRUE(offlineStorage->ResizeDb());
+    EXPECT_EQ(offlineStorage->GetRecordCount(EventLatency_Unspecified), 7u);
+
+    std::vector<std::string> ids;
+    offlineStorage->GetAndReserveRecords([&ids](StorageRecord&& record)
+    {
+        ids.push_back(record.id);
+        return true;
+    }, 60000, EventLatency_Normal);
+    EXPECT_THAT(ids, UnorderedElementsAre("heavy6", "heavy7", "heavy8", "heavy9", "light0", "light1", "light2"));
+}
+#endif
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+#include "bwcontrol/TokenBucketBandwidthController.hpp"
+
+using namespace testing;
+using namespace MAT;
+
+class TokenBucketBandwidthController4Test : public TokenBucketBandwidthController
+{
+  public:
+    TokenBucketBandwidthController4Test(unsigned rateBps, unsigned burstBytes) :
+        TokenBucketBandwidthController(rateBps, burstBytes)
+    {
+    }
+
+    uint64_t nowMs = 1000;
+
+  protected:
+    virtual uint64_t getMonotonicTimeMs() override
+    {
+        return nowMs;
+    }
+};
+
+TEST(TokenBucketBandwidthControllerTests, StartsFullAndProposesConfiguredRate)
+{
+    TokenBucketBandwidthController4Test bucket(1000, 5000);
+    EXPECT_EQ(bucket.GetProposedBandwidthBps(), 1000u);
+    EXPECT_EQ(bucket.GetAvailableBytes(), 5000u);
+}
+
+TEST(TokenBucketBandwidthControllerTests, BurstIsAtLeastOneSecondOfRate)
+{
+    TokenBucketBandwidthController4Test bucket(1000, 10);
+    EXPECT_EQ(bucket.GetAvailableBytes(), 1000u);
+}
+
+TEST(TokenBucketBandwidthControllerTests, UploadsConsumeTokensAndRefillAtRate)
+{
+    TokenBucketBandwidthController4Test bucket(1000, 2000);
+    bucket.GetAvailableBytes();
+    bucket.OnBytesUploaded(1500);
+    EXPECT_EQ(bucket.GetAvailableBytes(), 500u);
+
+    bucket.nowMs += 250;
+    EXPECT_EQ(bucket.GetAvailableBytes(), 750u);
+
+    bucket.nowMs += 60000;
+    EXPECT_EQ(bucket.GetAvailableBytes(), 2000u);
+}
+
+TEST(TokenBucketBandwidthControllerTests, OversizedUploadPutsBucketIntoDebt)
+{
+    TokenBucketBandwidthController4Test bucket(1000, 1000);
+    bucket.GetAvailableBytes();
+    bucket.OnBytesUploaded(3000);
+    EXPECT_EQ(bucket.GetAvailableBytes(), 0u);
+
+    bucket.nowMs += 1999;
+    EXPECT_EQ(bucket.GetAvailableBytes(), 0u);
+    bucket.nowMs += 1001;
+    EXPECT_EQ(bucket.GetAvailableBytes(), 1000u);
+}
@@ -17,8 +17,8 @@ using namespace MAT;
 
 class TransmissionPolicyManager4Test : public TransmissionPolicyManager {
   public:
-    TransmissionPolicyManager4Test(ITelemetrySystem& system, IBandwidthController* bandwidthController)
-      : TransmissionPolicyManager(system, *PAL::getDefaultTaskDispatcher(), bandwidthController)
+    TransmissionPolicyManager4Test(ITelemetrySystem& system, IBandwidthController* bandwidthController, TransmitProfiles& transmitProfiles)
+      : TransmissionPolicyManager(system, *PAL::getDefaultTaskDispatcher(), bandwidthController, transmitProfiles)
     {
     }
 
@@ -73,6 +73,7 @@ class TransmissionPolicyManagerTests : public StrictMock<Test> {
   protected:
     StrictMock<MockIRuntimeConfig>       runtimeConfigMock;
     StrictMock<MockIBandwidthController> bandwidthControllerMock;
+    TransmitProfiles                     transmitProfiles;
     TransmissionPolicyManager4Test       tpm;
 
     RouteSink<TransmissionPolicyManagerTests, EventsUploadContextPtr const&> initiateUpload{this, &TransmissionPolicyManagerTests::resultInitiateUpload};
@@ -80,7 +81,7 @@ class TransmissionPolicyManagerTests : public StrictMock<Test> {
 
   protected:
     TransmissionPolicyManagerTests()
-      : tpm(testing::getSystem(), &bandwidthControllerMock)
+      : tpm(testing::getSystem(), &bandwidthControllerMock, transmitProfiles)
     {
         tpm.initiateUpload     >> initiateUpload;
         tpm.allUploadsFinished >> allUploadsFinished;
@@ -93,6 +94,8 @@ class TransmissionPolicyManagerTests : public StrictMock<Test> {
     {
         EXPECT_CALL(bandwidthControllerMock, GetProposedBandwidthBps())
             .WillRepeatedly(Return(1000000));
+        EXPECT_CALL(bandwidthControllerMock, GetAvailableBytes())
+            .WillRepeatedly(Return(std::numeric_limits<unsigned>::max()));
         EXPECT_CALL(runtimeConfigMock, GetMinimumUploadBandwidthBps())
             .WillRepeatedly(Return(1000000));
 
@@ -171,8 +174,8 @@ TEST_F(TransmissionPolicyManagerTests, IncomingEventSchedulesUpload)
             }
         ]
     )";
-    EXPECT_TRUE(TransmitProfiles::load(customProfile));
-    EXPECT_TRUE(TransmitProfiles::setProfile("Fred"));
+    EXPECT_TRUE(transmitProfiles.load(customProfile));
+    EXPECT_TRUE(transmitProfiles.setProfile("Fred"));
 
     auto event = new IncomingEventContext();
     event->record.latency = EventLatency_Normal;
@@ -197,14 +200,14 @@ TEST_F(TransmissionPolicyManagerTests, ProfileAffectsSchedule)
             }
         ]
     )";
-    EXPECT_TRUE(TransmitProfiles::load(customProfile));
-    EXPECT_TRUE(TransmitProfiles::setProfile("Fred"));
+    EXPECT_TRUE(transmitProfiles.load(customProfile));
+    EXPECT_TRUE(transmitProfiles.setProfile("Fred"));
 
     auto event = new IncomingEventContext();
     event->record.latency = EventLatency_Normal;
     EXPECT_CALL(tpm, scheduleUpload(_, _, _)).Times(0);
     tpm.eventArrived(event);
-    TransmitProfiles::reset();
+    transmitProfiles.reset();
 }
 
 TEST_F(TransmissionPolicyManagerTests, NoUploadForNegative)
@@ -221,8 +224,8 @@ TEST_F(TransmissionPolicyManagerTests, NoUploadForNegative)
             }
         ]
     )";
-    EXPECT_TRUE(TransmitProfiles::load(customProfile));
-    EXPECT_TRUE(TransmitProfiles::setProfile("Fred"));
+    EXPECT_TRUE(transmitProfiles.load(customProfile));
+    EXPECT_TRUE(transmitProfiles.setProfile("Fred"));
 
     auto event = new IncomingEventContext();
     event->record.latency = EventLatency_Normal;
@@ -230,7 +233,7 @@ TEST_F(TransmissionPolicyManagerTests, NoUploadForNegative)
     tpm.eventArrived(event);
     EXPECT_CALL(tpm, uploadAsync(_)).Times(0);
     tpm.scheduleUploadParent(std::chrono::milliseconds{-1000}, EventLatency_RealTime, true);
-    TransmitProfiles::reset();
+    transmitProfiles.reset();
 }
 
 TEST_F(TransmissionPolicyManagerTests, ImmediateIncomingEventStartsUploadImmediately)
@@ -264,21 +267,91 @@ TEST_F(TransmissionPolicyManagerTests, UploadDoesNothingWhenAlreadyActive)
     EXPECT_CALL( tpm, uploadAsync(_) ).Times(0);
 }
 
-#if 0
 TEST_F(TransmissionPolicyManagerTests, UploadPostponedWithInsufficientAvailableBandwidth)
 {
     tpm.uploadScheduled(true);
     tpm.paused(false);
 
     EXPECT_CALL(bandwidthControllerMock, GetProposedBandwidthBps())
-        .WillOnce(Return(999999));
-    EXPECT_CALL(tpm, scheduleUpload(1000, EventLatency_Normal, false))
+        .WillOnce(Return(0));
+    EXPECT_CALL(tpm, scheduleUpload(std::chrono::milliseconds { 1000 }, EventLatency_Normal, false))
         .WillOnce(Return());
     tpm.uploadAsync(EventLatency_Normal);
 
     EXPECT_THAT(tpm.uploadScheduled(), false);
+    EXPECT_THAT(tpm.activeUploads(), IsEmpty());
+}
+
+TEST_F(TransmissionPolicyManagerTests, UploadPacedUntilBudgetCoversOneSecondOfBandwidth)
+{
+    tpm.uploadScheduled(true);
+    tpm.paused(false);
+
+    EXPECT_CALL(bandwidthControllerMock, GetProposedBandwidthBps())
+        .WillOnce(Return(1000));
+    EXPECT_CALL(bandwidthControllerMock, GetAvailableBytes())
+        .WillOnce(Return(250));
+    EXPECT_CALL(tpm, scheduleUpload(std::chrono::milliseconds { 750 }, EventLatency_Normal, false))
+        .WillOnce(Return());
+    tpm.uploadAsync(EventLatency_Normal);
+
+    EXPECT_THAT(tpm.activeUploads(), IsEmpty());
+}
+
+TEST_F(TransmissionPolicyManagerTests, UploadSizedToAvailableBudget)
+{
+    tpm.uploadScheduled(true);
+    tpm.paused(false);
+
+    EXPECT_CALL(bandwidthControllerMock, GetProposedBandwidthBps())
+        .WillOnce(Return(1000));
+    EXPECT_CALL(bandwidthControllerMock, GetAvailableBytes())
+        .WillOnce(Return(5000));
+    EventsUploadContextPtr upload;
+    EXPECT_CALL(*this, resultInitiateUpload(_))
+        .WillOnce(SaveArg<0>(&upload));
+    tpm.uploadAsync(EventLatency_Normal);
+
+    ASSERT_THAT(upload, NotNull());
+    EXPECT_THAT(upload->maxUploadSize, 5000u);
+}
+
+TEST_F(TransmissionPolicyManagerTests, UploadsWithoutByteBudgetRunConcurrently)
+{
+    tpm.uploadScheduled(true);
+    tpm.paused(false);
+    tpm.fakeActiveUpload();
+
+    EXPECT_CALL(*this, resultInitiateUpload(_))
+        .WillOnce(Return());
+    tpm.uploadAsync(EventLatency_Normal);
+
+    EXPECT_THAT(tpm.activeUploads(), SizeIs(2));
+}
+
+TEST_F(TransmissionPolicyManagerTests, UploadsWithByteBudgetGoOneAtATime)
+{
+    tpm.uploadScheduled(true);
+    tpm.paused(false);
+    tpm.fakeActiveUpload();
+
+    EXPECT_CALL(bandwidthControllerMock, GetAvailableBytes())
+        .WillOnce(Return(5000));
+    EXPECT_CALL(*this, resultInitiateUpload(_))
+        .Times(0);
+    tpm.uploadAsync(EventLatency_Normal);
+
+    EXPECT_THAT(tpm.activeUploads(), SizeIs(1));
+}
+
+TEST_F(TransmissionPolicyManagerTests, UploadStartingConsumesBudget)
+{
+    auto ctx = std::make_shared<EventsUploadContext>();
+    ctx->body.resize(123);
+    EXPECT_CALL(bandwidthControllerMock, OnBytesUploaded(123u))
+        .WillOnce(Return());
+    EXPECT_TRUE(tpm.uploadStarting(ctx));
 }
-#endif
 
 TEST_F(TransmissionPolicyManagerTests, UploadInitiatesUpload)
 {
@@ -487,8 +560,8 @@ TEST_F(TransmissionPolicyManagerTests, FredProfile)
     ]
 }]
 )";
-    EXPECT_TRUE(TransmitProfiles::load(fredProfile));
-    EXPECT_TRUE(TransmitProfiles::setProfile("Fred_Profile"));
+    EXPECT_TRUE(transmitProfiles.load(fredProfile));
+    EXPECT_TRUE(transmitProfiles.setProfile("Fred_Profile"));
     tpm.paused(false);
 
     auto event = new IncomingEventContext();
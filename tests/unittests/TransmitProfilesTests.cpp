@@ -347,6 +347,43 @@ TEST_F(TransmitProfilesTests, load_OneRule_ReturnsTrueAndSizeFour)
     ASSERT_EQ(TransmitProfiles::profiles.size(), 4);
 }
 
+TEST_F(TransmitProfilesTests, getTimers_ReturnsActiveRuleTimersAndClearsUpdateFlag)
+{
+    TransmitProfileRule rule;
+    rule.timers = std::vector<int>{1, 2, 3};
+    ASSERT_TRUE(TransmitProfiles::load(std::vector<TransmitProfileRules>{{"testProfile", { rule }}}));
+    ASSERT_TRUE(TransmitProfiles::setProfile("testProfile"));
+    ASSERT_TRUE(TransmitProfiles::isTimerUpdateRequired());
+
+    TimerArray timers;
+    TransmitProfiles::getTimers(timers);
+    EXPECT_EQ(timers[0], 1000);
+    EXPECT_EQ(timers[1], 3000);
+    EXPECT_FALSE(TransmitProfiles::isTimerUpdateRequired());
+}
+
+TEST(TransmitProfilesInstanceTests, setProfile_DoesNotAffectOtherInstances)
+{
+    TransmitProfiles first;
+    TransmitProfiles second;
+    TimerArray timers;
+    second.getTimers(timers);
+    ASSERT_FALSE(second.isTimerUpdateRequired());
+
+    TransmitProfileRule rule;
+    rule.timers = std::vector<int>{5, 5, 5};
+    ASSERT_TRUE(first.load(std::vector<TransmitProfileRules>{{"testProfile", { rule }}}));
+    ASSERT_TRUE(first.setProfile("testProfile"));
+
+    EXPECT_EQ(first.getProfile(), "testProfile");
+    EXPECT_EQ(second.getProfile(), "REAL_TIME");
+    EXPECT_FALSE(second.isTimerUpdateRequired());
+    EXPECT_FALSE(second.setProfile("testProfile"));
+
+    first.getTimers(timers);
+    EXPECT_EQ(timers[0], 5000);
+}
+
 #ifdef HAVE_MAT_JSONHPP
 TEST_F(TransmitProfilesTests, load_Json_EmptyJsonArray_FailsToParse)
 {
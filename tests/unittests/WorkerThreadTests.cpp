@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+
+#include "pal/TaskDispatcher.hpp"
+#include "pal/WorkerThread.hpp"
+#include "pal/typename.hpp"
+
+#include <chrono>
+#include <string>
+
+using namespace testing;
+using namespace MAT;
+using namespace PAL;
+
+namespace
+{
+    class Counter
+    {
+    public:
+        std::atomic<size_t> calls { 0 };
+        std::vector<int> order;
+
+        void Increment()
+        {
+            calls++;
+        }
+
+        void Append(int value)
+        {
+            order.push_back(value);
+            calls++;
+        }
+    };
+
+    // Dispatcher that keeps queued tasks without running them
+    class CapturingTaskDispatcher : public ITaskDispatcher
+    {
+    public:
+        std::vector<std::unique_ptr<Task>> tasks;
+
+        void Join() override {}
+
+        void Queue(Task* task) override
+        {
+            tasks.emplace_back(task);
+        }
+
+        bool Cancel(Task*, uint64_t) override
+        {
+            return false;
+        }
+    };
+
+    bool waitForCalls(Counter& counter, size_t expected, unsigned timeoutMs)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (counter.calls.load() < expected)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+} // namespace
+
+TEST(WorkerThreadTests, DispatchedTasksRunInOrder)
+{
+    Counter counter;
+    auto workerThread = WorkerThreadFactory::Create();
+    for (int i = 0; i < 100; i++)
+    {
+        dispatchTask(workerThread.get(), &counter, &Counter::Append, i);
+    }
+    ASSERT_TRUE(waitForCalls(counter, 100, 5000));
+
+    ASSERT_EQ(counter.order.size(), 100u);
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(counter.order[i], i);
+    }
+}
+
+TEST(WorkerThreadTests, ScheduledTaskCanBeCancelled)
+{
+    Counter counter;
+    auto workerThread = WorkerThreadFactory::Create();
+    auto handle = scheduleTask(workerThread.get(), 60000, &counter, &Counter::Increment);
+    EXPECT_TRUE(handle.Cancel());
+    dispatchTask(workerThread.get(), &counter, &Counter::Increment);
+    ASSERT_TRUE(waitForCalls(counter, 1, 5000));
+    EXPECT_EQ(counter.calls.load(), 1u);
+}
+
+TEST(WorkerThreadTests, TypeNameIsComputedLazily)
+{
+    CapturingTaskDispatcher dispatcher;
+    Counter counter;
+    dispatchTask(&dispatcher, &counter, &Counter::Increment);
+    ASSERT_EQ(dispatcher.tasks.size(), 1u);
+
+    Task* task = dispatcher.tasks.front().get();
+    EXPECT_TRUE(task->TypeName.empty());
+    std::string typeName = task->GetTypeName();
+#if HAS_RTTI
+    EXPECT_NE(typeName.find("Counter"), std::string::npos);
+#else
+    EXPECT_TRUE(typeName.empty());
+#endif
+    EXPECT_EQ(task->TypeName, typeName);
+
+    (*task)();
+    EXPECT_EQ(counter.calls.load(), 1u);
+}
+
+TEST(WorkerThreadTests, PooledTaskBlocksAreReusable)
+{
+    for (size_t size : { 16, 100, 200, 500 })
+    {
+        void* first = detail::allocateTask(size);
+        ASSERT_NE(first, nullptr);
+        memset(first, 0xAB, size);
+        detail::releaseTask(first, size);
+
+        // The block just released is at the head of its size class free list
+        void* second = detail::allocateTask(size);
+        EXPECT_EQ(second, first);
+        memset(second, 0xCD, size);
+        detail::releaseTask(second, size);
+    }
+
+    // Blocks larger than the biggest size class bypass the pool
+    void* large = detail::allocateTask(4096);
+    ASSERT_NE(large, nullptr);
+    memset(large, 0xAB, 4096);
+    detail::releaseTask(large, 4096);
+}
+
+TEST(WorkerThreadTests, TaskThroughput)
+{
+    const size_t taskCount = 200000;
+
+    Counter counter;
+    auto workerThread = WorkerThreadFactory::Create();
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < taskCount; i++)
+    {
+        dispatchTask(workerThread.get(), &counter, &Counter::Increment);
+    }
+    ASSERT_TRUE(waitForCalls(counter, taskCount, 60000));
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    RecordProperty("tasks", std::to_string(taskCount));
+    RecordProperty("tasksPerSecond", std::to_string(static_cast<uint64_t>(taskCount / elapsed)));
+    EXPECT_EQ(counter.calls.load(), taskCount);
+}
@@ -0,0 +1,209 @@
+//
+// Copyright (c) 2015-2020 Microsoft Corporation and Contributors.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+//
+// mat-decoder: converts captured request bodies (e.g. saved HTTPS POST payloads) into
+// newline-delimited JSON, one record per line. Input files are decoded in parallel,
+// each of them streamed so that memory usage stays bounded regardless of their size.
+//
+
+#include "PayloadDecoder.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MAT;
+
+namespace {
+
+    struct Options
+    {
+        std::vector<std::string> files;
+        unsigned jobs = 0;
+        bool compressed = true;
+        bool toStdout = false;
+    };
+
+    void usage(char const* name)
+    {
+        std::cerr << "Usage: " << name << " [-j <jobs>] [--raw] [--stdout] <file>..." << std::endl
+                  << "Decodes request bodies into newline-delimited JSON, written to <file>.ndjson" << std::endl
+                  << "  -j <jobs>  number of files decoded in parallel (default: number of cores)" << std::endl
+                  << "  --raw      input is not deflate-compressed" << std::endl
+                  << "  --stdout   write all the records to the standard output instead" << std::endl;
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            {
+                options.jobs = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+            }
+            else if (strcmp(argv[i], "--raw") == 0)
+            {
+                options.compressed = false;
+            }
+            else if (strcmp(argv[i], "--stdout") == 0)
+            {
+                options.toStdout = true;
+            }
+            else if (argv[i][0] == '-')
+            {
+                return false;
+            }
+            else
+            {
+                options.files.push_back(argv[i]);
+            }
+        }
+        return !options.files.empty();
+    }
+
+    /// <summary>
+    /// Output stream handing complete lines over to the shared standard output, so that records
+    /// decoded by different workers never interleave.
+    /// </summary>
+    class LineBuffer : public std::streambuf
+    {
+    public:
+        explicit LineBuffer(std::mutex& lock) :
+            m_lock(lock)
+        {
+        }
+
+        ~LineBuffer()
+        {
+            flushLines(true);
+        }
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if (c != traits_type::eof())
+            {
+                char ch = traits_type::to_char_type(c);
+                xsputn(&ch, 1);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(char const* data, std::streamsize size) override
+        {
+            m_pending.append(data, static_cast<size_t>(size));
+            if (memchr(data, '\n', static_cast<size_t>(size)) != nullptr)
+            {
+                flushLines(false);
+            }
+            return size;
+        }
+
+        void flushLines(bool all)
+        {
+            size_t end = all ? m_pending.size() : m_pending.rfind('\n') + 1;
+            if (end == 0 || end == std::string::npos)
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                std::cout.write(m_pending.data(), static_cast<std::streamsize>(end));
+            }
+            m_pending.erase(0, end);
+        }
+
+        std::mutex& m_lock;
+        std::string m_pending;
+    };
+
+    bool decodeFile(std::string const& path, Options const& options, std::mutex& outputLock)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            std::lock_guard<std::mutex> guard(outputLock);
+            std::cerr << path << ": unable to open" << std::endl;
+            return false;
+        }
+
+        bool result;
+        if (options.toStdout)
+        {
+            LineBuffer buffer(outputLock);
+            std::ostream out(&buffer);
+            result = exporters::DecodeRequestStream(in, out, options.compressed);
+        }
+        else
+        {
+            std::ofstream out(path + ".ndjson", std::ios::binary | std::ios::trunc);
+            result = out && exporters::DecodeRequestStream(in, out, options.compressed);
+        }
+
+        if (!result)
+        {
+            std::lock_guard<std::mutex> guard(outputLock);
+            std::cerr << path << ": decoding failed" << std::endl;
+        }
+        return result;
+    }
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    unsigned jobs = options.jobs ? options.jobs : std::thread::hardware_concurrency();
+    if (jobs == 0)
+    {
+        jobs = 1;
+    }
+    if (jobs > options.files.size())
+    {
+        jobs = static_cast<unsigned>(options.files.size());
+    }
+
+    // Workers pick the next file as soon as they are done with the previous one
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> failures(0);
+    std::mutex outputLock;
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < options.files.size(); i = next++)
+        {
+            if (!decodeFile(options.files[i], options, outputLock))
+            {
+                failures++;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < jobs; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    return (failures == 0) ? 0 : 1;
+}